@@ -0,0 +1,189 @@
+#include "asset_cache.h"
+#include "config.h"
+#include "logger.h"
+#include "perf_monitor.h"
+
+#include <cstring>
+
+namespace {
+  const lv_img_dsc_t *packed(const void *src) {
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) {
+      return NULL;
+    }
+    const lv_img_dsc_t *img = static_cast<const lv_img_dsc_t *>(src);
+    return img->header.cf == LV_IMG_CF_USER_ENCODED_0
+      || img->header.cf == LV_IMG_CF_USER_ENCODED_1 ? img : NULL;
+  }
+}
+
+AssetPixels asset_native_pixels() {
+#if LV_COLOR_DEPTH == 32
+  return AssetPixels::BGRA8888;
+#elif LV_COLOR_16_SWAP
+  return AssetPixels::RGB565A8_SWAP;
+#else
+  return AssetPixels::RGB565A8;
+#endif
+}
+
+AssetCache *AssetCache::get_instance() {
+  static AssetCache instance;
+  return &instance;
+}
+
+AssetCache::AssetCache()
+  : budget(0)
+  , used(0)
+  , imgbtn_pressed(lv_color_black())
+  , imgbtn_disabled(lv_color_black())
+  , decode_us(NULL)
+  , hits(NULL)
+  , misses(NULL)
+{
+}
+
+void AssetCache::init() {
+  budget = Config::get_instance()->get<uint32_t>("/ui/asset_cache_kb", 512) * 1024;
+
+  Metrics *m = Metrics::get_instance();
+  decode_us = m->histogram("guppy_asset_decode_seconds", "Time spent expanding a packed image", "", 1e-6);
+  hits = m->counter("guppy_asset_cache_total", "Packed image opens by cache result", "result=\"hit\"");
+  misses = m->counter("guppy_asset_cache_total", "Packed image opens by cache result", "result=\"miss\"");
+
+  lv_img_decoder_t *decoder = lv_img_decoder_create();
+  lv_img_decoder_set_info_cb(decoder, &AssetCache::info_cb);
+  lv_img_decoder_set_open_cb(decoder, &AssetCache::open_cb);
+  lv_img_decoder_set_close_cb(decoder, &AssetCache::close_cb);
+  LOG_DEBUG("asset cache {} kB", budget / 1024);
+}
+
+const lv_img_dsc_t *AssetCache::recolored(const void *src, lv_color_t colour) {
+  const lv_img_dsc_t *base = static_cast<const lv_img_dsc_t *>(src);
+  uint32_t c = lv_color_to32(colour);
+  auto &v = variants[{src, c}];
+  if (!v) {
+    v.reset(new Variant());
+    v->base = base;
+    v->rgb[0] = (c >> 16) & 0xff;
+    v->rgb[1] = (c >> 8) & 0xff;
+    v->rgb[2] = c & 0xff;
+    v->dsc.header = base->header;
+    v->dsc.header.cf = LV_IMG_CF_USER_ENCODED_1;
+    v->dsc.data_size = sizeof(Variant);
+    v->dsc.data = reinterpret_cast<const uint8_t *>(v.get());
+  }
+  return &v->dsc;
+}
+
+void AssetCache::set_imgbtn_colours(lv_color_t pressed, lv_color_t disabled) {
+  imgbtn_pressed = pressed;
+  imgbtn_disabled = disabled;
+}
+
+void AssetCache::set_imgbtn_src(lv_obj_t *btn, const void *src) {
+  lv_imgbtn_set_src(btn, LV_IMGBTN_STATE_RELEASED, NULL, src, NULL);
+  lv_imgbtn_set_src(btn, LV_IMGBTN_STATE_PRESSED, NULL, recolored(src, imgbtn_pressed), NULL);
+  lv_imgbtn_set_src(btn, LV_IMGBTN_STATE_DISABLED, NULL, recolored(src, imgbtn_disabled), NULL);
+}
+
+lv_res_t AssetCache::info_cb(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header) {
+  const lv_img_dsc_t *img = packed(src);
+  if (img == NULL) {
+    return LV_RES_INV;
+  }
+  *header = img->header;
+  header->cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+  return LV_RES_OK;
+}
+
+lv_res_t AssetCache::open_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+  const lv_img_dsc_t *img = packed(dsc->src);
+  if (img == NULL) {
+    return LV_RES_INV;
+  }
+  const uint8_t *pixels = get_instance()->acquire(img);
+  if (pixels == NULL) {
+    return LV_RES_INV;
+  }
+  dsc->img_data = pixels;
+  return LV_RES_OK;
+}
+
+void AssetCache::close_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+  get_instance()->release(static_cast<const lv_img_dsc_t *>(dsc->src));
+  dsc->img_data = NULL;
+}
+
+bool AssetCache::expand(const lv_img_dsc_t *img, uint8_t *pixels) {
+  uint32_t w = img->header.w;
+  uint32_t h = img->header.h;
+  if (img->header.cf == LV_IMG_CF_USER_ENCODED_0) {
+    return asset_decode(img->data, img->data_size, w, h, asset_native_pixels(), pixels);
+  }
+
+  const Variant *v = reinterpret_cast<const Variant *>(img->data);
+  const lv_img_dsc_t *base = v->base;
+  if (base->header.cf == LV_IMG_CF_USER_ENCODED_0) {
+    return asset_decode(base->data, base->data_size, w, h, asset_native_pixels(), pixels, v->rgb);
+  }
+  if (base->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA) {
+    return false;
+  }
+
+  // raw assets, keep the alpha and replace the native colour
+  lv_color_t c = lv_color_make(v->rgb[0], v->rgb[1], v->rgb[2]);
+  size_t px = LV_IMG_PX_SIZE_ALPHA_BYTE;
+  for (size_t i = 0; i < static_cast<size_t>(w) * h; i++) {
+    memcpy(pixels + i * px, &c, px - 1);
+    pixels[i * px + px - 1] = base->data[i * px + px - 1];
+  }
+  return true;
+}
+
+const uint8_t *AssetCache::acquire(const lv_img_dsc_t *img) {
+  auto found = index.find(img);
+  if (found != index.end()) {
+    entries.splice(entries.begin(), entries, found->second);
+    found->second->refs++;
+    (*hits)++;
+    return found->second->pixels.get();
+  }
+
+  (*misses)++;
+  uint64_t start = PerfMonitor::now_us();
+  size_t size = static_cast<size_t>(img->header.w) * img->header.h * asset_pixel_size(asset_native_pixels());
+  std::unique_ptr<uint8_t[]> pixels(new uint8_t[size]);
+  if (!expand(img, pixels.get())) {
+    LOG_ERROR("corrupt packed image {}x{}, {} bytes", img->header.w, img->header.h, img->data_size);
+    return NULL;
+  }
+  decode_us->observe(PerfMonitor::now_us() - start);
+
+  entries.push_front({img, std::move(pixels), size, 1});
+  index[img] = entries.begin();
+  used += size;
+  evict();
+  return entries.front().pixels.get();
+}
+
+void AssetCache::release(const lv_img_dsc_t *img) {
+  auto found = index.find(img);
+  if (found != index.end() && found->second->refs > 0) {
+    found->second->refs--;
+  }
+  evict();
+}
+
+void AssetCache::evict() {
+  // images still open in LVGL's cache stay, the budget is only exceeded
+  // by as many as LV_IMG_CACHE_DEF_SIZE
+  auto it = entries.end();
+  while (used > budget && it != entries.begin()) {
+    --it;
+    if (it->refs == 0) {
+      used -= it->size;
+      index.erase(it->src);
+      it = entries.erase(it);
+    }
+  }
+}
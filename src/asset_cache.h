@@ -0,0 +1,84 @@
+#ifndef __ASSET_CACHE_H__
+#define __ASSET_CACHE_H__
+
+#include "asset_codec.h"
+#include "metrics.h"
+#include "lvgl/lvgl.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+// LVGL image decoder for the packed assets (LV_IMG_CF_USER_ENCODED_0, see
+// asset_codec.h). Images are expanded to LV_IMG_CF_TRUE_COLOR_ALPHA on first
+// use and kept up to [ui] asset_cache_kb, the least recently used image not
+// held open by LVGL's own cache is dropped first.
+//
+// Recolored variants (LV_IMG_CF_USER_ENCODED_1) are expanded the same way
+// with the colour baked in, so imgbtn pressed and disabled states draw
+// without LVGL's per pixel img_recolor.
+//
+// Everything here runs with lv_lock held.
+// layout of LV_IMG_CF_TRUE_COLOR_ALPHA at the build's LV_COLOR_DEPTH
+AssetPixels asset_native_pixels();
+
+class AssetCache {
+ public:
+  static AssetCache *get_instance();
+
+  void init();
+
+  // src drawn with img_recolor at full opacity. src is a packed or an
+  // LV_IMG_CF_TRUE_COLOR_ALPHA image, the variant lives as long as the process
+  const lv_img_dsc_t *recolored(const void *src, lv_color_t colour);
+
+  // theme colours of the imgbtn pressed and disabled states
+  void set_imgbtn_colours(lv_color_t pressed, lv_color_t disabled);
+  // src for the released state, recolored variants for the others
+  void set_imgbtn_src(lv_obj_t *btn, const void *src);
+
+ private:
+  AssetCache();
+  AssetCache(const AssetCache &) = delete;
+  AssetCache &operator=(const AssetCache &) = delete;
+
+  struct Variant {
+    const lv_img_dsc_t *base;
+    uint8_t rgb[3];
+    lv_img_dsc_t dsc;
+  };
+
+  struct Entry {
+    const lv_img_dsc_t *src;
+    std::unique_ptr<uint8_t[]> pixels;
+    size_t size;
+    uint32_t refs;
+  };
+
+  static lv_res_t info_cb(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header);
+  static lv_res_t open_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc);
+  static void close_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc);
+
+  bool expand(const lv_img_dsc_t *img, uint8_t *pixels);
+  const uint8_t *acquire(const lv_img_dsc_t *img);
+  void release(const lv_img_dsc_t *img);
+  void evict();
+
+  size_t budget;
+  size_t used;
+  // front is the most recently used
+  std::list<Entry> entries;
+  std::unordered_map<const lv_img_dsc_t *, std::list<Entry>::iterator> index;
+  // by source and lv_color_to32 of the colour
+  std::map<std::pair<const void *, uint32_t>, std::unique_ptr<Variant>> variants;
+  lv_color_t imgbtn_pressed;
+  lv_color_t imgbtn_disabled;
+
+  Histogram *decode_us;
+  Metrics::Counter *hits;
+  Metrics::Counter *misses;
+};
+
+#endif // __ASSET_CACHE_H__
@@ -0,0 +1,258 @@
+#include "asset_codec.h"
+
+#include <cstdlib>
+#include <map>
+
+namespace {
+  const size_t MAX_LITERAL = 128;
+  const size_t MIN_RUN = 3;
+  const size_t MAX_RUN = 130;
+  const int COLOUR_TOLERANCE = 2;
+
+  void rle_encode(const std::vector<uint8_t> &plane, std::vector<uint8_t> &out) {
+    size_t n = plane.size();
+    size_t i = 0;
+    while (i < n) {
+      size_t run = 1;
+      while (i + run < n && run < MAX_RUN && plane[i + run] == plane[i]) {
+        run++;
+      }
+
+      if (run >= MIN_RUN) {
+        out.push_back(static_cast<uint8_t>(run + 125));
+        out.push_back(plane[i]);
+        i += run;
+        continue;
+      }
+
+      // literals until the next run worth encoding
+      size_t start = i;
+      while (i < n && i - start < MAX_LITERAL) {
+        if (i + 2 < n && plane[i] == plane[i + 1] && plane[i] == plane[i + 2]) {
+          break;
+        }
+        i++;
+      }
+      out.push_back(static_cast<uint8_t>(i - start - 1));
+      out.insert(out.end(), plane.begin() + start, plane.begin() + i);
+    }
+  }
+
+  // returns the bytes consumed from src, 0 on corrupt input
+  size_t rle_decode(const uint8_t *src, size_t len, uint8_t *plane, size_t n) {
+    size_t in = 0;
+    size_t i = 0;
+    while (i < n) {
+      if (in >= len) {
+        return 0;
+      }
+      uint8_t c = src[in++];
+      if (c < 128) {
+        size_t count = c + 1;
+        if (in + count > len || i + count > n) {
+          return 0;
+        }
+        for (size_t k = 0; k < count; k++) {
+          plane[i++] = src[in++];
+        }
+      } else {
+        size_t count = c - 125;
+        if (in >= len || i + count > n) {
+          return 0;
+        }
+        uint8_t v = src[in++];
+        for (size_t k = 0; k < count; k++) {
+          plane[i++] = v;
+        }
+      }
+    }
+    return in;
+  }
+
+  uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+  }
+
+  void put_pixel(uint8_t *out, AssetPixels fmt, uint8_t a, uint8_t r, uint8_t g, uint8_t b) {
+    switch (fmt) {
+    case AssetPixels::BGRA8888:
+      out[0] = b;
+      out[1] = g;
+      out[2] = r;
+      out[3] = a;
+      break;
+    case AssetPixels::RGB565A8: {
+      uint16_t c = rgb565(r, g, b);
+      out[0] = c & 0xff;
+      out[1] = c >> 8;
+      out[2] = a;
+      break;
+    }
+    case AssetPixels::RGB565A8_SWAP: {
+      uint16_t c = rgb565(r, g, b);
+      out[0] = c >> 8;
+      out[1] = c & 0xff;
+      out[2] = a;
+      break;
+    }
+    }
+  }
+
+  // 4x4 Bayer matrix, 0..15
+  const uint8_t BAYER[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+  };
+
+  // c to the nearest of the 2^bits levels after adding the threshold,
+  // (2 * threshold + 1) / 32 - 1/2 of a level, centred on zero so the
+  // levels average out to c over the matrix. returned as the 8 bit value
+  // rgb565 truncates back to that level
+  inline uint8_t dither(uint8_t c, uint8_t threshold, int bits) {
+    uint32_t levels = (1u << bits) - 1;
+    uint32_t level = (c * levels * 32 + 255 * (2 * threshold + 1)) / (255 * 32);
+    return level << (8 - bits);
+  }
+
+  // one colour with an alpha plane
+  bool expand_alpha(const uint8_t *src, size_t len, size_t n, AssetPixels fmt,
+                    const uint8_t *rgb, uint8_t *out) {
+    // expand the alpha plane in place at the end of out, then interleave
+    // front to back, the pixel written never overtakes the alpha read
+    size_t px = asset_pixel_size(fmt);
+    uint8_t *alpha = out + n * (px - 1);
+    if (rle_decode(src, len, alpha, n) == 0) {
+      return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+      put_pixel(out + i * px, fmt, alpha[i], rgb[0], rgb[1], rgb[2]);
+    }
+    return true;
+  }
+}
+
+size_t asset_pixel_size(AssetPixels fmt) {
+  return fmt == AssetPixels::BGRA8888 ? 4 : 3;
+}
+
+std::vector<uint8_t> asset_encode(const uint8_t *bgra, uint32_t w, uint32_t h) {
+  size_t n = static_cast<size_t>(w) * h;
+  std::vector<uint8_t> a(n), r(n), g(n), b(n);
+  std::map<uint32_t, size_t> colours;
+
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t *p = bgra + i * 4;
+    a[i] = p[3];
+    if (a[i] == 0) {
+      continue;
+    }
+    b[i] = p[0];
+    g[i] = p[1];
+    r[i] = p[2];
+    colours[(r[i] << 16) | (g[i] << 8) | b[i]]++;
+  }
+
+  // the converter leaves off by one colours on antialiased edges, close
+  // enough to the most used colour still counts as one colour
+  uint32_t colour = 0;
+  size_t most = 0;
+  for (const auto &c : colours) {
+    if (c.second > most) {
+      most = c.second;
+      colour = c.first;
+    }
+  }
+  uint8_t cr = colour >> 16, cg = (colour >> 8) & 0xff, cb = colour & 0xff;
+  bool one_colour = true;
+  for (const auto &c : colours) {
+    if (abs(static_cast<int>(c.first >> 16) - cr) > COLOUR_TOLERANCE
+        || abs(static_cast<int>((c.first >> 8) & 0xff) - cg) > COLOUR_TOLERANCE
+        || abs(static_cast<int>(c.first & 0xff) - cb) > COLOUR_TOLERANCE) {
+      one_colour = false;
+      break;
+    }
+  }
+
+  std::vector<uint8_t> out;
+  if (one_colour) {
+    out.push_back(ASSET_A8);
+    out.push_back(cr);
+    out.push_back(cg);
+    out.push_back(cb);
+    rle_encode(a, out);
+  } else {
+    out.push_back(ASSET_ARGB);
+    rle_encode(a, out);
+    rle_encode(r, out);
+    rle_encode(g, out);
+    rle_encode(b, out);
+  }
+  return out;
+}
+
+bool asset_decode(const uint8_t *src, size_t len, uint32_t w, uint32_t h,
+                  AssetPixels fmt, uint8_t *out, const uint8_t *rgb) {
+  size_t n = static_cast<size_t>(w) * h;
+  if (len < 1) {
+    return false;
+  }
+
+  if (src[0] == ASSET_A8) {
+    if (len < 4) {
+      return false;
+    }
+    const uint8_t *c = rgb != NULL ? rgb : src + 1;
+    return expand_alpha(src + 4, len - 4, n, fmt, c, out);
+  }
+
+  if (src[0] == ASSET_ARGB && rgb != NULL) {
+    // alpha is the first plane, the colour planes are not needed
+    return expand_alpha(src + 1, len - 1, n, fmt, rgb, out);
+  }
+
+  if (src[0] == ASSET_ARGB) {
+    size_t px = asset_pixel_size(fmt);
+    std::vector<uint8_t> planes(n * 4);
+    size_t in = 1;
+    for (size_t p = 0; p < 4; p++) {
+      size_t used = rle_decode(src + in, len - in, planes.data() + p * n, n);
+      if (used == 0) {
+        return false;
+      }
+      in += used;
+    }
+    const uint8_t *a = planes.data();
+    const uint8_t *r = a + n;
+    const uint8_t *g = r + n;
+    const uint8_t *b = g + n;
+    for (size_t i = 0; i < n; i++) {
+      put_pixel(out + i * px, fmt, a[i], r[i], g[i], b[i]);
+    }
+    return true;
+  }
+
+  return false;
+}
+
+void asset_convert_rgba(const uint8_t *rgba, uint32_t w, uint32_t h,
+                        AssetPixels fmt, uint8_t *out) {
+  // front to back, a pixel is never wider than the one it is made from
+  size_t px = asset_pixel_size(fmt);
+  for (uint32_t y = 0; y < h; y++) {
+    const uint8_t *bayer = BAYER[y & 3];
+    for (uint32_t x = 0; x < w; x++) {
+      size_t i = static_cast<size_t>(y) * w + x;
+      const uint8_t *p = rgba + i * 4;
+      uint8_t r = p[0], g = p[1], b = p[2], a = p[3];
+      if (fmt != AssetPixels::BGRA8888) {
+        uint8_t t = bayer[x & 3];
+        r = dither(r, t, 5);
+        g = dither(g, t, 6);
+        b = dither(b, t, 5);
+      }
+      put_pixel(out + i * px, fmt, a, r, g, b);
+    }
+  }
+}
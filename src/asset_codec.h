@@ -0,0 +1,49 @@
+#ifndef __ASSET_CODEC_H__
+#define __ASSET_CODEC_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packed image assets, produced at build time by tools/asset_pack from the
+// 32 bit arrays of the LVGL image converter and expanded by AssetCache on
+// first use.
+//
+//   byte 0      mode
+//   ASSET_A8    r, g, b, then the alpha plane. Icons drawn in one colour,
+//               only the alpha varies, channels within 2 of r, g, b are
+//               folded into it
+//   ASSET_ARGB  alpha, red, green and blue planes
+//
+// Planes are w * h bytes, PackBits style run length encoded: a control byte
+// c < 128 is followed by c + 1 literal bytes, c >= 128 by one byte repeated
+// c - 125 times. Colour under fully transparent pixels is dropped.
+enum AssetMode : uint8_t {
+  ASSET_A8 = 1,
+  ASSET_ARGB = 2,
+};
+
+// decoded pixel layouts, what LVGL expects for LV_IMG_CF_TRUE_COLOR_ALPHA
+enum class AssetPixels {
+  BGRA8888,       // LV_COLOR_DEPTH 32
+  RGB565A8,       // LV_COLOR_DEPTH 16
+  RGB565A8_SWAP,  // LV_COLOR_DEPTH 16, LV_COLOR_16_SWAP
+};
+
+size_t asset_pixel_size(AssetPixels fmt);
+
+// bgra is w * h pixels in the LV_COLOR_DEPTH 32 layout
+std::vector<uint8_t> asset_encode(const uint8_t *bgra, uint32_t w, uint32_t h);
+
+// out holds w * h * asset_pixel_size(fmt) bytes, false on corrupt input.
+// rgb, if set, replaces the colour of every pixel, as an image recolored
+// at full opacity
+bool asset_decode(const uint8_t *src, size_t len, uint32_t w, uint32_t h,
+                  AssetPixels fmt, uint8_t *out, const uint8_t *rgb = NULL);
+
+// rgba, as decoded from a PNG, to fmt. RGB565 is ordered dithered so
+// thumbnails and other photographic images don't band. out may be rgba
+void asset_convert_rgba(const uint8_t *rgba, uint32_t w, uint32_t h,
+                        AssetPixels fmt, uint8_t *out);
+
+#endif // __ASSET_CODEC_H__
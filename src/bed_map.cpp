@@ -0,0 +1,71 @@
+#include "bed_map.h"
+#include "state.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  bool parse_scalar(const json &v, double &out) {
+    if (v.is_number()) {
+      out = v.template get<double>();
+      return true;
+    }
+
+    if (v.is_string()) {
+      try {
+        out = std::stod(v.template get<std::string>());
+        return true;
+      } catch (...) {
+        return false;
+      }
+    }
+
+    return false;
+  }
+}
+
+BedMap::BedMap()
+  : min_x(0.0)
+  , max_x(220.0)
+  , min_y(0.0)
+  , max_y(220.0)
+{
+}
+
+void BedMap::load() {
+  auto s = State::get_instance();
+  auto stepper_x_max = s->get_data("/printer_state/configfile/config/stepper_x/position_max"_json_pointer);
+  auto stepper_y_max = s->get_data("/printer_state/configfile/config/stepper_y/position_max"_json_pointer);
+  double x = 0.0;
+  double y = 0.0;
+  if (parse_scalar(stepper_x_max, x) && parse_scalar(stepper_y_max, y)) {
+    min_x = 0.0;
+    min_y = 0.0;
+    max_x = x;
+    max_y = y;
+  }
+
+  if (max_x - min_x < 1.0) {
+    min_x = 0.0;
+    max_x = 220.0;
+  }
+
+  if (max_y - min_y < 1.0) {
+    min_y = 0.0;
+    max_y = 220.0;
+  }
+}
+
+lv_point_t BedMap::to_px(double mx, double my, lv_coord_t dim, lv_coord_t margin) const {
+  double bw = max_x - min_x;
+  double bh = max_y - min_y;
+  double avail = dim - 2 * margin;
+  double scale = avail / std::max(bw, bh);
+  double ox = margin + (avail - bw * scale) / 2.0;
+  double oy = margin + (avail - bh * scale) / 2.0;
+
+  lv_point_t p;
+  p.x = static_cast<lv_coord_t>(std::lround(ox + (mx - min_x) * scale));
+  p.y = static_cast<lv_coord_t>(std::lround(dim - oy - (my - min_y) * scale));
+  return p;
+}
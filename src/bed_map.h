@@ -0,0 +1,27 @@
+#ifndef __BED_MAP_H__
+#define __BED_MAP_H__
+
+#include "lvgl/lvgl.h"
+
+// Bed coordinates to pixels of a square map, the bed scaled to fit and
+// centred, y up. Bounds come from the configfile's stepper position_max.
+class BedMap {
+ public:
+  BedMap();
+
+  void load();
+
+  lv_point_t to_px(double mx, double my, lv_coord_t dim, lv_coord_t margin) const;
+
+  bool operator==(const BedMap &o) const {
+    return min_x == o.min_x && max_x == o.max_x && min_y == o.min_y && max_y == o.max_y;
+  }
+  bool operator!=(const BedMap &o) const { return !(*this == o); }
+
+  double min_x;
+  double max_x;
+  double min_y;
+  double max_y;
+};
+
+#endif // __BED_MAP_H__
@@ -0,0 +1,147 @@
+#include "binlog.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+BinLog::BinLog()
+  : segment_bytes(0)
+  , max_segments(0)
+  , seq(0)
+  , fd(-1)
+  , written(0)
+{
+}
+
+BinLog::~BinLog() {
+  close_segment();
+}
+
+bool BinLog::open(const std::string &p, size_t seg_bytes, size_t segments) {
+  prefix = p;
+  segment_bytes = std::max<size_t>(seg_bytes, 4096);
+  max_segments = std::max<size_t>(segments, 1);
+
+  // continue after the newest segment left by a previous run
+  for (uint64_t n : list_segments()) {
+    seq = std::max(seq, n);
+  }
+
+  return open_segment();
+}
+
+std::vector<uint64_t> BinLog::list_segments() const {
+  std::vector<uint64_t> out;
+  std::string dir = prefix.substr(0, prefix.rfind('/') == std::string::npos ? 0 : prefix.rfind('/'));
+  std::string base = prefix.substr(dir.empty() ? 0 : dir.size() + 1);
+  DIR *d = opendir(dir.empty() ? "." : dir.c_str());
+  if (d != NULL) {
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+      std::string name = e->d_name;
+      if (name.compare(0, base.size() + 1, base + ".") == 0) {
+        out.push_back(strtoull(name.c_str() + base.size() + 1, NULL, 10));
+      }
+    }
+    closedir(d);
+  }
+  return out;
+}
+
+bool BinLog::open_segment() {
+  seq++;
+  std::string path = prefix + "." + std::to_string(seq) + ".bin";
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  // everything older than the last max_segments, a previous run may
+  // have kept more
+  for (uint64_t n : list_segments()) {
+    if (n + max_segments <= seq) {
+      std::string old = prefix + "." + std::to_string(n) + ".bin";
+      unlink(old.c_str());
+    }
+  }
+
+  written = 0;
+  emitted.assign(emitted.size(), false);
+  buf.append(binlog::MAGIC, sizeof(binlog::MAGIC));
+  buf.push_back(static_cast<char>(binlog::VERSION));
+  buf.append(3, '\0');
+  return true;
+}
+
+void BinLog::close_segment() {
+  if (fd < 0) {
+    return;
+  }
+
+  flush(true);
+  ::close(fd);
+  fd = -1;
+}
+
+void BinLog::reserve(size_t bytes) {
+  if (written + buf.size() + bytes > segment_bytes && written + buf.size() > binlog::SEGMENT_HEADER_SIZE) {
+    close_segment();
+    open_segment();
+  }
+}
+
+void BinLog::append_line(uint8_t level, uint64_t ts_us, const char *fmt, size_t fmt_len, const std::string &args) {
+  if (fd < 0) {
+    return;
+  }
+
+  auto entry = format_ids.find(fmt);
+  uint32_t id;
+  if (entry == format_ids.end()) {
+    id = format_ids.size();
+    format_ids.insert({fmt, id});
+    emitted.push_back(false);
+  } else {
+    id = entry->second;
+  }
+
+  std::string id_bytes;
+  binlog::put_varint(id_bytes, id);
+
+  size_t format_size = emitted[id] ? 0 : binlog::RECORD_HEADER_SIZE + id_bytes.size() + fmt_len;
+  reserve(format_size + binlog::RECORD_HEADER_SIZE + id_bytes.size() + args.size());
+
+  if (!emitted[id]) {
+    binlog::put_record_header(buf, binlog::REC_FORMAT, 0, id_bytes.size() + fmt_len, 0);
+    buf.append(id_bytes);
+    buf.append(fmt, fmt_len);
+    emitted[id] = true;
+  }
+
+  binlog::put_record_header(buf, binlog::REC_LINE, level, id_bytes.size() + args.size(), ts_us);
+  buf.append(id_bytes);
+  buf.append(args);
+}
+
+void BinLog::flush(bool sync) {
+  if (fd < 0) {
+    return;
+  }
+
+  size_t off = 0;
+  while (off < buf.size()) {
+    ssize_t n = ::write(fd, buf.data() + off, buf.size() - off);
+    if (n <= 0) {
+      break;
+    }
+    off += n;
+  }
+  written += off;
+  buf.clear();
+
+  if (sync) {
+    fsync(fd);
+  }
+}
@@ -0,0 +1,175 @@
+#ifndef __BINLOG_H__
+#define __BINLOG_H__
+
+#ifndef FMT_HEADER_ONLY
+#define FMT_HEADER_ONLY
+#endif
+#include <fmt/core.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Binary log segment format, shared by the writer and tools/binlog_decode.
+//
+//   segment: "GSBL" version(u8) pad(3) record*
+//   record:  type(u8) level(u8) pad(2) length(u32 le) timestamp_us(u64 le) payload[length]
+//
+// A FORMAT record (id varint, format string) precedes the first LINE using
+// it in every segment, so each segment decodes on its own. LINE payloads
+// are the format id, the argument count and tagged arguments. Integers are
+// varints, signed ones zigzag encoded.
+namespace binlog {
+  constexpr char MAGIC[4] = {'G', 'S', 'B', 'L'};
+  constexpr uint8_t VERSION = 1;
+  constexpr size_t SEGMENT_HEADER_SIZE = 8;
+  constexpr size_t RECORD_HEADER_SIZE = 16;
+
+  enum RecordType : uint8_t {
+    REC_FORMAT = 'F',
+    REC_LINE = 'L',
+  };
+
+  enum ArgType : uint8_t {
+    ARG_BOOL = 'b',
+    ARG_CHAR = 'c',
+    ARG_INT = 'i',
+    ARG_UINT = 'u',
+    ARG_DOUBLE = 'd',
+    ARG_STRING = 's',
+  };
+
+  inline void put_varint(std::string &out, uint64_t v) {
+    while (v >= 0x80) {
+      out.push_back(static_cast<char>(v | 0x80));
+      v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+  }
+
+  inline bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+      uint8_t b = *p++;
+      v |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if ((b & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  inline uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+  }
+
+  inline int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+  }
+
+  inline void put_le(std::string &out, uint64_t v, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+      out.push_back(static_cast<char>(v >> (8 * i)));
+    }
+  }
+
+  inline uint64_t get_le(const uint8_t *p, size_t bytes) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; i++) {
+      v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return v;
+  }
+
+  inline void put_record_header(std::string &out, uint8_t type, uint8_t level, uint32_t len, uint64_t ts_us) {
+    out.push_back(static_cast<char>(type));
+    out.push_back(static_cast<char>(level));
+    put_le(out, 0, 2);
+    put_le(out, len, 4);
+    put_le(out, ts_us, 8);
+  }
+
+  inline void put_string(std::string &out, std::string_view s) {
+    out.push_back(ARG_STRING);
+    put_varint(out, s.size());
+    out.append(s.data(), s.size());
+  }
+
+  template <typename T>
+  inline void encode_arg(std::string &out, const T &v) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+      out.push_back(ARG_BOOL);
+      out.push_back(v ? 1 : 0);
+    } else if constexpr (std::is_same_v<U, char>) {
+      out.push_back(ARG_CHAR);
+      out.push_back(v);
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+      out.push_back(ARG_INT);
+      put_varint(out, zigzag(static_cast<int64_t>(v)));
+    } else if constexpr (std::is_integral_v<U>) {
+      out.push_back(ARG_UINT);
+      put_varint(out, static_cast<uint64_t>(v));
+    } else if constexpr (std::is_floating_point_v<U>) {
+      double d = static_cast<double>(v);
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      out.push_back(ARG_DOUBLE);
+      put_le(out, bits, 8);
+    } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+      put_string(out, std::string_view(v));
+    } else {
+      // anything else fmt knows about is stored already formatted
+      put_string(out, fmt::format("{}", v));
+    }
+  }
+
+  template <typename... Args>
+  inline void encode_args(std::string &out, const Args &... args) {
+    out.push_back(static_cast<char>(sizeof...(Args)));
+    (encode_arg(out, args), ...);
+  }
+}
+
+// Size capped rotating segments named <prefix>.<seq>.bin. Writes go to the
+// page cache, each segment is fsynced once, when it is closed. Not thread
+// safe, owned by the logger's writer thread.
+class BinLog {
+ public:
+  BinLog();
+  ~BinLog();
+
+  bool open(const std::string &prefix, size_t segment_bytes, size_t max_segments);
+  bool is_open() const { return fd >= 0; }
+
+  void append_line(uint8_t level, uint64_t ts_us, const char *fmt, size_t fmt_len, const std::string &args);
+
+  // write buffered records, sync also fsyncs the current segment
+  void flush(bool sync);
+
+ private:
+  bool open_segment();
+  void close_segment();
+  // seq of every segment under prefix, this run's and earlier ones
+  std::vector<uint64_t> list_segments() const;
+  void reserve(size_t bytes);
+
+  std::string prefix;
+  size_t segment_bytes;
+  size_t max_segments;
+  uint64_t seq;
+  int fd;
+  size_t written;
+  std::string buf;
+
+  // format strings are interned by address, FMT_STRING literals are stable
+  std::unordered_map<const char *, uint32_t> format_ids;
+  // per segment, indexed by format id
+  std::vector<bool> emitted;
+};
+
+#endif // __BINLOG_H__
@@ -1,4 +1,5 @@
 #include "button_container.h"
+#include "asset_cache.h"
 #include "simple_dialog.h"
 
 namespace {
@@ -30,7 +31,7 @@ ButtonContainer::ButtonContainer(lv_obj_t *parent,
   lv_obj_set_size(btn_cont, 150 * width_scale, LV_SIZE_CONTENT);
 
   lv_obj_clear_flag(btn_cont, LV_OBJ_FLAG_SCROLLABLE);
-  lv_imgbtn_set_src(btn, LV_IMGBTN_STATE_RELEASED, NULL, btn_img, NULL);
+  AssetCache::get_instance()->set_imgbtn_src(btn, btn_img);
   lv_obj_set_width(btn, LV_SIZE_CONTENT);
   lv_obj_align(btn, LV_ALIGN_TOP_MID, 0, 0);
 
@@ -81,7 +82,7 @@ void ButtonContainer::hide() {
 }
 
 void ButtonContainer::set_image(const void *img) {
-  lv_imgbtn_set_src(btn, LV_IMGBTN_STATE_RELEASED, NULL, img, NULL);
+  AssetCache::get_instance()->set_imgbtn_src(btn, img);
 }
 
 void ButtonContainer::handle_callback(lv_event_t *e) {
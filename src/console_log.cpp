@@ -0,0 +1,81 @@
+#include "console_log.h"
+
+#include <algorithm>
+
+ConsoleLog::ConsoleLog(size_t capacity)
+  : lines(std::max<size_t>(capacity, 1))
+  , head(0)
+  , count(0)
+  , pushed(0)
+{
+}
+
+int32_t ConsoleLog::push(const std::string &text, int32_t height) {
+  int64_t top = 0;
+  if (count > 0) {
+    const Line &last = at(count - 1);
+    top = last.top + last.height;
+  }
+
+  int32_t dropped = 0;
+  size_t slot;
+  if (count < lines.size()) {
+    slot = (head + count) % lines.size();
+    count++;
+  } else {
+    slot = head;
+    dropped = lines[slot].height;
+    head = (head + 1) % lines.size();
+  }
+
+  Line &l = lines[slot];
+  l.text.assign(text);
+  l.height = height;
+  l.top = top;
+  l.seq = pushed++;
+  return dropped;
+}
+
+void ConsoleLog::clear() {
+  head = 0;
+  count = 0;
+}
+
+int64_t ConsoleLog::height() const {
+  if (count == 0) {
+    return 0;
+  }
+  const Line &last = at(count - 1);
+  return last.top + last.height - at(0).top;
+}
+
+size_t ConsoleLog::find(int64_t y) const {
+  if (count == 0 || y < 0) {
+    return 0;
+  }
+
+  // first line whose bottom is below y
+  int64_t base = at(0).top;
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const Line &l = at(mid);
+    if (l.top - base + l.height <= y) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void ConsoleLog::measure(const std::function<int32_t(const std::string &)> &fn) {
+  int64_t top = count > 0 ? at(0).top : 0;
+  for (size_t i = 0; i < count; i++) {
+    Line &l = lines[(head + i) % lines.size()];
+    l.height = fn(l.text);
+    l.top = top;
+    top += l.height;
+  }
+}
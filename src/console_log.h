@@ -0,0 +1,52 @@
+#ifndef __CONSOLE_LOG_H__
+#define __CONSOLE_LOG_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Console scrollback as a fixed ring of lines, each with its wrapped
+// height and its top in a running total of every height pushed, so a
+// line's offset from the oldest kept line is a subtraction and the line
+// at a scroll offset a binary search. Pushing into a full ring reuses the
+// oldest slot and its string's storage.
+class ConsoleLog {
+ public:
+  struct Line {
+    std::string text;
+    int32_t height;
+    int64_t top;
+    // count of lines pushed before this one, stable while it is kept
+    uint64_t seq;
+  };
+
+  explicit ConsoleLog(size_t capacity);
+
+  // returns the height dropped off the front to make room, 0 if none
+  int32_t push(const std::string &text, int32_t height);
+  void clear();
+
+  size_t size() const { return count; }
+  size_t capacity() const { return lines.size(); }
+
+  // 0 is the oldest kept line
+  const Line &at(size_t i) const { return lines[(head + i) % lines.size()]; }
+  int64_t offset(size_t i) const { return at(i).top - at(0).top; }
+  int64_t height() const;
+
+  // the line covering offset y, size() if past the end
+  size_t find(int64_t y) const;
+
+  // heights for a new width, O(size)
+  void measure(const std::function<int32_t(const std::string &)> &fn);
+
+ private:
+  std::vector<Line> lines;
+  size_t head;
+  size_t count;
+  uint64_t pushed;
+};
+
+#endif // __CONSOLE_LOG_H__
@@ -1,21 +1,34 @@
 #include "console_panel.h"
+#include "config.h"
 #include "state.h"
 #include "logger.h"
 #include "klipper_temp_filter.h"
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <limits>
 
 LV_IMG_DECLARE(delete_img);
 LV_FONT_DECLARE(dejavusans_mono_14);
 
-ConsolePanel::ConsolePanel(KWebSocketClient &websocket_client, std::mutex &lock, lv_obj_t *parent)
+ConsolePanel::ConsolePanel(KWebSocketClient &websocket_client, LvLock &lock, lv_obj_t *parent)
   : ws(websocket_client)
   , lv_lock(lock)
   , console_cont(lv_obj_create(parent))
   , top_cont(lv_obj_create(console_cont))
-  , output(lv_textarea_create(top_cont))
+  , output(top_cont, Config::get_instance()->get<uint32_t>("/ui/console_scrollback", 2000))
   , delete_btn(top_cont, &delete_img, "", &ConsolePanel::_handle_delete_btn, this)
+  , completion_cont(lv_obj_create(console_cont))
+  , help_label(NULL)
+  , input_cont(lv_obj_create(console_cont))
+  , input(lv_textarea_create(input_cont))
+  , older_btn(lv_btn_create(input_cont))
+  , newer_btn(lv_btn_create(input_cont))
+  , kb(lv_keyboard_create(console_cont))
+  , completer(commands)
+  , history(Config::get_instance()->get<uint32_t>("/ui/console_history", 100))
+  , recalled(-1)
 {
   lv_obj_align(console_cont, LV_ALIGN_CENTER, 0, 0);
   lv_obj_set_size(console_cont, LV_PCT(100), LV_PCT(100));
@@ -27,13 +40,63 @@ ConsolePanel::ConsolePanel(KWebSocketClient &websocket_client, std::mutex &lock,
   lv_obj_set_style_pad_all(top_cont, 0, 0);
   lv_obj_set_width(top_cont, LV_PCT(100));
 
-  lv_obj_set_style_border_width(output, 0, 0);
-  lv_obj_set_size(output, LV_PCT(100), LV_PCT(100));
-  lv_obj_set_style_border_width(output, 0, LV_STATE_FOCUSED | LV_PART_CURSOR);
-
   lv_obj_add_flag(delete_btn.get_container(), LV_OBJ_FLAG_FLOATING);
   lv_obj_align(delete_btn.get_container(), LV_ALIGN_BOTTOM_RIGHT, 10, 10);
 
+  // completions for the command word, tap to take one
+  lv_obj_set_size(completion_cont, LV_PCT(100), LV_SIZE_CONTENT);
+  lv_obj_set_style_pad_all(completion_cont, 2, 0);
+  lv_obj_set_style_pad_column(completion_cont, 4, 0);
+  lv_obj_set_style_border_width(completion_cont, 0, 0);
+  lv_obj_clear_flag(completion_cont, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_set_flex_flow(completion_cont, LV_FLEX_FLOW_ROW);
+  lv_obj_set_flex_align(completion_cont, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+  for (size_t i = 0; i < MAX_SHOWN; i++) {
+    completion_btns[i] = lv_btn_create(completion_cont);
+    lv_obj_set_style_pad_all(completion_btns[i], 6, 0);
+    // taps here keep the input focused and the keyboard up
+    lv_obj_clear_flag(completion_btns[i], LV_OBJ_FLAG_CLICK_FOCUSABLE);
+    lv_label_create(completion_btns[i]);
+    lv_obj_add_event_cb(completion_btns[i], &ConsolePanel::_handle_input, LV_EVENT_CLICKED, this);
+    shown[i] = std::numeric_limits<uint32_t>::max();
+  }
+  help_label = lv_label_create(completion_cont);
+  lv_label_set_long_mode(help_label, LV_LABEL_LONG_DOT);
+  lv_obj_set_flex_grow(help_label, 1);
+  lv_obj_set_style_text_color(help_label, lv_palette_main(LV_PALETTE_GREY), 0);
+  lv_obj_add_flag(completion_cont, LV_OBJ_FLAG_HIDDEN);
+
+  lv_obj_set_size(input_cont, LV_PCT(100), LV_SIZE_CONTENT);
+  lv_obj_set_style_pad_all(input_cont, 2, 0);
+  lv_obj_set_style_pad_column(input_cont, 4, 0);
+  lv_obj_set_style_border_width(input_cont, 0, 0);
+  lv_obj_clear_flag(input_cont, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_set_flex_flow(input_cont, LV_FLEX_FLOW_ROW);
+  lv_obj_set_flex_align(input_cont, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+  lv_textarea_set_one_line(input, true);
+  lv_textarea_set_placeholder_text(input, "G-code");
+  lv_obj_set_flex_grow(input, 1);
+  lv_obj_add_event_cb(input, &ConsolePanel::_handle_input, LV_EVENT_FOCUSED, this);
+  lv_obj_add_event_cb(input, &ConsolePanel::_handle_input, LV_EVENT_DEFOCUSED, this);
+  lv_obj_add_event_cb(input, &ConsolePanel::_handle_input, LV_EVENT_READY, this);
+  lv_obj_add_event_cb(input, &ConsolePanel::_handle_input, LV_EVENT_CANCEL, this);
+  lv_obj_add_event_cb(input, &ConsolePanel::_handle_input, LV_EVENT_VALUE_CHANGED, this);
+
+  lv_obj_clear_flag(older_btn, LV_OBJ_FLAG_CLICK_FOCUSABLE);
+  lv_obj_clear_flag(newer_btn, LV_OBJ_FLAG_CLICK_FOCUSABLE);
+  lv_label_set_text(lv_label_create(older_btn), LV_SYMBOL_UP);
+  lv_label_set_text(lv_label_create(newer_btn), LV_SYMBOL_DOWN);
+  lv_obj_add_event_cb(older_btn, &ConsolePanel::_handle_input, LV_EVENT_CLICKED, this);
+  lv_obj_add_event_cb(newer_btn, &ConsolePanel::_handle_input, LV_EVENT_CLICKED, this);
+
+  lv_keyboard_set_mode(kb, LV_KEYBOARD_MODE_TEXT_UPPER);
+  lv_keyboard_set_textarea(kb, input);
+  lv_obj_set_width(kb, LV_PCT(100));
+  lv_obj_add_flag(kb, LV_OBJ_FLAG_HIDDEN);
+
+  history.load(Config::get_instance()->get<std::string>("/ui/console_history_path", ""));
+
   ws.register_method_callback("notify_gcode_response",
 			      "ConsolePanel",
 			      [this](json& d) { this->handle_macro_response(d); });
@@ -50,65 +113,172 @@ lv_obj_t *ConsolePanel::get_container() {
   return console_cont;
 }
 
-// thanks Chad
-void ta_add_text_limit_lines(lv_obj_t * ta, const std::string &line) {
-  // Always append a newline at the end
-  std::string msg = line + "\n";
-  lv_textarea_add_text(ta, msg.c_str());
-
-  // Get the full text after appending
-  const char * full = lv_textarea_get_text(ta);
-
-  // Count lines
-  int line_count = 0;
-  const char *p = full;
-  while (*p) {
-    if(*p == '\n') {
-      line_count++;
+void ConsolePanel::fetch_commands() {
+  ws.send_jsonrpc("printer.gcode.help", [this](json &d) {
+    auto &cmds = d["/result"_json_pointer];
+    if (!cmds.is_object()) {
+      return;
     }
-    p++;
-  }
-
-  if (p != full && *(p-1) != '\n') {
-    line_count++;
-  }
-
-  // Trim if too many lines
-  if (line_count > 100) {
-    int drop = line_count - 100;
 
-    // Find pointer to first line we want to keep
-    const char * keep = full;
-    while(drop > 0 && *keep) {
-        if(*keep == '\n') drop--;
-        keep++;
+    std::vector<std::string> names;
+    names.reserve(cmds.size());
+    for (auto &el : cmds.items()) {
+      names.push_back(el.key());
     }
+    GcodeTrie trie;
+    trie.build(std::move(names));
 
-    size_t keep_len = strlen(keep);
-    std::string trimmed_text(keep, keep_len);
-    lv_textarea_set_text(ta, trimmed_text.c_str());
-  }
+    std::vector<std::string> descriptions(trie.size());
+    for (auto &el : cmds.items()) {
+      int i = trie.find(el.key());
+      if (i >= 0 && el.value().is_string()) {
+        descriptions[i] = el.value().template get<std::string>();
+      }
+    }
+    LOG_DEBUG("console completions for {} commands", trie.size());
 
-  // Auto-scroll to bottom
-  lv_textarea_set_cursor_pos(ta, LV_TEXTAREA_CURSOR_LAST);
+    LV_LOCK_GUARD(lock, lv_lock);
+    commands = std::move(trie);
+    help = std::move(descriptions);
+    rerank();
+  });
 }
 
 void ConsolePanel::handle_macro_response(json &j) {
   LOG_TRACE("console macro response {}", j.dump());
 
   if (j.contains("params")) {
-    std::lock_guard<std::mutex> lock(lv_lock);
+    LV_LOCK_GUARD(lock, lv_lock);
     for (auto &l : j["params"]) {
-      std::string v = l.template get<std::string>() + "\n";
+      std::string v = l.template get<std::string>();
       if (klipper_is_temp_report(v.c_str())) {
           // Ignore TEMPERATURE_WAIT spam
           return;
       }
-      ta_add_text_limit_lines(output, v);
+
+      // a line per record, responses can span several
+      size_t start = 0;
+      while (start <= v.size()) {
+        size_t end = v.find('\n', start);
+        if (end == std::string::npos) {
+          end = v.size();
+        }
+        if (end > start || end < v.size()) {
+          output.append(v.substr(start, end - start));
+        }
+        start = end + 1;
+      }
     }
   }
 }
 
 void ConsolePanel::handle_delete_btn(lv_event_t *e) {
-  lv_textarea_set_text(output, "");
+  output.clear();
+}
+
+void ConsolePanel::handle_input(lv_event_t *e) {
+  const lv_event_code_t code = lv_event_get_code(e);
+  lv_obj_t *target = lv_event_get_current_target(e);
+
+  if (target == older_btn) {
+    recall(1);
+  } else if (target == newer_btn) {
+    recall(-1);
+  } else if (target != input) {
+    // a completion, the command and a space for its arguments
+    for (size_t i = 0; i < MAX_SHOWN; i++) {
+      if (target == completion_btns[i] && shown[i] < commands.size()) {
+        lv_textarea_set_text(input, (commands.name(shown[i]) + " ").c_str());
+      }
+    }
+  } else if (code == LV_EVENT_FOCUSED) {
+    lv_obj_clear_flag(kb, LV_OBJ_FLAG_HIDDEN);
+  } else if (code == LV_EVENT_DEFOCUSED || code == LV_EVENT_CANCEL) {
+    lv_obj_add_flag(kb, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clear_state(input, LV_STATE_FOCUSED);
+  } else if (code == LV_EVENT_READY) {
+    send();
+  } else if (code == LV_EVENT_VALUE_CHANGED) {
+    update_completions();
+  }
+}
+
+void ConsolePanel::send() {
+  std::string cmd = lv_textarea_get_text(input);
+  cmd.erase(0, cmd.find_first_not_of(' '));
+  cmd.erase(cmd.find_last_not_of(' ') + 1);
+  if (cmd.empty()) {
+    return;
+  }
+
+  output.append("$ " + cmd);
+  ws.gcode_script(cmd);
+  history.push(cmd);
+  rerank();
+
+  recalled = -1;
+  lv_textarea_set_text(input, "");
+}
+
+void ConsolePanel::recall(int dir) {
+  int next = recalled + dir;
+  if (next < -1 || next >= static_cast<int>(history.size())) {
+    return;
+  }
+  recalled = next;
+  lv_textarea_set_text(input, recalled < 0 ? "" : history.at(recalled).c_str());
+}
+
+// commands used lately first, the more recent and often the higher
+void ConsolePanel::rerank() {
+  std::vector<uint32_t> weights(commands.size());
+  for (size_t i = 0; i < history.size(); i++) {
+    const std::string &cmd = history.at(i);
+    int idx = commands.find(cmd.substr(0, cmd.find(' ')));
+    if (idx >= 0) {
+      weights[idx] += history.size() - i;
+    }
+  }
+  commands.rank(weights);
+
+  completer.reset();
+  for (auto &s : shown) {
+    s = std::numeric_limits<uint32_t>::max();
+  }
+  update_completions();
+}
+
+void ConsolePanel::update_completions() {
+  const char *text = lv_textarea_get_text(input);
+  completer.update(text);
+
+  // only while the command word is typed
+  size_t n = 0;
+  const uint32_t *found = NULL;
+  if (text[0] != '\0' && strchr(text, ' ') == NULL) {
+    found = completer.completions(n);
+  }
+
+  if (n == 0) {
+    lv_obj_add_flag(completion_cont, LV_OBJ_FLAG_HIDDEN);
+    return;
+  }
+
+  for (size_t i = 0; i < MAX_SHOWN; i++) {
+    lv_obj_t *btn = completion_btns[i];
+    if (i >= n) {
+      lv_obj_add_flag(btn, LV_OBJ_FLAG_HIDDEN);
+      shown[i] = std::numeric_limits<uint32_t>::max();
+      continue;
+    }
+    if (shown[i] != found[i]) {
+      lv_label_set_text(lv_obj_get_child(btn, 0), commands.name(found[i]).c_str());
+      if (i == 0) {
+        lv_label_set_text(help_label, found[0] < help.size() ? help[found[0]].c_str() : "");
+      }
+      shown[i] = found[i];
+    }
+    lv_obj_clear_flag(btn, LV_OBJ_FLAG_HIDDEN);
+  }
+  lv_obj_clear_flag(completion_cont, LV_OBJ_FLAG_HIDDEN);
 }
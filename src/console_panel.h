@@ -2,34 +2,71 @@
 #define __CONSOLE_PANEL_H__
 
 #include "button_container.h"
+#include "console_view.h"
+#include "gcode_history.h"
+#include "gcode_trie.h"
 #include "websocket_client.h"
 #include "lvgl/lvgl.h"
 
-#include <mutex>
-#include <list>
+#include "lv_lock.h"
+
+#include <string>
+#include <vector>
 
 class ConsolePanel {
  public:
-  ConsolePanel(KWebSocketClient &ws, std::mutex &lock, lv_obj_t *parent);
+  ConsolePanel(KWebSocketClient &ws, LvLock &lock, lv_obj_t *parent);
   ~ConsolePanel();
 
   lv_obj_t *get_container();
   void foreground();
+  // printer.gcode.help, once per connection
+  void fetch_commands();
   void handle_macro_response(json &d);
   void handle_delete_btn(lv_event_t *event);
+  void handle_input(lv_event_t *event);
 
   static void _handle_delete_btn(lv_event_t *event) {
     ConsolePanel *panel = (ConsolePanel*)event->user_data;
     panel->handle_delete_btn(event);
   };
 
+  static void _handle_input(lv_event_t *event) {
+    ConsolePanel *panel = (ConsolePanel*)event->user_data;
+    panel->handle_input(event);
+  };
+
  private:
+  static const size_t MAX_SHOWN = 4;
+
+  void send();
+  void recall(int dir);
+  void rerank();
+  void update_completions();
+
   KWebSocketClient &ws;
-  std::mutex &lv_lock;
+  LvLock &lv_lock;
   lv_obj_t *console_cont;
   lv_obj_t *top_cont;
-  lv_obj_t *output;
+  ConsoleView output;
   ButtonContainer delete_btn;
+  lv_obj_t *completion_cont;
+  lv_obj_t *completion_btns[MAX_SHOWN];
+  lv_obj_t *help_label;
+  lv_obj_t *input_cont;
+  lv_obj_t *input;
+  lv_obj_t *older_btn;
+  lv_obj_t *newer_btn;
+  lv_obj_t *kb;
+
+  GcodeTrie commands;
+  // printer.gcode.help descriptions, by command index
+  std::vector<std::string> help;
+  GcodeCompleter completer;
+  uint32_t shown[MAX_SHOWN];
+  GcodeHistory history;
+  // history entry in the input, -1 when typing
+  int recalled;
 };
 
 #endif // __CONSOLE_PANEL_H__
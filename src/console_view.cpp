@@ -0,0 +1,162 @@
+#include "console_view.h"
+
+#include <algorithm>
+#include <limits>
+
+ConsoleView::ConsoleView(lv_obj_t *parent, size_t capacity)
+  : cont(lv_obj_create(parent))
+  , spacer(lv_obj_create(cont))
+  , timer(lv_timer_create(&ConsoleView::layout_cb, LV_DISP_DEF_REFR_PERIOD, this))
+  , log(capacity)
+  , width(0)
+  , line_height(0)
+  , dirty(false)
+  , appending(false)
+{
+  lv_obj_set_size(cont, LV_PCT(100), LV_PCT(100));
+  lv_obj_set_style_border_width(cont, 0, 0);
+  lv_obj_set_scroll_dir(cont, LV_DIR_VER);
+
+  lv_obj_remove_style_all(spacer);
+  lv_obj_clear_flag(spacer, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_set_size(spacer, 1, 0);
+
+  lv_obj_add_event_cb(cont, &ConsoleView::_handle_event, LV_EVENT_SIZE_CHANGED, this);
+  lv_obj_add_event_cb(cont, &ConsoleView::_handle_event, LV_EVENT_SCROLL, this);
+}
+
+ConsoleView::~ConsoleView() {
+  lv_timer_del(timer);
+}
+
+lv_obj_t *ConsoleView::get_container() {
+  return cont;
+}
+
+void ConsoleView::append(const std::string &line) {
+  lv_coord_t view = lv_obj_get_content_height(cont);
+  lv_coord_t y = lv_obj_get_scroll_y(cont);
+  // following the tail unless scrolled back
+  bool follow = y + view >= log.height() - 1;
+
+  int32_t dropped = log.push(line, measure(line));
+  lv_obj_set_height(spacer, log.height());
+
+  appending = true;
+  if (follow) {
+    lv_obj_scroll_to_y(cont, std::max<int64_t>(log.height() - view, 0), LV_ANIM_OFF);
+  } else if (dropped > 0) {
+    // keep what is in view still as the oldest lines go
+    lv_obj_scroll_to_y(cont, std::max(y - dropped, 0), LV_ANIM_OFF);
+  }
+  appending = false;
+  dirty = true;
+}
+
+void ConsoleView::clear() {
+  log.clear();
+  lv_obj_set_height(spacer, 0);
+  lv_obj_scroll_to_y(cont, 0, LV_ANIM_OFF);
+  dirty = true;
+}
+
+void ConsoleView::layout_cb(lv_timer_t *timer) {
+  ConsoleView *view = static_cast<ConsoleView *>(timer->user_data);
+  if (view->dirty) {
+    view->layout();
+  }
+}
+
+void ConsoleView::handle_event(lv_event_t *e) {
+  lv_event_code_t code = lv_event_get_code(e);
+  if (code == LV_EVENT_SIZE_CHANGED) {
+    resize();
+  } else if (code == LV_EVENT_SCROLL && !appending) {
+    layout();
+  }
+}
+
+int32_t ConsoleView::measure(const std::string &text) const {
+  const lv_font_t *font = lv_obj_get_style_text_font(cont, LV_PART_MAIN);
+  int32_t min = lv_font_get_line_height(font);
+  if (width <= 0) {
+    return min;
+  }
+
+  lv_point_t size;
+  lv_txt_get_size(&size, text.c_str(), font,
+                  lv_obj_get_style_text_letter_space(cont, LV_PART_MAIN),
+                  lv_obj_get_style_text_line_space(cont, LV_PART_MAIN),
+                  width, LV_TEXT_FLAG_NONE);
+  return std::max<int32_t>(size.y, min);
+}
+
+void ConsoleView::resize() {
+  lv_coord_t w = lv_obj_get_content_width(cont);
+  if (w != width) {
+    // wrapping changed, every height with it
+    width = w;
+    log.measure([this](const std::string &text) { return measure(text); });
+    lv_obj_set_height(spacer, log.height());
+    for (auto &s : slots) {
+      lv_obj_set_width(s.label, width);
+    }
+  }
+
+  // enough labels for a viewport of single lines, and one cut at each edge
+  line_height = std::max<lv_coord_t>(lv_font_get_line_height(lv_obj_get_style_text_font(cont, LV_PART_MAIN)), 1);
+  size_t want = lv_obj_get_height(cont) / line_height + 2;
+  if (want > slots.size()) {
+    while (slots.size() < want) {
+      lv_obj_t *label = lv_label_create(cont);
+      lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
+      lv_obj_set_width(label, width);
+      lv_obj_add_flag(label, LV_OBJ_FLAG_HIDDEN);
+      slots.push_back({label, 0, false});
+    }
+    // lines map to labels by seq modulo the pool
+    for (auto &s : slots) {
+      s.seq = std::numeric_limits<uint64_t>::max();
+    }
+  }
+
+  layout();
+}
+
+void ConsoleView::layout() {
+  dirty = false;
+  if (slots.empty()) {
+    return;
+  }
+
+  // children also show through the padding
+  lv_coord_t top = lv_obj_get_scroll_y(cont) - lv_obj_get_style_pad_top(cont, LV_PART_MAIN);
+  lv_coord_t bottom = top + lv_obj_get_height(cont);
+
+  for (auto &s : slots) {
+    s.used = false;
+  }
+  for (size_t i = log.find(top); i < log.size() && log.offset(i) < bottom; i++) {
+    const ConsoleLog::Line &l = log.at(i);
+    Slot &s = slots[l.seq % slots.size()];
+    if (s.used) {
+      // more lines in view than labels, only after a shrink of the font
+      break;
+    }
+    if (s.seq != l.seq) {
+      lv_label_set_text(s.label, l.text.c_str());
+      s.seq = l.seq;
+    }
+    lv_obj_set_y(s.label, log.offset(i));
+    s.used = true;
+  }
+
+  for (auto &s : slots) {
+    bool hidden = lv_obj_has_flag(s.label, LV_OBJ_FLAG_HIDDEN);
+    if (s.used && hidden) {
+      lv_obj_clear_flag(s.label, LV_OBJ_FLAG_HIDDEN);
+    } else if (!s.used && !hidden) {
+      lv_obj_add_flag(s.label, LV_OBJ_FLAG_HIDDEN);
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef __CONSOLE_VIEW_H__
+#define __CONSOLE_VIEW_H__
+
+#include "console_log.h"
+#include "lvgl/lvgl.h"
+
+#include <string>
+#include <vector>
+
+// Scrollback for the console. Lines are kept in a ConsoleLog and only the
+// ones in view get a label, from a pool sized to the viewport. A spacer
+// as tall as the whole log gives the container its scroll range. A line
+// keeps its label while it stays in view, so an append sets the text of
+// the new line only, and a scroll sets the lines scrolled in.
+//
+// Everything here runs with lv_lock held.
+class ConsoleView {
+ public:
+  ConsoleView(lv_obj_t *parent, size_t capacity);
+  ~ConsoleView();
+
+  lv_obj_t *get_container();
+
+  // a line without its newline
+  void append(const std::string &line);
+  void clear();
+
+  static void _handle_event(lv_event_t *e) {
+    static_cast<ConsoleView *>(e->user_data)->handle_event(e);
+  }
+
+ private:
+  struct Slot {
+    lv_obj_t *label;
+    uint64_t seq;
+    bool used;
+  };
+
+  static void layout_cb(lv_timer_t *timer);
+  void handle_event(lv_event_t *e);
+  void resize();
+  void layout();
+  int32_t measure(const std::string &text) const;
+
+  lv_obj_t *cont;
+  lv_obj_t *spacer;
+  lv_timer_t *timer;
+  ConsoleLog log;
+  std::vector<Slot> slots;
+  lv_coord_t width;
+  lv_coord_t line_height;
+  bool dirty;
+  // our own scrolls while appending leave the layout to the timer
+  bool appending;
+};
+
+#endif // __CONSOLE_VIEW_H__
@@ -0,0 +1,77 @@
+#include "dithered_png.h"
+#include "asset_cache.h"
+#include "lvgl/lvgl.h"
+
+#if LV_COLOR_DEPTH == 16
+#include "lvgl/src/extra/libs/png/lodepng.h"
+
+#include <cstring>
+
+namespace {
+  bool is_png_file(const void *src) {
+    return lv_img_src_get_type(src) == LV_IMG_SRC_FILE
+      && strcmp(lv_fs_get_ext(static_cast<const char *>(src)), "png") == 0;
+  }
+
+  lv_res_t info_cb(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header) {
+    if (!is_png_file(src)) {
+      return LV_RES_INV;
+    }
+
+    // signature, IHDR length and type, then big endian width and height
+    lv_fs_file_t f;
+    if (lv_fs_open(&f, static_cast<const char *>(src), LV_FS_MODE_RD) != LV_FS_RES_OK) {
+      return LV_RES_INV;
+    }
+    uint8_t buf[24];
+    uint32_t read = 0;
+    lv_fs_read(&f, buf, sizeof(buf), &read);
+    lv_fs_close(&f);
+
+    static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if (read != sizeof(buf) || memcmp(buf, SIGNATURE, sizeof(SIGNATURE)) != 0) {
+      return LV_RES_INV;
+    }
+
+    header->always_zero = 0;
+    header->cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    header->w = (buf[16] << 24) | (buf[17] << 16) | (buf[18] << 8) | buf[19];
+    header->h = (buf[20] << 24) | (buf[21] << 16) | (buf[22] << 8) | buf[23];
+    return LV_RES_OK;
+  }
+
+  lv_res_t open_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+    if (!is_png_file(dsc->src)) {
+      return LV_RES_INV;
+    }
+
+    unsigned char *data = NULL;
+    unsigned w = 0;
+    unsigned h = 0;
+    if (lodepng_decode32_file(&data, &w, &h, static_cast<const char *>(dsc->src)) != 0) {
+      lv_mem_free(data);
+      return LV_RES_INV;
+    }
+
+    // rgba to rgb565 + alpha in place
+    asset_convert_rgba(data, w, h, asset_native_pixels(), data);
+    dsc->img_data = data;
+    return LV_RES_OK;
+  }
+
+  void close_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+    lv_mem_free(const_cast<uint8_t *>(dsc->img_data));
+    dsc->img_data = NULL;
+  }
+}
+
+void dithered_png_init() {
+  lv_img_decoder_t *decoder = lv_img_decoder_create();
+  lv_img_decoder_set_info_cb(decoder, info_cb);
+  lv_img_decoder_set_open_cb(decoder, open_cb);
+  lv_img_decoder_set_close_cb(decoder, close_cb);
+}
+#else
+void dithered_png_init() {
+}
+#endif
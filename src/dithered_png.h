@@ -0,0 +1,9 @@
+#ifndef __DITHERED_PNG_H__
+#define __DITHERED_PNG_H__
+
+// At LV_COLOR_DEPTH 16, a PNG file decoder tried before lv_png's that
+// orders dithers to RGB565 instead of truncating, so thumbnails don't
+// band. Does nothing at 32 bit. Call after lv_png_init().
+void dithered_png_init();
+
+#endif // __DITHERED_PNG_H__
@@ -1,18 +1,25 @@
 #include "exclude_object_panel.h"
 
 #include "logger.h"
+#include "panel_manager.h"
 #include "simple_dialog.h"
 #include "state.h"
+#include "lvgl/src/core/lv_refr.h"
+#include "lvgl/src/draw/sw/lv_draw_sw.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <sstream>
+#include <unordered_set>
 
 LV_IMG_DECLARE(back);
 
 namespace {
   static const lv_coord_t MARGIN = 12;
+  // how far the outline, marker and number of an object reach past its box
+  static const lv_coord_t DRAW_PAD = 16;
+  static const lv_coord_t MARKER_DIAMETER = 24;
 
   lv_coord_t calc_canvas_dim() {
     lv_coord_t screen_w = lv_disp_get_physical_hor_res(NULL);
@@ -46,61 +53,86 @@ namespace {
     return false;
   }
 
-  bool parse_scalar(const json &v, double &out) {
-    if (v.is_number()) {
-      out = v.template get<double>();
-      return true;
+  // lv_canvas_draw_* clipped to an area, so part of the canvas can be
+  // repainted without blending what is around it twice. The fake display
+  // lv_canvas.c sets up for every call, set up once per paint
+  class CanvasPainter {
+   public:
+    CanvasPainter(lv_obj_t *c, const lv_area_t &area)
+      : canvas(c)
+      , clip(area)
+    {
+      lv_img_dsc_t *img = lv_canvas_get_img(canvas);
+      buf_area.x1 = 0;
+      buf_area.y1 = 0;
+      buf_area.x2 = img->header.w - 1;
+      buf_area.y2 = img->header.h - 1;
+      _lv_area_intersect(&clip, &clip, &buf_area);
+
+      lv_memset_00(&disp, sizeof(disp));
+      lv_disp_drv_init(&drv);
+      drv.hor_res = img->header.w;
+      drv.ver_res = img->header.h;
+      disp.driver = &drv;
+      lv_draw_sw_init_ctx(&drv, &ctx.base_draw);
+      drv.draw_ctx = &ctx.base_draw;
+      ctx.base_draw.clip_area = &clip;
+      ctx.base_draw.buf_area = &buf_area;
+      ctx.base_draw.buf = const_cast<uint8_t *>(img->data);
+
+      refr_ori = _lv_refr_get_disp_refreshing();
+      _lv_refr_set_disp_refreshing(&disp);
     }
 
-    if (v.is_string()) {
-      try {
-        out = std::stod(v.template get<std::string>());
-        return true;
-      } catch (...) {
-        return false;
-      }
+    ~CanvasPainter() {
+      _lv_refr_set_disp_refreshing(refr_ori);
+      lv_draw_sw_deinit_ctx(&drv, &ctx.base_draw);
+
+      lv_area_t coords;
+      lv_obj_get_coords(canvas, &coords);
+      lv_area_move(&clip, coords.x1, coords.y1);
+      lv_obj_invalidate_area(canvas, &clip);
     }
 
-    return false;
-  }
+    const lv_area_t &get_clip() const { return clip; }
 
-  bool point_in_polygon(lv_coord_t x, lv_coord_t y, const std::vector<lv_point_t> &poly) {
-    if (poly.size() < 3) {
-      return false;
+    void rect(lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h, const lv_draw_rect_dsc_t &dsc) {
+      lv_area_t coords = {x, y, static_cast<lv_coord_t>(x + w - 1), static_cast<lv_coord_t>(y + h - 1)};
+      lv_draw_rect(&ctx.base_draw, &dsc, &coords);
     }
 
-    bool inside = false;
-    size_t j = poly.size() - 1;
-    for (size_t i = 0; i < poly.size(); j = i++) {
-      const lv_point_t &pi = poly[i];
-      const lv_point_t &pj = poly[j];
-      if ((pi.y > y) != (pj.y > y)) {
-        double x_intersect = static_cast<double>(pj.x - pi.x)
-          * static_cast<double>(y - pi.y)
-          / static_cast<double>(pj.y - pi.y)
-          + static_cast<double>(pi.x);
-        if (static_cast<double>(x) < x_intersect) {
-          inside = !inside;
-        }
-      }
+    void line(const lv_point_t &p1, const lv_point_t &p2, const lv_draw_line_dsc_t &dsc) {
+      lv_draw_line(&ctx.base_draw, &dsc, &p1, &p2);
     }
 
-    return inside;
-  }
+    void text(lv_coord_t x, lv_coord_t y, lv_coord_t max_w, const lv_draw_label_dsc_t &dsc, const char *txt) {
+      lv_area_t coords = {x, y, static_cast<lv_coord_t>(x + max_w - 1), buf_area.y2};
+      lv_draw_label(&ctx.base_draw, &dsc, &coords, txt, NULL);
+    }
+
+   private:
+    lv_obj_t *canvas;
+    lv_area_t clip;
+    lv_area_t buf_area;
+    lv_disp_t disp;
+    lv_disp_drv_t drv;
+    lv_draw_sw_ctx_t ctx;
+    lv_disp_t *refr_ori;
+  };
 } // namespace
 
-ExcludeObjectPanel::ExcludeObjectPanel(KWebSocketClient &websocket_client, std::mutex &l)
+ExcludeObjectPanel::ExcludeObjectPanel(KWebSocketClient &websocket_client, LvLock &l)
   : NotifyConsumer(l)
   , ws(websocket_client)
-  , panel_cont(lv_obj_create(lv_scr_act()))
+  , panel_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , canvas(lv_canvas_create(panel_cont))
   , canvas_dim(calc_canvas_dim())
   , canvas_buf(static_cast<lv_color_t *>(malloc(LV_CANVAS_BUF_SIZE_TRUE_COLOR(canvas_dim, canvas_dim))))
   , info_cont(lv_obj_create(panel_cont))
   , status_label(lv_label_create(info_cont))
   , back_btn(info_cont, &back, "Back", &ExcludeObjectPanel::_handle_callback, this)
+  , marker(canvas, canvas_dim, MARGIN)
 {
-  lv_obj_move_background(panel_cont);
   lv_obj_clear_flag(panel_cont, LV_OBJ_FLAG_SCROLLABLE);
   lv_obj_set_size(panel_cont, LV_PCT(100), LV_PCT(100));
   lv_obj_set_style_pad_all(panel_cont, 6, 0);
@@ -155,134 +187,140 @@ ExcludeObjectPanel::~ExcludeObjectPanel() {
 
 void ExcludeObjectPanel::foreground() {
   is_foreground = true;
-  load_bed_bounds();
+  // the list may have been replaced by a query while hidden
+  objects_stale = true;
+  bed.load();
+  marker.sync(bed);
   redraw();
-  lv_obj_move_foreground(panel_cont);
+  PanelManager::get_instance()->show(panel_cont);
 }
 
 void ExcludeObjectPanel::consume(json &j) {
-  auto pstate = j["/params/0/print_stats/state"_json_pointer];
-  if (!pstate.is_null()) {
-    std::string print_status = pstate.template get<std::string>();
+  {
+    LV_LOCK_GUARD(lock, lv_lock);
+    marker.consume(j);
+  }
+
+  const json *status = StatusUpdate::status(j);
+  const json *pstate = StatusUpdate::field(status, "print_stats", "state");
+  if (pstate != NULL) {
+    const std::string &print_status = pstate->template get_ref<const std::string &>();
     if (print_status != "printing" && print_status != "paused") {
-      std::lock_guard<std::mutex> lock(lv_lock);
+      LV_LOCK_GUARD(lock, lv_lock);
       is_foreground = false;
       pending_name.clear();
       confirm_mbox = nullptr;
-      lv_obj_move_background(panel_cont);
+      PanelManager::get_instance()->hide(panel_cont);
       return;
     }
   }
 
-  auto eo = j["/params/0/exclude_object"_json_pointer];
-  if (eo.is_null() || !is_foreground) {
+  if (status == NULL || status->find("exclude_object") == status->end()) {
     return;
   }
 
-  std::lock_guard<std::mutex> lock(lv_lock);
-  redraw();
-}
-
-void ExcludeObjectPanel::load_bed_bounds() {
-  auto s = State::get_instance();
-  auto stepper_x_max = s->get_data("/printer_state/configfile/config/stepper_x/position_max"_json_pointer);
-  auto stepper_y_max = s->get_data("/printer_state/configfile/config/stepper_y/position_max"_json_pointer);
-  double max_x = 0.0;
-  double max_y = 0.0;
-  if (parse_scalar(stepper_x_max, max_x) && parse_scalar(stepper_y_max, max_y)) {
-    bed_min_x = 0.0;
-    bed_min_y = 0.0;
-    bed_max_x = max_x;
-    bed_max_y = max_y;
+  LV_LOCK_GUARD(lock, lv_lock);
+  if (StatusUpdate::field(status, "exclude_object", "objects") != NULL) {
+    objects_stale = true;
   }
 
-  if (bed_max_x - bed_min_x < 1.0) {
-    bed_min_x = 0.0;
-    bed_max_x = 220.0;
-  }
-
-  if (bed_max_y - bed_min_y < 1.0) {
-    bed_min_y = 0.0;
-    bed_max_y = 220.0;
+  if (is_foreground) {
+    redraw();
   }
 }
 
 lv_point_t ExcludeObjectPanel::to_px(double mx, double my) {
-  double bw = bed_max_x - bed_min_x;
-  double bh = bed_max_y - bed_min_y;
-  double avail = canvas_dim - 2 * MARGIN;
-  double scale = avail / std::max(bw, bh);
-  double ox = MARGIN + (avail - bw * scale) / 2.0;
-  double oy = MARGIN + (avail - bh * scale) / 2.0;
-
-  lv_point_t p;
-  p.x = static_cast<lv_coord_t>(std::lround(ox + (mx - bed_min_x) * scale));
-  p.y = static_cast<lv_coord_t>(std::lround(canvas_dim - oy - (my - bed_min_y) * scale));
-  return p;
+  return bed.to_px(mx, my, canvas_dim, MARGIN);
 }
 
 void ExcludeObjectPanel::redraw() {
-  obj_boxes.clear();
-  lv_canvas_fill_bg(canvas, lv_color_make(30, 30, 30), LV_OPA_COVER);
-
-  lv_point_t bl = to_px(bed_min_x, bed_min_y);
-  lv_point_t tr = to_px(bed_max_x, bed_max_y);
+  auto s = State::get_instance();
+  const json &objs = s->get_data("/printer_state/exclude_object/objects"_json_pointer);
+  const json &excluded = s->get_data("/printer_state/exclude_object/excluded_objects"_json_pointer);
+  const json &current = s->get_data("/printer_state/exclude_object/current_object"_json_pointer);
+  static const std::string no_object;
+  const std::string &current_name = current.is_string()
+    ? current.template get_ref<const std::string &>() : no_object;
+
+  std::unordered_set<std::string> excluded_names;
+  if (excluded.is_array()) {
+    for (auto &e : excluded) {
+      if (e.is_string()) {
+        excluded_names.insert(e.template get<std::string>());
+      } else if (e.is_object() && e.contains("name") && e["name"].is_string()) {
+        excluded_names.insert(e["name"].template get<std::string>());
+      }
+    }
+  }
 
-  lv_draw_rect_dsc_t bed_dsc;
-  lv_draw_rect_dsc_init(&bed_dsc);
-  bed_dsc.bg_opa = LV_OPA_TRANSP;
-  bed_dsc.border_color = lv_palette_darken(LV_PALETTE_GREY, 2);
-  bed_dsc.border_width = 2;
-  bed_dsc.border_opa = LV_OPA_COVER;
-  lv_canvas_draw_rect(canvas, tr.x, tr.y, bl.x - tr.x, bl.y - tr.y, &bed_dsc);
+  lv_area_t full = {0, 0, static_cast<lv_coord_t>(canvas_dim - 1), static_cast<lv_coord_t>(canvas_dim - 1)};
+  bool rebuilt = objects_stale || bed != drawn_bed;
+  if (rebuilt) {
+    rebuild(objs);
+    drawn_bed = bed;
+    objects_stale = false;
+  }
 
-  auto s = State::get_instance();
-  auto objects = s->get_data("/printer_state/exclude_object/objects"_json_pointer);
-  auto excluded = s->get_data("/printer_state/exclude_object/excluded_objects"_json_pointer);
-  auto current = s->get_data("/printer_state/exclude_object/current_object"_json_pointer);
-  std::string current_name = current.is_string() ? current.template get<std::string>() : "";
-
-  auto is_excluded = [&excluded](const std::string &name) {
-    if (!excluded.is_array()) {
-      return false;
+  if (!objs.is_array() || objs.empty()) {
+    if (rebuilt) {
+      paint(full);
     }
+    lv_label_set_text(status_label, "No excludable objects.\n\nThe gcode must be sliced\nwith object labels.");
+    return;
+  }
 
-    for (auto &e : excluded) {
-      if (e.is_string() && e.template get<std::string>() == name) {
-        return true;
-      }
+  int n_excluded = 0;
+  std::vector<size_t> changed;
+  for (size_t i = 0; i < obj_boxes.size(); i++) {
+    ObjBox &b = obj_boxes[i];
+    bool excl = excluded_names.count(b.name) > 0;
+    bool cur = b.name == current_name;
+    if (excl) {
+      n_excluded++;
+    }
+    if (excl != b.excluded || cur != b.current) {
+      b.excluded = excl;
+      b.current = cur;
+      changed.push_back(i);
+    }
+  }
 
-      if (e.is_object() && e.contains("name") && e["name"] == name) {
-        return true;
+  if (rebuilt) {
+    paint(full);
+  } else {
+    for (size_t i : changed) {
+      const ObjectMap::Box &box = objects.get(i).box;
+      if (box.x1 < box.x0) {
+        continue;
       }
+      paint({static_cast<lv_coord_t>(box.x0 - DRAW_PAD), static_cast<lv_coord_t>(box.y0 - DRAW_PAD),
+             static_cast<lv_coord_t>(box.x1 + DRAW_PAD), static_cast<lv_coord_t>(box.y1 + DRAW_PAD)});
     }
+  }
 
-    return false;
-  };
+  lv_label_set_text(status_label,
+                    fmt::format("#4caf50 Printing now#\n"
+                                "#2196f3 Tap to exclude#\n"
+                                "#b71c1c Excluded#\n\n"
+                                "{} object(s), {} excluded",
+                                static_cast<int>(objs.size()), n_excluded).c_str());
+}
 
-  if (!objects.is_array() || objects.empty()) {
-    lv_label_set_text(status_label, "No excludable objects.\n\nThe gcode must be sliced\nwith object labels.");
+void ExcludeObjectPanel::rebuild(const json &objs) {
+  obj_boxes.clear();
+  if (!objs.is_array()) {
+    objects.clear();
     return;
   }
 
+  // to canvas space once per object list, not on every update
+  std::vector<std::vector<ObjectMap::Point>> polygons;
   int idx = 0;
-  int n_excluded = 0;
-  for (auto &obj : objects) {
+  for (auto &obj : objs) {
     if (!obj.contains("name")) {
       continue;
     }
 
-    std::string name = obj["name"].template get<std::string>();
-    bool excl = is_excluded(name);
-    bool cur = name == current_name;
-    if (excl) {
-      n_excluded++;
-    }
-
-    lv_color_t color = excl ? lv_palette_darken(LV_PALETTE_RED, 2)
-                            : (cur ? lv_palette_main(LV_PALETTE_GREEN)
-                                   : lv_palette_main(LV_PALETTE_BLUE));
-
     std::vector<lv_point_t> pts;
     if (obj.contains("polygon") && obj["polygon"].is_array() && !obj["polygon"].empty()) {
       for (auto &v : obj["polygon"]) {
@@ -305,63 +343,89 @@ void ExcludeObjectPanel::redraw() {
       continue;
     }
 
-    lv_coord_t x0 = pts[0].x;
-    lv_coord_t y0 = pts[0].y;
-    lv_coord_t x1 = pts[0].x;
-    lv_coord_t y1 = pts[0].y;
+    std::vector<ObjectMap::Point> polygon;
+    polygon.reserve(pts.size());
     for (auto &p : pts) {
-      x0 = std::min(x0, p.x);
-      y0 = std::min(y0, p.y);
-      x1 = std::max(x1, p.x);
-      y1 = std::max(y1, p.y);
+      polygon.push_back({static_cast<int16_t>(p.x), static_cast<int16_t>(p.y)});
     }
+    polygons.push_back(std::move(polygon));
+    obj_boxes.push_back({obj["name"].template get<std::string>(), idx + 1, 0, 0, false, false});
+    idx++;
+  }
+
+  objects.build(std::move(polygons), canvas_dim, canvas_dim);
+  for (size_t i = 0; i < obj_boxes.size(); i++) {
+    const ObjectMap::Box &box = objects.get(i).box;
+    obj_boxes[i].cx = (box.x0 + box.x1) / 2;
+    obj_boxes[i].cy = (box.y0 + box.y1) / 2;
+  }
+}
+
+void ExcludeObjectPanel::paint(const lv_area_t &area) {
+  CanvasPainter painter(canvas, area);
+  const lv_area_t &clip = painter.get_clip();
+
+  lv_draw_rect_dsc_t bg_dsc;
+  lv_draw_rect_dsc_init(&bg_dsc);
+  bg_dsc.bg_color = lv_color_make(30, 30, 30);
+  bg_dsc.bg_opa = LV_OPA_COVER;
+  painter.rect(clip.x1, clip.y1, lv_area_get_width(&clip), lv_area_get_height(&clip), bg_dsc);
+
+  lv_point_t bl = to_px(bed.min_x, bed.min_y);
+  lv_point_t tr = to_px(bed.max_x, bed.max_y);
+
+  lv_draw_rect_dsc_t bed_dsc;
+  lv_draw_rect_dsc_init(&bed_dsc);
+  bed_dsc.bg_opa = LV_OPA_TRANSP;
+  bed_dsc.border_color = lv_palette_darken(LV_PALETTE_GREY, 2);
+  bed_dsc.border_width = 2;
+  bed_dsc.border_opa = LV_OPA_COVER;
+  painter.rect(tr.x, tr.y, bl.x - tr.x, bl.y - tr.y, bed_dsc);
+
+  // in list order, so overlapping objects stack as in a full redraw
+  std::vector<size_t> under;
+  objects.query({static_cast<int16_t>(clip.x1 - DRAW_PAD), static_cast<int16_t>(clip.y1 - DRAW_PAD),
+                 static_cast<int16_t>(clip.x2 + DRAW_PAD), static_cast<int16_t>(clip.y2 + DRAW_PAD)}, under);
+  for (size_t i : under) {
+    const ObjBox &b = obj_boxes[i];
+    const ObjectMap::Object &o = objects.get(i);
+    lv_color_t color = b.excluded ? lv_palette_darken(LV_PALETTE_RED, 2)
+                                  : (b.current ? lv_palette_main(LV_PALETTE_GREEN)
+                                               : lv_palette_main(LV_PALETTE_BLUE));
+
     lv_draw_line_dsc_t line;
     lv_draw_line_dsc_init(&line);
     line.color = color;
     line.width = 3;
     line.opa = LV_OPA_COVER;
-    for (size_t i = 0; i < pts.size(); i++) {
-      lv_point_t seg[2] = {pts[i], pts[(i + 1) % pts.size()]};
-      lv_canvas_draw_line(canvas, seg, 2, &line);
+    for (size_t p = 0; p < o.polygon.size(); p++) {
+      const ObjectMap::Point &p1 = o.polygon[p];
+      const ObjectMap::Point &p2 = o.polygon[(p + 1) % o.polygon.size()];
+      painter.line({p1.x, p1.y}, {p2.x, p2.y}, line);
     }
 
-    lv_coord_t cx = (x0 + x1) / 2;
-    lv_coord_t cy = (y0 + y1) / 2;
-    lv_coord_t diameter = 24;
-    lv_coord_t radius = diameter / 2;
-    obj_boxes.push_back({name, idx + 1, x0, y0, x1, y1, cx, cy, radius, excl, pts});
-
+    lv_coord_t radius = MARKER_DIAMETER / 2;
     lv_draw_rect_dsc_t marker;
     lv_draw_rect_dsc_init(&marker);
     marker.bg_color = color;
-    marker.bg_opa = excl ? LV_OPA_30 : LV_OPA_70;
+    marker.bg_opa = b.excluded ? LV_OPA_30 : LV_OPA_70;
     marker.border_color = color;
     marker.border_width = 2;
     marker.border_opa = LV_OPA_COVER;
     marker.radius = LV_RADIUS_CIRCLE;
-    lv_canvas_draw_rect(canvas, cx - radius, cy - radius, diameter, diameter, &marker);
+    painter.rect(b.cx - radius, b.cy - radius, MARKER_DIAMETER, MARKER_DIAMETER, marker);
 
-    if (excl) {
-      lv_point_t d1[2] = {{x0, y0}, {x1, y1}};
-      lv_point_t d2[2] = {{x0, y1}, {x1, y0}};
-      lv_canvas_draw_line(canvas, d1, 2, &line);
-      lv_canvas_draw_line(canvas, d2, 2, &line);
+    if (b.excluded) {
+      painter.line({o.box.x0, o.box.y0}, {o.box.x1, o.box.y1}, line);
+      painter.line({o.box.x0, o.box.y1}, {o.box.x1, o.box.y0}, line);
     }
 
     lv_draw_label_dsc_t lbl;
     lv_draw_label_dsc_init(&lbl);
     lbl.color = lv_color_white();
     lbl.font = &lv_font_montserrat_14;
-    lv_canvas_draw_text(canvas, cx - 6, cy - 8, 20, &lbl, std::to_string(idx + 1).c_str());
-    idx++;
+    painter.text(b.cx - 6, b.cy - 8, 20, lbl, std::to_string(b.number).c_str());
   }
-
-  lv_label_set_text(status_label,
-                    fmt::format("#4caf50 Printing now#\n"
-                                "#2196f3 Tap to exclude#\n"
-                                "#b71c1c Excluded#\n\n"
-                                "{} object(s), {} excluded",
-                                static_cast<int>(objects.size()), n_excluded).c_str());
 }
 
 void ExcludeObjectPanel::handle_canvas_click(lv_event_t *e) {
@@ -383,25 +447,9 @@ void ExcludeObjectPanel::handle_canvas_click(lv_event_t *e) {
   lv_coord_t cx = point.x - coords.x1;
   lv_coord_t cy = point.y - coords.y1;
 
-  const ObjBox *hit = nullptr;
-  long best_area = 0;
-  for (auto &b : obj_boxes) {
-    if (b.excluded) {
-      continue;
-    }
-
-    if (point_in_polygon(cx, cy, b.polygon)) {
-      long area = static_cast<long>(std::max<lv_coord_t>(b.x1 - b.x0, 1))
-        * static_cast<long>(std::max<lv_coord_t>(b.y1 - b.y0, 1));
-      if (hit == nullptr || area < best_area) {
-        hit = &b;
-        best_area = area;
-      }
-    }
-  }
-
-  if (hit != nullptr) {
-    confirm_exclude(*hit);
+  int hit = objects.hit(cx, cy, [this](size_t i) { return !obj_boxes[i].excluded; });
+  if (hit >= 0) {
+    confirm_exclude(obj_boxes[hit]);
   }
 }
 
@@ -453,6 +501,6 @@ void ExcludeObjectPanel::handle_callback(lv_event_t *e) {
   lv_obj_t *btn = lv_event_get_current_target(e);
   if (btn == back_btn.get_container()) {
     is_foreground = false;
-    lv_obj_move_background(panel_cont);
+    PanelManager::get_instance()->hide(panel_cont);
   }
 }
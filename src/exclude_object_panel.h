@@ -1,8 +1,11 @@
 #ifndef __EXCLUDE_OBJECT_PANEL_H__
 #define __EXCLUDE_OBJECT_PANEL_H__
 
+#include "bed_map.h"
 #include "button_container.h"
 #include "notify_consumer.h"
+#include "object_map.h"
+#include "toolhead_marker.h"
 #include "websocket_client.h"
 #include "lvgl/lvgl.h"
 
@@ -11,7 +14,7 @@
 
 class ExcludeObjectPanel : public NotifyConsumer {
  public:
-  ExcludeObjectPanel(KWebSocketClient &ws, std::mutex &l);
+  ExcludeObjectPanel(KWebSocketClient &ws, LvLock &l);
   ~ExcludeObjectPanel();
 
   void foreground();
@@ -29,13 +32,13 @@ class ExcludeObjectPanel : public NotifyConsumer {
   }
 
  private:
+  // geometry lives in objects at the same index
   struct ObjBox {
     std::string name;
     int number;
-    lv_coord_t x0, y0, x1, y1;
-    lv_coord_t cx, cy, radius;
+    lv_coord_t cx, cy;
     bool excluded;
-    std::vector<lv_point_t> polygon;
+    bool current;
   };
 
   KWebSocketClient &ws;
@@ -46,20 +49,24 @@ class ExcludeObjectPanel : public NotifyConsumer {
   lv_obj_t *info_cont;
   lv_obj_t *status_label;
   ButtonContainer back_btn;
+  ToolheadMarker marker;
 
   bool is_foreground = false;
   std::string pending_name;
   lv_obj_t *confirm_mbox = nullptr;
 
-  double bed_min_x = 0.0;
-  double bed_max_x = 220.0;
-  double bed_min_y = 0.0;
-  double bed_max_y = 220.0;
+  BedMap bed;
 
   std::vector<ObjBox> obj_boxes;
+  ObjectMap objects;
+  // set when an update brings a new object list, a redraw without one
+  // only repaints the objects whose state changed
+  bool objects_stale = true;
+  BedMap drawn_bed;
 
-  void load_bed_bounds();
   void redraw();
+  void rebuild(const json &objs);
+  void paint(const lv_area_t &area);
   lv_point_t to_px(double mx, double my);
   void confirm_exclude(const ObjBox &obj);
   void do_exclude();
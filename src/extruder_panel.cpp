@@ -2,6 +2,7 @@
 #include "state.h"
 #include "config.h"
 #include "logger.h"
+#include "panel_manager.h"
 
 #include <algorithm>
 #include <cctype>
@@ -97,12 +98,12 @@ uint32_t resolve_default_idx(const std::string &config_key,
 } // namespace
 
 ExtruderPanel::ExtruderPanel(KWebSocketClient &websocket_client,
-			     std::mutex &lock,
+			     LvLock &lock,
 			     Numpad &numpad,
 			     SpoolmanPanel &sm)
   : NotifyConsumer(lock)
   , ws(websocket_client)
-  , panel_cont(lv_obj_create(lv_scr_act()))
+  , panel_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , spoolman_panel(sm)
   , temp_options(load_selector_options("/ui/extruder_temp_presets", 8))
   , temp_option_map(build_selector_map(temp_options))
@@ -131,7 +132,6 @@ ExtruderPanel::ExtruderPanel(KWebSocketClient &websocket_client,
   , retract_btn(rightside_btns_cont, &retract_img, "Retract", &ExtruderPanel::_handle_callback, this)
   , back_btn(rightside_btns_cont, &back, "Back", &ExtruderPanel::_handle_callback, this)
 {
-  lv_obj_move_background(panel_cont);
   lv_obj_clear_flag(panel_cont, LV_OBJ_FLAG_SCROLLABLE);  
   lv_obj_set_size(panel_cont, LV_PCT(100), LV_PCT(100));
   lv_obj_set_style_pad_all(panel_cont, 0, 0);
@@ -172,14 +172,22 @@ ExtruderPanel::ExtruderPanel(KWebSocketClient &websocket_client,
 }
 
 ExtruderPanel::~ExtruderPanel() {
+  ws.unregister_notify_update(this);
+
+  // the selectors and sensor delete their own containers, the root has to
+  // outlive them
   if (panel_cont != NULL) {
-    lv_obj_del(panel_cont);
+    lv_obj_del_async(panel_cont);
     panel_cont = NULL;
   }
 }
 
+lv_obj_t *ExtruderPanel::get_container() {
+  return panel_cont;
+}
+
 void ExtruderPanel::foreground() {
-  lv_obj_move_foreground(panel_cont);
+  PanelManager::get_instance()->show(panel_cont);
 }
 
 void ExtruderPanel::enable_spoolman() {
@@ -187,23 +195,24 @@ void ExtruderPanel::enable_spoolman() {
 }
 
 void ExtruderPanel::consume(json& j) {
-  std::lock_guard<std::mutex> lock(lv_lock);
-  auto target_value = j["/params/0/extruder/target"_json_pointer];
-  if (!target_value.is_null()) {
-    int target = target_value.template get<int>();
+  LV_LOCK_GUARD(lock, lv_lock);
+  const json *status = StatusUpdate::status(j);
+  const json *target_value = StatusUpdate::field(status, "extruder", "target");
+  if (target_value != NULL) {
+    int target = target_value->template get<int>();
     extruder_temp.update_target(target);
   }
-  
-  auto temp_value = j["/params/0/extruder/temperature"_json_pointer];
-  if (!temp_value.is_null()) {   
-    int value = temp_value.template get<int>();
+
+  const json *temp_value = StatusUpdate::field(status, "extruder", "temperature");
+  if (temp_value != NULL) {
+    int value = temp_value->template get<int>();
     extruder_temp.update_value(value);
   }
 
-  json &pstat_state = j["/params/0/print_stats/state"_json_pointer];
-  if (!pstat_state.is_null()) {
-    if (pstat_state.template get<std::string>() == "printing") {
-      lv_obj_move_background(panel_cont);
+  const json *pstat_state = StatusUpdate::field(status, "print_stats", "state");
+  if (pstat_state != NULL) {
+    if (pstat_state->template get_ref<const std::string &>() == "printing") {
+      PanelManager::get_instance()->hide(panel_cont);
     }
   }
 }
@@ -236,7 +245,7 @@ void ExtruderPanel::handle_callback(lv_event_t *e) {
     lv_obj_t *btn = lv_event_get_current_target(e);
 
     if (btn == back_btn.get_container()) {
-      lv_obj_move_background(panel_cont);
+      PanelManager::get_instance()->hide(panel_cont);
     }
 
     Config *conf = Config::get_instance();
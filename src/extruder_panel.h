@@ -14,9 +14,10 @@
 
 class ExtruderPanel : public NotifyConsumer {
  public:
-  ExtruderPanel(KWebSocketClient &ws, std::mutex &l, Numpad &np, SpoolmanPanel &sm);
+  ExtruderPanel(KWebSocketClient &ws, LvLock &l, Numpad &np, SpoolmanPanel &sm);
   ~ExtruderPanel();
 
+  lv_obj_t *get_container();
   void foreground();
   void enable_spoolman();  
   void consume(json &j);
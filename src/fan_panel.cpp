@@ -2,15 +2,16 @@
 #include "state.h"
 #include "utils.h"
 #include "logger.h"
+#include "panel_manager.h"
 
 LV_IMG_DECLARE(cancel);
 LV_IMG_DECLARE(fan_on);
 LV_IMG_DECLARE(back);
 
-FanPanel::FanPanel(KWebSocketClient &websocket_client, std::mutex &lock)
+FanPanel::FanPanel(KWebSocketClient &websocket_client, LvLock &lock, json &f)
   : NotifyConsumer(lock)
   , ws(websocket_client)
-  , fanpanel_cont(lv_obj_create(lv_scr_act()))
+  , fanpanel_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , fans_cont(lv_obj_create(fanpanel_cont))
   , back_btn(fanpanel_cont, &back, "Back", &FanPanel::_handle_callback, this)
 {
@@ -29,40 +30,47 @@ FanPanel::FanPanel(KWebSocketClient &websocket_client, std::mutex &lock)
   #else
       lv_obj_align(back_btn.get_container(), LV_ALIGN_BOTTOM_RIGHT, 30, -5);
   #endif
+  add_fans(f);
   ws.register_notify_update(this);
 }
 
 FanPanel::~FanPanel() {
+  ws.unregister_notify_update(this);
+
+  // sliders delete their own containers
+  fans.clear();
+
   if (fanpanel_cont != NULL) {
     lv_obj_del(fanpanel_cont);
     fanpanel_cont = NULL;
   }
-
-  fans.clear();
-
-  ws.unregister_notify_update(this);
 }
 
 void FanPanel::consume(json &j) {
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
+  const json *status = StatusUpdate::status(j);
   for (auto &f : fans) {
     // hack for output_pin fans
-    auto fan_value = j[json::json_pointer(fmt::format("/params/0/{}/value", f.first))];
-    if (!fan_value.is_null()) {
-      int v = static_cast<int>(fan_value.template get<double>() * 100);
+    const json *fan_value = StatusUpdate::field(status, f.first, "value");
+    if (fan_value != NULL) {
+      int v = static_cast<int>(fan_value->template get<double>() * 100);
       f.second->update_value(v);
     }
 
-    fan_value = j[json::json_pointer(fmt::format("/params/0/{}/speed", f.first))];
-    if (!fan_value.is_null()) {
-      int v = static_cast<int>(fan_value.template get<double>() * 100);
+    fan_value = StatusUpdate::field(status, f.first, "speed");
+    if (fan_value != NULL) {
+      int v = static_cast<int>(fan_value->template get<double>() * 100);
       f.second->update_value(v);
     }
   }
 }
 
 void FanPanel::create_fans(json &f) {
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
+  add_fans(f);
+}
+
+void FanPanel::add_fans(json &f) {
   fans.clear();
 
   for (auto &fan : f.items()) {
@@ -116,13 +124,13 @@ void FanPanel::foreground() {
   }
   
   lv_obj_move_foreground(back_btn.get_container());
-  lv_obj_move_foreground(fanpanel_cont);
+  PanelManager::get_instance()->show(fanpanel_cont);
 }
 
 void FanPanel::handle_callback(lv_event_t *event) {
   lv_obj_t *btn = lv_event_get_current_target(event);
   if (btn == back_btn.get_container()) {
-    lv_obj_move_background(fanpanel_cont);
+    PanelManager::get_instance()->hide(fanpanel_cont);
   }
   else {
     LOG_DEBUG("Unknown action button pressed");
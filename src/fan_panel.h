@@ -9,11 +9,11 @@
 
 #include <map>
 #include <memory>
-#include <mutex>
+#include "lv_lock.h"
 
 class FanPanel : public NotifyConsumer {
  public:
-  FanPanel(KWebSocketClient &ws, std::mutex &lock);
+  FanPanel(KWebSocketClient &ws, LvLock &lock, json &fans);
   ~FanPanel();
 
   void consume(json &j);
@@ -47,6 +47,7 @@ class FanPanel : public NotifyConsumer {
   };
 
  private:
+  void add_fans(json &f);
 
   KWebSocketClient &ws;
   lv_obj_t *fanpanel_cont;
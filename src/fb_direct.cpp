@@ -0,0 +1,103 @@
+#include "fb_direct.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+FbDirect *FbDirect::get_instance() {
+  static FbDirect instance;
+  return &instance;
+}
+
+FbDirect::FbDirect()
+  : mem(NULL)
+  , mem_size(0)
+  , xres(0)
+  , yres(0)
+  , xoffset(0)
+  , yoffset(0)
+  , line_length(0)
+{
+}
+
+bool FbDirect::open(const char *path) {
+  int fd = ::open(path, O_RDWR);
+  if (fd < 0) {
+    LOG_ERROR("failed to open {} for direct flush", path);
+    return false;
+  }
+
+  struct fb_var_screeninfo vinfo;
+  struct fb_fix_screeninfo finfo;
+  if (ioctl(fd, FBIOGET_FSCREENINFO, &finfo) != 0 || ioctl(fd, FBIOGET_VSCREENINFO, &vinfo) != 0) {
+    close(fd);
+    return false;
+  }
+
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0
+  bool same_layout = vinfo.bits_per_pixel == 16
+    && vinfo.red.offset == 11 && vinfo.green.offset == 5 && vinfo.blue.offset == 0;
+#elif LV_COLOR_DEPTH == 32
+  bool same_layout = vinfo.bits_per_pixel == 32
+    && vinfo.red.offset == 16 && vinfo.green.offset == 8 && vinfo.blue.offset == 0;
+#else
+  bool same_layout = false;
+#endif
+  if (!same_layout) {
+    LOG_INFO("framebuffer is {} bpp, LVGL draws {}, converting on flush",
+             vinfo.bits_per_pixel, LV_COLOR_DEPTH);
+    close(fd);
+    return false;
+  }
+
+  void *m = mmap(NULL, finfo.smem_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // the mapping stays valid without the descriptor
+  close(fd);
+  if (m == MAP_FAILED) {
+    LOG_ERROR("failed to map {} for direct flush", path);
+    return false;
+  }
+
+  mem = static_cast<uint8_t *>(m);
+  mem_size = finfo.smem_len;
+  xres = vinfo.xres;
+  yres = vinfo.yres;
+  xoffset = vinfo.xoffset;
+  yoffset = vinfo.yoffset;
+  line_length = finfo.line_length;
+  LOG_INFO("framebuffer {}x{} {} bpp, flushing directly", xres, yres, vinfo.bits_per_pixel);
+  return true;
+}
+
+void FbDirect::flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p) {
+  FbDirect *fb = get_instance();
+  int32_t x1 = std::max<int32_t>(area->x1, 0);
+  int32_t y1 = std::max<int32_t>(area->y1, 0);
+  int32_t x2 = std::min<int32_t>(area->x2, fb->xres - 1);
+  int32_t y2 = std::min<int32_t>(area->y2, fb->yres - 1);
+  if (x1 > x2 || y1 > y2) {
+    lv_disp_flush_ready(drv);
+    return;
+  }
+
+  size_t src_stride = lv_area_get_width(area);
+  size_t row = (x2 - x1 + 1) * sizeof(lv_color_t);
+  const lv_color_t *src = color_p + (y1 - area->y1) * src_stride + (x1 - area->x1);
+  uint8_t *dst = fb->mem + (y1 + fb->yoffset) * fb->line_length + (x1 + fb->xoffset) * sizeof(lv_color_t);
+
+  if (row == fb->line_length && src_stride * sizeof(lv_color_t) == row) {
+    memcpy(dst, src, row * (y2 - y1 + 1));
+  } else {
+    for (int32_t y = y1; y <= y2; y++) {
+      memcpy(dst, src, row);
+      dst += fb->line_length;
+      src += src_stride;
+    }
+  }
+  lv_disp_flush_ready(drv);
+}
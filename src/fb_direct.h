@@ -0,0 +1,36 @@
+#ifndef __FB_DIRECT_H__
+#define __FB_DIRECT_H__
+
+#include "lvgl/lvgl.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Framebuffer flush that copies LVGL's draw buffer row by row into the
+// mapped framebuffer. Only used when the framebuffer already has LVGL's
+// pixel layout, RGB565 at LV_COLOR_DEPTH 16 or XRGB8888 at 32, anything
+// else goes through lv_drivers' per pixel fbdev_flush.
+class FbDirect {
+ public:
+  static FbDirect *get_instance();
+
+  // false if the framebuffer can't be copied into directly
+  bool open(const char *path);
+
+  static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+
+ private:
+  FbDirect();
+  FbDirect(const FbDirect &) = delete;
+  FbDirect &operator=(const FbDirect &) = delete;
+
+  uint8_t *mem;
+  size_t mem_size;
+  int32_t xres;
+  int32_t yres;
+  uint32_t xoffset;
+  uint32_t yoffset;
+  uint32_t line_length;
+};
+
+#endif // __FB_DIRECT_H__
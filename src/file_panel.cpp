@@ -17,6 +17,7 @@ namespace fs = std::experimental::filesystem;
 FilePanel::FilePanel(lv_obj_t *parent)
   : file_cont(lv_obj_create(parent))
   , thumbnail(lv_img_create(file_cont))
+  , thumbnail_view(thumbnail)
   , fname_label(lv_label_create(file_cont))
   , detail_label(lv_label_create(file_cont))
 {
@@ -74,14 +75,9 @@ void FilePanel::refresh_view(json &j, const std::string &gcode_path) {
   if (fullpath.length() > 0) {
     lv_label_set_text(detail_label, detail.c_str());
     auto screen_width = lv_disp_get_physical_hor_res(NULL);
-    uint32_t normalized_thumb_scale = ((0.29 * (double)screen_width) / (double)thumb_detail.second) * 256;
-    lv_img_set_src(thumbnail, ("A:" + fullpath).c_str());
-    lv_img_set_zoom(thumbnail, normalized_thumb_scale);
+    thumbnail_view.show(fullpath, 0.29 * screen_width);
   } else {
-    // free src
-    lv_img_set_src(thumbnail, NULL);
-    // hack to color in empty space.
-    ((lv_img_t*)thumbnail)->src_type = LV_IMG_SRC_SYMBOL;
+    thumbnail_view.clear();
   }
 }
 
@@ -3,6 +3,7 @@
 
 #include "lvgl/lvgl.h"
 #include "button_container.h"
+#include "thumbnail_service.h"
 #include "hv/json.hpp"
 
 #include <string>
@@ -21,6 +22,7 @@ class FilePanel {
  private:
   lv_obj_t *file_cont;
   lv_obj_t *thumbnail;
+  ThumbnailView thumbnail_view;
   lv_obj_t *fname_label;
   lv_obj_t *detail_label;
 };
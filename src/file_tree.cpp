@@ -0,0 +1,276 @@
+#include "file_tree.h"
+
+#include <algorithm>
+
+FileTree::FileTree() {
+  nodes.push_back({intern(""), NONE, true, false, 0, 0, {}, {}});
+}
+
+void FileTree::unload() {
+  for (auto &n : nodes) {
+    n.loaded = false;
+  }
+}
+
+std::string FileTree::path(Id id) const {
+  std::vector<Id> chain;
+  for (; id != ROOT && id != NONE; id = nodes[id].parent) {
+    chain.push_back(id);
+  }
+
+  std::string p;
+  for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+    if (!p.empty()) {
+      p.push_back('/');
+    }
+    p.append(name(*it));
+  }
+  return p;
+}
+
+FileTree::Id FileTree::find(const std::string &p) const {
+  Id id = ROOT;
+  std::string_view rest(p);
+  while (!rest.empty()) {
+    size_t slash = rest.find('/');
+    std::string_view part = rest.substr(0, slash);
+    rest = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+    if (part.empty()) {
+      continue;
+    }
+    if (!nodes[id].dir || (id = child(id, part)) == NONE) {
+      return NONE;
+    }
+  }
+  return id;
+}
+
+FileTree::Id FileTree::child(Id dir, std::string_view n) const {
+  const std::vector<Id> &kids = nodes[dir].by_name;
+  auto it = std::lower_bound(kids.begin(), kids.end(), n,
+                             [this](Id a, std::string_view b) { return name(a) < b; });
+  return it != kids.end() && name(*it) == n ? *it : NONE;
+}
+
+void FileTree::fill(Id dir, const json &result) {
+  if (dir >= nodes.size() || !nodes[dir].dir) {
+    return;
+  }
+
+  std::vector<uint32_t> seen;
+  auto take = [this, dir, &seen](const json &entries, const char *key, bool is_dir) {
+    if (!entries.is_array()) {
+      return;
+    }
+    for (auto &e : entries) {
+      std::string n = e.value(key, "");
+      // hidden, .thumbs and the like
+      if (n.empty() || n[0] == '.') {
+        continue;
+      }
+      Id id = add(dir, n, is_dir, e.value("modified", 0.0), e.value("size", static_cast<uint64_t>(0)));
+      seen.push_back(nodes[id].name);
+    }
+  };
+  take(result.value("dirs", json::array()), "dirname", true);
+  take(result.value("files", json::array()), "filename", false);
+
+  // whatever the listing no longer has
+  std::sort(seen.begin(), seen.end());
+  std::vector<Id> gone;
+  for (Id c : nodes[dir].by_name) {
+    if (!std::binary_search(seen.begin(), seen.end(), nodes[c].name)) {
+      gone.push_back(c);
+    }
+  }
+  for (Id c : gone) {
+    remove(c);
+  }
+  nodes[dir].loaded = true;
+}
+
+FileTree::Change FileTree::apply(const std::string &action, const json &item, const json &source) {
+  Change change = {NONE, NONE, false};
+  if (action == "root_update") {
+    change.reload = true;
+    return change;
+  }
+
+  // items of other roots are outside the tree, a move out of it is a
+  // delete and a move into it a create
+  bool move = action == "move_file" || action == "move_dir";
+  bool in_tree = item.is_object() && item.value("root", "gcodes") == "gcodes";
+  bool from_tree = move && source.is_object() && source.value("root", "gcodes") == "gcodes";
+  if (!in_tree) {
+    return from_tree ? apply(action == "move_dir" ? "delete_dir" : "delete_file", source, json::object()) : change;
+  }
+
+  std::string p = item.value("path", "");
+  std::string_view leaf;
+  Id parent = parent_of(p, leaf);
+  bool into = parent != NONE && nodes[parent].loaded && !leaf.empty() && leaf[0] != '.';
+  double modified = item.value("modified", 0.0);
+  uint64_t size = item.value("size", static_cast<uint64_t>(0));
+
+  if (action == "create_file" || action == "modify_file") {
+    if (into) {
+      add(parent, leaf, false, modified, size);
+      change.dir = parent;
+    }
+  } else if (action == "create_dir") {
+    if (into) {
+      bool known = child(parent, leaf) != NONE;
+      Id id = add(parent, leaf, true, modified, 0);
+      // a new directory is empty
+      nodes[id].loaded = nodes[id].loaded || !known;
+      change.dir = parent;
+    }
+  } else if (action == "delete_file" || action == "delete_dir") {
+    Id id = find(p);
+    if (id != NONE && id != ROOT) {
+      change.dir = nodes[id].parent;
+      remove(id);
+    }
+  } else if (move) {
+    Id id = from_tree ? find(source.value("path", "")) : NONE;
+    if (id == ROOT) {
+      id = NONE;
+    }
+    if (id != NONE) {
+      change.from = nodes[id].parent;
+    }
+
+    if (into) {
+      Id there = child(parent, leaf);
+      if (there != NONE && there != id) {
+        remove(there);
+      }
+      if (id != NONE) {
+        // the node and anything loaded under it carry over
+        detach(id);
+        nodes[id].name = intern(leaf);
+        if (item.contains("modified")) {
+          nodes[id].modified = modified;
+        }
+        attach(parent, id);
+      } else {
+        add(parent, leaf, action == "move_dir", modified, size);
+      }
+      change.dir = parent;
+    } else if (id != NONE) {
+      remove(id);
+    }
+  }
+  return change;
+}
+
+FileTree::Id FileTree::add(Id dir, std::string_view n, bool is_dir, double modified, uint64_t size) {
+  Id id = child(dir, n);
+  if (id != NONE) {
+    nodes[id].size = size;
+    if (nodes[id].dir != is_dir) {
+      // a file replaced by a directory or the other way round
+      remove(id);
+    } else {
+      if (nodes[id].modified != modified) {
+        detach(id);
+        nodes[id].modified = modified;
+        attach(dir, id);
+      }
+      return id;
+    }
+  }
+
+  uint32_t name_id = intern(n);
+  id = alloc();
+  nodes[id] = {name_id, NONE, is_dir, false, modified, size, {}, {}};
+  attach(dir, id);
+  return id;
+}
+
+void FileTree::remove(Id id) {
+  detach(id);
+  release(id);
+}
+
+void FileTree::release(Id id) {
+  for (Id c : nodes[id].by_name) {
+    release(c);
+  }
+  std::vector<Id>().swap(nodes[id].by_name);
+  std::vector<Id>().swap(nodes[id].by_modified);
+  nodes[id].parent = NONE;
+  free_ids.push_back(id);
+}
+
+void FileTree::attach(Id dir, Id id) {
+  nodes[id].parent = dir;
+
+  std::vector<Id> &names = nodes[dir].by_name;
+  const std::string &n = name(id);
+  names.insert(std::lower_bound(names.begin(), names.end(), n,
+                                [this](Id a, const std::string &b) { return name(a) < b; }), id);
+
+  // newest first, then by name
+  std::vector<Id> &recent = nodes[dir].by_modified;
+  recent.insert(std::lower_bound(recent.begin(), recent.end(), id, [this](Id a, Id b) {
+    if (nodes[a].modified != nodes[b].modified) {
+      return nodes[a].modified > nodes[b].modified;
+    }
+    return name(a) < name(b);
+  }), id);
+}
+
+void FileTree::detach(Id id) {
+  Id dir = nodes[id].parent;
+  if (dir == NONE) {
+    return;
+  }
+
+  std::vector<Id> &names = nodes[dir].by_name;
+  names.erase(std::find(std::lower_bound(names.begin(), names.end(), name(id),
+                                         [this](Id a, const std::string &b) { return name(a) < b; }),
+                        names.end(), id));
+
+  std::vector<Id> &recent = nodes[dir].by_modified;
+  auto at = std::lower_bound(recent.begin(), recent.end(), id, [this](Id a, Id b) {
+    if (nodes[a].modified != nodes[b].modified) {
+      return nodes[a].modified > nodes[b].modified;
+    }
+    return name(a) < name(b);
+  });
+  recent.erase(std::find(at, recent.end(), id));
+  nodes[id].parent = NONE;
+}
+
+FileTree::Id FileTree::alloc() {
+  if (!free_ids.empty()) {
+    Id id = free_ids.back();
+    free_ids.pop_back();
+    return id;
+  }
+  nodes.emplace_back();
+  return nodes.size() - 1;
+}
+
+uint32_t FileTree::intern(std::string_view s) {
+  auto it = interned.find(s);
+  if (it != interned.end()) {
+    return it->second;
+  }
+  storage.emplace_back(s);
+  uint32_t id = strings.size();
+  strings.push_back(&storage.back());
+  interned.emplace(std::string_view(storage.back()), id);
+  return id;
+}
+
+FileTree::Id FileTree::parent_of(const std::string &p, std::string_view &leaf) const {
+  size_t slash = p.rfind('/');
+  if (slash == std::string::npos) {
+    leaf = std::string_view(p);
+    return ROOT;
+  }
+  leaf = std::string_view(p).substr(slash + 1);
+  return find(p.substr(0, slash));
+}
@@ -0,0 +1,93 @@
+#ifndef __FILE_TREE_H__
+#define __FILE_TREE_H__
+
+#include "hv/json.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+// The gcodes root as far as it has been looked at. Directories are
+// filled one at a time from server.files.get_directory and kept up to
+// date by applying notify_filelist_changed items to the directories they
+// touch, so a change costs the size of its directory, not the library.
+//
+// Nodes live in one vector and are addressed by index; freed indexes are
+// reused. Names are interned, a node holds the id of its name. Each
+// directory keeps its children twice, ordered by name for lookups and by
+// modified time, newest first, for listing.
+class FileTree {
+ public:
+  typedef uint32_t Id;
+  static const Id NONE = UINT32_MAX;
+  static const Id ROOT = 0;
+
+  struct Node {
+    uint32_t name;
+    Id parent;
+    bool dir;
+    // a directory whose children are known
+    bool loaded;
+    double modified;
+    uint64_t size;
+    std::vector<Id> by_name;
+    std::vector<Id> by_modified;
+  };
+
+  // what an edit touched, directories whose listing changed
+  struct Change {
+    Id dir;
+    Id from;
+    // an item this tree can't apply, start over
+    bool reload;
+  };
+
+  FileTree();
+
+  // every directory to be listed again, nodes and their ids are kept so
+  // a refill updates them in place
+  void unload();
+
+  const Node &get(Id id) const { return nodes[id]; }
+  const std::string &name(Id id) const { return *strings[nodes[id].name]; }
+  // relative to the root, "" for the root
+  std::string path(Id id) const;
+
+  // NONE if the path isn't known
+  Id find(const std::string &path) const;
+  Id child(Id dir, std::string_view name) const;
+
+  // a get_directory result for dir, children not in it are dropped
+  void fill(Id dir, const json &result);
+  // a notify_filelist_changed item and its source_item, of any root
+  Change apply(const std::string &action, const json &item, const json &source);
+
+  // live nodes
+  size_t size() const { return nodes.size() - free_ids.size(); }
+
+ private:
+  // a child of dir, updated in place if it is there
+  Id add(Id dir, std::string_view name, bool is_dir, double modified, uint64_t size);
+  void remove(Id id);
+  void release(Id id);
+  void attach(Id dir, Id id);
+  void detach(Id id);
+  Id alloc();
+  uint32_t intern(std::string_view s);
+  // the parent directory of a path and the name in it, NONE if unknown
+  Id parent_of(const std::string &path, std::string_view &leaf) const;
+
+  std::vector<Node> nodes;
+  std::vector<Id> free_ids;
+  // names are never dropped, a handful of bytes per distinct name
+  std::deque<std::string> storage;
+  std::vector<const std::string *> strings;
+  std::unordered_map<std::string_view, uint32_t> interned;
+};
+
+#endif // __FILE_TREE_H__
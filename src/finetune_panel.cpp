@@ -1,6 +1,7 @@
 #include "finetune_panel.h"
 #include "state.h"
 #include "logger.h"
+#include "panel_manager.h"
 #include "config.h"
 
 #include <algorithm>
@@ -17,10 +18,10 @@ LV_IMG_DECLARE(flow_up_img);
 LV_IMG_DECLARE(flow_down_img);
 LV_IMG_DECLARE(back);
 
-FineTunePanel::FineTunePanel(KWebSocketClient &websocket_client, std::mutex &l)
+FineTunePanel::FineTunePanel(KWebSocketClient &websocket_client, LvLock &l)
   : NotifyConsumer(l)
   , ws(websocket_client)
-  , panel_cont(lv_obj_create(lv_scr_act()))
+  , panel_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , values_cont(lv_obj_create(panel_cont))
   , zreset_btn(panel_cont, &refresh_img, "Reset Z", &FineTunePanel::_handle_zoffset, this)
   , zup_btn(panel_cont, &z_closer, "Z+", &FineTunePanel::_handle_zoffset, this)
@@ -44,7 +45,6 @@ FineTunePanel::FineTunePanel(KWebSocketClient &websocket_client, std::mutex &l)
   , speed_factor(values_cont, &speed_up_img, 150, 100, 15 ,"100%")
   , flow_factor(values_cont, &flow_up_img, 150, 100, 15, "100%")
 {
-  lv_obj_move_background(panel_cont);
   
   lv_obj_set_size(panel_cont, LV_PCT(100), LV_PCT(100));
   lv_obj_clear_flag(panel_cont, LV_OBJ_FLAG_SCROLLABLE);
@@ -113,19 +113,19 @@ void FineTunePanel::foreground() {
 
   v = State::get_instance()->get_data("/printer_state/extruder/pressure_advance"_json_pointer);
   if (!v.is_null()) {
-    pa.update_label(fmt::format("{:.5} mm/s", v.template get<double>()).c_str());
+    pa.update_label(fmt::format("{:.5} mm/s", v->template get<double>()).c_str());
   }
 
   v = State::get_instance()->get_data("/printer_state/gcode_move/speed_factor"_json_pointer);
   if (!v.is_null()) {
     speed_factor.update_label(fmt::format("{}%",
-    static_cast<int>(v.template get<double>() * 100)).c_str());
+    static_cast<int>(v->template get<double>() * 100)).c_str());
   }
 
   v = State::get_instance()->get_data("/printer_state/gcode_move/extrude_factor"_json_pointer);
   if (!v.is_null()) {
     flow_factor.update_label(fmt::format("{}%",
-    static_cast<int>(v.template get<double>() * 100)).c_str());
+    static_cast<int>(v->template get<double>() * 100)).c_str());
   }
 
   //Set the Z axis buttons
@@ -140,14 +140,15 @@ void FineTunePanel::foreground() {
     zdown_btn.set_image(&z_farther);
   }
   
-  lv_obj_move_foreground(panel_cont);
+  PanelManager::get_instance()->show(panel_cont);
 }
 
 void FineTunePanel::consume(json &j) {
-  std::lock_guard<std::mutex> lock(lv_lock);
-  auto v = j["/params/0/gcode_move/homing_origin/2"_json_pointer];
-  if (!v.is_null()) {
-    std::string z_offset_str = fmt::format("{:.5} mm", v.template get<double>());
+  LV_LOCK_GUARD(lock, lv_lock);
+  const json *status = StatusUpdate::status(j);
+  const json *v = StatusUpdate::field(status, "gcode_move", "homing_origin");
+  if (v != NULL && v->is_array() && v->size() > 2 && !(*v)[2].is_null()) {
+    std::string z_offset_str = fmt::format("{:.5} mm", (*v)[2].template get<double>());
     // this is some dodgy shit not even sure why it happens
     if (z_offset_str.find("e-") == std::string::npos && z_offset_str.find("E-") == std::string::npos) {
       z_offset.update_label(z_offset_str.c_str());
@@ -156,21 +157,21 @@ void FineTunePanel::consume(json &j) {
     }
   }
 
-  v = j["/params/0/extruder/pressure_advance"_json_pointer];
-  if (!v.is_null()) {
-    pa.update_label(fmt::format("{:.5} mm/s", v.template get<double>()).c_str());
+  v = StatusUpdate::field(status, "extruder", "pressure_advance");
+  if (v != NULL) {
+    pa.update_label(fmt::format("{:.5} mm/s", v->template get<double>()).c_str());
   }
 
-  v = j["/params/0/gcode_move/speed_factor"_json_pointer];
-  if (!v.is_null()) {
+  v = StatusUpdate::field(status, "gcode_move", "speed_factor");
+  if (v != NULL) {
     speed_factor.update_label(fmt::format("{}%",
-    static_cast<int>(v.template get<double>() * 100)).c_str());
+    static_cast<int>(v->template get<double>() * 100)).c_str());
   }
 
-  v = j["/params/0/gcode_move/extrude_factor"_json_pointer];
-  if (!v.is_null()) {
+  v = StatusUpdate::field(status, "gcode_move", "extrude_factor");
+  if (v != NULL) {
     flow_factor.update_label(fmt::format("{}%",
-    static_cast<int>(v.template get<double>() * 100)).c_str());
+    static_cast<int>(v->template get<double>() * 100)).c_str());
   }
 }
 
@@ -192,7 +193,7 @@ void FineTunePanel::handle_callback(lv_event_t *e) {
   if (lv_event_get_code(e) == LV_EVENT_CLICKED) {
     lv_obj_t *btn = lv_event_get_current_target(e);
     if (btn == back_btn.get_container()) {
-      lv_obj_move_background(panel_cont);
+      PanelManager::get_instance()->hide(panel_cont);
     }
   }
 }
@@ -8,11 +8,11 @@
 #include "websocket_client.h"
 #include "notify_consumer.h"
 
-#include <mutex>
+#include "lv_lock.h"
 
 class FineTunePanel : public NotifyConsumer {
  public:
-  FineTunePanel(KWebSocketClient &, std::mutex &);
+  FineTunePanel(KWebSocketClient &, LvLock &);
   ~FineTunePanel();
   void foreground();
   void handle_callback(lv_event_t *event);
@@ -0,0 +1,92 @@
+#include "gcode_history.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem;
+
+GcodeHistory::GcodeHistory(size_t capacity)
+  : ring(std::max<size_t>(capacity, 1))
+  , head(0)
+  , count(0)
+  , file_lines(0)
+{
+}
+
+void GcodeHistory::load(const std::string &p) {
+  path = p;
+  head = 0;
+  count = 0;
+  file_lines = 0;
+  if (path.empty()) {
+    return;
+  }
+
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+
+  // oldest first, the ring keeps the newest
+  std::ifstream f(path);
+  std::string line;
+  while (std::getline(f, line)) {
+    file_lines++;
+    if (!line.empty() && (count == 0 || at(0) != line)) {
+      ring[head] = line;
+      head = (head + 1) % ring.size();
+      count = std::min(count + 1, ring.size());
+    }
+  }
+  LOG_DEBUG("console history {}, {} commands", path, count);
+}
+
+void GcodeHistory::push(const std::string &cmd) {
+  if (cmd.empty() || (count > 0 && at(0) == cmd)) {
+    return;
+  }
+
+  ring[head] = cmd;
+  head = (head + 1) % ring.size();
+  count = std::min(count + 1, ring.size());
+
+  if (path.empty()) {
+    return;
+  }
+  if (file_lines + 1 >= 2 * ring.size()) {
+    rewrite();
+    return;
+  }
+
+  std::ofstream f(path, std::ios::app);
+  f << cmd << '\n';
+  if (f) {
+    file_lines++;
+  } else {
+    LOG_ERROR("failed to append console history {}", path);
+  }
+}
+
+const std::string &GcodeHistory::at(size_t i) const {
+  return ring[(head + ring.size() - 1 - i) % ring.size()];
+}
+
+void GcodeHistory::rewrite() {
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream f(tmp, std::ios::trunc);
+    for (size_t i = count; i-- > 0;) {
+      f << at(i) << '\n';
+    }
+    if (!f) {
+      LOG_ERROR("failed to write console history {}", tmp);
+      return;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    LOG_ERROR("failed to replace console history {}", path);
+    return;
+  }
+  file_lines = count;
+}
@@ -0,0 +1,36 @@
+#ifndef __GCODE_HISTORY_H__
+#define __GCODE_HISTORY_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Commands sent from the console, newest first, in a fixed ring. Each is
+// appended to a file as it is sent and the file is rewritten from the
+// ring when it grows to twice the capacity, so history survives a restart
+// without a rewrite per command.
+class GcodeHistory {
+ public:
+  explicit GcodeHistory(size_t capacity);
+
+  // an empty path keeps history in memory only
+  void load(const std::string &path);
+  // the same command twice in a row is kept once
+  void push(const std::string &cmd);
+
+  size_t size() const { return count; }
+  // 0 is the newest
+  const std::string &at(size_t i) const;
+
+ private:
+  void rewrite();
+
+  std::vector<std::string> ring;
+  // where the next command goes
+  size_t head;
+  size_t count;
+  std::string path;
+  size_t file_lines;
+};
+
+#endif // __GCODE_HISTORY_H__
@@ -0,0 +1,213 @@
+#include "gcode_trie.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+  inline unsigned char fold(char c) {
+    return std::toupper(static_cast<unsigned char>(c));
+  }
+
+  uint32_t common_prefix(const std::string &a, const std::string &b) {
+    uint32_t n = 0;
+    while (n < a.size() && n < b.size() && a[n] == b[n]) {
+      n++;
+    }
+    return n;
+  }
+}
+
+GcodeTrie::GcodeTrie() {
+}
+
+void GcodeTrie::build(std::vector<std::string> cmds) {
+  for (auto &c : cmds) {
+    std::transform(c.begin(), c.end(), c.begin(), fold);
+  }
+  cmds.erase(std::remove(cmds.begin(), cmds.end(), ""), cmds.end());
+  std::sort(cmds.begin(), cmds.end());
+  cmds.erase(std::unique(cmds.begin(), cmds.end()), cmds.end());
+  names = std::move(cmds);
+
+  nodes.clear();
+  top.clear();
+  if (names.empty()) {
+    return;
+  }
+
+  // breadth first, so a node's index is its place in the queue and each
+  // node's children are pushed together
+  struct Range {
+    uint32_t lo;
+    uint32_t hi;
+  };
+  std::vector<Range> queue;
+  nodes.push_back({0, 0, 0, 0, 0, -1});
+  queue.push_back({0, static_cast<uint32_t>(names.size())});
+
+  for (size_t q = 0; q < queue.size(); q++) {
+    Range r = queue[q];
+    uint32_t d = nodes[q].depth;
+    uint32_t i = r.lo;
+    // sorted, so a name ending here comes first
+    if (names[i].size() == d) {
+      nodes[q].cmd = i++;
+    }
+
+    nodes[q].child = nodes.size();
+    while (i < r.hi) {
+      char c = names[i][d];
+      uint32_t j = i + 1;
+      while (j < r.hi && names[j][d] == c) {
+        j++;
+      }
+      // the edge runs as far as every name under it agrees
+      nodes.push_back({i, common_prefix(names[i], names[j - 1]), 0, 0, 0, -1});
+      queue.push_back({i, j});
+      i = j;
+    }
+    nodes[q].nchild = nodes.size() - nodes[q].child;
+  }
+
+  rank(std::vector<uint32_t>());
+}
+
+void GcodeTrie::rank(const std::vector<uint32_t> &weights) {
+  auto weight = [&weights](uint32_t i) { return i < weights.size() ? weights[i] : 0; };
+  auto better = [this, &weight](uint32_t a, uint32_t b) {
+    if (weight(a) != weight(b)) {
+      return weight(a) > weight(b);
+    }
+    if (names[a].size() != names[b].size()) {
+      return names[a].size() < names[b].size();
+    }
+    return a < b;
+  };
+
+  top.assign(nodes.size() * MAX_COMPLETIONS, 0);
+  std::vector<uint32_t> pool;
+  // children come after their parent
+  for (size_t i = nodes.size(); i-- > 0;) {
+    Node &n = nodes[i];
+    pool.clear();
+    if (n.cmd >= 0) {
+      pool.push_back(n.cmd);
+    }
+    for (uint32_t c = n.child; c < n.child + n.nchild; c++) {
+      auto begin = top.begin() + c * MAX_COMPLETIONS;
+      pool.insert(pool.end(), begin, begin + nodes[c].ntop);
+    }
+
+    size_t keep = std::min(pool.size(), MAX_COMPLETIONS);
+    std::partial_sort(pool.begin(), pool.begin() + keep, pool.end(), better);
+    std::copy(pool.begin(), pool.begin() + keep, top.begin() + i * MAX_COMPLETIONS);
+    n.ntop = keep;
+  }
+}
+
+int GcodeTrie::find(const std::string &name) const {
+  Cursor c = root();
+  for (char ch : name) {
+    if (!step(c, ch)) {
+      return -1;
+    }
+  }
+  if (nodes.empty() || c.depth != nodes[c.node].depth) {
+    return -1;
+  }
+  return nodes[c.node].cmd;
+}
+
+bool GcodeTrie::step(Cursor &c, char ch) const {
+  if (nodes.empty()) {
+    return false;
+  }
+
+  unsigned char u = fold(ch);
+  const Node &n = nodes[c.node];
+  if (c.depth < n.depth) {
+    if (static_cast<unsigned char>(names[n.rep][c.depth]) != u) {
+      return false;
+    }
+    c.depth++;
+    return true;
+  }
+
+  // children by the first character of their edge
+  uint32_t lo = n.child;
+  uint32_t hi = n.child + n.nchild;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (static_cast<unsigned char>(names[nodes[mid].rep][n.depth]) < u) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == n.child + n.nchild || static_cast<unsigned char>(names[nodes[lo].rep][n.depth]) != u) {
+    return false;
+  }
+  c = {lo, n.depth + 1};
+  return true;
+}
+
+const uint32_t *GcodeTrie::completions(const Cursor &c, size_t &n) const {
+  if (nodes.empty()) {
+    n = 0;
+    return NULL;
+  }
+  n = nodes[c.node].ntop;
+  return &top[c.node * MAX_COMPLETIONS];
+}
+
+GcodeCompleter::GcodeCompleter(const GcodeTrie &t)
+  : trie(t)
+  , miss(0)
+{
+  word.reserve(64);
+  path.reserve(65);
+  path.push_back(trie.root());
+}
+
+void GcodeCompleter::reset() {
+  word.clear();
+  path.resize(1);
+  path[0] = trie.root();
+  miss = 0;
+}
+
+void GcodeCompleter::update(const char *text) {
+  size_t len = 0;
+  while (text[len] != '\0' && text[len] != ' ') {
+    len++;
+  }
+
+  // back up to where the text and what was typed before part
+  size_t same = 0;
+  while (same < len && same < word.size() && fold(text[same]) == static_cast<unsigned char>(word[same])) {
+    same++;
+  }
+  word.resize(same);
+  size_t stepped = std::min(same, path.size() - 1);
+  path.resize(stepped + 1);
+  miss = same - stepped;
+
+  for (size_t i = same; i < len; i++) {
+    char c = fold(text[i]);
+    word.push_back(c);
+    GcodeTrie::Cursor cur = path.back();
+    if (miss == 0 && trie.step(cur, c)) {
+      path.push_back(cur);
+    } else {
+      miss++;
+    }
+  }
+}
+
+const uint32_t *GcodeCompleter::completions(size_t &n) const {
+  if (miss > 0) {
+    n = 0;
+    return NULL;
+  }
+  return trie.completions(path.back(), n);
+}
@@ -0,0 +1,84 @@
+#ifndef __GCODE_TRIE_H__
+#define __GCODE_TRIE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Command names from printer.gcode.help in a path compressed prefix trie,
+// flattened breadth first so a node's children are contiguous and sorted.
+// Every node carries its subtree's best few commands, ranked once when
+// the trie is built or reweighted, so completing a prefix is a walk down
+// to it and a read of that list. Names are upper case, lookups fold case.
+class GcodeTrie {
+ public:
+  static const size_t MAX_COMPLETIONS = 8;
+
+  // a node and how far into it the prefix reaches
+  struct Cursor {
+    uint32_t node;
+    uint32_t depth;
+  };
+
+  GcodeTrie();
+
+  // names are upper cased, sorted and deduplicated, name(i) is in that order
+  void build(std::vector<std::string> names);
+  // higher weights rank first, then shorter names, then alphabetical
+  void rank(const std::vector<uint32_t> &weights);
+
+  size_t size() const { return names.size(); }
+  const std::string &name(size_t i) const { return names[i]; }
+  // index of an exact name, -1 if there is none
+  int find(const std::string &name) const;
+
+  Cursor root() const { return {0, 0}; }
+  // the prefix one character longer, false if nothing starts with it
+  bool step(Cursor &c, char ch) const;
+  // ranked completions under c, n of them
+  const uint32_t *completions(const Cursor &c, size_t &n) const;
+
+ private:
+  struct Node {
+    // a name in the subtree, the edge into the node is its characters
+    // from the parent's depth to this node's
+    uint32_t rep;
+    uint32_t depth;
+    uint32_t child;
+    uint16_t nchild;
+    uint16_t ntop;
+    int32_t cmd;
+  };
+
+  std::vector<std::string> names;
+  std::vector<Node> nodes;
+  // MAX_COMPLETIONS slots per node
+  std::vector<uint32_t> top;
+};
+
+// The trie cursor for the text being typed, kept a character at a time.
+// Typing or deleting at the end moves it by the characters changed; no
+// allocation once the text has been this long before.
+class GcodeCompleter {
+ public:
+  explicit GcodeCompleter(const GcodeTrie &trie);
+
+  // the command word of text, up to the first space
+  void update(const char *text);
+  void reset();
+
+  // false once the word matches nothing
+  bool matched() const { return miss == 0; }
+  const uint32_t *completions(size_t &n) const;
+
+ private:
+  const GcodeTrie &trie;
+  std::string word;
+  // cursor after each character of word that matched
+  std::vector<GcodeTrie::Cursor> path;
+  // characters of word past the last match
+  size_t miss;
+};
+
+#endif // __GCODE_TRIE_H__
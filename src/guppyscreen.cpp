@@ -1,13 +1,20 @@
 #include "guppyscreen.h"
 
 #include "config.h"
+#include "dithered_png.h"
 #include "lv_drivers/display/fbdev.h"
 #include "lv_drivers/indev/evdev.h"
 #ifdef GUPPY_WAYLAND
 #include "lv_drivers/wayland/wayland.h"
 #endif
 #include "logger.h"
+#include "metrics_server.h"
+#include "panel_manager.h"
+#include "perf_monitor.h"
 #include "state.h"
+#include "thumbnail_service.h"
+#include "trace.h"
+#include "utils.h"
 #ifdef GUPPY_CALIBRATE
 #include <fstream>
 #endif
@@ -17,22 +24,28 @@ namespace fs = std::experimental::filesystem;
 GuppyScreen *GuppyScreen::instance = NULL;
 lv_style_t GuppyScreen::style_container;
 lv_style_t GuppyScreen::style_imgbtn_default;
-lv_style_t GuppyScreen::style_imgbtn_pressed;
-lv_style_t GuppyScreen::style_imgbtn_disabled;
 lv_theme_t GuppyScreen::th_new;
 
 lv_obj_t *GuppyScreen::screen_saver = NULL;
 
 KWebSocketClient GuppyScreen::ws(NULL);
 
-std::mutex GuppyScreen::lv_lock;
+LvLock GuppyScreen::lv_lock("lv_lock");
 
 GuppyScreen::GuppyScreen()
-  : spoolman_panel(ws, lv_lock)
-  , main_panel(ws, lv_lock, spoolman_panel)
-  , init_panel(main_panel, lv_lock)
+  : init_panel(lv_lock)
+  , built_future(built.get_future().share())
 {
-  main_panel.create_panel();
+}
+
+void GuppyScreen::build() {
+  spoolman_panel = std::make_unique<SpoolmanPanel>(ws, lv_lock);
+  main_panel = std::make_unique<MainPanel>(ws, lv_lock, *spoolman_panel);
+  main_panel->create_panel();
+  init_panel.set_main_panel(main_panel.get());
+  // stays over the main panel until the printer state is in
+  init_panel.foreground();
+  built.set_value();
 }
 
 GuppyScreen *GuppyScreen::get() {
@@ -51,12 +64,25 @@ GuppyScreen *GuppyScreen::init(std::function<void(lv_color_t, lv_color_t)> hal_i
   auto ll = conf->get<std::string>("/ui/log_level");
   set_log_level(ll);
 
+  auto binary_log = conf->get<std::string>("/ui/log_binary_path");
+  if (!binary_log.empty()) {
+    if (log_open_binary(binary_log,
+                        conf->get<int32_t>("/ui/log_binary_segment_kb", 1024) * 1024,
+                        conf->get<int32_t>("/ui/log_binary_segments", 8))) {
+      LOG_INFO("logging to binary segments {}.*.bin, decode with binlog_decode", binary_log);
+    } else {
+      LOG_ERROR("failed to open binary log {}, logging to stdout", binary_log);
+    }
+  }
+
   auto theme_primary_color = conf->get<std::string>("/theme/primary_colour", "0x2196F3");
   auto theme_secondary_color = conf->get<std::string>("/theme/secondary_colour", "0xF44336");
   auto primary_color = lv_color_hex(std::stoul(theme_primary_color, nullptr, 16));
   auto secondary_color = lv_color_hex(std::stoul(theme_secondary_color, nullptr, 16));
 
   LOG_INFO("GrumpyScreen Version: {}-{}", GUPPYSCREEN_BRANCH, GUPPYSCREEN_VERSION);
+  PerfMonitor *perf = PerfMonitor::get_instance();
+  perf->startup_stage("config");
 
   LOG_INFO("DPI: {}", LV_DPI_DEF);
   /*LittlevGL init*/
@@ -70,18 +96,19 @@ GuppyScreen *GuppyScreen::init(std::function<void(lv_color_t, lv_color_t)> hal_i
 
   hal_init(primary_color, secondary_color);
   lv_png_init();
+  dithered_png_init();
+  AssetCache::get_instance()->init();
+  perf->startup_stage("display");
 
   lv_style_init(&style_container);
   lv_style_set_border_width(&style_container, 0);
   lv_style_set_radius(&style_container, 0);
+#if LV_COLOR_DEPTH == 16
+  lv_style_set_bg_dither_mode(&style_container, LV_DITHER_ORDERED);
+#endif
 
-  lv_style_init(&style_imgbtn_pressed);
-  lv_style_set_img_recolor_opa(&style_imgbtn_pressed, LV_OPA_100);
-  lv_style_set_img_recolor(&style_imgbtn_pressed, primary_color);
-
-  lv_style_init(&style_imgbtn_disabled);
-  lv_style_set_img_recolor_opa(&style_imgbtn_disabled, LV_OPA_100);
-  lv_style_set_img_recolor(&style_imgbtn_disabled, lv_palette_darken(LV_PALETTE_GREY, 1));
+  // baked into recolored images instead of an img_recolor style
+  AssetCache::get_instance()->set_imgbtn_colours(primary_color, lv_palette_darken(LV_PALETTE_GREY, 1));
 
   // Initia1ize the new theme from the current theme
   lv_theme_t *th_act = lv_disp_get_theme(NULL);
@@ -94,28 +121,102 @@ GuppyScreen *GuppyScreen::init(std::function<void(lv_color_t, lv_color_t)> hal_i
   // Assign the new theme to the current display
   lv_disp_set_theme(NULL, &th_new);
 
+  perf->attach(lv_disp_get_default());
+  if (conf->get<bool>("/ui/perf_overlay", false)) {
+    perf->enable_overlay();
+  }
+  perf->set_log_interval(conf->get<int32_t>("/ui/perf_log_interval_sec", 0));
+  LvLockWatchdog::get_instance()->start(conf->get<int32_t>("/ui/lock_watchdog_ms", 0),
+                                        &lv_lock, &State::get_lock());
+
+  if (conf->get<bool>("/trace/enabled", false)) {
+    Trace *trace = Trace::get_instance();
+    trace->enable(conf->get<int32_t>("/trace/buffer_events", 65536),
+                  conf->get<std::string>("/trace/dump_path", "/tmp/grumpyscreen_trace.json"),
+                  conf->get<std::string>("/trace/trigger_file", "/tmp/grumpyscreen_trace.trigger"));
+    for (lv_indev_t *indev = lv_indev_get_next(NULL); indev != NULL; indev = lv_indev_get_next(indev)) {
+      if (lv_indev_get_type(indev) == LV_INDEV_TYPE_POINTER) {
+        trace->attach(indev);
+      }
+    }
+  }
+
   ws.register_notify_update(State::get_instance());
+  ThumbnailService::get_instance()->init(lv_lock);
+  PanelManager::get_instance()->init(ws, lv_lock);
 
+  // only the banner so far, put it on screen before building anything else
   GuppyScreen *gs = GuppyScreen::get();
-  // start initializing all guppy components
-  std::string ws_url = fmt::format("ws://{}:{}/websocket",
-                                   conf->get<std::string>("/moonraker/host"),
-                                   conf->get<uint32_t>("/moonraker/port"));
+  lv_refr_now(NULL);
+  perf->startup_stage("first frame");
+
+  // the handshake runs while the panels are built, connected() waits for them
+  std::string unix_socket = conf->get<std::string>("/moonraker/unix_socket");
+  if (!unix_socket.empty()) {
+    LOG_INFO("connecting to printer at {}", unix_socket);
+    gs->connect_unix(unix_socket);
+  } else {
+    std::string ws_url = fmt::format("ws://{}:{}/websocket",
+                                     conf->get<std::string>("/moonraker/host"),
+                                     conf->get<uint32_t>("/moonraker/port"));
+
+    LOG_INFO("connecting to printer at {}", ws_url);
+    gs->connect_ws(ws_url);
+  }
 
-  LOG_INFO("connecting to printer at {}", ws_url);
-  gs->connect_ws(ws_url);
+  std::string klippy_uds = conf->get<std::string>("/klippy/uds_address");
+  if (!klippy_uds.empty()) {
+    std::vector<std::string> groups;
+    for (auto &g : KUtils::split(conf->get<std::string>("/klippy/direct_groups", "temperature, motion, print"), ',')) {
+      g.erase(0, g.find_first_not_of(' '));
+      g.erase(g.find_last_not_of(' ') + 1);
+      if (!g.empty()) {
+        groups.push_back(g);
+      }
+    }
+    LOG_INFO("status for {} from klippy at {}", join(groups, ", "), klippy_uds);
+    ws.connect_klippy(klippy_uds, groups);
+  }
 
-  screen_saver = lv_obj_create(lv_scr_act());
+  {
+    // the disconnected callback may already be touching the banner
+    LV_LOCK_GUARD(lock, lv_lock);
+    gs->build();
 
-  lv_obj_set_size(screen_saver, LV_PCT(100), LV_PCT(100));
-  lv_obj_set_style_bg_opa(screen_saver, LV_OPA_100, 0);
+    screen_saver = lv_obj_create(lv_scr_act());
+
+    lv_obj_set_size(screen_saver, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_style_bg_opa(screen_saver, LV_OPA_100, 0);
 #ifdef GUPPY_WAYLAND
-  lv_obj_set_style_bg_color(screen_saver, lv_color_black(), 0);
+    lv_obj_set_style_bg_color(screen_saver, lv_color_black(), 0);
+#endif
+    lv_obj_move_background(screen_saver);
+  }
+  perf->startup_stage("panels");
+
+  if (conf->get<bool>("/metrics/enabled", false)) {
+    perf->register_metrics();
+    static MetricsServer metrics_server;
+    std::string unix_socket = conf->get<std::string>("/metrics/unix_socket");
+    if (!unix_socket.empty()) {
+      metrics_server.start(unix_socket, -1);
+    } else {
+      metrics_server.start(conf->get<std::string>("/metrics/host", "127.0.0.1"),
+                           conf->get<int32_t>("/metrics/port", 9101));
+    }
+  }
+
+#ifdef GUPPY_CALIBRATE
+  // off the startup path, runs from the first pass of the ui loop
+  lv_timer_t *calibration = lv_timer_create(&GuppyScreen::load_calibration, 0, lv_disp_get_scr_act(NULL));
+  lv_timer_set_repeat_count(calibration, 1);
 #endif
-  lv_obj_move_background(screen_saver);
+  return gs;
+}
 
 #ifdef GUPPY_CALIBRATE
-  lv_obj_t *main_screen = lv_disp_get_scr_act(NULL);
+void GuppyScreen::load_calibration(lv_timer_t *t) {
+  lv_obj_t *main_screen = (lv_obj_t *)t->user_data;
   std::vector<float> c = GuppyScreen::load_calibration_coeff();
   if (c.empty()) {
     lv_tc_register_coeff_save_cb(&GuppyScreen::save_calibration_coeff);
@@ -130,19 +231,39 @@ GuppyScreen *GuppyScreen::init(std::function<void(lv_color_t, lv_color_t)> hal_i
     lv_tc_set_coeff(coeff, false);
     LOG_INFO("loaded calibration coefficients");
   }
-#endif
-  return gs;
 }
+#endif
 
 void GuppyScreen::loop() {
   /*Handle LitlevGL tasks (tickless mode)*/
   std::atomic_bool is_sleeping(false);
   Config *conf = Config::get_instance();
   int32_t display_sleep = conf->get<int32_t>("/ui/display_sleep_sec") * 1000;
+  PerfMonitor *perf = PerfMonitor::get_instance();
+  Trace *trace = Trace::get_instance();
+  LvLockWatchdog *watchdog = LvLockWatchdog::get_instance();
+  // the banner was flushed from init, wait for the frame after it
+  uint64_t banner_flushes = perf->get_flushes();
+  bool drawn = false;
 
   while (1) {
-    lv_lock.lock();
+    watchdog->tick();
+    uint64_t wait_start = PerfMonitor::now_us();
+    lv_lock.lock(LV_LOCK_SITE(lv_lock));
+    uint64_t locked = PerfMonitor::now_us();
+    perf->record_lock_wait(locked - wait_start);
+    if (locked - wait_start > 100) {
+      trace->complete("lvgl", "lv_lock_wait", wait_start, locked - wait_start);
+    }
+
     lv_timer_handler();
+    uint64_t handled = PerfMonitor::now_us();
+    perf->record_timer_handler(handled - locked);
+    trace->complete("lvgl", "lv_timer_handler", locked, handled - locked);
+    if (!drawn && perf->get_flushes() > banner_flushes) {
+      perf->startup_stage("main panel drawn");
+      drawn = true;
+    }
 
 #ifdef GUPPY_WAYLAND
     if (!lv_wayland_window_is_open(NULL)) {
@@ -174,19 +295,29 @@ void GuppyScreen::loop() {
       }
     }
 
+    perf->record_lock_hold(PerfMonitor::now_us() - locked);
     lv_lock.unlock();
+
+    trace->poll();
     usleep(5000);
   }
 }
 
-std::mutex &GuppyScreen::get_lock() {
+LvLock &GuppyScreen::get_lock() {
   return lv_lock;
 }
 
 void GuppyScreen::connect_ws(const std::string &url) {
   init_panel.set_message(LV_SYMBOL_WARNING " Waiting for Klipper to start...");
   ws.connect(url.c_str(),
-   [this]() { init_panel.connected(ws); },
+   [this]() { built_future.wait(); init_panel.connected(ws); },
+   [this]() { init_panel.disconnected(ws); });
+}
+
+void GuppyScreen::connect_unix(const std::string &path) {
+  init_panel.set_message(LV_SYMBOL_WARNING " Waiting for Klipper to start...");
+  ws.connect_unix(path,
+   [this]() { built_future.wait(); init_panel.connected(ws); },
    [this]() { init_panel.disconnected(ws); });
 }
 
@@ -196,11 +327,6 @@ void GuppyScreen::new_theme_apply_cb(lv_theme_t *th, lv_obj_t *obj) {
   if (lv_obj_check_type(obj, &lv_obj_class)) {
     lv_obj_add_style(obj, &style_container, 0);
   }
-
-  if (lv_obj_check_type(obj, &lv_imgbtn_class)) {
-    lv_obj_add_style(obj, &style_imgbtn_pressed, LV_STATE_PRESSED);
-    lv_obj_add_style(obj, &style_imgbtn_disabled, LV_STATE_DISABLED);
-  }
 }
 
 #ifdef GUPPY_CALIBRATE
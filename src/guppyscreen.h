@@ -1,8 +1,10 @@
 #ifndef __GUPPY_SCREEN_H__
 #define __GUPPY_SCREEN_H__
 
-#include <mutex>
+#include "lv_lock.h"
 #include <functional>
+#include <future>
+#include <memory>
 
 #ifdef GUPPY_CALIBRATE
 #include "lv_tc.h"
@@ -22,24 +24,33 @@ class GuppyScreen {
   static GuppyScreen *instance;
   static lv_style_t style_container;
   static lv_style_t style_imgbtn_default;
-  static lv_style_t style_imgbtn_pressed;
-  static lv_style_t style_imgbtn_disabled;
   static lv_theme_t th_new;
   static lv_obj_t *screen_saver;
-  static std::mutex lv_lock;
+  static LvLock lv_lock;
   static KWebSocketClient ws;
-  SpoolmanPanel spoolman_panel;
-  MainPanel main_panel;
+  // up first so the banner can be drawn while the rest is built
   InitPanel init_panel;
+  std::unique_ptr<SpoolmanPanel> spoolman_panel;
+  std::unique_ptr<MainPanel> main_panel;
+  // connection callbacks wait on this, the connection is opened before
+  // the panels exist
+  std::promise<void> built;
+  std::shared_future<void> built_future;
+
+  void build();
+#ifdef GUPPY_CALIBRATE
+  static void load_calibration(lv_timer_t *t);
+#endif
 
  public:
   GuppyScreen();
   GuppyScreen(GuppyScreen &o) = delete;
   void operator=(const GuppyScreen &) = delete;
 
-  std::mutex &get_lock();
+  LvLock &get_lock();
 
   void connect_ws(const std::string &url);
+  void connect_unix(const std::string &path);
   static GuppyScreen *get();
   static GuppyScreen *init(std::function<void(lv_color_t, lv_color_t)> hal_init);
   static void loop();
@@ -0,0 +1,87 @@
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size histogram with power of two buckets. Bucket i counts values
+// <= 2^i, the last bucket is unbounded. Safe to observe from one thread and
+// read from another, readers may see a slightly torn snapshot.
+class Histogram {
+ public:
+  static constexpr size_t BUCKETS = 24;
+
+  Histogram() {
+    reset();
+  }
+
+  Histogram(const Histogram &) = delete;
+  Histogram &operator=(const Histogram &) = delete;
+
+  void observe(uint64_t v) {
+    buckets[index(v)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+
+    uint64_t cur = max_.load(std::memory_order_relaxed);
+    while (v > cur && !max_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+    }
+  }
+
+  void reset() {
+    for (auto &b : buckets) {
+      b.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const { return total.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  uint64_t bucket_count(size_t i) const {
+    return buckets[i].load(std::memory_order_relaxed);
+  }
+
+  // upper bound of bucket i, the last bucket has no bound
+  static uint64_t bucket_bound(size_t i) {
+    return i + 1 < BUCKETS ? (uint64_t(1) << i) : UINT64_MAX;
+  }
+
+  // approximate percentile, reported as the upper bound of the bucket it falls in
+  uint64_t percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) {
+      return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(n));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      seen += bucket_count(i);
+      if (seen > rank) {
+        return i + 1 < BUCKETS ? bucket_bound(i) : max();
+      }
+    }
+    return max();
+  }
+
+ private:
+  static size_t index(uint64_t v) {
+    if (v <= 1) {
+      return 0;
+    }
+    size_t i = 64 - __builtin_clzll(v - 1);
+    return i < BUCKETS ? i : BUCKETS - 1;
+  }
+
+  std::atomic<uint64_t> buckets[BUCKETS];
+  std::atomic<uint64_t> total;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+#endif // __HISTOGRAM_H__
@@ -2,6 +2,7 @@
 #include "state.h"
 #include "logger.h"
 #include "config.h"
+#include "panel_manager.h"
 
 static const float distances[] = {0.1, 0.5, 1, 5, 10, 25, 50};
 
@@ -16,10 +17,10 @@ LV_IMG_DECLARE(z_farther);
 LV_IMG_DECLARE(emergency);
 LV_IMG_DECLARE(motor_off_img);
 
-HomingPanel::HomingPanel(KWebSocketClient &websocket_client, std::mutex &lock)
+HomingPanel::HomingPanel(KWebSocketClient &websocket_client, LvLock &lock)
   : NotifyConsumer(lock)
   , ws(websocket_client)
-  , homing_cont(lv_obj_create(lv_scr_act()))
+  , homing_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , home_all_btn(homing_cont, &home, "Home All", &HomingPanel::_handle_callback, this)
   , home_xy_btn(homing_cont, &home, "Home XY", &HomingPanel::_handle_callback, this)
   , y_up_btn(homing_cont, &arrow_up, "Y+", &HomingPanel::_handle_callback, this)
@@ -69,13 +70,21 @@ HomingPanel::HomingPanel(KWebSocketClient &websocket_client, std::mutex &lock)
 }
 
 HomingPanel::~HomingPanel() {
+  ws.unregister_notify_update(this);
+
+  // the selector deletes its own container, the root has to outlive it
+  if (homing_cont != NULL) {
+    lv_obj_del_async(homing_cont);
+    homing_cont = NULL;
+  }
 }
 
 void HomingPanel::consume(json &j) {
-  std::lock_guard<std::mutex> lock(lv_lock);
-  auto v = j["/params/0/toolhead/homed_axes"_json_pointer];
-  if (!v.is_null()) {
-    std::string homed_axes = v.template get<std::string>();
+  LV_LOCK_GUARD(lock, lv_lock);
+  const json *status = StatusUpdate::status(j);
+  const json *v = StatusUpdate::field(status, "toolhead", "homed_axes");
+  if (v != NULL) {
+    const std::string &homed_axes = v->template get_ref<const std::string &>();
     if (homed_axes.find("x") != std::string::npos) {
       x_up_btn.enable();
       x_down_btn.enable();
@@ -101,11 +110,12 @@ void HomingPanel::consume(json &j) {
     }
   }
 
-  json &pstat_state = j["/params/0/print_stats/state"_json_pointer];
-  if (!pstat_state.is_null()) {
-    if (pstat_state.template get<std::string>() == "printing") {
-      lv_obj_move_background(homing_cont);
-    } else if (pstat_state.template get<std::string>() == "paused") {
+  const json *pstat_state = StatusUpdate::field(status, "print_stats", "state");
+  if (pstat_state != NULL) {
+    const std::string &state = pstat_state->template get_ref<const std::string &>();
+    if (state == "printing") {
+      PanelManager::get_instance()->hide(homing_cont);
+    } else if (state == "paused") {
       home_all_btn.disable();
       home_xy_btn.disable();
       motoroff_btn.disable();
@@ -167,7 +177,7 @@ void HomingPanel::foreground() {
     z_down_btn.set_image(&z_farther);
   }
 
-  lv_obj_move_foreground(homing_cont);
+  PanelManager::get_instance()->show(homing_cont);
 }
 
 void HomingPanel::handle_callback(lv_event_t *event) {
@@ -205,7 +215,7 @@ void HomingPanel::handle_callback(lv_event_t *event) {
     LOG_DEBUG("motor off pressed");
     ws.gcode_script("M84");
   } else if (btn == back_btn.get_container()) {
-    lv_obj_move_background(homing_cont);
+    PanelManager::get_instance()->hide(homing_cont);
   } else {
     LOG_DEBUG("Unknown action button pressed");
   }
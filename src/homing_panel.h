@@ -7,11 +7,11 @@
 #include "selector.h"
 #include "notify_consumer.h"
 
-#include <mutex>
+#include "lv_lock.h"
 
 class HomingPanel : public NotifyConsumer {
  public:
-  HomingPanel(KWebSocketClient &ws, std::mutex &);
+  HomingPanel(KWebSocketClient &ws, LvLock &);
   ~HomingPanel();
 
   void consume(json &data);
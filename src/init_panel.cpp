@@ -3,14 +3,15 @@
 #include "state.h"
 #include "config.h"
 #include "logger.h"
+#include "perf_monitor.h"
 
 #include <algorithm>
 #include <cstdio>
 
-InitPanel::InitPanel(MainPanel &mp, std::mutex& l)
+InitPanel::InitPanel(LvLock &l)
   : cont(lv_obj_create(lv_scr_act()))
   , label(lv_label_create(cont))
-  , main_panel(mp)
+  , main_panel(NULL)
   , lv_lock(l)
 {
   lv_obj_set_size(cont, LV_PCT(55), LV_SIZE_CONTENT);
@@ -33,6 +34,14 @@ InitPanel::~InitPanel() {
   }
 }
 
+void InitPanel::set_main_panel(MainPanel *mp) {
+  main_panel = mp;
+}
+
+void InitPanel::foreground() {
+  lv_obj_move_foreground(cont);
+}
+
 void InitPanel::connected(KWebSocketClient &ws) {
   LOG_DEBUG("init panel connected");
   State *state = State::get_instance();
@@ -48,7 +57,7 @@ void InitPanel::connected(KWebSocketClient &ws) {
 	  ws.send_jsonrpc("printer.info",
 			[](json& j) { State::get_instance()->set_data("printer_info", j, "/result"); });
 
-    this->main_panel.subscribe();
+    this->main_panel->subscribe();
 
     // spoolman
     ws.send_jsonrpc("server.info", [this](json &j) {
@@ -59,19 +68,19 @@ void InitPanel::connected(KWebSocketClient &ws) {
       if (!components.is_null()) {
         const auto &has_spoolman = components.template get<std::vector<std::string>>();
         if (std::find(has_spoolman.begin(), has_spoolman.end(), "spoolman") != has_spoolman.end()) {
-          this->main_panel.enable_spoolman();
+          this->main_panel->enable_spoolman();
         }
       }
     });
 
     auto display_sensors = state->get_display_sensors();
-    this->main_panel.create_sensors(display_sensors);
+    this->main_panel->create_sensors(display_sensors);
 
     auto display_fans = state->get_display_fans();
-    this->main_panel.create_fans(display_fans);
+    this->main_panel->create_fans(display_fans);
 
     auto display_leds = state->get_display_leds();
-    this->main_panel.create_leds(display_leds);
+    this->main_panel->create_leds(display_leds);
 
     // subscribe to all objects except gcode_macro
     auto objs = d["/result/objects"_json_pointer];
@@ -84,13 +93,13 @@ void InitPanel::connected(KWebSocketClient &ws) {
         }
       }
 
-      json subs = {{ "objects", sub_objs }};
-      LOG_DEBUG("subscribing to {}", subs.dump());
-      ws.send_jsonrpc("printer.objects.subscribe", subs, [this](json &data) {
+      LOG_DEBUG("subscribing to {}", sub_objs.dump());
+      ws.subscribe_objects(sub_objs, [this](json &data) {
         State::get_instance()->set_data("printer_state", data, "/result/status");
-        this->main_panel.init(data);
+        this->main_panel->init(data);
         LOG_DEBUG("done init");
-        std::lock_guard<std::mutex> lock(this->lv_lock);
+        PerfMonitor::get_instance()->startup_stage("printer state", true);
+        LV_LOCK_GUARD(lock, this->lv_lock);
         lv_obj_add_flag(this->cont, LV_OBJ_FLAG_HIDDEN);
         lv_obj_move_background(this->cont);
       });
@@ -100,7 +109,7 @@ void InitPanel::connected(KWebSocketClient &ws) {
 
 void InitPanel::disconnected(KWebSocketClient &ws) {
   LOG_DEBUG("init panel disconnected");
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
   set_message(LV_SYMBOL_WARNING " Waiting for Klipper to start...");
   lv_obj_clear_flag(cont, LV_OBJ_FLAG_HIDDEN);
   lv_obj_move_foreground(cont);
@@ -6,13 +6,17 @@
 #include "main_panel.h"
 #include "print_status_panel.h"
 
-#include <mutex>
+#include "lv_lock.h"
 
 class InitPanel {
  public:
-  InitPanel(MainPanel &mp, std::mutex &l);
+  InitPanel(LvLock &l);
   ~InitPanel();
 
+  // the main panel is built after the banner is on screen
+  void set_main_panel(MainPanel *mp);
+  void foreground();
+
   void connected(KWebSocketClient &ws);
   void disconnected(KWebSocketClient &ws);
   void set_message(const char *message);
@@ -20,8 +24,8 @@ class InitPanel {
  private:
   lv_obj_t *cont;
   lv_obj_t *label;
-  MainPanel &main_panel;
-  std::mutex &lv_lock;
+  MainPanel *main_panel;
+  LvLock &lv_lock;
 };
 
 #endif // __INIT_PANEL_H__
@@ -0,0 +1,340 @@
+#include "json_parser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+  // deeper documents go to json::parse
+  constexpr size_t MAX_DEPTH = 64;
+  // dropped keys kept for reuse
+  constexpr size_t MAX_SPARE = 256;
+  // after a frame this long, and the one after it, which drops its keys,
+  // nothing is kept for reuse
+  constexpr size_t LARGE_FRAME = 64 * 1024;
+
+  bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+  }
+}
+
+JsonParser::JsonParser()
+  : p(NULL)
+  , end(NULL)
+  , large(false)
+  , counts({0, 0})
+{
+}
+
+json &JsonParser::parse(const char *data, size_t len, bool allow_exceptions) {
+  counts.frames++;
+  p = data;
+  end = data + len;
+
+  skip_ws();
+  bool ok = value(doc, 0);
+  if (ok) {
+    skip_ws();
+    ok = p == end;
+  }
+
+  if (!ok) {
+    counts.fallbacks++;
+    doc = json::parse(data, data + len, nullptr, allow_exceptions);
+  }
+
+  if (large || len > LARGE_FRAME) {
+    spare.clear();
+    std::vector<std::vector<const json *>>().swap(seen);
+  }
+  large = len > LARGE_FRAME;
+  return doc;
+}
+
+bool JsonParser::value(json &v, size_t depth) {
+  if (p >= end) {
+    return false;
+  }
+
+  switch (*p) {
+  case '{':
+    return object(v, depth);
+  case '[':
+    return array(v, depth);
+  case '"':
+    if (v.is_string()) {
+      return string(v.get_ref<std::string &>());
+    }
+    if (!string(key)) {
+      return false;
+    }
+    v = key;
+    return true;
+  case 't':
+    v = true;
+    return literal("true", 4);
+  case 'f':
+    v = false;
+    return literal("false", 5);
+  case 'n':
+    v = nullptr;
+    return literal("null", 4);
+  default:
+    return number(v);
+  }
+}
+
+bool JsonParser::object(json &v, size_t depth) {
+  if (depth >= MAX_DEPTH) {
+    return false;
+  }
+  p++;
+
+  if (!v.is_object()) {
+    v = json::object();
+  }
+  json::object_t &obj = *v.get_ptr<json::object_t *>();
+  if (seen.size() <= depth) {
+    seen.resize(depth + 1);
+  }
+  seen[depth].clear();
+
+  skip_ws();
+  if (p < end && *p == '}') {
+    p++;
+    obj.clear();
+    return true;
+  }
+
+  while (1) {
+    if (p >= end || *p != '"' || !string(key)) {
+      return false;
+    }
+    auto it = obj.find(key);
+    if (it == obj.end()) {
+      auto kept = spare.find(key);
+      if (kept == spare.end() && spare.size() >= MAX_SPARE) {
+        kept = spare.begin();
+      }
+      if (kept == spare.end()) {
+        it = obj.emplace(key, nullptr).first;
+      } else {
+        auto node = spare.extract(kept);
+        node.key() = key;
+        it = obj.insert(std::move(node)).position;
+      }
+    }
+
+    skip_ws();
+    if (p >= end || *p != ':') {
+      return false;
+    }
+    p++;
+    skip_ws();
+    if (!value(it->second, depth + 1)) {
+      return false;
+    }
+    // nested objects may have grown seen, don't hold on to a reference
+    seen[depth].push_back(&it->second);
+
+    skip_ws();
+    if (p < end && *p == ',') {
+      p++;
+      skip_ws();
+      continue;
+    }
+    if (p < end && *p == '}') {
+      p++;
+      break;
+    }
+    return false;
+  }
+
+  // map nodes don't move, a key the frame didn't have isn't in seen
+  std::vector<const json *> &s = seen[depth];
+  std::sort(s.begin(), s.end());
+  s.erase(std::unique(s.begin(), s.end()), s.end());
+  if (s.size() != obj.size()) {
+    for (auto it = obj.begin(); it != obj.end();) {
+      if (std::binary_search(s.begin(), s.end(), &it->second)) {
+        ++it;
+      } else if (spare.size() < MAX_SPARE) {
+        spare.insert(obj.extract(it++));
+      } else {
+        it = obj.erase(it);
+      }
+    }
+  }
+  return true;
+}
+
+bool JsonParser::array(json &v, size_t depth) {
+  if (depth >= MAX_DEPTH) {
+    return false;
+  }
+  p++;
+
+  if (!v.is_array()) {
+    v = json::array();
+  }
+  json::array_t &arr = *v.get_ptr<json::array_t *>();
+
+  skip_ws();
+  if (p < end && *p == ']') {
+    p++;
+    arr.clear();
+    return true;
+  }
+
+  size_t n = 0;
+  while (1) {
+    if (n == arr.size()) {
+      arr.emplace_back();
+    }
+    if (!value(arr[n++], depth + 1)) {
+      return false;
+    }
+
+    skip_ws();
+    if (p < end && *p == ',') {
+      p++;
+      skip_ws();
+      continue;
+    }
+    if (p < end && *p == ']') {
+      p++;
+      break;
+    }
+    return false;
+  }
+
+  arr.erase(arr.begin() + n, arr.end());
+  return true;
+}
+
+bool JsonParser::string(std::string &out) {
+  p++;
+  out.clear();
+
+  while (p < end) {
+    const char *run = p;
+    while (p < end && *p != '"' && *p != '\\'
+           && static_cast<unsigned char>(*p) >= 0x20 && static_cast<unsigned char>(*p) < 0x80) {
+      p++;
+    }
+    out.append(run, p - run);
+    if (p >= end) {
+      return false;
+    }
+
+    char c = *p++;
+    if (c == '"') {
+      return true;
+    }
+    if (c != '\\' || p >= end) {
+      // control characters are invalid, utf-8 is left to json::parse
+      return false;
+    }
+
+    switch (*p++) {
+    case '"': out.push_back('"'); break;
+    case '\\': out.push_back('\\'); break;
+    case '/': out.push_back('/'); break;
+    case 'b': out.push_back('\b'); break;
+    case 'f': out.push_back('\f'); break;
+    case 'n': out.push_back('\n'); break;
+    case 'r': out.push_back('\r'); break;
+    case 't': out.push_back('\t'); break;
+    default:
+      // \u, and anything invalid
+      return false;
+    }
+  }
+  return false;
+}
+
+bool JsonParser::number(json &v) {
+  const char *start = p;
+  if (p < end && *p == '-') {
+    p++;
+  }
+  if (p >= end) {
+    return false;
+  }
+  if (*p == '0') {
+    p++;
+  } else if (is_digit(*p)) {
+    while (p < end && is_digit(*p)) {
+      p++;
+    }
+  } else {
+    return false;
+  }
+
+  bool is_float = false;
+  if (p < end && *p == '.') {
+    is_float = true;
+    p++;
+    if (p >= end || !is_digit(*p)) {
+      return false;
+    }
+    while (p < end && is_digit(*p)) {
+      p++;
+    }
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    is_float = true;
+    p++;
+    if (p < end && (*p == '+' || *p == '-')) {
+      p++;
+    }
+    if (p >= end || !is_digit(*p)) {
+      return false;
+    }
+    while (p < end && is_digit(*p)) {
+      p++;
+    }
+  }
+
+  // same types as json::parse, integers that don't fit become floats.
+  // from_chars ignores the locale, strtod would read "1.5" as 1 under one
+  // with a decimal comma
+  if (!is_float) {
+    if (*start == '-') {
+      json::number_integer_t x;
+      if (std::from_chars(start, p, x).ec == std::errc()) {
+        v = x;
+        return true;
+      }
+    } else {
+      json::number_unsigned_t x;
+      if (std::from_chars(start, p, x).ec == std::errc()) {
+        v = x;
+        return true;
+      }
+    }
+  }
+
+  // out of range goes to json::parse
+  double x;
+  if (std::from_chars(start, p, x).ec != std::errc() || !std::isfinite(x)) {
+    return false;
+  }
+  v = x;
+  return true;
+}
+
+bool JsonParser::literal(const char *word, size_t n) {
+  if (static_cast<size_t>(end - p) < n || memcmp(p, word, n) != 0) {
+    return false;
+  }
+  p += n;
+  return true;
+}
+
+void JsonParser::skip_ws() {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+    p++;
+  }
+}
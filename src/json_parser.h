@@ -0,0 +1,62 @@
+#ifndef __JSON_PARSER_H__
+#define __JSON_PARSER_H__
+
+#include "hv/json.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Parses websocket frames into a document it keeps between calls. Objects,
+// arrays and strings already in the document are parsed into in place, so
+// a frame shaped like the one before it takes no allocations. Keys a frame
+// doesn't have are taken out, with their values, and put back when a later
+// frame names them again, so notify_status_update, which names whichever
+// objects changed, settles down to none as well. The result is always
+// what json::parse returns.
+//
+// Input with \u escapes or non-ASCII bytes, and anything malformed, is
+// handed to json::parse, which reports errors the usual way. The document
+// is only valid until the next parse and the parser is not reentrant.
+class JsonParser {
+ public:
+  struct Stats {
+    uint64_t frames;
+    uint64_t fallbacks;
+  };
+
+  JsonParser();
+
+  // allow_exceptions as for json::parse, a discarded value otherwise
+  json &parse(const char *data, size_t len, bool allow_exceptions = true);
+
+  const Stats &stats() const { return counts; }
+
+ private:
+  bool value(json &v, size_t depth);
+  bool object(json &v, size_t depth);
+  bool array(json &v, size_t depth);
+  bool string(std::string &out);
+  bool number(json &v);
+  bool literal(const char *word, size_t n);
+  void skip_ws();
+
+  json doc;
+  const char *p;
+  const char *end;
+  std::string key;
+  // keys seen per object nesting level, to drop the ones that went away
+  std::vector<std::vector<const json *>> seen;
+  // map nodes of dropped keys by key, moved between maps without allocating
+  std::multimap<json::object_t::key_type, json::object_t::mapped_type,
+                json::object_t::key_compare, json::object_t::allocator_type> spare;
+  // the last frame was over LARGE_FRAME
+  bool large;
+  Stats counts;
+};
+
+#endif // __JSON_PARSER_H__
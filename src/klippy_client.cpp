@@ -0,0 +1,267 @@
+#include "klippy_client.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace hv;
+
+namespace {
+  // object name prefixes per group
+  const std::map<std::string, std::vector<std::string>> GROUPS = {
+    {"temperature", {"extruder", "heater_bed", "heater_generic ", "temperature_sensor ", "temperature_fan "}},
+    {"motion", {"toolhead", "motion_report", "gcode_move"}},
+    {"print", {"print_stats", "virtual_sdcard", "display_status", "exclude_object"}},
+    {"fan", {"fan", "heater_fan ", "fan_generic ", "controller_fan ", "output_pin "}},
+    {"led", {"led "}},
+  };
+
+  const char DELIMITER = 0x03;
+
+  // objects/subscribe field lists, null is every field
+  void merge_objects(json &into, const json &objects) {
+    for (auto &el : objects.items()) {
+      auto entry = into.find(el.key());
+      if (entry == into.end()) {
+        into[el.key()] = el.value();
+      } else if (entry->is_null() || !el.value().is_array()) {
+        *entry = nullptr;
+      } else {
+        for (auto &field : el.value()) {
+          if (std::find(entry->begin(), entry->end(), field) == entry->end()) {
+            entry->push_back(field);
+          }
+        }
+      }
+    }
+  }
+
+  json error_reply(uint64_t req_id, const std::string &reason) {
+    return {{"id", req_id}, {"error", {{"message", reason}}}};
+  }
+}
+
+KlippyClient::KlippyClient(EventLoopPtr loop, Metrics::Counter *frames, Metrics::Counter *bytes)
+  : client(std::make_unique<TcpClient>(loop))
+  , connected(false)
+  , id(0)
+  , status_params(json::array({nullptr, nullptr}))
+  , frames_in(frames)
+  , bytes_in(bytes)
+  , subscribed(json::object())
+{
+}
+
+KlippyClient::~KlippyClient() {
+}
+
+int KlippyClient::connect(const std::string &path, std::function<void(json &)> status_cb) {
+  LOG_DEBUG("klippy connecting to {}", path);
+  on_status = status_cb;
+
+  // a negative port makes libhv treat the host as a socket path
+  if (client->createsocket(-1, path.c_str()) < 0) {
+    LOG_ERROR("failed to create klippy socket for {}", path);
+    return -1;
+  }
+
+  unpack_setting_t unpack;
+  memset(&unpack, 0, sizeof(unpack));
+  unpack.mode = UNPACK_BY_DELIMITER;
+  unpack.package_max_length = DEFAULT_PACKAGE_MAX_LENGTH;
+  unpack.delimiter[0] = DELIMITER;
+  unpack.delimiter_bytes = 1;
+  client->setUnpack(&unpack);
+
+  reconn_setting_t reconn;
+  reconn_setting_init(&reconn);
+  reconn.min_delay = 200;
+  reconn.max_delay = 2000;
+  reconn.delay_policy = 2;
+  client->setReconnect(&reconn);
+
+  client->onConnection = [this](const SocketChannelPtr &channel) {
+    connected = channel->isConnected();
+    LOG_DEBUG("klippy socket {}", connected ? "connected" : "closed");
+    if (connected) {
+      // klippy forgets subscriptions with the connection
+      resubscribe();
+    } else {
+      // subscribe goes through moonraker until this reconnects
+      fail_pending("klippy socket closed");
+    }
+  };
+  client->onMessage = [this](const SocketChannelPtr &, Buffer *buf) {
+    const char *data = static_cast<const char *>(buf->data());
+    size_t len = buf->size();
+    frames_in->fetch_add(1, std::memory_order_relaxed);
+    bytes_in->fetch_add(len, std::memory_order_relaxed);
+    if (len > 0 && data[len - 1] == DELIMITER) {
+      len--;
+    }
+    try {
+      handle_message(data, len);
+    } catch (const std::exception &e) {
+      LOG_ERROR("failed to handle klippy message: {}", e.what());
+    }
+  };
+
+  // the loop is already running, start() would not connect
+  client->loop()->runInLoop([this]() { client->startConnect(); });
+  return 0;
+}
+
+void KlippyClient::set_groups(const std::vector<std::string> &groups) {
+  prefixes.clear();
+  for (const auto &g : groups) {
+    auto entry = GROUPS.find(g);
+    if (entry == GROUPS.end()) {
+      LOG_ERROR("unknown klippy status group {}", g);
+      continue;
+    }
+    prefixes.insert(prefixes.end(), entry->second.begin(), entry->second.end());
+  }
+}
+
+bool KlippyClient::wants(const std::string &object) const {
+  for (const auto &p : prefixes) {
+    if (object.rfind(p, 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int KlippyClient::subscribe(const json &objects, std::function<void(json &)> cb) {
+  uint64_t req_id = id++;
+  std::string frame;
+  {
+    std::lock_guard<std::mutex> guard(callbacks_lock);
+    merge_objects(subscribed, objects);
+    callbacks.insert({req_id, cb});
+    frame = subscribe_request(req_id);
+  }
+  return send(req_id, frame);
+}
+
+std::string KlippyClient::subscribe_request(uint64_t req_id) {
+  json req = {
+    {"id", req_id},
+    {"method", "objects/subscribe"},
+    {"params", {
+        {"objects", subscribed},
+        {"response_template", {{"method", "notify_status_update"}}}
+      }}
+  };
+  return req.dump();
+}
+
+int KlippyClient::send(uint64_t req_id, std::string &frame) {
+  LOG_DEBUG("klippy subscribe: {}", frame);
+  frame.push_back(DELIMITER);
+  int ret = client->send(frame);
+  if (ret < 0) {
+    std::function<void(json &)> cb;
+    {
+      std::lock_guard<std::mutex> guard(callbacks_lock);
+      auto entry = callbacks.find(req_id);
+      if (entry != callbacks.end()) {
+        cb = std::move(entry->second);
+        callbacks.erase(entry);
+      }
+    }
+    if (cb) {
+      json reply = error_reply(req_id, "klippy socket not connected");
+      cb(reply);
+    }
+  }
+  return ret;
+}
+
+void KlippyClient::resubscribe() {
+  uint64_t req_id = id++;
+  std::string frame;
+  {
+    std::lock_guard<std::mutex> guard(callbacks_lock);
+    if (subscribed.empty()) {
+      return;
+    }
+    // the reply is the current state of everything, updates only say
+    // what changed since
+    callbacks.insert({req_id, [this](json &j) {
+      auto result = j.find("result");
+      if (result == j.end() || !result->is_object()) {
+        return;
+      }
+      json update = {
+        {"method", "notify_status_update"},
+        {"params", {(*result)["status"], (*result)["eventtime"]}}
+      };
+      on_status(update);
+    }});
+    frame = subscribe_request(req_id);
+    LOG_INFO("klippy subscribing to {} objects again", subscribed.size());
+  }
+  send(req_id, frame);
+}
+
+void KlippyClient::fail_pending(const std::string &reason) {
+  std::map<uint64_t, std::function<void(json &)>> failed;
+  {
+    std::lock_guard<std::mutex> guard(callbacks_lock);
+    failed.swap(callbacks);
+  }
+  // called without the lock, they may subscribe again
+  for (auto &entry : failed) {
+    json reply = error_reply(entry.first, reason);
+    entry.second(reply);
+  }
+}
+
+void KlippyClient::handle_message(const char *data, size_t len) {
+  json &j = parser.parse(data, len, false);
+  if (j.is_discarded()) {
+    LOG_ERROR("klippy sent invalid json");
+    return;
+  }
+
+  auto method = j.find("method");
+  if (method != j.end()) {
+    json &params = j["params"];
+    if (!params.is_object()) {
+      on_status(j);
+      return;
+    }
+
+    // {"eventtime": t, "status": {..}} -> [{..}, t], swapped rather than
+    // moved so the parser gets its nodes back for the next update
+    status_params[0].swap(params["status"]);
+    status_params[1].swap(params["eventtime"]);
+    params.swap(status_params);
+    on_status(j);
+    params.swap(status_params);
+    params["status"].swap(status_params[0]);
+    params["eventtime"].swap(status_params[1]);
+    return;
+  }
+
+  auto req_id = j.find("id");
+  if (req_id != j.end() && req_id->is_number_unsigned()) {
+    std::function<void(json &)> cb;
+    {
+      std::lock_guard<std::mutex> guard(callbacks_lock);
+      auto entry = callbacks.find(req_id->get<uint64_t>());
+      if (entry != callbacks.end()) {
+        cb = std::move(entry->second);
+        callbacks.erase(entry);
+      }
+    }
+
+    if (j.contains("error")) {
+      LOG_ERROR("klippy request failed: {}", j["error"].dump());
+    }
+    if (cb) {
+      cb(j);
+    }
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef __KLIPPY_CLIENT_H__
+#define __KLIPPY_CLIENT_H__
+
+#include "hv/TcpClient.h"
+#include "hv/json.hpp"
+#include "json_parser.h"
+#include "metrics.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Klippy's API socket (klippy_uds_address in moonraker.conf), used only
+// for objects/subscribe so high rate status skips the moonraker relay.
+// Requests are plain JSON terminated by 0x03. Status updates are rewritten
+// to moonraker's notify_status_update shape, params [status, eventtime],
+// so consumers can't tell the difference. Klippy keeps one subscription
+// per connection, so every subscribe sends all objects subscribed so far,
+// and they are subscribed again when the socket reconnects.
+class KlippyClient {
+ public:
+  // runs on loop, normally the websocket's, so updates from both
+  // connections are delivered on the same thread. frames received are
+  // counted in frames_in and bytes_in
+  KlippyClient(hv::EventLoopPtr loop, Metrics::Counter *frames_in, Metrics::Counter *bytes_in);
+  ~KlippyClient();
+
+  int connect(const std::string &path, std::function<void(json &)> on_status);
+  bool is_connected() const { return connected; }
+
+  // status groups to take from klippy, see GROUPS in klippy_client.cpp
+  void set_groups(const std::vector<std::string> &groups);
+  bool wants(const std::string &object) const;
+
+  // result is {"eventtime": .., "status": {..}}, like moonraker's, for
+  // every object subscribed so far. if the socket closes before klippy
+  // replies, cb gets an error reply instead
+  int subscribe(const json &objects, std::function<void(json &)> cb);
+
+ private:
+  void handle_message(const char *data, size_t len);
+  // sends objects/subscribe for everything in subscribed, callbacks_lock held
+  std::string subscribe_request(uint64_t req_id);
+  int send(uint64_t req_id, std::string &frame);
+  void resubscribe();
+  void fail_pending(const std::string &reason);
+
+  std::unique_ptr<hv::TcpClient> client;
+  std::atomic_bool connected;
+  std::atomic_uint64_t id;
+  std::vector<std::string> prefixes;
+  std::function<void(json &)> on_status;
+  JsonParser parser;
+  // [status, eventtime], swapped in and out of each update
+  json status_params;
+
+  Metrics::Counter *frames_in;
+  Metrics::Counter *bytes_in;
+
+  // guards subscribed too
+  std::mutex callbacks_lock;
+  std::map<uint64_t, std::function<void(json &)>> callbacks;
+  // objects/subscribe objects, field lists merged
+  json subscribed;
+};
+
+#endif // __KLIPPY_CLIENT_H__
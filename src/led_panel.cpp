@@ -2,6 +2,7 @@
 #include "state.h"
 #include "utils.h"
 #include "logger.h"
+#include "panel_manager.h"
 
 namespace {
 bool get_led_pwm(const json &led) {
@@ -26,10 +27,10 @@ LV_IMG_DECLARE(light_img);
 LV_IMG_DECLARE(light_off);
 LV_IMG_DECLARE(back);
 
-LedPanel::LedPanel(KWebSocketClient &websocket_client, std::mutex &lock)
+LedPanel::LedPanel(KWebSocketClient &websocket_client, LvLock &lock)
   : NotifyConsumer(lock)
   , ws(websocket_client)
-  , ledpanel_cont(lv_obj_create(lv_scr_act()))
+  , ledpanel_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , leds_cont(lv_obj_create(ledpanel_cont))
   , back_btn(ledpanel_cont, &back, "Back", &LedPanel::_handle_callback, this)
 {
@@ -63,12 +64,13 @@ LedPanel::~LedPanel() {
 }
 
 void LedPanel::consume(json &j) {
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
+  const json *status = StatusUpdate::status(j);
   for (auto &l : leds) {
     // hack for output_pin leds
-    auto value = j[json::json_pointer(fmt::format("/params/0/{}/value", l.first))];
-    if (!value.is_null()) {
-      const double raw_value = value.template get<double>();
+    const json *value = StatusUpdate::field(status, l.first, "value");
+    if (value != NULL) {
+      const double raw_value = value->template get<double>();
       int v = static_cast<int>(raw_value * 100);
       l.second->update_value(v);
       if (!single_led_id.empty() && l.first == single_led_id) {
@@ -77,12 +79,12 @@ void LedPanel::consume(json &j) {
       }
     }
 
-    value = j[json::json_pointer(fmt::format("/params/0/{}/color_data", l.first))];
-    if (!value.is_null() && value.size() > 0) {
+    value = StatusUpdate::field(status, l.first, "color_data");
+    if (value != NULL && value->size() > 0) {
       // color_data = [[r,b,g,w]]
-      value =  value.at(0);
-      if (value.size() == 4) {
-        const double raw_value = value.at(3).template get<double>();
+      const json &color = value->at(0);
+      if (color.size() == 4) {
+        const double raw_value = color.at(3).template get<double>();
         int v = static_cast<int>(raw_value * 100);
         l.second->update_value(v);
         if (!single_led_id.empty() && l.first == single_led_id) {
@@ -216,7 +218,7 @@ void LedPanel::foreground() {
     }
   }
 
-  lv_obj_move_foreground(ledpanel_cont);
+  PanelManager::get_instance()->show(ledpanel_cont);
 }
 
 const void *LedPanel::get_main_button_image() {
@@ -267,7 +269,7 @@ void LedPanel::toggle_single_led() {
 void LedPanel::handle_callback(lv_event_t *event) {
   lv_obj_t *btn = lv_event_get_current_target(event);
   if (btn == back_btn.get_container()) {
-    lv_obj_move_background(ledpanel_cont);
+    PanelManager::get_instance()->hide(ledpanel_cont);
   }
   else {
     LOG_DEBUG("Unknown action button pressed");
@@ -7,13 +7,13 @@
 #include "slider_container.h"
 #include "button_container.h"
 
-#include <mutex>
+#include "lv_lock.h"
 #include <map>
 #include <string>
 
 class LedPanel : public NotifyConsumer {
  public:
-  LedPanel(KWebSocketClient &, std::mutex &);
+  LedPanel(KWebSocketClient &, LvLock &);
   ~LedPanel();
 
   void consume(json &j);
@@ -0,0 +1,249 @@
+#include "logger.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+  // bounded MPSC queue after Vyukov, producers never block, a full ring
+  // drops the line and counts it
+  struct Slot {
+    std::atomic<size_t> seq;
+    LogLevel lvl;
+    uint64_t ts_us;
+    // set for binary records, msg then holds the encoded arguments
+    const char *fmt;
+    size_t fmt_len;
+    std::string msg;
+  };
+
+  constexpr size_t RING_SIZE = 4096;
+  // the writer wakes at least this often to flush without new lines
+  constexpr std::chrono::milliseconds FLUSH_TIMEOUT(1000);
+
+  // leaked so the writer can outlive static destructors at exit
+  Slot *ring = NULL;
+  std::atomic<size_t> enqueue_pos{0};
+  size_t dequeue_pos = 0;
+  std::atomic<uint64_t> dropped{0};
+  std::atomic_bool running{false};
+
+  // serialises the consumer side, the writer thread and log_flush
+  std::mutex drain_lock;
+  BinLog binary;
+
+  // the writer sleeps on wake_cv with writer_waiting set, producers only
+  // take wake_lock to wake it then
+  std::mutex wake_lock;
+  std::condition_variable wake_cv;
+  bool woken = false;
+  std::atomic_bool writer_waiting{false};
+
+  time_t cached_sec = 0;
+  char cached_ts[24];
+
+  const char *level_prefix(LogLevel lvl) {
+    switch (lvl) {
+      case LogLevel::TRACE: return "[TRACE] ";
+      case LogLevel::DEBUG: return "[DEBUG] ";
+      case LogLevel::INFO:  return "[INFO ] ";
+      case LogLevel::ERROR: return "[ERROR] ";
+      default: return "";
+    }
+  }
+
+  uint64_t now_us() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+  }
+
+  void append_line(std::string &out, LogLevel lvl, uint64_t ts_us, const std::string &msg) {
+    time_t ts = ts_us / 1000000;
+    // localtime_r only once per second
+    if (ts != cached_sec) {
+      std::tm tm{};
+      localtime_r(&ts, &tm);
+      strftime(cached_ts, sizeof(cached_ts), "%F %T ", &tm);
+      cached_sec = ts;
+    }
+    out.append(cached_ts);
+    out.append(level_prefix(lvl));
+    out.append(msg);
+    out.push_back('\n');
+  }
+
+  void write_all(const std::string &out) {
+    size_t off = 0;
+    while (off < out.size()) {
+      ssize_t n = ::write(STDOUT_FILENO, out.data() + off, out.size() - off);
+      if (n <= 0) {
+        return;
+      }
+      off += n;
+    }
+  }
+
+  bool pending() {
+    return ring[dequeue_pos & (RING_SIZE - 1)].seq.load(std::memory_order_acquire) == dequeue_pos + 1
+      || dropped.load(std::memory_order_relaxed) > 0;
+  }
+
+  // drain_lock held
+  size_t drain(std::string &out) {
+    size_t n = 0;
+    while (1) {
+      Slot &s = ring[dequeue_pos & (RING_SIZE - 1)];
+      if (s.seq.load(std::memory_order_acquire) != dequeue_pos + 1) {
+        break;
+      }
+
+      if (s.fmt != NULL) {
+        binary.append_line(static_cast<uint8_t>(s.lvl), s.ts_us, s.fmt, s.fmt_len, s.msg);
+      } else {
+        append_line(out, s.lvl, s.ts_us, s.msg);
+      }
+      s.msg.clear();
+      s.seq.store(dequeue_pos + RING_SIZE, std::memory_order_release);
+      dequeue_pos++;
+      n++;
+    }
+
+    uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost > 0) {
+      append_line(out, LogLevel::ERROR, now_us(), fmt::format("logger dropped {} lines", lost));
+    }
+    return n;
+  }
+
+  void writer() {
+    std::string out;
+    out.reserve(16 * 1024);
+    while (1) {
+      {
+        std::lock_guard<std::mutex> l(drain_lock);
+        drain(out);
+        write_all(out);
+        binary.flush(false);
+      }
+      out.clear();
+
+      writer_waiting.store(true);
+      // pairs with the fence in wake_writer, either the producer sees
+      // writer_waiting or this sees its line
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      bool idle;
+      {
+        std::lock_guard<std::mutex> l(drain_lock);
+        idle = !pending();
+      }
+      if (idle) {
+        std::unique_lock<std::mutex> l(wake_lock);
+        wake_cv.wait_for(l, FLUSH_TIMEOUT, [] { return woken; });
+        woken = false;
+      }
+      writer_waiting.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  void wake_writer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writer_waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> l(wake_lock);
+      woken = true;
+      wake_cv.notify_one();
+    }
+  }
+
+  void enqueue(LogLevel lvl, uint64_t ts_us, const char *fmt, size_t fmt_len, std::string &&msg) {
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    Slot *s;
+    while (1) {
+      s = &ring[pos & (RING_SIZE - 1)];
+      size_t seq = s->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        wake_writer();
+        return;
+      } else {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+
+    s->lvl = lvl;
+    s->ts_us = ts_us;
+    s->fmt = fmt;
+    s->fmt_len = fmt_len;
+    s->msg = std::move(msg);
+    s->seq.store(pos + 1, std::memory_order_release);
+    wake_writer();
+  }
+}
+
+void log_line(LogLevel lvl, std::string &&msg) {
+  uint64_t ts = now_us();
+  if (!running.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> l(drain_lock);
+    std::string out;
+    append_line(out, lvl, ts, msg);
+    write_all(out);
+    return;
+  }
+
+  enqueue(lvl, ts, NULL, 0, std::move(msg));
+}
+
+void log_binary(LogLevel lvl, const char *fmt, size_t fmt_len, std::string &&args) {
+  enqueue(lvl, now_us(), fmt, fmt_len, std::move(args));
+}
+
+void log_start() {
+  if (running.load()) {
+    return;
+  }
+
+  ring = new Slot[RING_SIZE];
+  for (size_t i = 0; i < RING_SIZE; i++) {
+    ring[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  running.store(true, std::memory_order_release);
+  std::thread(writer).detach();
+  std::atexit(log_flush);
+}
+
+bool log_open_binary(const std::string &prefix, size_t segment_bytes, size_t segments) {
+  if (!running.load()) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> l(drain_lock);
+    if (!binary.open(prefix, segment_bytes, segments)) {
+      return false;
+    }
+  }
+
+  g_log_binary = true;
+  return true;
+}
+
+void log_flush() {
+  if (!running.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(drain_lock);
+  std::string out;
+  drain(out);
+  write_all(out);
+  binary.flush(true);
+}
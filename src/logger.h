@@ -2,6 +2,7 @@
 #pragma once
 #define FMT_HEADER_ONLY
 #include <fmt/core.h>
+#include "binlog.h"
 #include <atomic>
 #include <chrono>
 #include <cctype>
@@ -14,6 +15,7 @@
 enum class LogLevel : int { TRACE = 0, DEBUG = 1, INFO = 2, ERROR = 3 };
 
 inline std::atomic<LogLevel> g_log_level{LogLevel::INFO};
+inline std::atomic_bool g_log_binary{false};
 
 inline void set_log_level(LogLevel lvl) {
   g_log_level.store(lvl, std::memory_order_relaxed);
@@ -34,32 +36,53 @@ inline void set_log_level(const std::string& s) {
   if (lower == "info")  { set_log_level(LogLevel::INFO);}
 }
 
-inline void log_line(LogLevel lvl, const std::string& msg){
-  using namespace std::chrono;
-  const auto now = system_clock::to_time_t(system_clock::now());
-  std::tm tm{};
-  localtime_r(&now, &tm);
-  std::ostream& out = std::cout;
-  out << std::put_time(&tm, "%F %T") << ' ';
-  switch (lvl) {
-    case LogLevel::TRACE: out << "[TRACE] "; break;
-    case LogLevel::DEBUG: out << "[DEBUG] "; break;
-    case LogLevel::INFO:  out << "[INFO ] "; break;
-    case LogLevel::ERROR: out << "[ERROR] "; break;
-    default: break;
-  }
-  out << msg << '\n';
-  out.flush();
+// levels below this are compiled out, e.g. GUPPY_LOG_MIN_LEVEL=2 keeps info and error
+#ifndef GUPPY_LOG_MIN_LEVEL
+#define GUPPY_LOG_MIN_LEVEL 0
+#endif
+
+inline bool log_enabled(LogLevel lvl) {
+  return static_cast<int>(lvl) >= GUPPY_LOG_MIN_LEVEL && lvl >= get_log_level();
 }
 
+// queues the line for the writer thread, written directly before log_start()
+void log_line(LogLevel lvl, std::string &&msg);
+
+// queues an encoded binary record, fmt must be a string literal
+void log_binary(LogLevel lvl, const char *fmt, size_t fmt_len, std::string &&args);
+
+// starts the background writer, lines are flushed at exit
+void log_start();
+
+// switch to binary segments at prefix.<n>.bin, errors still go to stdout
+bool log_open_binary(const std::string &prefix, size_t segment_bytes, size_t segments);
+
+// blocks until every queued line is written
+void log_flush();
+
 template <typename... Args>
 inline void log_fmt(LogLevel lvl, fmt::format_string<Args...> fmt_str, Args&&... args) {
-  const LogLevel cur = get_log_level();
-  if (lvl < cur) return;
+  if (g_log_binary.load(std::memory_order_relaxed)) {
+    std::string encoded;
+    binlog::encode_args(encoded, args...);
+    fmt::string_view f = fmt_str;
+    log_binary(lvl, f.data(), f.size(), std::move(encoded));
+    if (lvl < LogLevel::ERROR) {
+      return;
+    }
+  }
   log_line(lvl, fmt::format(fmt_str, std::forward<Args>(args)...));
 }
 
-#define LOG_TRACE(fmt_str, ...) ::log_fmt(::LogLevel::TRACE, FMT_STRING(fmt_str), ##__VA_ARGS__)
-#define LOG_DEBUG(fmt_str, ...) ::log_fmt(::LogLevel::DEBUG, FMT_STRING(fmt_str), ##__VA_ARGS__)
-#define LOG_INFO(fmt_str, ...)  ::log_fmt(::LogLevel::INFO,  FMT_STRING(fmt_str), ##__VA_ARGS__)
-#define LOG_ERROR(fmt_str, ...) ::log_fmt(::LogLevel::ERROR, FMT_STRING(fmt_str), ##__VA_ARGS__)
+// arguments are only evaluated when the level is enabled
+#define LOG_AT(lvl, fmt_str, ...)                                   \
+  do {                                                              \
+    if (::log_enabled(lvl)) {                                       \
+      ::log_fmt(lvl, FMT_STRING(fmt_str), ##__VA_ARGS__);           \
+    }                                                               \
+  } while (0)
+
+#define LOG_TRACE(fmt_str, ...) LOG_AT(::LogLevel::TRACE, fmt_str, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt_str, ...) LOG_AT(::LogLevel::DEBUG, fmt_str, ##__VA_ARGS__)
+#define LOG_INFO(fmt_str, ...)  LOG_AT(::LogLevel::INFO,  fmt_str, ##__VA_ARGS__)
+#define LOG_ERROR(fmt_str, ...) LOG_AT(::LogLevel::ERROR, fmt_str, ##__VA_ARGS__)
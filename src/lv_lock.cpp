@@ -0,0 +1,163 @@
+#include "lv_lock.h"
+#include "histogram.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <thread>
+
+namespace {
+  // sites are shared by every LvLock, keyed by lock name and call site
+  std::mutex sites_lock;
+  std::map<std::tuple<const char *, const char *, int>, LvLock::Site *> sites;
+}
+
+LvLock::LvLock(const char *name)
+  : name(name)
+  , holder(NULL)
+  , acquired_us(0)
+  , acquisitions(0)
+{
+}
+
+LvLock::Site *LvLock::site(const char *file, int line) {
+  std::lock_guard<std::mutex> l(sites_lock);
+  auto key = std::make_tuple(name, file, line);
+  auto entry = sites.find(key);
+  if (entry != sites.end()) {
+    return entry->second;
+  }
+
+  const char *base = strrchr(file, '/');
+  std::string site_name = fmt::format("{}:{}", base != NULL ? base + 1 : file, line);
+  std::string labels = fmt::format("lock=\"{}\",site=\"{}\"", name, site_name);
+
+  Metrics *m = Metrics::get_instance();
+  Site *s = new Site{
+    site_name,
+    m->histogram("guppy_lock_wait_seconds", "Time spent waiting for a lock per call site", labels, 1e-6),
+    m->histogram("guppy_lock_hold_seconds", "Time a lock was held per call site", labels, 1e-6),
+    this,
+    file,
+    line
+  };
+  sites.insert({key, s});
+  return s;
+}
+
+void LvLock::lock(Site *s) {
+  if (s->lock != this) {
+    // a site that takes more than one lock
+    s = site(s->file, s->line);
+  }
+
+  uint64_t start = LvLockWatchdog::now_us();
+  mutex.lock();
+  uint64_t now = LvLockWatchdog::now_us();
+
+  s->wait->observe(now - start);
+  if (now - start > 100) {
+    Trace::get_instance()->complete("lock", s->name.c_str(), start, now - start);
+  }
+
+  acquired_us.store(now, std::memory_order_relaxed);
+  acquisitions.fetch_add(1, std::memory_order_relaxed);
+  holder.store(s, std::memory_order_release);
+}
+
+void LvLock::unlock() {
+  Site *s = holder.load(std::memory_order_relaxed);
+  uint64_t held = LvLockWatchdog::now_us() - acquired_us.load(std::memory_order_relaxed);
+  holder.store(NULL, std::memory_order_release);
+  mutex.unlock();
+
+  if (s == NULL) {
+    return;
+  }
+
+  s->hold->observe(held);
+
+  uint64_t threshold = LvLockWatchdog::get_instance()->get_threshold_us();
+  if (threshold > 0 && held > threshold) {
+    LOG_ERROR("{} held for {} ms at {}", name, held / 1000, s->name);
+  }
+}
+
+LvLockWatchdog::LvLockWatchdog()
+  : threshold_us(0)
+  , last_tick_us(0)
+  , message(NULL)
+  , ui_lock(NULL)
+  , state_lock(NULL)
+{
+}
+
+LvLockWatchdog *LvLockWatchdog::get_instance() {
+  static LvLockWatchdog instance;
+  return &instance;
+}
+
+uint64_t LvLockWatchdog::now_us() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+const char *LvLockWatchdog::get_message() const {
+  const char *m = message.load(std::memory_order_relaxed);
+  return m != NULL ? m : "none";
+}
+
+void LvLockWatchdog::start(uint32_t threshold_ms, LvLock *ui, LvLock *state) {
+  if (threshold_ms == 0 || threshold_us.load() != 0) {
+    return;
+  }
+
+  ui_lock = ui;
+  state_lock = state;
+  tick();
+  threshold_us = static_cast<uint64_t>(threshold_ms) * 1000;
+
+  std::thread([this]() { run(); }).detach();
+  LOG_INFO("lock watchdog started, threshold {} ms", threshold_ms);
+}
+
+void LvLockWatchdog::check(LvLock *l, uint64_t now, uint64_t &reported) {
+  const LvLock::Site *s = l->get_holder();
+  uint64_t acquired = l->get_acquired_us();
+  uint64_t seq = l->get_acquisitions();
+  if (s == NULL || now < acquired || now - acquired < get_threshold_us() || seq == reported) {
+    return;
+  }
+
+  // once per acquisition, the release logs the final duration
+  reported = seq;
+  LOG_ERROR("{} held for {} ms by {}, current message {}",
+            l->get_name(), (now - acquired) / 1000, s->name, get_message());
+}
+
+void LvLockWatchdog::run() {
+  uint64_t threshold = get_threshold_us();
+  uint64_t ui_reported = 0;
+  uint64_t state_reported = 0;
+  uint64_t stalled_tick = 0;
+
+  while (1) {
+    std::this_thread::sleep_for(std::chrono::microseconds(threshold / 4));
+    uint64_t now = now_us();
+
+    check(ui_lock, now, ui_reported);
+    check(state_lock, now, state_reported);
+
+    uint64_t last = last_tick_us.load(std::memory_order_relaxed);
+    if (now > last && now - last >= threshold && last != stalled_tick) {
+      stalled_tick = last;
+      const LvLock::Site *s = ui_lock->get_holder();
+      LOG_ERROR("ui loop has not ticked for {} ms, {} held by {}, current message {}",
+                (now - last) / 1000, ui_lock->get_name(), s != NULL ? s->name : "nobody", get_message());
+    }
+  }
+}
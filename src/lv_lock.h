@@ -0,0 +1,121 @@
+#ifndef __LV_LOCK_H__
+#define __LV_LOCK_H__
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+class Histogram;
+
+// std::mutex that records wait and hold time per call site. The call site
+// is resolved once, into a static at the site, by the macros below, so
+// `LV_LOCK_GUARD(lock, lv_lock);` tags the acquisition with the file and
+// line it was written on and locking only takes the mutex.
+class LvLock {
+ public:
+  struct Site {
+    std::string name;
+    Histogram *wait;
+    Histogram *hold;
+    const LvLock *lock;
+    const char *file;
+    int line;
+  };
+
+  explicit LvLock(const char *name);
+  LvLock(const LvLock &) = delete;
+  LvLock &operator=(const LvLock &) = delete;
+
+  // takes a lock shared by every LvLock, resolve it once per call site
+  Site *site(const char *file, int line);
+
+  void lock(Site *s);
+  void unlock();
+
+  const char *get_name() const { return name; }
+
+  // snapshot for the watchdog, holder is NULL when unlocked
+  const Site *get_holder() const { return holder.load(std::memory_order_acquire); }
+  uint64_t get_acquired_us() const { return acquired_us.load(std::memory_order_acquire); }
+  uint64_t get_acquisitions() const { return acquisitions.load(std::memory_order_relaxed); }
+
+ private:
+  const char *name;
+  std::mutex mutex;
+  std::atomic<Site *> holder;
+  std::atomic<uint64_t> acquired_us;
+  std::atomic<uint64_t> acquisitions;
+};
+
+class LvLockGuard {
+ public:
+  LvLockGuard(LvLock &l, LvLock::Site *s)
+    : l(l)
+    , owned(true)
+  {
+    l.lock(s);
+  }
+
+  ~LvLockGuard() {
+    if (owned) {
+      l.unlock();
+    }
+  }
+
+  void unlock() {
+    if (owned) {
+      owned = false;
+      l.unlock();
+    }
+  }
+
+  LvLockGuard(const LvLockGuard &) = delete;
+  LvLockGuard &operator=(const LvLockGuard &) = delete;
+
+ private:
+  LvLock &l;
+  bool owned;
+};
+
+#define LV_LOCK_SITE(l) \
+  ([](LvLock &lk) { static LvLock::Site *s = lk.site(__FILE__, __LINE__); return s; }(l))
+
+#define LV_LOCK_GUARD(var, l) LvLockGuard var((l), LV_LOCK_SITE(l))
+
+// Logs when a watched lock is held, or the ui loop has not ticked, for
+// longer than the threshold, together with the websocket message being
+// dispatched at the time.
+class LvLockWatchdog {
+ public:
+  static LvLockWatchdog *get_instance();
+
+  void start(uint32_t threshold_ms, LvLock *ui_lock, LvLock *state_lock);
+
+  // called once per ui loop iteration
+  void tick() { last_tick_us.store(now_us(), std::memory_order_relaxed); }
+
+  // method must stay valid, NULL when idle
+  void set_message(const char *method) { message.store(method, std::memory_order_relaxed); }
+  const char *get_message() const;
+
+  uint64_t get_threshold_us() const { return threshold_us.load(std::memory_order_relaxed); }
+
+  static uint64_t now_us();
+
+ private:
+  LvLockWatchdog();
+  LvLockWatchdog(const LvLockWatchdog &) = delete;
+  LvLockWatchdog &operator=(const LvLockWatchdog &) = delete;
+
+  void run();
+  void check(LvLock *l, uint64_t now, uint64_t &reported);
+
+  std::atomic<uint64_t> threshold_us;
+  std::atomic<uint64_t> last_tick_us;
+  std::atomic<const char *> message;
+  LvLock *ui_lock;
+  LvLock *state_lock;
+};
+
+#endif // __LV_LOCK_H__
@@ -20,8 +20,10 @@ namespace fs = std::experimental::filesystem;
 static void hal_init(lv_color_t p, lv_color_t s);
 
 #include "guppyscreen.h"
+#include "fb_direct.h"
 #include "hv/hlog.h"
 #include "config.h"
+#include "logger.h"
 
 #include <algorithm>
 
@@ -30,6 +32,8 @@ using namespace hv;
 #define DISP_BUF_SIZE (128 * 1024)
 
 int main(void) {
+    log_start();
+
     const char* config_file_env = std::getenv("CONFIG_FILE");
     fs::path config_path = config_file_env && config_file_env[0] != '\0'
         ? fs::path(config_file_env)
@@ -97,7 +101,7 @@ static void hal_init(lv_color_t primary, lv_color_t secondary) {
     static lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
     disp_drv.draw_buf   = &disp_buf;
-    disp_drv.flush_cb   = fbdev_flush;
+    disp_drv.flush_cb   = FbDirect::get_instance()->open(FBDEV_PATH) ? FbDirect::flush_cb : fbdev_flush;
 
     uint32_t width;
     uint32_t height;
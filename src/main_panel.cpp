@@ -24,12 +24,12 @@ LV_FONT_DECLARE(materialdesign_font_40);
 #define CONSOLE_SYMBOL u8"\U000F018D"
 
 MainPanel::MainPanel(KWebSocketClient &websocket,
-		     std::mutex &lock,
+		     LvLock &lock,
 		     SpoolmanPanel &sm)
   : NotifyConsumer(lock)
   , ws(websocket)
-  , homing_panel(ws, lock)
-  , fan_panel(ws, lock)
+  , homing_panel("homing", true, [this]() { return new HomingPanel(ws, lv_lock); })
+  , fan_panel("fan", true, [this]() { return new FanPanel(ws, lv_lock, display_fans); })
   , led_panel(ws, lock)    
   , tabview(lv_tabview_create(lv_scr_act(), LV_DIR_LEFT, 60))
   , main_tab(lv_tabview_add_tab(tabview, HOME_SYMBOL))
@@ -43,9 +43,17 @@ MainPanel::MainPanel(KWebSocketClient &websocket,
   , print_status_panel(websocket, lock, main_cont)
   , print_panel(ws, lock, print_status_panel)
   , numpad(Numpad(main_cont))
-  , extruder_panel(ws, lock, numpad, sm)
+  , extruder_panel("extruder", true, [this]() {
+      ExtruderPanel *panel = new ExtruderPanel(ws, lv_lock, numpad, spoolman_panel);
+      if (spoolman_enabled) {
+        panel->enable_spoolman();
+      }
+      return panel;
+    })
   , prompt_panel(websocket, lock, main_cont)
   , spoolman_panel(sm)
+  , display_fans(json::object())
+  , spoolman_enabled(false)
   , temp_cont(lv_obj_create(main_cont))
   , temp_chart(lv_chart_create(main_cont))
   , homing_btn(main_cont, &move, "Homing", &MainPanel::_handle_homing_cb, this)
@@ -63,6 +71,7 @@ MainPanel::MainPanel(KWebSocketClient &websocket,
     lv_style_set_border_width(&style, 0);
     lv_style_set_bg_color(&style, lv_palette_darken(LV_PALETTE_GREY, 4));
 
+    print_state = status_fields.add("print_stats", "state");
     ws.register_notify_update(this);
 
     lv_obj_add_event_cb(tabview, &MainPanel::_tabview_event_cb,
@@ -81,18 +90,19 @@ MainPanel::~MainPanel() {
 void MainPanel::subscribe() {
   LOG_TRACE("main panel subscribing");
   print_panel.subscribe();
+  console_panel.fetch_commands();
 }
 
 void MainPanel::init(json &j) {
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
   for (const auto &el : sensors) {
-    auto target_value = j[json::json_pointer(fmt::format("/result/status/{}/target", el.first))];
+    auto &target_value = j[json::json_pointer(fmt::format("/result/status/{}/target", el.first))];
     if (!target_value.is_null()) {
       int target = target_value.template get<int>();
       el.second->update_target(target);
     }
 
-    auto temp_value = j[json::json_pointer(fmt::format("/result/status/{}/temperature", el.first))];
+    auto &temp_value = j[json::json_pointer(fmt::format("/result/status/{}/temperature", el.first))];
     if (!temp_value.is_null()) {
       int value = temp_value.template get<int>();
       el.second->update_series(value);
@@ -103,26 +113,27 @@ void MainPanel::init(json &j) {
   print_status_panel.init(fans);
 }
 
-void MainPanel::consume(json &j) {  
-  std::lock_guard<std::mutex> lock(lv_lock);
-  for (const auto &el : sensors) {
-    auto target_value = j[json::json_pointer(fmt::format("/params/0/{}/target", el.first))];
-    if (!target_value.is_null()) {
-      int target = target_value.template get<int>();
-      el.second->update_target(target);
+void MainPanel::consume(json &j) {
+  LV_LOCK_GUARD(lock, lv_lock);
+  status_fields.read(j);
+  for (const auto &f : sensor_fields) {
+    const json *target_value = status_fields.get(f.target);
+    if (target_value != NULL) {
+      int target = target_value->template get<int>();
+      f.sensor->update_target(target);
     }
 
-    auto temp_value = j[json::json_pointer(fmt::format("/params/0/{}/temperature", el.first))];
-    if (!temp_value.is_null()) {
-      int value = temp_value.template get<int>();
-      el.second->update_series(value);
-      el.second->update_value(value);
+    const json *temp_value = status_fields.get(f.temperature);
+    if (temp_value != NULL) {
+      int value = temp_value->template get<int>();
+      f.sensor->update_series(value);
+      f.sensor->update_value(value);
     }
   }
 
-  json &pstat_state = j["/params/0/print_stats/state"_json_pointer];
-  if (!pstat_state.is_null()) {
-    if (pstat_state.template get<std::string>() != "printing") {
+  const json *pstat_state = status_fields.get(print_state);
+  if (pstat_state != NULL) {
+    if (pstat_state->template get_ref<const std::string &>() != "printing") {
       homing_btn.enable();
       extrude_btn.enable();
     } else {
@@ -178,21 +189,21 @@ void MainPanel::create_panel() {
 void MainPanel::handle_homing_cb(lv_event_t *event) {
   if (lv_event_get_code(event) == LV_EVENT_CLICKED) {
     LOG_TRACE("clicked homing");
-    homing_panel.foreground();
+    homing_panel.get().foreground();
   }
 }
 
 void MainPanel::handle_extrude_cb(lv_event_t *event) {
   if (lv_event_get_code(event) == LV_EVENT_CLICKED) {
     LOG_TRACE("clicked extruder");
-    extruder_panel.foreground();
+    extruder_panel.get().foreground();
   }
 }
 
 void MainPanel::handle_fanpanel_cb(lv_event_t *event) {
   if (lv_event_get_code(event) == LV_EVENT_CLICKED) {
     LOG_TRACE("clicked fan panel");
-    fan_panel.foreground();
+    fan_panel.get().foreground();
   }
 }
 
@@ -260,8 +271,11 @@ void MainPanel::create_main(lv_obj_t * parent) {
 }
 
 void MainPanel::create_sensors(json &temp_sensors) {
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
   sensors.clear();
+  sensor_fields.clear();
+  status_fields.clear();
+  print_state = status_fields.add("print_stats", "state");
   for (auto &sensor : temp_sensors.items()) {
     std::string key = sensor.key();
     bool controllable = sensor.value()["controllable"].template get<bool>();
@@ -292,18 +306,29 @@ void MainPanel::create_sensors(json &temp_sensors) {
     lv_chart_series_t *temp_series =
       lv_chart_add_series(temp_chart, color_code, LV_CHART_AXIS_PRIMARY_Y);
 
-    sensors.insert({key, std::make_shared<SensorContainer>(ws, temp_cont, sensor_img, 150,
+    auto container = std::make_shared<SensorContainer>(ws, temp_cont, sensor_img, 150,
 			   display_name.c_str(), color_code, controllable, false, numpad, key,
-        		   temp_chart, temp_series)});
+        		   temp_chart, temp_series);
+    sensors.insert({key, container});
+    sensor_fields.push_back({container.get(), status_fields.add(key, "target"),
+                             status_fields.add(key, "temperature")});
   }
 }
 
 void MainPanel::create_fans(json &fans) {
-  fan_panel.create_fans(fans);
+  LV_LOCK_GUARD(lock, lv_lock);
+  display_fans = fans;
+  FanPanel *panel = fan_panel.peek();
+  lock.unlock();
+
+  // teardown deletes on this thread, the panel outlives this call
+  if (panel != NULL) {
+    panel->create_fans(fans);
+  }
 }
 
 void MainPanel::create_leds(json &leds) {
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
   if (leds.is_array() && !leds.empty()) {
     led_btn.enable();
   } else {
@@ -315,5 +340,11 @@ void MainPanel::create_leds(json &leds) {
 
 void MainPanel::enable_spoolman() {
   spoolman_panel.init();
-  extruder_panel.enable_spoolman();
+
+  LV_LOCK_GUARD(lock, lv_lock);
+  spoolman_enabled = true;
+  ExtruderPanel *panel = extruder_panel.peek();
+  if (panel != NULL) {
+    panel->enable_spoolman();
+  }
 }
@@ -17,16 +17,18 @@
 #include "sysinfo_panel.h"
 #include "print_status_panel.h"
 #include "spoolman_panel.h"
+#include "panel_manager.h"
+#include "status_fields.h"
 #include "lvgl/lvgl.h"
 
-#include <mutex>
+#include "lv_lock.h"
 #include <map>
 #include <memory>
 
 class MainPanel : public NotifyConsumer {
  public:
   MainPanel(KWebSocketClient &ws,
-	    std::mutex &lv_lock,
+	    LvLock &lv_lock,
 	    SpoolmanPanel &sm);
 
   ~MainPanel();
@@ -90,8 +92,9 @@ class MainPanel : public NotifyConsumer {
   void create_main(lv_obj_t *parent);
   static void _tabview_event_cb(lv_event_t *e);
   KWebSocketClient &ws;
-  HomingPanel homing_panel;
-  FanPanel fan_panel;
+  // built on first use, torn down by PanelManager when not needed
+  LazyPanel<HomingPanel> homing_panel;
+  LazyPanel<FanPanel> fan_panel;
   LedPanel led_panel;
   lv_obj_t *tabview;
   lv_obj_t *main_tab;
@@ -105,9 +108,12 @@ class MainPanel : public NotifyConsumer {
   PrintStatusPanel print_status_panel;
   PrintPanel print_panel;
   Numpad numpad;
-  ExtruderPanel extruder_panel;
+  LazyPanel<ExtruderPanel> extruder_panel;
   PromptPanel prompt_panel;
   SpoolmanPanel &spoolman_panel;
+  // kept for the lazy panels, written from the websocket thread under lv_lock
+  json display_fans;
+  bool spoolman_enabled;
   
   lv_style_t style;
 
@@ -115,6 +121,16 @@ class MainPanel : public NotifyConsumer {
   lv_obj_t *temp_chart;
 
   std::map<std::string, std::shared_ptr<SensorContainer>> sensors;
+
+  struct SensorFields {
+    SensorContainer *sensor;
+    StatusFields::Id target;
+    StatusFields::Id temperature;
+  };
+  // what consume reads, set up with the sensors
+  StatusFields status_fields;
+  std::vector<SensorFields> sensor_fields;
+  StatusFields::Id print_state;
   
   ButtonContainer homing_btn;
   ButtonContainer extrude_btn;
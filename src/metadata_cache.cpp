@@ -0,0 +1,216 @@
+#include "metadata_cache.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <experimental/filesystem>
+#include <fmt/format.h>
+
+namespace fs = std::experimental::filesystem;
+
+namespace {
+  // what the file panel and the list read
+  const char *KEPT[] = {"modified", "size", "slicer", "slicer_version", "estimated_time",
+                        "filament_total", "filament_weight_total", "filament_type",
+                        "layer_height", "object_height", "thumbnails"};
+
+  json trim(const json &result) {
+    json out = json::object();
+    if (!result.is_object()) {
+      return out;
+    }
+    for (const char *k : KEPT) {
+      auto it = result.find(k);
+      if (it != result.end()) {
+        out[k] = *it;
+      }
+    }
+    return out;
+  }
+
+  double number(const json &result, const char *key) {
+    auto it = result.find(key);
+    return it != result.end() && it->is_number() ? it->template get<double>() : 0;
+  }
+
+  std::string summarize(const json &result) {
+    std::string s;
+    auto add = [&s](const std::string &part) {
+      if (!s.empty()) {
+        s.append("  ");
+      }
+      s.append(part);
+    };
+
+    int64_t eta = number(result, "estimated_time");
+    if (eta > 0) {
+      int64_t h = eta / 3600;
+      int64_t m = std::max<int64_t>((eta % 3600) / 60, h > 0 ? 0 : 1);
+      // min so it doesn't read as metres of filament
+      add(h > 0 ? fmt::format("{}h{:02}m", h, m) : fmt::format("{}min", m));
+    }
+
+    double grams = number(result, "filament_weight_total");
+    double mm = number(result, "filament_total");
+    if (grams > 0) {
+      add(fmt::format("{:.0f}g", grams));
+    } else if (mm > 0) {
+      add(fmt::format("{:.1f}m", mm / 1000));
+    }
+
+    auto slicer = result.find("slicer");
+    if (slicer != result.end() && slicer->is_string()) {
+      add(slicer->template get<std::string>());
+    }
+    return s;
+  }
+}
+
+MetadataCache::MetadataCache(size_t c)
+  : capacity(std::max<size_t>(c, 1))
+  , file_lines(0)
+  , hits(Metrics::get_instance()->counter("guppy_metadata_cache_total", "Gcode metadata lookups", "result=\"hit\""))
+  , misses(Metrics::get_instance()->counter("guppy_metadata_cache_total", "Gcode metadata lookups", "result=\"miss\""))
+{
+}
+
+void MetadataCache::load(const std::string &p) {
+  path = p;
+  entries.clear();
+  index.clear();
+  file_lines = 0;
+  if (path.empty()) {
+    return;
+  }
+
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+
+  // oldest first, a later line for a path replaces an earlier one
+  std::ifstream f(path);
+  std::string line;
+  while (std::getline(f, line)) {
+    file_lines++;
+    json j = json::parse(line, nullptr, false);
+    if (j.is_discarded() || !j.is_object() || !j["path"].is_string()) {
+      continue;
+    }
+    insert(j["path"].template get<std::string>(), number(j, "modified"),
+           static_cast<uint64_t>(number(j, "size")), std::move(j["result"]));
+  }
+  LOG_DEBUG("metadata cache {}, {} files", path, entries.size());
+
+  if (file_lines >= 2 * capacity) {
+    rewrite();
+  }
+}
+
+json *MetadataCache::get(const std::string &p, double modified, uint64_t size) {
+  auto it = index.find(p);
+  if (it == index.end() || it->second->modified != modified || it->second->size != size) {
+    misses->fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+
+  hits->fetch_add(1, std::memory_order_relaxed);
+  entries.splice(entries.begin(), entries, it->second);
+  return &it->second->metadata;
+}
+
+bool MetadataCache::contains(const std::string &p, double modified, uint64_t size) const {
+  return find(p, modified, size) != NULL;
+}
+
+const char *MetadataCache::summary(const std::string &p, double modified, uint64_t size) const {
+  const Entry *e = find(p, modified, size);
+  return e == NULL ? "" : e->summary.c_str();
+}
+
+json &MetadataCache::put(const std::string &p, double modified, uint64_t size, const json &response) {
+  auto result = response.find("result");
+  Entry &e = insert(p, modified, size, trim(result == response.end() ? json() : *result));
+  append(p, e);
+  return e.metadata;
+}
+
+void MetadataCache::erase(const std::string &p) {
+  auto it = index.find(p);
+  if (it != index.end()) {
+    entries.erase(it->second);
+    index.erase(it);
+  }
+}
+
+const MetadataCache::Entry *MetadataCache::find(const std::string &p, double modified, uint64_t size) const {
+  auto it = index.find(p);
+  if (it == index.end() || it->second->modified != modified || it->second->size != size) {
+    return NULL;
+  }
+  return &*it->second;
+}
+
+MetadataCache::Entry &MetadataCache::insert(const std::string &p, double modified, uint64_t size, json result) {
+  auto it = index.find(p);
+  if (it != index.end()) {
+    entries.splice(entries.begin(), entries, it->second);
+  } else {
+    if (entries.size() >= capacity) {
+      index.erase(entries.back().path);
+      entries.pop_back();
+    }
+    entries.emplace_front();
+    entries.front().path = p;
+    index[p] = entries.begin();
+  }
+
+  Entry &e = entries.front();
+  e.modified = modified;
+  e.size = size;
+  e.summary = summarize(result);
+  e.metadata = json::object();
+  e.metadata["result"] = std::move(result);
+  return e;
+}
+
+void MetadataCache::append(const std::string &p, const Entry &e) {
+  if (path.empty()) {
+    return;
+  }
+  if (file_lines + 1 >= 2 * capacity) {
+    rewrite();
+    return;
+  }
+
+  json line = {{"path", p}, {"modified", e.modified}, {"size", e.size}, {"result", e.metadata["result"]}};
+  std::ofstream f(path, std::ios::app);
+  f << line.dump() << '\n';
+  if (f) {
+    file_lines++;
+  } else {
+    LOG_ERROR("failed to append metadata cache {}", path);
+  }
+}
+
+void MetadataCache::rewrite() {
+  std::string tmp = path + ".tmp";
+  {
+    // least recently shown first so a reload keeps the order
+    std::ofstream f(tmp, std::ios::trunc);
+    for (auto e = entries.rbegin(); e != entries.rend(); ++e) {
+      json line = {{"path", e->path}, {"modified", e->modified}, {"size", e->size},
+                   {"result", e->metadata["result"]}};
+      f << line.dump() << '\n';
+    }
+    if (!f) {
+      LOG_ERROR("failed to write metadata cache {}", tmp);
+      return;
+    }
+  }
+
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    LOG_ERROR("failed to replace metadata cache {}", path);
+    return;
+  }
+  file_lines = entries.size();
+}
@@ -0,0 +1,67 @@
+#ifndef __METADATA_CACHE_H__
+#define __METADATA_CACHE_H__
+
+#include "metrics.h"
+#include "hv/json.hpp"
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+using json = nlohmann::json;
+
+// server.files.metadata responses by gcode path, good for as long as the
+// file's modified time and size are those it was fetched for. Up to the
+// capacity are kept, the least recently shown go first. Each entry is
+// appended to a file as it comes in and the file is rewritten from memory
+// when it grows to twice the capacity, so the cache survives a restart.
+//
+// Only what the print panel shows is kept of a response. Everything here
+// runs with lv_lock held.
+class MetadataCache {
+ public:
+  explicit MetadataCache(size_t capacity);
+
+  // an empty path keeps the cache in memory only
+  void load(const std::string &path);
+
+  // the response as put, NULL if missing or stale. counts a hit or a miss
+  json *get(const std::string &path, double modified, uint64_t size);
+  // for prefetching, not counted
+  bool contains(const std::string &path, double modified, uint64_t size) const;
+  // print time, filament and slicer on one line, "" if missing or stale
+  const char *summary(const std::string &path, double modified, uint64_t size) const;
+
+  json &put(const std::string &path, double modified, uint64_t size, const json &response);
+  void erase(const std::string &path);
+
+  size_t size() const { return entries.size(); }
+  size_t get_capacity() const { return capacity; }
+
+ private:
+  struct Entry {
+    std::string path;
+    double modified;
+    uint64_t size;
+    // {"result": {...}} as server.files.metadata has it
+    json metadata;
+    std::string summary;
+  };
+
+  const Entry *find(const std::string &path, double modified, uint64_t size) const;
+  Entry &insert(const std::string &path, double modified, uint64_t size, json result);
+  void append(const std::string &path, const Entry &e);
+  void rewrite();
+
+  size_t capacity;
+  // front is the most recently shown
+  std::list<Entry> entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  std::string path;
+  size_t file_lines;
+  Metrics::Counter *hits;
+  Metrics::Counter *misses;
+};
+
+#endif // __METADATA_CACHE_H__
@@ -0,0 +1,118 @@
+#include "metrics.h"
+
+#include "logger.h"
+
+#include <fmt/format.h>
+
+Metrics *Metrics::get_instance() {
+  static Metrics instance;
+  return &instance;
+}
+
+Metrics::Family &Metrics::family(const std::string &name,
+                                 const std::string &help,
+                                 const std::string &type,
+                                 double scale) {
+  auto &f = families[name];
+  if (f.type.empty()) {
+    f.help = help;
+    f.type = type;
+    f.scale = scale;
+  }
+  return f;
+}
+
+Metrics::Counter *Metrics::counter(const std::string &name,
+                                   const std::string &help,
+                                   const std::string &labels) {
+  std::lock_guard<std::mutex> l(lock);
+  auto &s = family(name, help, "counter", 1.0).series[labels];
+  if (!s.owned_counter) {
+    s.owned_counter = std::make_unique<Counter>(0);
+    s.counter = s.owned_counter.get();
+  }
+  return s.owned_counter.get();
+}
+
+void Metrics::register_counter(const std::string &name,
+                               const std::string &help,
+                               const std::string &labels,
+                               const Counter *c) {
+  std::lock_guard<std::mutex> l(lock);
+  family(name, help, "counter", 1.0).series[labels].counter = c;
+}
+
+Histogram *Metrics::histogram(const std::string &name,
+                              const std::string &help,
+                              const std::string &labels,
+                              double scale) {
+  std::lock_guard<std::mutex> l(lock);
+  auto &s = family(name, help, "histogram", scale).series[labels];
+  if (!s.owned) {
+    s.owned = std::make_unique<Histogram>();
+    s.histogram = s.owned.get();
+  }
+  return s.owned.get();
+}
+
+void Metrics::register_histogram(const std::string &name,
+                                 const std::string &help,
+                                 const std::string &labels,
+                                 const Histogram *h,
+                                 double scale) {
+  std::lock_guard<std::mutex> l(lock);
+  family(name, help, "histogram", scale).series[labels].histogram = h;
+}
+
+void Metrics::gauge(const std::string &name,
+                    const std::string &help,
+                    std::function<double()> fn) {
+  std::lock_guard<std::mutex> l(lock);
+  family(name, help, "gauge", 1.0).gauge = fn;
+}
+
+std::string Metrics::render() {
+  std::lock_guard<std::mutex> l(lock);
+  fmt::memory_buffer out;
+  auto it = std::back_inserter(out);
+
+  for (const auto &entry : families) {
+    const std::string &name = entry.first;
+    const Family &f = entry.second;
+    fmt::format_to(it, "# HELP {} {}\n# TYPE {} {}\n", name, f.help, name, f.type);
+
+    if (f.gauge) {
+      fmt::format_to(it, "{} {}\n", name, f.gauge());
+      continue;
+    }
+
+    for (const auto &s : f.series) {
+      const std::string &labels = s.first;
+      std::string braced = labels.empty() ? "" : "{" + labels + "}";
+      std::string prefix = labels.empty() ? "" : labels + ",";
+
+      if (s.second.counter) {
+        fmt::format_to(it, "{}{} {}\n", name, braced, s.second.counter->load(std::memory_order_relaxed));
+        continue;
+      }
+
+      const Histogram *h = s.second.histogram;
+      if (h == NULL) {
+        continue;
+      }
+
+      // exported buckets are cumulative, the unbounded last bucket is +Inf
+      uint64_t cumulative = 0;
+      for (size_t i = 0; i + 1 < Histogram::BUCKETS; i++) {
+        cumulative += h->bucket_count(i);
+        fmt::format_to(it, "{}_bucket{{{}le=\"{}\"}} {}\n",
+                       name, prefix, Histogram::bucket_bound(i) * f.scale, cumulative);
+      }
+      fmt::format_to(it, "{}_bucket{{{}le=\"+Inf\"}} {}\n", name, prefix, h->count());
+      fmt::format_to(it, "{}_sum{} {}\n", name, braced, h->sum() * f.scale);
+      fmt::format_to(it, "{}_count{} {}\n", name, braced, h->count());
+    }
+  }
+
+  return fmt::to_string(out);
+}
@@ -0,0 +1,83 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include "histogram.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Registry of counters, gauges and histograms rendered in the Prometheus
+// text exposition format. Lookups take a lock, callers on hot paths should
+// keep the returned pointer, it stays valid for the lifetime of the process.
+class Metrics {
+ public:
+  typedef std::atomic<uint64_t> Counter;
+
+  static Metrics *get_instance();
+
+  // labels are preformatted, e.g. method="notify_status_update"
+  Counter *counter(const std::string &name,
+                   const std::string &help,
+                   const std::string &labels = "");
+
+  // scale converts observed values to the exported unit, e.g. 1e-6 for us -> s
+  Histogram *histogram(const std::string &name,
+                       const std::string &help,
+                       const std::string &labels = "",
+                       double scale = 1.0);
+
+  // export a counter owned elsewhere
+  void register_counter(const std::string &name,
+                        const std::string &help,
+                        const std::string &labels,
+                        const Counter *c);
+
+  // export a histogram owned elsewhere
+  void register_histogram(const std::string &name,
+                          const std::string &help,
+                          const std::string &labels,
+                          const Histogram *h,
+                          double scale = 1.0);
+
+  // sampled when rendered, fn may be called from the http server thread
+  void gauge(const std::string &name,
+             const std::string &help,
+             std::function<double()> fn);
+
+  std::string render();
+
+ private:
+  Metrics() {};
+  Metrics(const Metrics &) = delete;
+  Metrics &operator=(const Metrics &) = delete;
+
+  struct Series {
+    std::unique_ptr<Counter> owned_counter;
+    const Counter *counter;
+    std::unique_ptr<Histogram> owned;
+    const Histogram *histogram;
+  };
+
+  struct Family {
+    std::string help;
+    std::string type;
+    double scale;
+    std::function<double()> gauge;
+    std::map<std::string, Series> series;
+  };
+
+  Family &family(const std::string &name,
+                 const std::string &help,
+                 const std::string &type,
+                 double scale);
+
+  std::mutex lock;
+  std::map<std::string, Family> families;
+};
+
+#endif // __METRICS_H__
@@ -0,0 +1,52 @@
+#include "metrics_server.h"
+#include "metrics.h"
+#include "logger.h"
+
+#include <unistd.h>
+
+MetricsServer::MetricsServer()
+  : running(false)
+{
+  router.GET("/metrics", [](HttpRequest *req, HttpResponse *resp) {
+    resp->SetHeader("Content-Type", "text/plain; version=0.0.4");
+    resp->body = Metrics::get_instance()->render();
+    return 200;
+  });
+}
+
+MetricsServer::~MetricsServer() {
+  stop();
+}
+
+int MetricsServer::start(const std::string &host, int port) {
+  if (running) {
+    return 0;
+  }
+
+  if (port < 0) {
+    // stale socket from a previous run
+    unlink(host.c_str());
+  }
+
+  server.registerHttpService(&router);
+  server.setHost(host.c_str());
+  server.setPort(port);
+  server.setThreadNum(1);
+
+  int ret = server.start();
+  if (ret != 0) {
+    LOG_ERROR("failed to start metrics server on {}:{}, {}", host, port, ret);
+    return ret;
+  }
+
+  LOG_INFO("serving metrics on {}:{}", host, port);
+  running = true;
+  return 0;
+}
+
+void MetricsServer::stop() {
+  if (running) {
+    server.stop();
+    running = false;
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef __METRICS_SERVER_H__
+#define __METRICS_SERVER_H__
+
+#include "hv/HttpServer.h"
+
+#include <string>
+
+// Serves Metrics::render() on GET /metrics from libhv's own worker thread.
+class MetricsServer {
+ public:
+  MetricsServer();
+  ~MetricsServer();
+
+  // a negative port binds a unix socket at path host
+  int start(const std::string &host, int port);
+  void stop();
+
+ private:
+  hv::HttpService router;
+  hv::HttpServer server;
+  bool running;
+};
+
+#endif // __METRICS_SERVER_H__
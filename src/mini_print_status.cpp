@@ -7,6 +7,7 @@ MiniPrintStatus::MiniPrintStatus(lv_obj_t *parent,
   : cont(lv_obj_create(parent))
   , progress_bar(lv_arc_create(cont))
   , thumb(lv_img_create(cont))
+  , thumb_view(thumb)
   , status_label(lv_label_create(cont))
   , status("n/a")
   , eta("...")
@@ -88,20 +89,15 @@ void MiniPrintStatus::update_progress(int p) {
   lv_arc_set_value(progress_bar, p);
 }
 
-void MiniPrintStatus::update_img(const std::string &img_path, size_t twidth) {
+void MiniPrintStatus::update_img(const std::string &img_path) {
   auto screen_width = lv_disp_get_physical_hor_res(NULL);
-  uint32_t normalized_thumb_scale = ((0.05 * (double)screen_width) / (double)twidth) * 256;
-  lv_img_set_zoom(thumb, normalized_thumb_scale);  
-  lv_img_set_src(thumb, img_path.c_str());
+  thumb_view.show(img_path, 0.05 * screen_width);
 }
 
 void MiniPrintStatus::reset() {
   lv_arc_set_value(progress_bar, 0);
 
-  // free src
-  lv_img_set_src(thumb, NULL);
-  // hack to color in empty space.
-  ((lv_img_t*)thumb)->src_type = LV_IMG_SRC_SYMBOL;
+  thumb_view.clear();
 
   eta = "...";
   status = "n/a";  
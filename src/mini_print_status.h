@@ -2,6 +2,7 @@
 #define __MINI_PRINT_STATUS__
 
 #include "lvgl/lvgl.h"
+#include "thumbnail_service.h"
 #include <string>
 
 class MiniPrintStatus {
@@ -19,13 +20,14 @@ class MiniPrintStatus {
   void update_eta(std::string &eta_str);
   void update_status(std::string &status_str);
   void update_progress(int p);
-  void update_img(const std::string &img_path, size_t twidth);
+  void update_img(const std::string &img_path);
   void reset();
 
  private:
   lv_obj_t *cont;
   lv_obj_t *progress_bar;  
   lv_obj_t *thumb;
+  ThumbnailView thumb_view;
   lv_obj_t *status_label;
   std::string status;
   std::string eta;
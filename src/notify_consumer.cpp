@@ -1,8 +1,8 @@
-#include <mutex>
+#include "lv_lock.h"
 
 #include "notify_consumer.h"
 
-NotifyConsumer::NotifyConsumer(std::mutex &lock)
+NotifyConsumer::NotifyConsumer(LvLock &lock)
   : lv_lock(lock) {
 }
 
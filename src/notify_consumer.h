@@ -2,18 +2,47 @@
 #define __NOTIFY_CONSUMER_H__
 
 #include "hv/json.hpp"
-#include <mutex>
+#include "lv_lock.h"
+
+#include <string>
 
 using json = nlohmann::json;
 
+// Lookups into a notify_status_update, {"params": [{object: {..}}, eventtime]}.
+// Unlike operator[] with a json_pointer, nothing is parsed per call and
+// missing keys aren't added to the update.
+namespace StatusUpdate {
+  // params[0], NULL when the update has none
+  inline const json *status(const json &j) {
+    auto params = j.find("params");
+    if (params == j.end() || !params->is_array() || params->empty() || !(*params)[0].is_object()) {
+      return NULL;
+    }
+    return &(*params)[0];
+  }
+
+  // status[object][field], NULL when missing or null
+  inline const json *field(const json *status, const std::string &object, const char *field) {
+    if (status == NULL) {
+      return NULL;
+    }
+    auto obj = status->find(object);
+    if (obj == status->end() || !obj->is_object()) {
+      return NULL;
+    }
+    auto value = obj->find(field);
+    return value == obj->end() || value->is_null() ? NULL : &*value;
+  }
+}
+
 class NotifyConsumer {
  public:
-  NotifyConsumer(std::mutex &lv_lock);
+  NotifyConsumer(LvLock &lv_lock);
   ~NotifyConsumer();
   virtual void consume(nlohmann::json &data) = 0;
   // virtual void consume(std::string &str) = 0;
  protected:
-  std::mutex &lv_lock;
+  LvLock &lv_lock;
 };
 
 #endif // __NOTIFY_CONSUMER_H__
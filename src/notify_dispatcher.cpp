@@ -0,0 +1,82 @@
+#include "notify_dispatcher.h"
+#include "logger.h"
+#include "metrics.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <typeinfo>
+
+NotifyDispatcher::NotifyDispatcher()
+  : consumers(std::make_shared<const Entries>())
+{
+}
+
+void NotifyDispatcher::add(NotifyConsumer *consumer) {
+  std::string name = consumer_name(consumer);
+
+  std::lock_guard<std::mutex> guard(lock);
+  if (contains_locked(consumer)) {
+    return;
+  }
+
+  auto m = metrics.find(name);
+  if (m == metrics.end()) {
+    Histogram *h = Metrics::get_instance()->histogram(
+      "guppy_ws_consume_seconds", "Time spent in NotifyConsumer::consume per status update",
+      fmt::format("consumer=\"{}\"", name), 1e-6);
+    m = metrics.insert({name, {name, h}}).first;
+  }
+
+  auto next = std::make_shared<Entries>(*consumers);
+  next->push_back({consumer, &m->second});
+  consumers = next;
+}
+
+void NotifyDispatcher::remove(NotifyConsumer *consumer) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto next = std::make_shared<Entries>(*consumers);
+  next->erase(std::remove_if(next->begin(), next->end(),
+                             [consumer](const Entry &e) { return e.consumer == consumer; }),
+              next->end());
+  consumers = next;
+}
+
+std::vector<NotifyConsumer *> NotifyDispatcher::get_consumers() const {
+  std::vector<NotifyConsumer *> out;
+  for (const Entry &e : *snapshot()) {
+    out.push_back(e.consumer);
+  }
+  return out;
+}
+
+bool NotifyDispatcher::contains(NotifyConsumer *consumer) const {
+  std::lock_guard<std::mutex> guard(lock);
+  return contains_locked(consumer);
+}
+
+bool NotifyDispatcher::contains_locked(NotifyConsumer *consumer) const {
+  return std::any_of(consumers->begin(), consumers->end(),
+                     [consumer](const Entry &e) { return e.consumer == consumer; });
+}
+
+std::shared_ptr<const NotifyDispatcher::Entries> NotifyDispatcher::snapshot() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return consumers;
+}
+
+std::string NotifyDispatcher::consumer_name(NotifyConsumer *consumer) {
+  int status = 0;
+  char *demangled = abi::__cxa_demangle(typeid(*consumer).name(), NULL, NULL, &status);
+  std::string name = status == 0 ? demangled : typeid(*consumer).name();
+  free(demangled);
+  return name;
+}
+
+uint64_t NotifyDispatcher::now_us() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
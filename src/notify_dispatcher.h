@@ -0,0 +1,77 @@
+#ifndef __NOTIFY_DISPATCHER_H__
+#define __NOTIFY_DISPATCHER_H__
+
+#include "notify_consumer.h"
+#include "histogram.h"
+#include "hv/json.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Fans notify_status_update out to the registered consumers in order,
+// timing each one. Kept apart from the websocket client so the path can be
+// driven without a connection (tests/test_alloc_budget.cpp).
+//
+// Panels are created and torn down on the UI thread while updates are
+// dispatched on the websocket loop, so the consumer list is copy on write.
+// A dispatch keeps going over the list it started with, a consumer removed
+// meanwhile may still see that one update.
+class NotifyDispatcher {
+ public:
+  struct ConsumerMetrics {
+    std::string name;
+    Histogram *consume;
+  };
+
+  NotifyDispatcher();
+
+  void add(NotifyConsumer *consumer);
+  void remove(NotifyConsumer *consumer);
+
+  std::vector<NotifyConsumer *> get_consumers() const;
+  bool contains(NotifyConsumer *consumer) const;
+
+  // observe(consumer, metrics, start_us, dur_us) runs after each consumer
+  template <typename F>
+  void dispatch(json &j, F &&observe) {
+    std::shared_ptr<const Entries> current = snapshot();
+    for (const Entry &e : *current) {
+      uint64_t start = now_us();
+      e.consumer->consume(j);
+      uint64_t dur = now_us() - start;
+
+      e.metrics->consume->observe(dur);
+      observe(e.consumer, *e.metrics, start, dur);
+    }
+  }
+
+  void dispatch(json &j) {
+    dispatch(j, [](NotifyConsumer *, const ConsumerMetrics &, uint64_t, uint64_t) {});
+  }
+
+  static std::string consumer_name(NotifyConsumer *consumer);
+
+ private:
+  struct Entry {
+    NotifyConsumer *consumer;
+    ConsumerMetrics *metrics;
+  };
+  typedef std::vector<Entry> Entries;
+
+  std::shared_ptr<const Entries> snapshot() const;
+  bool contains_locked(NotifyConsumer *consumer) const;
+  static uint64_t now_us();
+
+  mutable std::mutex lock;
+  std::shared_ptr<const Entries> consumers;
+  // names are referenced by trace events, entries are never replaced or
+  // removed. keyed by name so a panel built again reuses its histogram
+  std::map<std::string, ConsumerMetrics> metrics;
+};
+
+#endif // __NOTIFY_DISPATCHER_H__
@@ -0,0 +1,172 @@
+#include "object_map.h"
+
+#include <algorithm>
+
+namespace {
+  const int16_t CELL = 32;
+}
+
+ObjectMap::ObjectMap()
+  : cols(0)
+  , rows(0)
+{
+}
+
+void ObjectMap::clear() {
+  objects.clear();
+  cells.clear();
+  cols = 0;
+  rows = 0;
+}
+
+void ObjectMap::build(std::vector<std::vector<Point>> polygons, int16_t w, int16_t h) {
+  clear();
+  cols = std::max<int16_t>(1, (w + CELL - 1) / CELL);
+  rows = std::max<int16_t>(1, (h + CELL - 1) / CELL);
+  cells.resize(static_cast<size_t>(cols) * rows);
+
+  objects.reserve(polygons.size());
+  for (auto &poly : polygons) {
+    Object o;
+    o.polygon = std::move(poly);
+    o.box = {0, 0, -1, -1};
+    if (!o.polygon.empty()) {
+      o.box = {o.polygon[0].x, o.polygon[0].y, o.polygon[0].x, o.polygon[0].y};
+      for (auto &p : o.polygon) {
+        o.box.x0 = std::min(o.box.x0, p.x);
+        o.box.y0 = std::min(o.box.y0, p.y);
+        o.box.x1 = std::max(o.box.x1, p.x);
+        o.box.y1 = std::max(o.box.y1, p.y);
+      }
+
+      // only what is on the canvas is masked, an object off it has no box
+      o.box.x0 = std::max<int16_t>(o.box.x0, 0);
+      o.box.y0 = std::max<int16_t>(o.box.y0, 0);
+      o.box.x1 = std::min<int16_t>(o.box.x1, w - 1);
+      o.box.y1 = std::min<int16_t>(o.box.y1, h - 1);
+      if (o.box.x1 < o.box.x0 || o.box.y1 < o.box.y0) {
+        o.box = {0, 0, -1, -1};
+      } else {
+        rasterise(o);
+      }
+    }
+
+    uint32_t idx = objects.size();
+    objects.push_back(std::move(o));
+
+    const Box &b = objects.back().box;
+    if (b.x1 < b.x0) {
+      continue;
+    }
+    int16_t c0 = b.x0 / CELL;
+    int16_t c1 = b.x1 / CELL;
+    int16_t r0 = b.y0 / CELL;
+    int16_t r1 = b.y1 / CELL;
+    for (int16_t r = r0; r <= r1; r++) {
+      for (int16_t c = c0; c <= c1; c++) {
+        cells[r * cols + c].push_back(idx);
+      }
+    }
+  }
+}
+
+void ObjectMap::rasterise(Object &o) {
+  const std::vector<Point> &poly = o.polygon;
+  if (poly.size() < 3) {
+    return;
+  }
+
+  size_t w = o.box.x1 - o.box.x0 + 1;
+  size_t h = o.box.y1 - o.box.y0 + 1;
+  o.mask.assign((w * h + 7) / 8, 0);
+
+  // even-odd along each row, the same crossings a ray cast from the
+  // pixel to the right would count
+  std::vector<double> xs;
+  for (size_t row = 0; row < h; row++) {
+    int16_t y = o.box.y0 + row;
+    xs.clear();
+    size_t j = poly.size() - 1;
+    for (size_t i = 0; i < poly.size(); j = i++) {
+      const Point &pi = poly[i];
+      const Point &pj = poly[j];
+      if ((pi.y > y) != (pj.y > y)) {
+        xs.push_back(static_cast<double>(pj.x - pi.x)
+                     * static_cast<double>(y - pi.y)
+                     / static_cast<double>(pj.y - pi.y)
+                     + static_cast<double>(pi.x));
+      }
+    }
+    std::sort(xs.begin(), xs.end());
+
+    // crossings right of x, counted down as x moves past them
+    size_t right = xs.size();
+    size_t next = 0;
+    for (size_t col = 0; col < w; col++) {
+      double x = o.box.x0 + static_cast<double>(col);
+      while (next < xs.size() && xs[next] <= x) {
+        next++;
+        right--;
+      }
+      if (right & 1) {
+        size_t bit = row * w + col;
+        o.mask[bit / 8] |= 1 << (bit % 8);
+      }
+    }
+  }
+}
+
+bool ObjectMap::inside(const Object &o, int16_t x, int16_t y) const {
+  if (o.mask.empty() || x < o.box.x0 || x > o.box.x1 || y < o.box.y0 || y > o.box.y1) {
+    return false;
+  }
+  size_t w = o.box.x1 - o.box.x0 + 1;
+  size_t bit = static_cast<size_t>(y - o.box.y0) * w + (x - o.box.x0);
+  return (o.mask[bit / 8] >> (bit % 8)) & 1;
+}
+
+int ObjectMap::hit(int16_t x, int16_t y, const std::function<bool(size_t)> &accept) const {
+  if (x < 0 || y < 0 || x / CELL >= cols || y / CELL >= rows) {
+    return -1;
+  }
+
+  int best = -1;
+  long best_area = 0;
+  for (uint32_t i : cells[(y / CELL) * cols + x / CELL]) {
+    const Object &o = objects[i];
+    if (!inside(o, x, y) || !accept(i)) {
+      continue;
+    }
+    long area = static_cast<long>(std::max<int16_t>(o.box.x1 - o.box.x0, 1))
+      * static_cast<long>(std::max<int16_t>(o.box.y1 - o.box.y0, 1));
+    if (best < 0 || area < best_area) {
+      best = i;
+      best_area = area;
+    }
+  }
+  return best;
+}
+
+void ObjectMap::query(const Box &area, std::vector<size_t> &out) const {
+  out.clear();
+  if (cells.empty()) {
+    return;
+  }
+
+  int16_t c0 = std::max<int16_t>(area.x0, 0) / CELL;
+  int16_t c1 = std::min<int16_t>(std::max<int16_t>(area.x1, 0) / CELL, cols - 1);
+  int16_t r0 = std::max<int16_t>(area.y0, 0) / CELL;
+  int16_t r1 = std::min<int16_t>(std::max<int16_t>(area.y1, 0) / CELL, rows - 1);
+  for (int16_t r = r0; r <= r1; r++) {
+    for (int16_t c = c0; c <= c1; c++) {
+      for (uint32_t i : cells[r * cols + c]) {
+        const Box &b = objects[i].box;
+        if (b.x0 <= area.x1 && b.x1 >= area.x0 && b.y0 <= area.y1 && b.y1 >= area.y0) {
+          out.push_back(i);
+        }
+      }
+    }
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+}
@@ -0,0 +1,59 @@
+#ifndef __OBJECT_MAP_H__
+#define __OBJECT_MAP_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Excludable objects in canvas pixels for ExcludeObjectPanel. Polygons are
+// rasterised to bit masks once and indexed by a uniform grid over the
+// canvas, so a touch is resolved against the few objects in one cell and
+// a redraw of an area finds the objects under it without a scan.
+class ObjectMap {
+ public:
+  struct Point {
+    int16_t x;
+    int16_t y;
+  };
+
+  // inclusive
+  struct Box {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+  };
+
+  struct Object {
+    std::vector<Point> polygon;
+    Box box;
+    // box sized, a bit per pixel, row major
+    std::vector<uint8_t> mask;
+  };
+
+  ObjectMap();
+
+  void build(std::vector<std::vector<Point>> polygons, int16_t w, int16_t h);
+  void clear();
+
+  size_t size() const { return objects.size(); }
+  const Object &get(size_t i) const { return objects[i]; }
+
+  // the smallest object containing x, y among those accept allows, -1 if none
+  int hit(int16_t x, int16_t y, const std::function<bool(size_t)> &accept) const;
+
+  // objects whose box overlaps area, in build order
+  void query(const Box &area, std::vector<size_t> &out) const;
+
+ private:
+  bool inside(const Object &o, int16_t x, int16_t y) const;
+  void rasterise(Object &o);
+
+  std::vector<Object> objects;
+  int16_t cols;
+  int16_t rows;
+  std::vector<std::vector<uint32_t>> cells;
+};
+
+#endif // __OBJECT_MAP_H__
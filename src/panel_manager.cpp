@@ -0,0 +1,157 @@
+#include "panel_manager.h"
+#include "config.h"
+#include "logger.h"
+#include "state.h"
+#include "websocket_client.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+PanelManager *PanelManager::get_instance() {
+  static PanelManager instance;
+  return &instance;
+}
+
+PanelManager::PanelManager()
+  : ws(NULL)
+  , lv_lock(NULL)
+  , parked(NULL)
+  , max_hidden(2)
+  , min_free_kb(0)
+  , clock(0)
+{
+}
+
+void PanelManager::init(KWebSocketClient &websocket, LvLock &lock) {
+  ws = &websocket;
+  lv_lock = &lock;
+
+  Config *conf = Config::get_instance();
+  max_hidden = conf->get<uint32_t>("/ui/panel_cache", 2);
+  min_free_kb = conf->get<uint32_t>("/ui/panel_min_free_kb", 8192);
+  LOG_DEBUG("panel cache {}, min free {} kB", max_hidden, min_free_kb);
+
+  if (min_free_kb > 0) {
+    lv_timer_create(&PanelManager::pressure_timer_cb, 5000, this);
+  }
+}
+
+lv_obj_t *PanelManager::parking() {
+  if (parked == NULL) {
+    // a screen of its own, never loaded
+    parked = lv_obj_create(NULL);
+  }
+  return parked;
+}
+
+void PanelManager::show(lv_obj_t *root) {
+  if (lv_obj_get_parent(root) != lv_scr_act()) {
+    lv_obj_set_parent(root, lv_scr_act());
+  }
+  lv_obj_move_foreground(root);
+}
+
+void PanelManager::hide(lv_obj_t *root) {
+  if (lv_obj_get_parent(root) != parking()) {
+    lv_obj_set_parent(root, parking());
+  }
+}
+
+bool PanelManager::is_shown(lv_obj_t *root) {
+  return root != NULL && lv_obj_get_screen(root) == lv_scr_act();
+}
+
+void PanelManager::add(PanelSlot *slot) {
+  slots.push_back(slot);
+}
+
+void PanelManager::remove(PanelSlot *slot) {
+  slots.erase(std::remove(slots.begin(), slots.end(), slot), slots.end());
+}
+
+void PanelManager::used(PanelSlot *slot) {
+  slot->last_used = ++clock;
+  trim(false, slot);
+}
+
+void PanelManager::trim(bool low_memory, PanelSlot *keep) {
+  std::vector<PanelSlot *> hidden;
+  for (PanelSlot *s : slots) {
+    if (s != keep && s->is_evictable() && s->built() && !is_shown(s->root())) {
+      hidden.push_back(s);
+    }
+  }
+
+  size_t keep_count = low_memory ? 0 : max_hidden;
+  if (hidden.size() <= keep_count) {
+    return;
+  }
+
+  std::sort(hidden.begin(), hidden.end(),
+            [](PanelSlot *a, PanelSlot *b) { return a->last_used < b->last_used; });
+  for (size_t i = 0; i < hidden.size() - keep_count; i++) {
+    LOG_DEBUG("tearing down {} panel{}", hidden[i]->get_name(), low_memory ? ", memory is low" : "");
+    hidden[i]->teardown();
+  }
+}
+
+void PanelManager::retire(NotifyConsumer *consumer, std::function<void()> destroy) {
+  ws->unregister_notify_update(consumer);
+
+  // dispatch is single threaded on the loop, anything queued behind the
+  // current update runs after the consumer's last consume() returned
+  LvLock *lock = lv_lock;
+  ws->run_in_loop([lock, destroy]() {
+    LV_LOCK_GUARD(guard, *lock);
+    destroy();
+  });
+}
+
+void PanelManager::prime(NotifyConsumer *consumer) {
+  ws->run_in_loop([this, consumer]() {
+    if (!ws->is_registered(consumer)) {
+      return;
+    }
+
+    // state is only written from this thread, the copy needs no lock
+    json j = {
+      {"method", "notify_status_update"},
+      {"params", json::array({State::get_instance()->get_data("/printer_state"_json_pointer)})}
+    };
+    if (j["params"][0].is_object()) {
+      consumer->consume(j);
+    }
+  });
+}
+
+uint64_t PanelManager::mem_available_kb() {
+  std::ifstream f("/proc/meminfo");
+  std::string line;
+  while (std::getline(f, line)) {
+    if (line.rfind("MemAvailable:", 0) == 0) {
+      return std::stoull(line.substr(13));
+    }
+  }
+  return 0;
+}
+
+void PanelManager::pressure_timer_cb(lv_timer_t *t) {
+  PanelManager *pm = static_cast<PanelManager *>(t->user_data);
+  uint64_t avail = mem_available_kb();
+  if (avail > 0 && avail < pm->min_free_kb) {
+    pm->trim(true, NULL);
+  }
+}
+
+PanelSlot::PanelSlot(const char *name, bool evictable)
+  : name(name)
+  , evictable(evictable)
+  , last_used(0)
+{
+  PanelManager::get_instance()->add(this);
+}
+
+PanelSlot::~PanelSlot() {
+  PanelManager::get_instance()->remove(this);
+}
@@ -0,0 +1,139 @@
+#ifndef __PANEL_MANAGER_H__
+#define __PANEL_MANAGER_H__
+
+#include "notify_consumer.h"
+#include "lv_lock.h"
+#include "lvgl/lvgl.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class KWebSocketClient;
+class PanelSlot;
+
+// Owns where full screen panels live while they are not shown. Hidden
+// panels are parked on a screen that is never loaded, so LVGL does not
+// lay them out, hit test or invalidate them. Panels held in a LazyPanel
+// are built on first navigation, and the least recently used hidden ones
+// are torn down past [ui] panel_cache or when MemAvailable drops under
+// [ui] panel_min_free_kb.
+//
+// Everything here runs with lv_lock held.
+class PanelManager {
+ public:
+  static PanelManager *get_instance();
+
+  void init(KWebSocketClient &ws, LvLock &lv_lock);
+
+  // parent for panel roots at construction
+  lv_obj_t *parking();
+  void show(lv_obj_t *root);
+  void hide(lv_obj_t *root);
+  bool is_shown(lv_obj_t *root);
+
+  void add(PanelSlot *slot);
+  void remove(PanelSlot *slot);
+  void used(PanelSlot *slot);
+  // drops the least recently used hidden evictable panels, all of them
+  // when memory is low
+  void trim(bool low_memory, PanelSlot *keep = NULL);
+
+  // the panel stops getting status updates now and is destroyed on the
+  // websocket loop, after any update already being dispatched to it
+  void retire(NotifyConsumer *consumer, std::function<void()> destroy);
+  // consume() the current printer state on the websocket loop, for panels
+  // that missed the updates before they were built
+  void prime(NotifyConsumer *consumer);
+
+  // kB, 0 if unknown
+  static uint64_t mem_available_kb();
+
+ private:
+  PanelManager();
+  PanelManager(const PanelManager &) = delete;
+  PanelManager &operator=(const PanelManager &) = delete;
+
+  static void pressure_timer_cb(lv_timer_t *t);
+
+  KWebSocketClient *ws;
+  LvLock *lv_lock;
+  lv_obj_t *parked;
+  std::vector<PanelSlot *> slots;
+  uint32_t max_hidden;
+  uint64_t min_free_kb;
+  uint64_t clock;
+};
+
+class PanelSlot {
+ public:
+  PanelSlot(const char *name, bool evictable);
+  virtual ~PanelSlot();
+
+  virtual bool built() const = 0;
+  virtual lv_obj_t *root() = 0;
+  virtual void teardown() = 0;
+
+  const char *get_name() const { return name; }
+  bool is_evictable() const { return evictable; }
+
+ private:
+  friend class PanelManager;
+
+  const char *name;
+  bool evictable;
+  uint64_t last_used;
+};
+
+// Builds the panel with create() on first get(). T is a NotifyConsumer
+// with get_container() returning its root, created on parking().
+template <typename T>
+class LazyPanel : public PanelSlot {
+ public:
+  LazyPanel(const char *name, bool evictable, std::function<T *()> create)
+    : PanelSlot(name, evictable)
+    , create(create)
+  {
+  }
+
+  ~LazyPanel() {
+    teardown();
+  }
+
+  T &get() {
+    PanelManager *pm = PanelManager::get_instance();
+    if (!panel) {
+      panel.reset(create());
+      pm->prime(panel.get());
+    }
+    pm->used(this);
+    return *panel;
+  }
+
+  // null until built
+  T *peek() {
+    return panel.get();
+  }
+
+  bool built() const override {
+    return panel != nullptr;
+  }
+
+  lv_obj_t *root() override {
+    return panel ? panel->get_container() : NULL;
+  }
+
+  void teardown() override {
+    if (panel) {
+      T *p = panel.release();
+      PanelManager::get_instance()->retire(p, [p]() { delete p; });
+    }
+  }
+
+ private:
+  std::function<T *()> create;
+  std::unique_ptr<T> panel;
+};
+
+#endif // __PANEL_MANAGER_H__
@@ -0,0 +1,294 @@
+#include "perf_monitor.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
+#include "lvgl/lvgl.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+  // taken during static initialization, before main
+  const uint64_t process_start_us = PerfMonitor::now_us();
+
+  void (*orig_flush_cb)(lv_disp_drv_t *, const lv_area_t *, lv_color_t *) = NULL;
+  lv_timer_cb_t orig_refresh_cb = NULL;
+
+  void timed_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p) {
+    TRACE_SCOPE("lvgl", "flush");
+    uint64_t start = PerfMonitor::now_us();
+    orig_flush_cb(drv, area, color_p);
+    PerfMonitor::get_instance()->record_flush(PerfMonitor::now_us() - start);
+  }
+
+  void timed_refresh_cb(lv_timer_t *t) {
+    TRACE_SCOPE("lvgl", "refresh");
+    PerfMonitor *pm = PerfMonitor::get_instance();
+    pm->begin_frame();
+    uint64_t start = PerfMonitor::now_us();
+    orig_refresh_cb(t);
+    if (pm->end_frame(PerfMonitor::now_us() - start)) {
+      Trace::get_instance()->end_frame_flows();
+    }
+  }
+
+  void monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px) {
+    PerfMonitor::get_instance()->record_area(px);
+  }
+
+  void sample_timer_cb(lv_timer_t *t) {
+    PerfMonitor::get_instance()->update_overlay();
+  }
+
+  // utime + stime of this process in clock ticks
+  uint64_t cpu_ticks() {
+    std::ifstream f("/proc/self/stat");
+    std::string stat;
+    std::getline(f, stat);
+
+    // comm may contain spaces, fields are counted from the closing paren
+    size_t pos = stat.rfind(')');
+    if (pos == std::string::npos) {
+      return 0;
+    }
+
+    std::istringstream iss(stat.substr(pos + 1));
+    std::string field;
+    uint64_t ticks = 0;
+    for (int i = 3; i <= 15 && (iss >> field); i++) {
+      if (i == 14 || i == 15) {
+        ticks += std::strtoull(field.c_str(), NULL, 10);
+      }
+    }
+    return ticks;
+  }
+}
+
+PerfMonitor::PerfMonitor()
+  : frames(0)
+  , flushes(0)
+  , messages(0)
+  , frame_flush_count(0)
+  , frame_flush_us(0)
+  , overlay(NULL)
+  , last_sample_us(0)
+  , last_cpu_ticks(0)
+  , last_frames(0)
+  , last_messages(0)
+  , log_interval_sec(0)
+  , last_log_us(0)
+  , startup_last_us(process_start_us)
+  , startup_done(false)
+{
+}
+
+PerfMonitor *PerfMonitor::get_instance() {
+  static PerfMonitor instance;
+  return &instance;
+}
+
+void PerfMonitor::attach(lv_disp_t *disp) {
+  if (disp == NULL || orig_flush_cb != NULL) {
+    return;
+  }
+
+  orig_flush_cb = disp->driver->flush_cb;
+  disp->driver->flush_cb = timed_flush_cb;
+  disp->driver->monitor_cb = monitor_cb;
+
+  if (disp->refr_timer != NULL) {
+    orig_refresh_cb = disp->refr_timer->timer_cb;
+    disp->refr_timer->timer_cb = timed_refresh_cb;
+  }
+}
+
+void PerfMonitor::enable_overlay() {
+  if (overlay != NULL) {
+    return;
+  }
+
+  overlay = lv_label_create(lv_layer_sys());
+  lv_obj_set_style_text_font(overlay, &lv_font_montserrat_14, 0);
+  lv_obj_set_style_text_color(overlay, lv_color_white(), 0);
+  lv_obj_set_style_bg_color(overlay, lv_color_black(), 0);
+  lv_obj_set_style_bg_opa(overlay, LV_OPA_60, 0);
+  lv_obj_set_style_pad_all(overlay, 2, 0);
+  lv_obj_clear_flag(overlay, LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_align(overlay, LV_ALIGN_TOP_RIGHT, 0, 0);
+  lv_label_set_text(overlay, "");
+
+  if (log_interval_sec == 0) {
+    lv_timer_create(sample_timer_cb, 1000, NULL);
+  }
+}
+
+void PerfMonitor::set_log_interval(uint32_t sec) {
+  if (sec == 0) {
+    return;
+  }
+
+  if (log_interval_sec == 0 && overlay == NULL) {
+    lv_timer_create(sample_timer_cb, 1000, NULL);
+  }
+  log_interval_sec = sec;
+}
+
+void PerfMonitor::register_metrics() {
+  Metrics *m = Metrics::get_instance();
+  m->register_histogram("guppy_timer_handler_seconds", "Time spent in lv_timer_handler", "", &timer_handler, 1e-6);
+  m->register_histogram("guppy_frame_render_seconds", "Time spent rendering a frame excluding flush", "", &render, 1e-6);
+  m->register_histogram("guppy_frame_flush_seconds", "Time spent flushing a frame to the display", "", &flush, 1e-6);
+  m->register_histogram("guppy_frame_flushes", "Flush calls per rendered frame", "", &frame_flushes);
+  m->register_histogram("guppy_frame_area_pixels", "Pixels redrawn per frame", "", &area);
+  m->register_histogram("guppy_lv_lock_wait_seconds", "Time the ui loop waited for lv_lock", "", &lock_wait, 1e-6);
+  m->register_histogram("guppy_lv_lock_hold_seconds", "Time the ui loop held lv_lock", "", &lock_hold, 1e-6);
+
+  m->register_counter("guppy_frames_total", "Rendered frames", "", &frames);
+  m->gauge("guppy_process_resident_memory_bytes", "Resident set size",
+           []() { return static_cast<double>(rss_bytes()); });
+  // LV_MEM_CUSTOM routes lvgl allocations through malloc, so this is also the lvgl heap
+  if (has_heap_bytes()) {
+    m->gauge("guppy_heap_bytes", "Allocated heap bytes", []() { return static_cast<double>(heap_bytes()); });
+  }
+}
+
+void PerfMonitor::record_lock_wait(uint64_t us) {
+  lock_wait.observe(us);
+}
+
+void PerfMonitor::record_lock_hold(uint64_t us) {
+  lock_hold.observe(us);
+}
+
+void PerfMonitor::record_timer_handler(uint64_t us) {
+  timer_handler.observe(us);
+}
+
+void PerfMonitor::record_message() {
+  messages.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerfMonitor::startup_stage(const char *stage, bool last) {
+  if (startup_done.load()) {
+    return;
+  }
+  if (last) {
+    startup_done = true;
+  }
+
+  uint64_t now = now_us();
+  uint64_t prev = startup_last_us.exchange(now);
+  LOG_INFO("startup {}: {} ms, {} ms since start", stage, (now - prev) / 1000, (now - process_start_us) / 1000);
+}
+
+void PerfMonitor::begin_frame() {
+  frame_flush_count = 0;
+  frame_flush_us = 0;
+}
+
+void PerfMonitor::record_flush(uint64_t us) {
+  flushes.fetch_add(1, std::memory_order_relaxed);
+  frame_flush_count++;
+  frame_flush_us += us;
+}
+
+bool PerfMonitor::end_frame(uint64_t us) {
+  // the refresh timer fires even when nothing was invalidated
+  if (frame_flush_count == 0) {
+    return false;
+  }
+
+  frames.fetch_add(1, std::memory_order_relaxed);
+  refresh.observe(us);
+  flush.observe(frame_flush_us);
+  render.observe(us > frame_flush_us ? us - frame_flush_us : 0);
+  frame_flushes.observe(frame_flush_count);
+  return true;
+}
+
+void PerfMonitor::record_area(uint32_t px) {
+  area.observe(px);
+}
+
+uint64_t PerfMonitor::rss_bytes() {
+  std::ifstream f("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  if (!(f >> size >> resident)) {
+    return 0;
+  }
+  return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+bool PerfMonitor::has_heap_bytes() {
+#if defined(__GLIBC__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t PerfMonitor::heap_bytes() {
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 33)
+  struct mallinfo2 mi = mallinfo2();
+  return mi.uordblks + mi.hblkhd;
+#else
+  struct mallinfo mi = mallinfo();
+  return static_cast<unsigned>(mi.uordblks) + static_cast<unsigned>(mi.hblkhd);
+#endif
+#else
+  // musl has no mallinfo
+  return 0;
+#endif
+}
+
+void PerfMonitor::update_overlay() {
+  uint64_t now = now_us();
+  uint64_t ticks = cpu_ticks();
+  uint64_t cur_frames = get_frames();
+  uint64_t cur_messages = get_messages();
+
+  if (last_sample_us != 0 && now > last_sample_us) {
+    double elapsed_s = static_cast<double>(now - last_sample_us) / 1000000.0;
+    double fps = (cur_frames - last_frames) / elapsed_s;
+    double msgs = (cur_messages - last_messages) / elapsed_s;
+    double cpu = 100.0 * (static_cast<double>(ticks - last_cpu_ticks) / sysconf(_SC_CLK_TCK)) / elapsed_s;
+
+    if (overlay != NULL) {
+      bool heap = has_heap_bytes();
+      lv_label_set_text(overlay,
+                        fmt::format("{:.0f} FPS  CPU {:.0f}%  {:.0f} msg/s  {} {:.1f} MB",
+                                    fps, cpu, msgs, heap ? "heap" : "rss",
+                                    static_cast<double>(heap ? heap_bytes() : rss_bytes()) / (1024.0 * 1024.0)).c_str());
+    }
+  }
+
+  last_sample_us = now;
+  last_cpu_ticks = ticks;
+  last_frames = cur_frames;
+  last_messages = cur_messages;
+
+  if (log_interval_sec > 0 && now - last_log_us >= log_interval_sec * 1000000ULL) {
+    last_log_us = now;
+    log_summary();
+  }
+}
+
+void PerfMonitor::log_summary() {
+  LOG_INFO("perf: frames {}, flushes {}, messages {}, rss {} KB",
+           get_frames(), get_flushes(), get_messages(), rss_bytes() / 1024);
+  LOG_INFO("perf: p50/p99/max us timer_handler {}/{}/{}, render {}/{}/{}, flush {}/{}/{}, lock_wait {}/{}/{}",
+           timer_handler.percentile(0.5), timer_handler.percentile(0.99), timer_handler.max(),
+           render.percentile(0.5), render.percentile(0.99), render.max(),
+           flush.percentile(0.5), flush.percentile(0.99), flush.max(),
+           lock_wait.percentile(0.5), lock_wait.percentile(0.99), lock_wait.max());
+  LOG_INFO("perf: p50/p99/max area px {}/{}/{}, flushes per frame {}/{}/{}",
+           area.percentile(0.5), area.percentile(0.99), area.max(),
+           frame_flushes.percentile(0.5), frame_flushes.percentile(0.99), frame_flushes.max());
+}
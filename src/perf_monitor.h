@@ -0,0 +1,103 @@
+#ifndef __PERF_MONITOR_H__
+#define __PERF_MONITOR_H__
+
+#include "histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+struct _lv_disp_t;
+struct _lv_obj_t;
+
+// Per frame timing of the UI loop. Always on, every sample is a handful of
+// relaxed atomic increments so it is cheap enough to leave in release builds.
+class PerfMonitor {
+ public:
+  static PerfMonitor *get_instance();
+
+  static uint64_t now_us() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  // wraps the display's flush and refresh callbacks
+  void attach(struct _lv_disp_t *disp);
+  void enable_overlay();
+  void set_log_interval(uint32_t sec);
+  void update_overlay();
+  // export the histograms and process gauges through Metrics
+  void register_metrics();
+
+  void record_lock_wait(uint64_t us);
+  void record_lock_hold(uint64_t us);
+  void record_timer_handler(uint64_t us);
+  void record_message();
+
+  // logs at info the time since the previous stage and since the process
+  // started. stages after the last one are ignored, so reconnects don't
+  // show up as startup
+  void startup_stage(const char *stage, bool last = false);
+
+  // called from the wrapped display callbacks, ui thread only
+  void begin_frame();
+  void record_flush(uint64_t us);
+  // true if the refresh drew anything
+  bool end_frame(uint64_t us);
+  void record_area(uint32_t px);
+
+  const Histogram &timer_handler_us() const { return timer_handler; }
+  const Histogram &refresh_us() const { return refresh; }
+  const Histogram &render_us() const { return render; }
+  const Histogram &flush_us() const { return flush; }
+  const Histogram &lock_wait_us() const { return lock_wait; }
+  const Histogram &lock_hold_us() const { return lock_hold; }
+  const Histogram &area_px() const { return area; }
+  const Histogram &flushes_per_frame() const { return frame_flushes; }
+
+  uint64_t get_frames() const { return frames.load(std::memory_order_relaxed); }
+  uint64_t get_flushes() const { return flushes.load(std::memory_order_relaxed); }
+  uint64_t get_messages() const { return messages.load(std::memory_order_relaxed); }
+
+  // in bytes, heap_bytes only where has_heap_bytes, musl can't tell
+  static uint64_t rss_bytes();
+  static bool has_heap_bytes();
+  static uint64_t heap_bytes();
+
+ private:
+  PerfMonitor();
+  PerfMonitor(const PerfMonitor &) = delete;
+  PerfMonitor &operator=(const PerfMonitor &) = delete;
+
+  void log_summary();
+
+  Histogram timer_handler;
+  Histogram refresh;
+  Histogram render;
+  Histogram flush;
+  Histogram lock_wait;
+  Histogram lock_hold;
+  Histogram area;
+  Histogram frame_flushes;
+
+  std::atomic<uint64_t> frames;
+  std::atomic<uint64_t> flushes;
+  std::atomic<uint64_t> messages;
+
+  // accumulated while a refresh is running
+  uint32_t frame_flush_count;
+  uint64_t frame_flush_us;
+
+  struct _lv_obj_t *overlay;
+  uint64_t last_sample_us;
+  uint64_t last_cpu_ticks;
+  uint64_t last_frames;
+  uint64_t last_messages;
+  uint32_t log_interval_sec;
+  uint64_t last_log_us;
+
+  std::atomic<uint64_t> startup_last_us;
+  std::atomic<bool> startup_done;
+};
+
+#endif // __PERF_MONITOR_H__
@@ -3,39 +3,50 @@
 #include "state.h"
 #include "utils.h"
 #include "logger.h"
+#include "panel_manager.h"
+#include "perf_monitor.h"
+#include "config.h"
 
-#include <map>
-#include <sstream>
+#include <algorithm>
 
 LV_IMG_DECLARE(info_img);
 LV_IMG_DECLARE(print);
 LV_IMG_DECLARE(back);
 
-#define SORTED_BY_MODIFIED  1 << 1
+namespace {
+  // untouched for this long before prefetching
+  const uint32_t PREFETCH_IDLE_MS = 1000;
+  const uint32_t PREFETCH_PERIOD_MS = 100;
+}
 
-PrintPanel::PrintPanel(KWebSocketClient &websocket, std::mutex &lock, PrintStatusPanel &ps)
+PrintPanel::PrintPanel(KWebSocketClient &websocket, LvLock &lock, PrintStatusPanel &ps)
   : NotifyConsumer(lock)
   , ws(websocket)
-  , files_cont(lv_obj_create(lv_scr_act()))
+  , files_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , spinner(lv_spinner_create(files_cont, 1000, 60))
   , left_cont(lv_obj_create(files_cont))
-  , file_table(lv_table_create(left_cont))
+  , file_list(left_cont,
+              [this](size_t row) { return row_text.c_str() + row_offsets[row]; },
+              [this](size_t row) { handle_row(row); },
+              [this](size_t row) { return row_detail(row); })
   , file_view(lv_obj_create(files_cont))
   , status_btn(file_view, &info_img, "Status", &PrintPanel::_handle_status_btn, this)
   , print_btn(file_view, &print, "Print", &PrintPanel::_handle_print_callback, this)
   , back_btn(file_view, &back, "Back", &PrintPanel::_handle_back_btn, this)
-  , root("", "", 0)
-  , cur_dir(&root)
-  , cur_file(NULL)
   , file_panel(file_view)
   , print_status(ps)
-  , sorted_by(SORTED_BY_MODIFIED)
+  , metadata(Config::get_instance()->get<uint32_t>("/ui/metadata_cache", 1000))
+  , prefetch_max(std::max<uint32_t>(Config::get_instance()->get<uint32_t>("/ui/metadata_prefetch", 2), 1))
+  , prefetch_next(0)
+  , prefetch_timer(lv_timer_create(&PrintPanel::prefetch_cb, PREFETCH_PERIOD_MS, this))
+  , detail_since(0)
+  , time_to_detail(Metrics::get_instance()->histogram("guppy_file_detail_seconds",
+                                                      "Time from picking a file to its details showing", "", 1e-6))
   , refreshing_files(false)
   , refresh_pending(false)
   , visible(false)
 {
   LOG_TRACE("building print panel");
-  lv_obj_move_background(files_cont);
 
   lv_obj_set_size(files_cont, LV_PCT(100), LV_PCT(100));
   lv_obj_clear_flag(files_cont, LV_OBJ_FLAG_SCROLLABLE);
@@ -52,12 +63,8 @@ PrintPanel::PrintPanel(KWebSocketClient &websocket, std::mutex &lock, PrintStatu
   lv_obj_set_flex_flow(left_cont, LV_FLEX_FLOW_COLUMN);
   lv_obj_set_style_pad_all(left_cont, 0, 0);
 
-  lv_obj_set_size(file_table, LV_PCT(100), LV_PCT(100));
-  lv_table_set_col_width(file_table, 0, LV_PCT(100));
-  lv_table_set_col_cnt(file_table, 1);
-  lv_obj_add_event_cb(file_table, &PrintPanel::_handle_callback, LV_EVENT_ALL, this);
-  lv_obj_set_scroll_dir(file_table, LV_DIR_TOP | LV_DIR_BOTTOM);
-  lv_obj_set_style_pad_bottom(file_table, 60, 0);
+  lv_obj_set_size(file_list.get_container(), LV_PCT(100), LV_PCT(100));
+  lv_obj_set_style_pad_bottom(file_list.get_container(), 60, 0);
 
   lv_obj_set_size(file_view, LV_PCT(50), LV_PCT(100));
   lv_obj_clear_flag(file_view, LV_OBJ_FLAG_SCROLLABLE);
@@ -75,6 +82,8 @@ PrintPanel::PrintPanel(KWebSocketClient &websocket, std::mutex &lock, PrintStatu
   lv_obj_move_foreground(print_btn.get_container());
   lv_obj_move_foreground(status_btn.get_container());
 
+  metadata.load(Config::get_instance()->get<std::string>("/ui/metadata_cache_path", ""));
+
   ws.register_notify_update(this);
   ws.register_method_callback("notify_filelist_changed",
     			      "PrintPanel",
@@ -82,39 +91,63 @@ PrintPanel::PrintPanel(KWebSocketClient &websocket, std::mutex &lock, PrintStatu
 }
 
 PrintPanel::~PrintPanel() {
+  lv_timer_del(prefetch_timer);
   if (files_cont != NULL) {
     lv_obj_del(files_cont);
     files_cont = NULL;
   }
 }
 
-void PrintPanel::populate_files(json &j) {
-  sorted_by = SORTED_BY_MODIFIED;
-  show_dir(cur_dir, SORTED_BY_MODIFIED);
-}
-
 void PrintPanel::handle_file_list_change(json &j) {
-  if (j["/params/0/item/root"_json_pointer] != "gcodes") {
+  json &item = j["/params/0/item"_json_pointer];
+  json &source = j["/params/0/source_item"_json_pointer];
+  const json &from = source.is_object() ? source : json::object();
+  bool to_gcodes = item.is_object() && item.value("root", "") == "gcodes";
+  bool from_gcodes = from.value("root", "") == "gcodes";
+  if (!to_gcodes && !from_gcodes) {
     return;
   }
 
   LOG_TRACE("file list change response {}", j.dump());
-  refresh_pending = true;
+  json &action = j["/params/0/action"_json_pointer];
+
+  LV_LOCK_GUARD(lock, lv_lock);
+  if (to_gcodes) {
+    metadata.erase(item.value("path", ""));
+  }
+  if (from_gcodes) {
+    metadata.erase(from.value("path", ""));
+  }
+
+  FileTree::Change change = files.apply(action.is_string() ? action.template get<std::string>() : "", item, from);
+  if (change.reload) {
+    refresh_pending = true;
+    load_dir();
+    return;
+  }
+
   if (!visible) {
     return;
   }
 
-  subscribe();
+  FileTree::Id dir = files.find(cur_dir_path);
+  if (dir == FileTree::NONE || !files.get(dir).dir) {
+    // the directory shown went away
+    load_dir();
+  } else if (dir == change.dir || dir == change.from) {
+    show_dir(dir, false);
+  }
 }
 
 void PrintPanel::consume(json &j) {
-  json &pstat_state = j["/params/0/print_stats/state"_json_pointer];
-  if (pstat_state.is_null()) {
+  const json *pstat_state = StatusUpdate::field(StatusUpdate::status(j), "print_stats", "state");
+  if (pstat_state == NULL) {
     return;
   }
-  
-  std::lock_guard<std::mutex> lock(lv_lock);
-  if (pstat_state.template get<std::string>() != "printing" && pstat_state.template get<std::string>() != "paused") {
+
+  LV_LOCK_GUARD(lock, lv_lock);
+  const std::string &state = pstat_state->template get_ref<const std::string &>();
+  if (state != "printing" && state != "paused") {
     status_btn.disable();
     print_btn.enable();
   } else {
@@ -124,49 +157,61 @@ void PrintPanel::consume(json &j) {
 }
 
 void PrintPanel::subscribe() {
+  // changes may have been missed while disconnected
+  LV_LOCK_GUARD(lock, lv_lock);
   refresh_pending = true;
+  load_dir();
+}
+
+void PrintPanel::load_dir() {
   if (!visible || refreshing_files) {
     return;
   }
 
-  refreshing_files = true;
-  refresh_pending = false;
-  lv_obj_clear_flag(file_table, LV_OBJ_FLAG_CLICKABLE);
-  lv_obj_clear_flag(spinner, LV_OBJ_FLAG_HIDDEN);
-
-  ws.send_jsonrpc("server.files.list", R"({"root":"gcodes"})"_json, [this](json &d) {
-    std::unique_lock<std::mutex> lock(lv_lock);
-    std::string cur_path = cur_dir == NULL ? "" : cur_dir->full_path;
-    root.clear();
-    cur_file = NULL;
-    cur_dir = NULL;
-
-    if (d.contains("result")) {
-      for (auto f : d["result"]) {
-        root.add_path(KUtils::split(f["path"], '/'), f["path"], f["modified"].template get<uint32_t>());
-      }
-    }
+  if (refresh_pending) {
+    refresh_pending = false;
+    files.unload();
+  }
 
-    Tree *dir = root.find_path(KUtils::split(cur_path, '/'));
-    if (dir == NULL) {
-      dir = &root;
-    }
+  // the nearest known directory on the way to the one shown
+  FileTree::Id dir = files.find(cur_dir_path);
+  while (dir == FileTree::NONE || !files.get(dir).dir) {
+    size_t slash = cur_dir_path.rfind('/');
+    cur_dir_path.resize(slash == std::string::npos ? 0 : slash);
+    dir = files.find(cur_dir_path);
+  }
 
-    // need to simplify this using the directory endpoint
-    cur_dir = dir;
+  if (files.get(dir).loaded) {
+    show_dir(dir, true);
+    return;
+  }
 
-    this->populate_files(d);
+  refreshing_files = true;
+  lv_obj_clear_flag(spinner, LV_OBJ_FLAG_HIDDEN);
 
-    // Re-enable the table interaction ONLY after the data is stable
-    lv_obj_add_flag(file_table, LV_OBJ_FLAG_CLICKABLE);
+  std::string path = cur_dir_path;
+  RpcWriter rpc("server.files.get_directory");
+  rpc.param("path", path.empty() ? std::string("gcodes") : "gcodes/" + path);
+  ws.send_jsonrpc(rpc, [this, path](json &d) {
+    LV_LOCK_GUARD(lock, lv_lock);
     lv_obj_add_flag(spinner, LV_OBJ_FLAG_HIDDEN);
     refreshing_files = false;
-    if (!visible || !refresh_pending) {
-      return;
+
+    FileTree::Id dir = files.find(path);
+    if (d.contains("result")) {
+      if (dir != FileTree::NONE) {
+        files.fill(dir, d["result"]);
+      }
+    } else if (path.empty()) {
+      LOG_ERROR("failed to list gcodes {}", d.dump());
+      // nothing to fall back to, show it empty
+      files.fill(FileTree::ROOT, json::object());
+    } else if (path == cur_dir_path) {
+      size_t slash = path.rfind('/');
+      cur_dir_path = path.substr(0, slash == std::string::npos ? 0 : slash);
     }
 
-    lock.unlock();
-    subscribe();
+    load_dir();
   });
 }
 
@@ -185,143 +230,190 @@ void PrintPanel::foreground() {
   }
 
   visible = true;
-  lv_obj_move_foreground(files_cont);
-  subscribe();
+  PanelManager::get_instance()->show(files_cont);
+  load_dir();
 }
 
-void PrintPanel::handle_callback(lv_event_t *e) {
-  lv_event_code_t code = lv_event_get_code(e);
-
-  if(code == LV_EVENT_VALUE_CHANGED) {
-    const char * str_fn = NULL;
-    uint16_t row;
-    uint16_t col;
+void PrintPanel::handle_row(size_t row) {
+  if (refreshing_files || row >= row_nodes.size()) {
+    return;
+  }
 
-    lv_table_get_selected_cell(file_table, &row, &col);
-    uint16_t row_count = lv_table_get_row_cnt(file_table);
-    if (row == LV_TABLE_CELL_NONE || col == LV_TABLE_CELL_NONE || row >= row_count) {
-      return;
+  FileTree::Id node = row_nodes[row];
+  if (node == FileTree::NONE) {
+    if (!cur_dir_path.empty()) {
+      size_t slash = cur_dir_path.rfind('/');
+      cur_dir_path.resize(slash == std::string::npos ? 0 : slash);
+      load_dir();
     }
-
-    str_fn = lv_table_get_cell_value(file_table, row, col);
-    
-    const char *filename = str_fn+5; // +5 skips the LV_SYMBOL and spaces
-    if (std::memcmp(LV_SYMBOL_DIRECTORY, str_fn, 3) == 0) {
-      if ((strcmp(filename, "..") == 0)) {
-        if (cur_dir->parent != cur_dir) {
-          cur_dir = cur_dir->parent;
-          show_dir(cur_dir, sorted_by);
-        }
-      } else {
-        Tree *dir = cur_dir->get_child(filename);
-        if (dir != NULL) {
-          cur_dir = dir;
-          show_dir(cur_dir, sorted_by);
-        }
-      }
-    } else {
-      if (cur_file != cur_dir->get_child(filename)) {
-        cur_file = cur_dir->get_child(filename);
-        show_file_detail(cur_file);
-      }
+  } else if (files.get(node).dir) {
+    cur_dir_path = files.path(node);
+    load_dir();
+  } else {
+    std::string path = files.path(node);
+    if (path != cur_file_path) {
+      cur_file_path = path;
+      file_list.set_selected(row);
+      show_file_detail(cur_file_path);
     }
   }
 }
 
-void PrintPanel::show_dir(Tree *dir, uint32_t sort_type) {
-  uint32_t index = 0;
-  lv_table_set_cell_value_fmt(file_table, index++, 0, LV_SYMBOL_DIRECTORY "  %s", "..");
-
-  bool reversed = sorted_by & sort_type;
-  std::vector<Tree> sorted_files;
-  if (sort_type == SORTED_BY_MODIFIED) {
-    KUtils::sort_map_values<std::string, Tree>(dir->children, sorted_files, [reversed](Tree &x, Tree &y) {
-      if (x.is_leaf() && !y.is_leaf()) {
-        return false;
-      } else if (!x.is_leaf() && y.is_leaf()) {
-        return true;
-      }
-      return reversed ? x.date_modified > y.date_modified : y.date_modified > x.date_modified;
-    });
-  } else {
-    KUtils::sort_map_values<std::string, Tree>(dir->children, sorted_files, [reversed](Tree &x, Tree &y) {
-      if (x.is_leaf() && !y.is_leaf()) {
-        return false;
-      } else if (!x.is_leaf() && y.is_leaf()) {
-        return true;
-      }
-      return reversed ? x.name > y.name : y.name > x.name;
-    });
+void PrintPanel::add_row(FileTree::Id node, const char *symbol, const std::string &name) {
+  row_offsets.push_back(row_text.size());
+  row_nodes.push_back(node);
+  row_text.append(symbol);
+  row_text.append("  ");
+  row_text.append(name);
+  row_text.push_back('\0');
+}
+
+const char *PrintPanel::row_detail(size_t row) {
+  FileTree::Id id = row_nodes[row];
+  if (id == FileTree::NONE || files.get(id).dir) {
+    return "";
   }
 
-  sorted_by = (sorted_by ^ sort_type) & sort_type;
-  for (const auto &c : sorted_files) {
-    if (c.is_leaf()) {
-      lv_table_set_cell_value_fmt(file_table, index, 0, LV_SYMBOL_FILE "  %s", c.name.c_str());
-    } else {
-      lv_table_set_cell_value_fmt(file_table, index, 0, LV_SYMBOL_DIRECTORY "  %s", c.name.c_str());
-    }
-    index++;
+  row_path.assign(shown_path);
+  if (!row_path.empty()) {
+    row_path.push_back('/');
   }
+  row_path.append(files.name(id));
+  const FileTree::Node &n = files.get(id);
+  return metadata.summary(row_path, n.modified, n.size);
+}
 
-  lv_table_set_row_cnt(file_table, index);
-  lv_obj_scroll_to_y(file_table, 0, LV_ANIM_OFF);
+void PrintPanel::show_dir(FileTree::Id dir, bool from_top) {
+  row_text.clear();
+  row_offsets.clear();
+  row_nodes.clear();
+  std::string dir_path = files.path(dir);
+  if (dir_path != shown_path) {
+    // the same folder shown again after an edit carries on where it was
+    prefetch_next = 0;
+    shown_path = dir_path;
+  }
 
-  // XXX: maybe use the directory instead of file endpoint in moonraker
-  for (auto &c : sorted_files) {
-    if (c.is_leaf()) {
-      const auto &selected = dir->children.find(c.name);
-      if (selected != dir->children.cend()) {
-        cur_file = &selected->second;
-        show_file_detail(cur_file);
-      }
-      break;
+  // folders first, newest first within each
+  const FileTree::Node &d = files.get(dir);
+  add_row(FileTree::NONE, LV_SYMBOL_DIRECTORY, "..");
+  for (FileTree::Id c : d.by_modified) {
+    if (files.get(c).dir) {
+      add_row(c, LV_SYMBOL_DIRECTORY, files.name(c));
     }
   }
+  size_t first_file = row_nodes.size();
+  for (FileTree::Id c : d.by_modified) {
+    if (!files.get(c).dir) {
+      add_row(c, LV_SYMBOL_FILE, files.name(c));
+    }
+  }
+
+  file_list.set_count(row_nodes.size());
+  if (from_top) {
+    file_list.scroll_to(0);
+  }
+
+  if (first_file == row_nodes.size()) {
+    return;
+  }
+
+  // the file picked before if it is still here, otherwise the newest
+  size_t selected = first_file;
+  FileTree::Id cur = files.find(cur_file_path);
+  if (cur != FileTree::NONE && files.get(cur).parent == dir) {
+    selected = std::find(row_nodes.begin() + first_file, row_nodes.end(), cur) - row_nodes.begin();
+  }
+  cur_file_path = files.path(row_nodes[selected]);
+  file_list.set_selected(selected);
+  show_file_detail(cur_file_path);
 }
 
-void PrintPanel::show_file_detail(Tree *f) {
-  if (f->is_leaf()) {
-    if (f->contains_metadata()) {
-      file_panel.refresh_view(f->metadata, f->full_path);
-    } else {
-      std::string full_path = f->full_path;
-      LOG_TRACE("getting metadata for {}", full_path);
-
-      ws.send_jsonrpc("server.files.metadata",
-		      json::parse(R"({"filename":")" + f->full_path + R"("})"),
-		      [this, full_path](json &d) {
-             this->handle_metadata(full_path, d);
-         });
-    }
+void PrintPanel::show_file_detail(const std::string &path) {
+  FileTree::Id f = files.find(path);
+  if (f == FileTree::NONE) {
+    return;
+  }
+
+  const FileTree::Node &n = files.get(f);
+  detail_since = PerfMonitor::now_us();
+  json *m = metadata.get(path, n.modified, n.size);
+  if (m != NULL) {
+    file_panel.refresh_view(*m, path);
+    time_to_detail->observe(PerfMonitor::now_us() - detail_since);
+    detail_since = 0;
+  } else if (fetching.count(path) == 0) {
+    fetch_metadata(path, n.modified, n.size);
   }
 }
 
-void PrintPanel::handle_metadata(const std::string& full_path, json &j) {
-  LOG_TRACE("handling metadata for {}", full_path);
+void PrintPanel::fetch_metadata(const std::string &path, double modified, uint64_t size) {
+  LOG_TRACE("getting metadata for {}", path);
+  fetching.insert(path);
+
+  RpcWriter rpc("server.files.metadata");
+  rpc.param("filename", path);
+  ws.send_jsonrpc(rpc, [this, path, modified, size](json &d) {
+    this->handle_metadata(path, modified, size, d);
+  });
+}
+
+void PrintPanel::handle_metadata(const std::string &path, double modified, uint64_t size, json &j) {
+  LOG_TRACE("handling metadata for {}", path);
 
-  std::vector<std::string> segments = KUtils::split(full_path, '/');
-  if (segments.empty()) {
+  LV_LOCK_GUARD(lock, lv_lock);
+  fetching.erase(path);
+  FileTree::Id f = files.find(path);
+  if (!j.contains("result") || f == FileTree::NONE || files.get(f).dir) {
     return;
   }
 
-  std::string filename = segments.back();
-  segments.pop_back();
+  json &m = metadata.put(path, modified, size, j);
+  if (path == cur_file_path) {
+    file_panel.refresh_view(m, path);
+    if (detail_since != 0) {
+      time_to_detail->observe(PerfMonitor::now_us() - detail_since);
+      detail_since = 0;
+    }
+  }
+
+  if (files.get(f).parent == files.find(shown_path)) {
+    auto row = std::find(row_nodes.begin(), row_nodes.end(), f);
+    if (row != row_nodes.end()) {
+      file_list.refresh(row - row_nodes.begin());
+    }
+  }
+}
+
+void PrintPanel::prefetch_cb(lv_timer_t *timer) {
+  static_cast<PrintPanel *>(timer->user_data)->prefetch();
+}
 
-  Tree *parent_dir = &root;
-  if (!segments.empty()) {
-      parent_dir = root.find_path(segments);
+void PrintPanel::prefetch() {
+  if (!visible || refreshing_files || fetching.size() >= prefetch_max
+      || lv_disp_get_inactive_time(NULL) < PREFETCH_IDLE_MS) {
+    return;
   }
-  Tree *f = nullptr;
-  if (parent_dir != nullptr) {
-      f = parent_dir->get_child(filename.c_str());
+
+  FileTree::Id dir = files.find(shown_path);
+  if (dir == FileTree::NONE) {
+    return;
   }
 
-  if (f != nullptr && f->is_leaf()) {
-    if (j.contains("result")) {
-      std::lock_guard<std::mutex> lock(lv_lock);
-      f->set_metadata(j);
-      file_panel.refresh_view(f->metadata, f->full_path);
+  // newest first, as listed, no more than the cache holds or the last
+  // ones would push out the first
+  const std::vector<FileTree::Id> &children = files.get(dir).by_modified;
+  size_t end = std::min(children.size(), metadata.get_capacity());
+  while (fetching.size() < prefetch_max && prefetch_next < end) {
+    FileTree::Id c = children[prefetch_next++];
+    const FileTree::Node &n = files.get(c);
+    if (n.dir) {
+      continue;
+    }
+
+    std::string path = shown_path.empty() ? files.name(c) : shown_path + "/" + files.name(c);
+    if (!metadata.contains(path, n.modified, n.size) && fetching.count(path) == 0) {
+      fetch_metadata(path, n.modified, n.size);
     }
   }
 }
@@ -330,26 +422,27 @@ void PrintPanel::handle_back_btn(lv_event_t *event) {
   lv_obj_t *btn = lv_event_get_current_target(event);
   if (btn == back_btn.get_container()) {
     visible = false;
-    lv_obj_move_background(files_cont);
+    PanelManager::get_instance()->hide(files_cont);
     print_status.background();
   }
 }
 
 void PrintPanel::handle_print_callback(lv_event_t *event) {
   lv_event_code_t code = lv_event_get_code(event);
-  if (code == LV_EVENT_CLICKED && cur_file != NULL) {
+  if (code == LV_EVENT_CLICKED && !cur_file_path.empty()) {
     json &pstat_state = State::get_instance()->get_data("/printer_state/print_stats/state"_json_pointer);
     LOG_DEBUG("print panel print stats {}", pstat_state.is_null() ? "nil" : pstat_state.template get<std::string>());
     
     if (!pstat_state.is_null()
           && pstat_state.template get<std::string>() != "printing"
           && pstat_state.template get<std::string>() != "paused") {
-      LOG_DEBUG("printer ready to print. print file {}", cur_file->full_path);
+      LOG_DEBUG("printer ready to print. print file {}", cur_file_path);
 
-      json fname_input = {{"filename", cur_file->full_path }};
       visible = false;
-      lv_obj_move_background(files_cont);
-      ws.send_jsonrpc("printer.print.start", fname_input);
+      PanelManager::get_instance()->hide(files_cont);
+      RpcWriter rpc("printer.print.start");
+      rpc.param("filename", cur_file_path);
+      ws.send_jsonrpc(rpc);
       print_status.foreground();
     }
   }
@@ -357,10 +450,10 @@ void PrintPanel::handle_print_callback(lv_event_t *event) {
 
 void PrintPanel::handle_status_btn(lv_event_t *event) {
   lv_event_code_t code = lv_event_get_code(event);
-  if (code == LV_EVENT_CLICKED && cur_file != NULL) {
+  if (code == LV_EVENT_CLICKED && !cur_file_path.empty()) {
     LOG_TRACE("status button clicked");
     visible = false;
-    lv_obj_move_background(files_cont);
+    PanelManager::get_instance()->hide(files_cont);
     print_status.foreground();
   }
 }
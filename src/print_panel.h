@@ -7,29 +7,29 @@
 #include "button_container.h"
 #include "file_panel.h"
 #include "print_status_panel.h"
-#include "tree.h"
+#include "file_tree.h"
+#include "metadata_cache.h"
+#include "virtual_list.h"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 class PrintPanel : public NotifyConsumer {
  public:
-  PrintPanel(KWebSocketClient &ws, std::mutex &lv_lock, PrintStatusPanel &ps);
+  PrintPanel(KWebSocketClient &ws, LvLock &lv_lock, PrintStatusPanel &ps);
   ~PrintPanel();
 
   void consume(json &data);
-  void populate_files(json &data);
   void subscribe();
   void foreground();
-  void handle_callback(lv_event_t *event);
-  void handle_metadata(const std::string& full_path, json & data);
+  void handle_row(size_t row);
+  void handle_metadata(const std::string &path, double modified, uint64_t size, json &data);
   void handle_back_btn(lv_event_t *event);
   void handle_print_callback(lv_event_t *event);
   void handle_status_btn(lv_event_t *event);
   void handle_file_list_change(json &d);
 
-  static void _handle_callback(lv_event_t *event) {
-    PrintPanel *panel = (PrintPanel*)event->user_data;
-    panel->handle_callback(event);
-  };
-
   static void _handle_back_btn(lv_event_t *event) {
     PrintPanel *panel = (PrintPanel*)event->user_data;
     panel->handle_back_btn(event);
@@ -46,24 +46,50 @@ class PrintPanel : public NotifyConsumer {
   };
 
  private:
-  void show_dir(Tree *dir, uint32_t sort_type);
-  void show_file_detail(Tree *f);
+  // shows the directory if it is loaded, otherwise asks for it
+  void load_dir();
+  void show_dir(FileTree::Id dir, bool from_top);
+  void show_file_detail(const std::string &path);
+  void fetch_metadata(const std::string &path, double modified, uint64_t size);
+  // a file of the folder shown for its metadata while the screen is idle
+  void prefetch();
+  static void prefetch_cb(lv_timer_t *timer);
+  void add_row(FileTree::Id node, const char *symbol, const std::string &name);
+  const char *row_detail(size_t row);
   
   KWebSocketClient &ws;
   lv_obj_t *files_cont;
   lv_obj_t *spinner;
   lv_obj_t *left_cont;
-  lv_obj_t *file_table;
+  VirtualList file_list;
   lv_obj_t *file_view;
   ButtonContainer status_btn;
   ButtonContainer print_btn;
   ButtonContainer back_btn;
-  Tree root;
-  Tree *cur_dir;
-  Tree *cur_file;
+  FileTree files;
+  // relative to gcodes, ids are looked up again after every edit
+  std::string cur_dir_path;
+  std::string cur_file_path;
   FilePanel file_panel;
   PrintStatusPanel &print_status;
-  uint32_t sorted_by;
+  MetadataCache metadata;
+  // paths with a server.files.metadata request in flight
+  std::unordered_set<std::string> fetching;
+  size_t prefetch_max;
+  // next in shown_path's by_modified to look at
+  size_t prefetch_next;
+  lv_timer_t *prefetch_timer;
+  // when the file shown was picked, 0 once its details are up
+  uint64_t detail_since;
+  Histogram *time_to_detail;
+  // rows of the directory shown, ".." then folders then files. texts
+  // back to back, each NUL terminated, and the node of each, NONE for ..
+  std::string row_text;
+  std::vector<uint32_t> row_offsets;
+  std::vector<FileTree::Id> row_nodes;
+  // the folder the rows are of, and a path built for a row
+  std::string shown_path;
+  std::string row_path;
   bool refreshing_files;
   bool refresh_pending;
   bool visible;
@@ -5,6 +5,7 @@
 #include "state.h"
 #include "utils.h"
 #include "logger.h"
+#include "panel_manager.h"
 #include "config.h"
 
 LV_IMG_DECLARE(extruder);
@@ -28,15 +29,23 @@ LV_IMG_DECLARE(back);
 
 double pi() { return std::atan(1)*4; }
 
+namespace {
+  const lv_coord_t MAP_MARGIN = 4;
+
+  lv_coord_t calc_map_dim() {
+    return lv_disp_get_physical_hor_res(NULL) * 0.1;
+  }
+}
+
 PrintStatusPanel::PrintStatusPanel(KWebSocketClient &websocket_client,
-				   std::mutex &lock,
+				   LvLock &lock,
 				   lv_obj_t *mini_parent)
   : NotifyConsumer(lock)
   , ws(websocket_client)
   , finetune_panel(websocket_client, lock)
   , exclude_object_panel(websocket_client, lock)
   , mini_print_status(mini_parent, &PrintStatusPanel::_handle_callback, this)
-  , status_cont(lv_obj_create(lv_scr_act()))
+  , status_cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , buttons_cont(lv_obj_create(status_cont))
   , finetune_btn(buttons_cont, &fine_tune_img, "Fine Tune", &PrintStatusPanel::_handle_callback, this)
   , objects_btn(buttons_cont, &delete_img, "Objects", &PrintStatusPanel::_handle_callback, this)
@@ -50,6 +59,11 @@ PrintStatusPanel::PrintStatusPanel(KWebSocketClient &websocket_client,
   , back_btn(buttons_cont, &back, "Back", &PrintStatusPanel::_handle_callback, this)
   , thumbnail_cont(lv_obj_create(status_cont))
   , thumbnail(lv_img_create(thumbnail_cont))
+  , thumbnail_view(thumbnail)
+  , map_cont(lv_obj_create(thumbnail_cont))
+  , bed_map(lv_obj_create(map_cont))
+  , object_label(lv_label_create(map_cont))
+  , marker(bed_map, calc_map_dim(), MAP_MARGIN, object_label)
   , pbar_cont(lv_obj_create(thumbnail_cont))
   , progress_bar(lv_bar_create(pbar_cont))
   , progress_label(lv_label_create(pbar_cont))
@@ -70,7 +84,6 @@ PrintStatusPanel::PrintStatusPanel(KWebSocketClient &websocket_client,
   , heater_bed_target(-1)
   , chamber_sensor_key_(Config::get_instance()->get<std::string>("/ui/chamber_temp_sensor"))
 {
-  lv_obj_move_background(status_cont);
   lv_obj_clear_flag(status_cont, LV_OBJ_FLAG_SCROLLABLE);  
   lv_obj_set_size(status_cont, LV_PCT(100), LV_PCT(100));
 
@@ -145,6 +158,29 @@ PrintStatusPanel::PrintStatusPanel(KWebSocketClient &websocket_client,
   lv_obj_set_style_pad_all(thumbnail_cont, 0, 0);
   lv_obj_set_style_pad_row(thumbnail_cont, 20, 0);
 
+  lv_obj_add_flag(map_cont, LV_OBJ_FLAG_FLOATING);
+  lv_obj_clear_flag(map_cont, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_set_size(map_cont, calc_map_dim(), LV_SIZE_CONTENT);
+  lv_obj_set_style_pad_all(map_cont, 0, 0);
+  lv_obj_set_style_pad_row(map_cont, 2, 0);
+  lv_obj_set_style_border_width(map_cont, 0, 0);
+  lv_obj_set_style_bg_opa(map_cont, LV_OPA_TRANSP, 0);
+  lv_obj_set_flex_flow(map_cont, LV_FLEX_FLOW_COLUMN);
+  lv_obj_align(map_cont, LV_ALIGN_TOP_RIGHT, 0, 0);
+
+  lv_obj_clear_flag(bed_map, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_set_size(bed_map, calc_map_dim(), calc_map_dim());
+  lv_obj_set_style_pad_all(bed_map, 0, 0);
+  lv_obj_set_style_radius(bed_map, 2, 0);
+  lv_obj_set_style_border_width(bed_map, 1, 0);
+  lv_obj_set_style_border_color(bed_map, lv_palette_darken(LV_PALETTE_GREY, 2), 0);
+  lv_obj_set_style_bg_color(bed_map, lv_color_make(30, 30, 30), 0);
+  lv_obj_set_style_bg_opa(bed_map, LV_OPA_70, 0);
+
+  lv_label_set_long_mode(object_label, LV_LABEL_LONG_DOT);
+  lv_obj_set_width(object_label, LV_PCT(100));
+  lv_obj_set_style_text_font(object_label, &lv_font_montserrat_12, 0);
+
   // row 1
   lv_obj_set_grid_cell(thumbnail_cont, LV_GRID_ALIGN_CENTER, 0, 1, LV_GRID_ALIGN_CENTER, 0, 1);
   lv_obj_set_grid_cell(detail_cont, LV_GRID_ALIGN_CENTER, 1, 1, LV_GRID_ALIGN_CENTER, 0, 1);  
@@ -166,11 +202,11 @@ PrintStatusPanel::~PrintStatusPanel() {
 
 void PrintStatusPanel::foreground() {
   // populate();
-  lv_obj_move_foreground(status_cont);
+  PanelManager::get_instance()->show(status_cont);
 }
 
 void PrintStatusPanel::background() {
-  lv_obj_move_background(status_cont);
+  PanelManager::get_instance()->hide(status_cont);
 }
 
 void PrintStatusPanel::reset() {
@@ -187,10 +223,7 @@ void PrintStatusPanel::reset() {
   extruder_target = -1;
   heater_bed_target = -1;
 
-  // free src
-  lv_img_set_src(thumbnail, NULL);
-  // hack to color in empty space.
-  ((lv_img_t*)thumbnail)->src_type = LV_IMG_SRC_SYMBOL;
+  thumbnail_view.clear();
 
   mini_print_status.reset();
   mini_print_status.hide();
@@ -237,14 +270,17 @@ void PrintStatusPanel::init(json &fan_cfgs) {
 
 void PrintStatusPanel::populate() {
   State* s = State::get_instance();
+  bed_bounds.load();
+  marker.sync(bed_bounds);
+
   auto &pstate = s->get_data("/printer_state/print_stats/state"_json_pointer);
   json& printfile = s->get_data("/printer_state/print_stats/filename"_json_pointer);
   if (!printfile.is_null()) {
     const std::string fname = printfile.template get<std::string>();
     if (fname.length() > 0) {
-      json fname_input = {{"filename", fname }};
-      ws.send_jsonrpc("server.files.metadata", fname_input,
-		      [fname, this](json &d) { this->handle_metadata(fname, d); });
+      RpcWriter rpc("server.files.metadata");
+      rpc.param("filename", fname);
+      ws.send_jsonrpc(rpc, [fname, this](json &d) { this->handle_metadata(fname, d); });
 
       mini_print_status.show();
     }
@@ -290,7 +326,7 @@ void PrintStatusPanel::handle_metadata(const std::string &gcode_file, json &j) {
       uint32_t passed = static_cast<uint32_t>(v.template get<float>());
       LOG_TRACE("updated time progress in handle metadata, passed {}", passed);
 
-      std::lock_guard<std::mutex> lock(lv_lock);
+      LV_LOCK_GUARD(lock, lv_lock);
       update_time_progress(passed);
     }
   }
@@ -302,21 +338,19 @@ void PrintStatusPanel::handle_metadata(const std::string &gcode_file, json &j) {
   std::string fullpath = thumb_detail.first;
   if (fullpath.length() > 0) {
     LOG_TRACE("thumb path: {}", fullpath);
-    std::lock_guard<std::mutex> lock(lv_lock);
-    const std::string img_path = "A:" + fullpath;
+    LV_LOCK_GUARD(lock, lv_lock);
 
     auto screen_width = lv_disp_get_physical_hor_res(NULL);
-    uint32_t normalized_thumb_scale = ((0.34 * (double)screen_width) / (double)thumb_detail.second) * 256;
-    lv_img_set_src(thumbnail, img_path.c_str());
-    lv_img_set_zoom(thumbnail, normalized_thumb_scale);
-    mini_print_status.update_img(img_path, thumb_detail.second);
+    thumbnail_view.show(fullpath, 0.34 * screen_width);
+    mini_print_status.update_img(fullpath);
   }
 }
 
 void PrintStatusPanel::consume(json &j) {
-  std::lock_guard<std::mutex> lock(lv_lock);
+  LV_LOCK_GUARD(lock, lv_lock);
+  marker.consume(j);
 
-  auto printfile = j["/params/0/print_stats/filename"_json_pointer];
+  auto &printfile = j["/params/0/print_stats/filename"_json_pointer];
   if (!printfile.is_null()) {
     // filename change indicates a start of a print
     reset();
@@ -373,7 +407,7 @@ void PrintStatusPanel::consume(json &j) {
   }
 
   // speed
-  auto speed = j["/params/0/motion_report/live_velocity"_json_pointer];
+  auto &speed = j["/params/0/motion_report/live_velocity"_json_pointer];
   if (!speed.is_null()) {
     int s = static_cast<int>(speed.template get<double>());
     print_speed.update_label((std::to_string(s) + " mm/s").c_str());
@@ -461,7 +495,7 @@ void PrintStatusPanel::consume(json &j) {
 void PrintStatusPanel::handle_callback(lv_event_t *event) {
   lv_obj_t *btn = lv_event_get_current_target(event);
   if (btn == back_btn.get_container()) {
-    lv_obj_move_background(status_cont);
+    PanelManager::get_instance()->hide(status_cont);
 
   } else if (btn == emergency_btn.get_container()) {
     ws.send_jsonrpc("printer.emergency_stop");
@@ -8,15 +8,17 @@
 #include "image_label.h"
 #include "finetune_panel.h"
 #include "mini_print_status.h"
+#include "thumbnail_service.h"
+#include "toolhead_marker.h"
 #include "lvgl/lvgl.h"
 
-#include <mutex>
+#include "lv_lock.h"
 #include <ctime>
 #include <map>
 
 class PrintStatusPanel : public NotifyConsumer {
  public:
-  PrintStatusPanel(KWebSocketClient &ws, std::mutex &lock, lv_obj_t *mini_parent);
+  PrintStatusPanel(KWebSocketClient &ws, LvLock &lock, lv_obj_t *mini_parent);
   ~PrintStatusPanel();
 
   void init(json &fans);
@@ -58,6 +60,13 @@ class PrintStatusPanel : public NotifyConsumer {
   ButtonContainer back_btn;
   lv_obj_t *thumbnail_cont;
   lv_obj_t *thumbnail;
+  ThumbnailView thumbnail_view;
+  // toolhead over the bed, floating over the thumbnail's corner
+  lv_obj_t *map_cont;
+  lv_obj_t *bed_map;
+  lv_obj_t *object_label;
+  BedMap bed_bounds;
+  ToolheadMarker marker;
   lv_obj_t *pbar_cont;
   lv_obj_t *progress_bar;
   lv_obj_t *progress_label;
@@ -2,6 +2,7 @@
 #include "state.h"
 #include "utils.h"
 #include "logger.h"
+#include "panel_manager.h"
 
 // uncomment for helper boxes
 // #define DEBUG_LINES
@@ -13,10 +14,10 @@ static lv_style_t style_btn_orange;
 static lv_style_t style_btn_dark_grey;
 static lv_style_t button_group_flex_style;
 
-PromptPanel::PromptPanel(KWebSocketClient &websocket_client, std::mutex &lock, lv_obj_t *parent)
+PromptPanel::PromptPanel(KWebSocketClient &websocket_client, LvLock &lock, lv_obj_t *parent)
     : NotifyConsumer(lock)
     , ws(websocket_client)
-    , prompt_cont(lv_obj_create(lv_scr_act()))
+    , prompt_cont(lv_obj_create(PanelManager::get_instance()->parking()))
     , flex(lv_obj_create(prompt_cont))
     , header(lv_label_create(prompt_cont))
     , footer_cont(lv_obj_create(prompt_cont))
@@ -141,11 +142,11 @@ PromptPanel::~PromptPanel() {
 
 void PromptPanel::foreground() {
   // shrink wrap
-  lv_obj_move_foreground(prompt_cont);
+  PanelManager::get_instance()->show(prompt_cont);
 }
 
 void PromptPanel::background() {
-  lv_obj_move_background(prompt_cont);
+  PanelManager::get_instance()->hide(prompt_cont);
 }
 
 void PromptPanel::handle_callback(lv_event_t *event) {
@@ -203,7 +204,7 @@ void PromptPanel::handle_macro_response(json &j) {
   if (!v.is_null()) {
     LOG_TRACE("data found");
     std::string resp = v.template get<std::string>();
-    std::lock_guard<std::mutex> lock(lv_lock);
+    LV_LOCK_GUARD(lock, lv_lock);
     LOG_TRACE("data: {}", resp);
 
     if (resp.find("// action:", 0) == 0) {
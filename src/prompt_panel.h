@@ -8,7 +8,7 @@
 
 #include <map>
 #include <memory>
-#include <mutex>
+#include "lv_lock.h"
 
 struct SharedButton {
     SharedButton(lv_obj_t *bbtn) : btn(bbtn) {};
@@ -17,7 +17,7 @@ struct SharedButton {
 
 class PromptPanel : public NotifyConsumer {
     public:
-        PromptPanel(KWebSocketClient &ws, std::mutex &lock, lv_obj_t *parent);
+        PromptPanel(KWebSocketClient &ws, LvLock &lock, lv_obj_t *parent);
         ~PromptPanel();
 
         void handle_macro_response(json &j);
@@ -0,0 +1,181 @@
+#include "rpc_writer.h"
+
+#include <charconv>
+
+namespace {
+  // reused across requests, keeps the capacity of the largest one
+  thread_local std::string buffer;
+  thread_local bool buffer_taken = false;
+}
+
+RpcWriter::RpcWriter(std::string_view method)
+  : shared(!buffer_taken)
+  , out(claim())
+  , depth(0)
+  , first{}
+  , failed(false)
+{
+  out.clear();
+  out.append(R"({"jsonrpc":"2.0","method":)");
+  escape(out, method);
+}
+
+RpcWriter::~RpcWriter() {
+  if (shared) {
+    buffer_taken = false;
+  }
+}
+
+std::string &RpcWriter::claim() {
+  if (!shared) {
+    return own;
+  }
+  buffer_taken = true;
+  return buffer;
+}
+
+bool RpcWriter::fail() {
+  failed = true;
+  out.clear();
+  return false;
+}
+
+RpcWriter &RpcWriter::param(std::string_view key, std::string_view value) {
+  if (this->key(key)) {
+    escape(out, value);
+  }
+  return *this;
+}
+
+RpcWriter &RpcWriter::param(std::string_view key, const char *value) {
+  return param(key, std::string_view(value));
+}
+
+RpcWriter &RpcWriter::param(std::string_view key, bool value) {
+  if (this->key(key)) {
+    out.append(value ? "true" : "false");
+  }
+  return *this;
+}
+
+RpcWriter &RpcWriter::params(const json &value) {
+  // the whole params member, so not after any other param
+  if (failed || depth != 0) {
+    fail();
+    return *this;
+  }
+  out.append(R"(,"params":)");
+  out.append(value.dump());
+  depth = -1;
+  return *this;
+}
+
+RpcWriter &RpcWriter::begin_object(std::string_view key) {
+  if (depth >= MAX_DEPTH) {
+    fail();
+    return *this;
+  }
+  if (this->key(key)) {
+    out.push_back('{');
+    first[depth++] = true;
+  }
+  return *this;
+}
+
+RpcWriter &RpcWriter::end_object() {
+  if (!failed && depth > 1) {
+    out.push_back('}');
+    depth--;
+  }
+  return *this;
+}
+
+const std::string &RpcWriter::finish(uint64_t id) {
+  if (failed) {
+    return out;
+  }
+  if (depth == -2) {
+    fail();
+    return out;
+  }
+
+  for (; depth > 0; depth--) {
+    out.push_back('}');
+  }
+  depth = -2;
+
+  out.append(R"(,"id":)");
+  number(id);
+  out.push_back('}');
+  return out;
+}
+
+bool RpcWriter::key(std::string_view k) {
+  if (failed || depth < 0) {
+    return fail();
+  }
+  if (depth == 0) {
+    out.append(R"(,"params":{)");
+    first[depth++] = true;
+  }
+
+  if (!first[depth - 1]) {
+    out.push_back(',');
+  }
+  first[depth - 1] = false;
+
+  escape(out, k);
+  out.push_back(':');
+  return true;
+}
+
+void RpcWriter::number(int64_t v) {
+  char buf[24];
+  auto res = std::to_chars(buf, buf + sizeof(buf), v);
+  out.append(buf, res.ptr - buf);
+}
+
+void RpcWriter::number(uint64_t v) {
+  char buf[24];
+  auto res = std::to_chars(buf, buf + sizeof(buf), v);
+  out.append(buf, res.ptr - buf);
+}
+
+void RpcWriter::escape(std::string &out, std::string_view s) {
+  static const char HEX[] = "0123456789abcdef";
+  out.push_back('"');
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      out.append("\\\"");
+      break;
+    case '\\':
+      out.append("\\\\");
+      break;
+    case '\b':
+      out.append("\\b");
+      break;
+    case '\f':
+      out.append("\\f");
+      break;
+    case '\n':
+      out.append("\\n");
+      break;
+    case '\r':
+      out.append("\\r");
+      break;
+    case '\t':
+      out.append("\\t");
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        out.append("\\u00");
+        out.push_back(HEX[(c >> 4) & 0xf]);
+        out.push_back(HEX[c & 0xf]);
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+  out.push_back('"');
+}
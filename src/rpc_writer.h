@@ -0,0 +1,88 @@
+#ifndef __RPC_WRITER_H__
+#define __RPC_WRITER_H__
+
+#include "hv/json.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+using json = nlohmann::json;
+
+// Writes a JSON-RPC request straight into a per thread buffer, for the
+// requests sent on every tap or slider step. The frame is equivalent to
+// dumping the json object, without building one (members are written in
+// call order rather than sorted). A writer created while another one on
+// the same thread is alive, say from a callback, writes into its own
+// buffer instead.
+//
+// Misuse, nesting deeper than MAX_DEPTH or writing after params or
+// finish, fails the writer: the rest of the calls are ignored and finish
+// returns an empty frame.
+//
+//   RpcWriter rpc("printer.gcode.script");
+//   rpc.param("script", "G28");
+//   ws.send_jsonrpc(rpc);
+class RpcWriter {
+ public:
+  RpcWriter(std::string_view method);
+  ~RpcWriter();
+  RpcWriter(const RpcWriter &) = delete;
+  RpcWriter &operator=(const RpcWriter &) = delete;
+
+  RpcWriter &param(std::string_view key, std::string_view value);
+  // otherwise string literals would pick the bool overload
+  RpcWriter &param(std::string_view key, const char *value);
+  RpcWriter &param(std::string_view key, bool value);
+
+  template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+  RpcWriter &param(std::string_view key, T value) {
+    if (!this->key(key)) {
+      return *this;
+    }
+    if constexpr (std::is_signed_v<T>) {
+      number(static_cast<int64_t>(value));
+    } else {
+      number(static_cast<uint64_t>(value));
+    }
+    return *this;
+  }
+
+  // all params at once from a DOM, for the generic path. nothing but
+  // finish may follow
+  RpcWriter &params(const json &value);
+
+  // nested object param, closed by end_object
+  RpcWriter &begin_object(std::string_view key);
+  RpcWriter &end_object();
+
+  // closes the request, the frame stays valid until the writer goes away
+  // and the next one on this thread is created. empty if the writer failed
+  const std::string &finish(uint64_t id);
+
+  bool ok() const { return !failed; }
+
+  static void escape(std::string &out, std::string_view s);
+
+ private:
+  std::string &claim();
+  bool fail();
+  bool key(std::string_view k);
+  void number(int64_t v);
+  void number(uint64_t v);
+
+  static constexpr int MAX_DEPTH = 4;
+
+  // only used when the thread's buffer is taken
+  std::string own;
+  bool shared;
+  std::string &out;
+  // 0 no params yet, 1 in params, deeper for nested objects, -1 once
+  // params wrote them all, -2 once finished
+  int depth;
+  bool first[MAX_DEPTH];
+  bool failed;
+};
+
+#endif // __RPC_WRITER_H__
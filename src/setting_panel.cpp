@@ -48,7 +48,7 @@ static void run_factory_reset_cb(lv_timer_t * t) {
     lv_timer_del(t);
 }
 
-SettingPanel::SettingPanel(std::mutex &l, lv_obj_t *parent)
+SettingPanel::SettingPanel(LvLock &l, lv_obj_t *parent)
   : cont(lv_obj_create(parent))
   , wifi_panel(l)
   , wifi_btn(cont, &network_img, "WIFI", &SettingPanel::_handle_callback, this)
@@ -7,11 +7,11 @@
 #include "websocket_client.h"
 #include "lvgl/lvgl.h"
 
-#include <mutex>
+#include "lv_lock.h"
 
 class SettingPanel {
  public:
-  SettingPanel(std::mutex &l, lv_obj_t *parent);
+  SettingPanel(LvLock &l, lv_obj_t *parent);
   ~SettingPanel();
 
   lv_obj_t *get_container();
@@ -1,6 +1,7 @@
 #include "spoolman_panel.h"
 #include "utils.h"
 #include "logger.h"
+#include "panel_manager.h"
 
 LV_IMG_DECLARE(back);
 LV_IMG_DECLARE(refresh_img);
@@ -11,10 +12,10 @@ LV_IMG_DECLARE(refresh_img);
 #define SORTED_BY_WT   1 << 3
 #define SORTED_BY_LEN  1 << 4
 
-SpoolmanPanel::SpoolmanPanel(KWebSocketClient &c, std::mutex &l)
+SpoolmanPanel::SpoolmanPanel(KWebSocketClient &c, LvLock &l)
   : ws(c)
   , lv_lock(l)
-  , cont(lv_obj_create(lv_scr_act()))
+  , cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , spool_table(lv_table_create(cont))
   , controls(lv_obj_create(cont))
   , switch_cont(lv_obj_create(controls))
@@ -25,7 +26,6 @@ SpoolmanPanel::SpoolmanPanel(KWebSocketClient &c, std::mutex &l)
   , sorted_by(SORTED_BY_ID)
 {
   lv_obj_add_flag(cont, LV_OBJ_FLAG_HIDDEN);
-  lv_obj_move_background(cont);
 
   lv_obj_set_size(cont, LV_PCT(100), LV_PCT(100));
   lv_obj_set_style_pad_all(cont, 0, 0);
@@ -85,12 +85,11 @@ SpoolmanPanel::~SpoolmanPanel() {
 }
 
 void SpoolmanPanel::init() {
-  json param = {
-    { "request_method", "GET" },
-    { "path", "/v1/spool?allow_archived=true" },
-  };
+  RpcWriter rpc("server.spoolman.proxy");
+  rpc.param("request_method", "GET")
+    .param("path", "/v1/spool?allow_archived=true");
 
-  ws.send_jsonrpc("server.spoolman.proxy", param, [this](json &d) {
+  ws.send_jsonrpc(rpc, [this](json &d) {
     auto &s = d["/result"_json_pointer];
     if (!s.is_null() && !s.empty()) {
       spools.clear();
@@ -107,7 +106,7 @@ void SpoolmanPanel::init() {
       });
       sorted_by = SORTED_BY_ID;
       
-      std::lock_guard<std::mutex> lock(this->lv_lock);
+      LV_LOCK_GUARD(lock, this->lv_lock);
       populate_spools(sorted_spools);
     }
   });
@@ -124,7 +123,7 @@ void SpoolmanPanel::init() {
       });
       sorted_by = SORTED_BY_ID;
       
-      std::lock_guard<std::mutex> lock(this->lv_lock);
+      LV_LOCK_GUARD(lock, this->lv_lock);
       populate_spools(sorted_spools);
     }
   });
@@ -132,7 +131,7 @@ void SpoolmanPanel::init() {
 
 void SpoolmanPanel::foreground() {
   lv_obj_clear_flag(cont, LV_OBJ_FLAG_HIDDEN);
-  lv_obj_move_foreground(cont);
+  PanelManager::get_instance()->show(cont);
 }
 
 void SpoolmanPanel::populate_spools(std::vector<json> &sorted_spools) {
@@ -221,7 +220,7 @@ void SpoolmanPanel::handle_active_id_update(json &j) {
     });
     sorted_by = SORTED_BY_ID;
 
-    std::lock_guard<std::mutex> lock(lv_lock);
+    LV_LOCK_GUARD(lock, lv_lock);
     populate_spools(sorted_spools);
   }
 }
@@ -230,7 +229,7 @@ void SpoolmanPanel::handle_callback(lv_event_t *event) {
   lv_obj_t *btn = lv_event_get_current_target(event);
   if (btn == back_btn.get_container()) {
     LOG_TRACE("spoolman back button pressed");
-    lv_obj_move_background(cont);
+    PanelManager::get_instance()->hide(cont);
   } else if (btn == reload_btn.get_container()) {
     LOG_TRACE("spoolman reload button pressed");
     init();
@@ -342,39 +341,33 @@ void SpoolmanPanel::handle_spoolman_action(lv_event_t *e) {
         // set active spool
         int id = std::stoi(spool_id);
         LOG_TRACE("set active spool id {}", id);
-        json param = {
-          {"spool_id", id}
-        };
-
-        ws.send_jsonrpc("server.spoolman.post_spool_id", param);
+        RpcWriter rpc("server.spoolman.post_spool_id");
+        rpc.param("spool_id", id);
+        ws.send_jsonrpc(rpc);
       }
 
       if (col == 7 && selected != NULL && strlen(selected) != 0) {
         if (std::memcmp(LV_SYMBOL_DRIVE, selected, 3) == 0) {
           // archive
-          json param = {
-            { "request_method", "PATCH" },
-            { "path", fmt::format("/v1/spool/{}", spool_id) },
-            { "body", {
-                { "archived", true }
-              }
-            }
-          };
-          ws.send_jsonrpc("server.spoolman.proxy", param, [this](json &d) {
+          RpcWriter rpc("server.spoolman.proxy");
+          rpc.param("request_method", "PATCH")
+            .param("path", fmt::format("/v1/spool/{}", spool_id))
+            .begin_object("body")
+            .param("archived", true)
+            .end_object();
+          ws.send_jsonrpc(rpc, [this](json &d) {
             this->init();
           });
         } else if (std::memcmp(LV_SYMBOL_UPLOAD, selected, 3) == 0) {
           // unarchive
-          json param = {
-            { "request_method", "PATCH" },
-            { "path", fmt::format("/v1/spool/{}", spool_id) },
-            { "body", {
-          { "archived", false }
-              }
-            }
-          };
-
-          ws.send_jsonrpc("server.spoolman.proxy", param, [this](json &d) {
+          RpcWriter rpc("server.spoolman.proxy");
+          rpc.param("request_method", "PATCH")
+            .param("path", fmt::format("/v1/spool/{}", spool_id))
+            .begin_object("body")
+            .param("archived", false)
+            .end_object();
+
+          ws.send_jsonrpc(rpc, [this](json &d) {
             this->init();
           });
         }
@@ -7,11 +7,11 @@
 #include "lvgl/lvgl.h"
 
 #include <map>
-#include <mutex>
+#include "lv_lock.h"
 
 class SpoolmanPanel {
  public:
-  SpoolmanPanel(KWebSocketClient &c, std::mutex &l);
+  SpoolmanPanel(KWebSocketClient &c, LvLock &l);
   ~SpoolmanPanel();
 
   void init();
@@ -34,7 +34,7 @@ class SpoolmanPanel {
 
  private:
   KWebSocketClient &ws;
-  std::mutex &lv_lock;
+  LvLock &lv_lock;
   lv_obj_t *cont;
   lv_obj_t *spool_table;
   lv_obj_t *controls;
@@ -27,10 +27,45 @@ const lv_palette_t GUPPY_COLORS[GUPPY_COLOR_SIZE] = {
   LV_PALETTE_GREY
 };
 
-std::mutex State::lock;
+namespace {
+  // plain assignment, except strings and same sized arrays are overwritten
+  // in place so repeated updates reuse the storage the state already holds
+  void assign(json &target, const json &value) {
+    if (target.is_string() && value.is_string()) {
+      target.get_ref<std::string &>() = value.get_ref<const std::string &>();
+    } else if (target.is_array() && value.is_array() && target.size() == value.size()) {
+      for (size_t i = 0; i < value.size(); i++) {
+        assign(target[i], value[i]);
+      }
+    } else {
+      target = value;
+    }
+  }
+
+  // same result as json::merge_patch
+  void merge(json &target, const json &patch) {
+    if (!patch.is_object()) {
+      assign(target, patch);
+      return;
+    }
+
+    if (!target.is_object()) {
+      target = json::object();
+    }
+    for (auto it = patch.begin(); it != patch.end(); ++it) {
+      if (it.value().is_null()) {
+        target.erase(it.key());
+      } else {
+        merge(target[it.key()], it.value());
+      }
+    }
+  }
+}
+
+LvLock State::lock("state");
 State *State::instance{NULL};
 
-State::State(std::mutex &state_lock)
+State::State(LvLock &state_lock)
   : NotifyConsumer(state_lock)
 {
 }
@@ -42,37 +77,46 @@ State *State::get_instance() {
   return instance;
 }
 
+LvLock &State::get_lock() {
+  return lock;
+}
+
 void State::reset() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   data.clear();
 }
 
 void State::set_data(const std::string &key, json &j, const std::string &json_path) {
-  std::lock_guard<std::mutex> guard(lock);
-  auto patch = j[json::json_pointer(json_path)];
+  set_data(key, j, json::json_pointer(json_path));
+}
+
+void State::set_data(const std::string &key, json &j, const json::json_pointer &ptr) {
+  LV_LOCK_GUARD(guard, lock);
+  json &patch = j[ptr];
   if (!patch.is_null()) {
-    data[key].merge_patch(patch);
+    merge(data[key], patch);
   }
 }
 
 json &State::get_data() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   return data;
 }
 
 json &State::get_data(const json::json_pointer& ptr) {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   return data[ptr];
 }
 
 void State::consume(json &j) {
+  static const json::json_pointer status_ptr("/params/0");
   if (j.contains("params") && !j["params"].empty()) {
-    set_data("printer_state", j, "/params/0");
+    set_data("printer_state", j, status_ptr);
   }
 }
 
 std::vector<std::string> State::get_extruders() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   auto &objects = data["/printer_objs/objects"_json_pointer];
   std::vector<std::string> extruders;
   if (!objects.is_null()) {
@@ -88,7 +132,7 @@ std::vector<std::string> State::get_extruders() {
 }
   
 std::vector<std::string> State::get_heaters() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   auto &objects = data["/printer_objs/objects"_json_pointer];
   std::vector<std::string> heaters;
   if (!objects.is_null()) {
@@ -104,7 +148,7 @@ std::vector<std::string> State::get_heaters() {
 }
 
 std::vector<std::string> State::get_sensors() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   auto &objects = data["/printer_objs/objects"_json_pointer];
   std::vector<std::string> sensors;
   if (!objects.is_null()) {
@@ -120,7 +164,7 @@ std::vector<std::string> State::get_sensors() {
 }
 
 std::vector<std::string> State::get_fans() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   auto &objects = data["/printer_objs/objects"_json_pointer];
   std::vector<std::string> fans;
   if (!objects.is_null()) {
@@ -139,7 +183,7 @@ std::vector<std::string> State::get_fans() {
 }
 
 std::vector<std::string> State::get_leds() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   auto &objects = data["/printer_objs/objects"_json_pointer];
   std::vector<std::string> leds;
   if (!objects.is_null()) {
@@ -155,7 +199,7 @@ std::vector<std::string> State::get_leds() {
 }
 
 std::vector<std::string> State::get_output_pins() {
-  std::lock_guard<std::mutex> guard(lock);
+  LV_LOCK_GUARD(guard, lock);
   auto &objects = data["/printer_objs/objects"_json_pointer];
   std::vector<std::string> output_pins;
   if (!objects.is_null()) {
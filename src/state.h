@@ -1,25 +1,26 @@
 #ifndef __STATE_H__
 #define __STATE_H__
 
-#include <mutex>
+#include "lv_lock.h"
 #include <vector>
 #include "notify_consumer.h"
 
 class State : public NotifyConsumer {
  private:
   static State *instance;
-  static std::mutex lock;
+  static LvLock lock;
   
  protected:
   json data;
 
  public:
-  State(std::mutex &lv_lock);
+  State(LvLock &lv_lock);
   State(State &o) = delete;
   void operator=(const State &) = delete;
 
   void reset();
   void set_data(const std::string &key, json &j, const std::string &json_path);
+  void set_data(const std::string &key, json &j, const json::json_pointer &ptr);
   json &get_data();
   json &get_data(const json::json_pointer &ptr);
 
@@ -37,6 +38,7 @@ class State : public NotifyConsumer {
   json get_display_leds();
 
   static State *get_instance();
+  static LvLock &get_lock();
 };
 
 #endif // __STATE_H__
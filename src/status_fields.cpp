@@ -0,0 +1,20 @@
+#include "status_fields.h"
+#include "notify_consumer.h"
+
+StatusFields::Id StatusFields::add(const std::string &object, const char *field) {
+  fields.push_back({object, field});
+  values.push_back(NULL);
+  return fields.size() - 1;
+}
+
+void StatusFields::clear() {
+  fields.clear();
+  values.clear();
+}
+
+void StatusFields::read(const json &update) {
+  const json *status = StatusUpdate::status(update);
+  for (size_t i = 0; i < fields.size(); i++) {
+    values[i] = StatusUpdate::field(status, fields[i].first, fields[i].second);
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef __STATUS_FIELDS_H__
+#define __STATUS_FIELDS_H__
+
+#include "hv/json.hpp"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+using json = nlohmann::json;
+
+// The fields a consumer takes from every notify_status_update, named once
+// when the consumer is set up. read() points each at its value in the
+// update, through StatusUpdate, so nothing is parsed, copied or added to
+// the update and nothing is allocated per update.
+class StatusFields {
+ public:
+  typedef size_t Id;
+
+  Id add(const std::string &object, const char *field);
+  void clear();
+
+  void read(const json &update);
+  // the value from the last read, NULL if the update didn't have it
+  const json *get(Id id) const { return values[id]; }
+
+ private:
+  std::vector<std::pair<std::string, const char *>> fields;
+  std::vector<const json *> values;
+};
+
+#endif // __STATUS_FIELDS_H__
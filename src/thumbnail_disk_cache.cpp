@@ -0,0 +1,223 @@
+#include "thumbnail_disk_cache.h"
+#include "asset_cache.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem;
+
+namespace {
+  const char *EXT = ".bin";
+  const char *TMP_EXT = ".tmp";
+
+  bool ends_with(const std::string &s, const char *suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+  }
+
+  // fnv-1a, a file name per key
+  std::string file_name(const std::string &key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key) {
+      h = (h ^ c) * 0x100000001b3ULL;
+    }
+    return fmt::format("{:016x}{}", h, EXT);
+  }
+
+  bool read_all(int fd, void *out, size_t len) {
+    return ::read(fd, out, len) == static_cast<ssize_t>(len);
+  }
+
+  bool write_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+      ssize_t n = ::write(fd, data, len);
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+}
+
+ThumbnailDiskCache::ThumbnailDiskCache()
+  : budget(0)
+  , used(0)
+{
+}
+
+bool ThumbnailDiskCache::open(const std::string &d, size_t b) {
+  dir = d;
+  budget = b;
+
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  DIR *dp = opendir(dir.c_str());
+  if (dp == NULL) {
+    LOG_ERROR("thumbnail disk cache {} not usable", dir);
+    dir.clear();
+    return false;
+  }
+
+  // most recently used first, by the modified time load() refreshes
+  std::vector<std::pair<time_t, std::string>> found;
+  struct dirent *e;
+  while ((e = readdir(dp)) != NULL) {
+    std::string name = e->d_name;
+    std::string path = dir + "/" + name;
+    struct stat st;
+    if (ends_with(name, TMP_EXT)) {
+      // left by a write that never finished
+      unlink(path.c_str());
+    } else if (ends_with(name, EXT) && stat(path.c_str(), &st) == 0) {
+      found.push_back({st.st_mtime, name});
+      index[name].size = st.st_size;
+      used += st.st_size;
+    }
+  }
+  closedir(dp);
+
+  std::sort(found.begin(), found.end(), std::greater<std::pair<time_t, std::string>>());
+  for (auto &f : found) {
+    lru.push_back(f.second);
+    index[f.second].lru = std::prev(lru.end());
+  }
+  evict();
+  LOG_DEBUG("thumbnail disk cache {}, {} files, {} kB", dir, index.size(), used / 1024);
+  return true;
+}
+
+std::shared_ptr<ThumbnailService::Image> ThumbnailDiskCache::load(const std::string &key) {
+  if (dir.empty()) {
+    return NULL;
+  }
+  std::string name = file_name(key);
+  auto found = index.find(name);
+  if (found == index.end()) {
+    return NULL;
+  }
+
+  std::string path = dir + "/" + name;
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  uint32_t key_len = 0;
+  bool ok = fd >= 0 && read_all(fd, &key_len, sizeof(key_len))
+    && sizeof(key_len) + key_len < found->second.size;
+
+  // another key with the same hash is a miss, its file is replaced by the
+  // store that follows
+  std::string stored;
+  if (ok) {
+    stored.resize(key_len);
+    ok = read_all(fd, &stored[0], key_len);
+    if (ok && stored != key) {
+      ::close(fd);
+      return NULL;
+    }
+  }
+
+  lv_img_header_t header;
+  ok = ok && read_all(fd, &header, sizeof(header)) && header.cf == LV_IMG_CF_TRUE_COLOR_ALPHA;
+  size_t size = ok ? static_cast<size_t>(header.w) * header.h * asset_pixel_size(asset_native_pixels()) : 0;
+  ok = ok && sizeof(key_len) + key_len + sizeof(header) + size == found->second.size;
+
+  // read before an Image exists, dropping one needs lv_lock
+  std::unique_ptr<uint8_t[]> pixels;
+  if (ok) {
+    pixels.reset(new uint8_t[size]);
+    ok = read_all(fd, pixels.get(), size);
+  }
+  if (fd >= 0) {
+    ::close(fd);
+  }
+
+  if (!ok) {
+    // truncated by a power cut, from another colour depth or an older
+    // version without the key
+    LOG_DEBUG("dropping thumbnail cache file {}", path);
+    unlink(path.c_str());
+    drop(name);
+    return NULL;
+  }
+
+  // the modified time orders the files on the next open
+  utimensat(AT_FDCWD, path.c_str(), NULL, 0);
+  use(name, found->second.size);
+  uint32_t w = header.w;
+  uint32_t h = header.h;
+  return std::make_shared<ThumbnailService::Image>(w, h, std::move(pixels), size);
+}
+
+void ThumbnailDiskCache::store(const std::string &key, const ThumbnailService::Image &img) {
+  if (dir.empty()) {
+    return;
+  }
+  std::string name = file_name(key);
+  std::string path = dir + "/" + name;
+  std::string tmp = path + TMP_EXT;
+
+  int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return;
+  }
+  uint32_t key_len = key.size();
+  bool ok = write_all(fd, reinterpret_cast<const uint8_t *>(&key_len), sizeof(key_len))
+    && write_all(fd, reinterpret_cast<const uint8_t *>(key.data()), key_len)
+    && write_all(fd, reinterpret_cast<const uint8_t *>(&img.dsc.header), sizeof(img.dsc.header))
+    && write_all(fd, img.dsc.data, img.dsc.data_size)
+    && fsync(fd) == 0;
+  ::close(fd);
+
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    LOG_ERROR("failed to write thumbnail cache file {}", path);
+    unlink(tmp.c_str());
+    return;
+  }
+
+  // the rename is only durable once the directory is
+  int dfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dfd >= 0) {
+    fsync(dfd);
+    ::close(dfd);
+  }
+
+  use(name, sizeof(key_len) + key_len + sizeof(img.dsc.header) + img.dsc.data_size);
+  evict();
+}
+
+void ThumbnailDiskCache::use(const std::string &name, size_t size) {
+  auto found = index.find(name);
+  if (found != index.end()) {
+    used -= found->second.size;
+    lru.splice(lru.begin(), lru, found->second.lru);
+  } else {
+    lru.push_front(name);
+  }
+  index[name] = {lru.begin(), size};
+  used += size;
+}
+
+void ThumbnailDiskCache::drop(const std::string &name) {
+  auto found = index.find(name);
+  if (found != index.end()) {
+    used -= found->second.size;
+    lru.erase(found->second.lru);
+    index.erase(found);
+  }
+}
+
+void ThumbnailDiskCache::evict() {
+  while (used > budget && !lru.empty()) {
+    std::string name = lru.back();
+    unlink((dir + "/" + name).c_str());
+    drop(name);
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef __THUMBNAIL_DISK_CACHE_H__
+#define __THUMBNAIL_DISK_CACHE_H__
+
+#include "thumbnail_service.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Thumbnails already scaled and converted, kept across restarts in [ui]
+// thumbnail_disk_cache_path, up to thumbnail_disk_cache_kb. A file holds
+// the key (its length as a uint32_t, then the bytes), then an LVGL binary
+// image (lv_img_header_t, then the pixels). Files are named after a hash
+// of the key, which is checked on load, the least recently used go first.
+//
+// Only used from ThumbnailService's worker.
+class ThumbnailDiskCache {
+ public:
+  ThumbnailDiskCache();
+
+  bool open(const std::string &dir, size_t budget);
+
+  // key names the source, its modified time and size and the decoded size
+  std::shared_ptr<ThumbnailService::Image> load(const std::string &key);
+  // written to a temporary file and renamed into place
+  void store(const std::string &key, const ThumbnailService::Image &img);
+
+ private:
+  struct Entry {
+    std::list<std::string>::iterator lru;
+    size_t size;
+  };
+
+  void use(const std::string &name, size_t size);
+  void drop(const std::string &name);
+  void evict();
+
+  std::string dir;
+  size_t budget;
+  size_t used;
+  // file names, front is the most recently used
+  std::list<std::string> lru;
+  std::unordered_map<std::string, Entry> index;
+};
+
+#endif // __THUMBNAIL_DISK_CACHE_H__
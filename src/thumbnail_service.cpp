@@ -0,0 +1,370 @@
+#include "thumbnail_service.h"
+#include "asset_cache.h"
+#include "asset_codec.h"
+#include "config.h"
+#include "thumbnail_disk_cache.h"
+#include "logger.h"
+#include "perf_monitor.h"
+#include "lvgl/src/extra/libs/png/lodepng.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+namespace {
+  // requests nobody is likely to look at any more, scrolled past
+  const size_t MAX_QUEUED = 32;
+  const uint32_t MAX_SOURCE_PIXELS = 2048 * 2048;
+
+  struct Rgba {
+    std::vector<uint8_t> px;
+    uint32_t w = 0;
+    uint32_t h = 0;
+  };
+
+  bool decode_png(const std::vector<uint8_t> &in, Rgba &out) {
+    // lodepng allocates through lv_mem_alloc, malloc with LV_MEM_CUSTOM, so
+    // safe off the ui thread
+    unsigned char *data = NULL;
+    unsigned w = 0;
+    unsigned h = 0;
+    unsigned err = lodepng_decode32(&data, &w, &h, in.data(), in.size());
+    if (err != 0 || static_cast<uint64_t>(w) * h > MAX_SOURCE_PIXELS) {
+      lv_mem_free(data);
+      return false;
+    }
+    out.w = w;
+    out.h = h;
+    out.px.assign(data, data + static_cast<size_t>(w) * h * 4);
+    lv_mem_free(data);
+    return true;
+  }
+
+  uint32_t be32(const uint8_t *p) {
+    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+  }
+
+  // https://qoiformat.org/qoi-specification.pdf
+  bool decode_qoi(const std::vector<uint8_t> &in, Rgba &out) {
+    if (in.size() < 14 + 8) {
+      return false;
+    }
+    out.w = be32(&in[4]);
+    out.h = be32(&in[8]);
+    size_t n = static_cast<size_t>(out.w) * out.h;
+    if (n == 0 || n > MAX_SOURCE_PIXELS) {
+      return false;
+    }
+    out.px.resize(n * 4);
+
+    uint8_t index[64][4] = {};
+    uint8_t px[4] = {0, 0, 0, 255};
+    size_t p = 14;
+    size_t end = in.size() - 8;
+    uint32_t run = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (run > 0) {
+        run--;
+      } else {
+        if (p >= end) {
+          return false;
+        }
+        uint8_t b = in[p++];
+        if (b == 0xfe || b == 0xff) {
+          size_t len = b == 0xfe ? 3 : 4;
+          if (p + len > end) {
+            return false;
+          }
+          memcpy(px, &in[p], len);
+          p += len;
+        } else if ((b & 0xc0) == 0x00) {
+          memcpy(px, index[b], 4);
+        } else if ((b & 0xc0) == 0x40) {
+          px[0] += ((b >> 4) & 0x03) - 2;
+          px[1] += ((b >> 2) & 0x03) - 2;
+          px[2] += (b & 0x03) - 2;
+        } else if ((b & 0xc0) == 0x80) {
+          if (p >= end) {
+            return false;
+          }
+          int dg = (b & 0x3f) - 32;
+          uint8_t b2 = in[p++];
+          px[0] += dg - 8 + ((b2 >> 4) & 0x0f);
+          px[1] += dg;
+          px[2] += dg - 8 + (b2 & 0x0f);
+        } else {
+          run = b & 0x3f;
+        }
+        memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+      }
+      memcpy(&out.px[i * 4], px, 4);
+    }
+    return true;
+  }
+
+  // averages the source pixels under each destination pixel, nearest when
+  // scaling up. alpha weighted, so transparent borders don't darken edges
+  void scale(const Rgba &src, uint32_t w, uint32_t h, uint8_t *out) {
+    for (uint32_t y = 0; y < h; y++) {
+      uint32_t y0 = static_cast<uint64_t>(y) * src.h / h;
+      uint32_t y1 = std::max(y0 + 1, static_cast<uint32_t>(static_cast<uint64_t>(y + 1) * src.h / h));
+      for (uint32_t x = 0; x < w; x++) {
+        uint32_t x0 = static_cast<uint64_t>(x) * src.w / w;
+        uint32_t x1 = std::max(x0 + 1, static_cast<uint32_t>(static_cast<uint64_t>(x + 1) * src.w / w));
+        uint64_t sum[4] = {0, 0, 0, 0};
+        for (uint32_t sy = y0; sy < y1; sy++) {
+          const uint8_t *row = &src.px[(static_cast<size_t>(sy) * src.w + x0) * 4];
+          for (uint32_t sx = x0; sx < x1; sx++, row += 4) {
+            sum[0] += row[0] * row[3];
+            sum[1] += row[1] * row[3];
+            sum[2] += row[2] * row[3];
+            sum[3] += row[3];
+          }
+        }
+        uint8_t *d = out + (static_cast<size_t>(y) * w + x) * 4;
+        uint32_t count = (y1 - y0) * (x1 - x0);
+        for (int c = 0; c < 3; c++) {
+          d[c] = sum[3] == 0 ? 0 : sum[c] / sum[3];
+        }
+        d[3] = sum[3] / count;
+      }
+    }
+  }
+
+  std::shared_ptr<ThumbnailService::Image> decode(const std::string &path, uint32_t size) {
+    std::ifstream f(path, std::ios::binary);
+    std::vector<uint8_t> in((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    Rgba src;
+    bool ok = in.size() >= 4 && memcmp(in.data(), "qoif", 4) == 0
+      ? decode_qoi(in, src) : decode_png(in, src);
+    if (!ok) {
+      return NULL;
+    }
+
+    // fit the box, keeping the aspect
+    uint32_t w = std::max<uint32_t>(1, static_cast<uint64_t>(src.w) * size / std::max(src.w, src.h));
+    uint32_t h = std::max<uint32_t>(1, static_cast<uint64_t>(src.h) * size / std::max(src.w, src.h));
+    std::vector<uint8_t> rgba(static_cast<size_t>(w) * h * 4);
+    scale(src, w, h, rgba.data());
+
+    AssetPixels fmt = asset_native_pixels();
+    size_t bytes = rgba.size() / 4 * asset_pixel_size(fmt);
+    std::unique_ptr<uint8_t[]> pixels(new uint8_t[bytes]);
+    asset_convert_rgba(rgba.data(), w, h, fmt, pixels.get());
+    return std::make_shared<ThumbnailService::Image>(w, h, std::move(pixels), bytes);
+  }
+}
+
+ThumbnailService::Image::Image(uint32_t w, uint32_t h, std::unique_ptr<uint8_t[]> p, size_t size)
+  : pixels(std::move(p))
+{
+  memset(&dsc, 0, sizeof(dsc));
+  dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+  dsc.header.w = w;
+  dsc.header.h = h;
+  dsc.data_size = size;
+  dsc.data = pixels.get();
+}
+
+ThumbnailService::Image::~Image() {
+  lv_img_cache_invalidate_src(&dsc);
+}
+
+ThumbnailService *ThumbnailService::get_instance() {
+  // never destroyed, the detached worker waits on it until exit
+  static ThumbnailService *instance = new ThumbnailService();
+  return instance;
+}
+
+ThumbnailService::ThumbnailService()
+  : lv_lock(NULL)
+  , disk_budget(0)
+  , disk(new ThumbnailDiskCache())
+  , budget(0)
+  , used(0)
+  , decode_us(NULL)
+  , hits(NULL)
+  , misses(NULL)
+  , disk_hits(NULL)
+{
+}
+
+ThumbnailService::~ThumbnailService() {
+}
+
+void ThumbnailService::init(LvLock &l) {
+  if (lv_lock != NULL) {
+    return;
+  }
+
+  lv_lock = &l;
+  Config *conf = Config::get_instance();
+  budget = conf->get<uint32_t>("/ui/thumbnail_cache_kb", 2048) * 1024;
+  disk_path = conf->get<std::string>("/ui/thumbnail_disk_cache_path", "");
+  disk_budget = conf->get<uint32_t>("/ui/thumbnail_disk_cache_kb", 8192) * 1024;
+
+  Metrics *m = Metrics::get_instance();
+  decode_us = m->histogram("guppy_thumbnail_decode_seconds", "Time spent decoding and scaling a thumbnail", "", 1e-6);
+  hits = m->counter("guppy_thumbnail_cache_total", "Thumbnail lookups by cache result", "result=\"hit\"");
+  misses = m->counter("guppy_thumbnail_cache_total", "Thumbnail lookups by cache result", "result=\"miss\"");
+  disk_hits = m->counter("guppy_thumbnail_cache_total", "Thumbnail lookups by cache result", "result=\"disk\"");
+
+  std::thread([this]() { run(); }).detach();
+  LOG_DEBUG("thumbnail cache {} kB", budget / 1024);
+}
+
+std::shared_ptr<ThumbnailService::Image> ThumbnailService::fetch(const std::string &path,
+                                                                 uint32_t size,
+                                                                 ThumbnailView *view) {
+  std::string key = fmt::format("{}:{}", size, path);
+  auto found = index.find(key);
+  if (found != index.end()) {
+    entries.splice(entries.begin(), entries, found->second);
+    (*hits)++;
+    return found->second->img;
+  }
+
+  (*misses)++;
+  if (view != NULL) {
+    waiting[view] = key;
+  }
+
+  std::string dropped;
+  {
+    std::lock_guard<std::mutex> l(queue_lock);
+    auto queued = std::find_if(queue.begin(), queue.end(), [&key](const Job &j) { return j.key == key; });
+    if (queued != queue.end()) {
+      queue.erase(queued);
+    }
+    queue.push_back({key, path, size});
+    if (queue.size() > MAX_QUEUED) {
+      dropped = std::move(queue.front().key);
+      queue.pop_front();
+    }
+  }
+  queue_cv.notify_one();
+
+  if (!dropped.empty()) {
+    notify(dropped, NULL);
+  }
+  return NULL;
+}
+
+void ThumbnailService::run() {
+  if (!disk_path.empty()) {
+    disk->open(disk_path, disk_budget);
+  }
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> l(queue_lock);
+      queue_cv.wait(l, [this]() { return !queue.empty(); });
+      job = std::move(queue.back());
+      queue.pop_back();
+    }
+
+    // moonraker rewrites the thumbnails with the gcode, their modified
+    // time and size follow it
+    struct stat st;
+    std::string disk_key = stat(job.path.c_str(), &st) != 0 ? "" : fmt::format("{}:{}:{}:{}:{}",
+      job.path, st.st_mtime, st.st_size, job.size, static_cast<int>(asset_native_pixels()));
+
+    std::shared_ptr<Image> img = disk_key.empty() ? NULL : disk->load(disk_key);
+    if (img) {
+      (*disk_hits)++;
+    } else {
+      uint64_t start = PerfMonitor::now_us();
+      img = decode(job.path, job.size);
+      if (img) {
+        decode_us->observe(PerfMonitor::now_us() - start);
+        if (!disk_key.empty()) {
+          disk->store(disk_key, *img);
+        }
+      } else {
+        LOG_ERROR("failed to decode thumbnail {}", job.path);
+      }
+    }
+
+    LV_LOCK_GUARD(lock, *lv_lock);
+    deliver(job.key, std::move(img));
+  }
+}
+
+void ThumbnailService::deliver(const std::string &key, std::shared_ptr<Image> img) {
+  if (img && index.find(key) == index.end()) {
+    entries.push_front({key, img});
+    index[key] = entries.begin();
+    used += img->dsc.data_size;
+
+    // views hold what they show, the budget is the cache's own
+    while (used > budget && entries.size() > 1) {
+      used -= entries.back().img->dsc.data_size;
+      index.erase(entries.back().key);
+      entries.pop_back();
+    }
+  }
+  notify(key, img);
+}
+
+void ThumbnailService::notify(const std::string &key, std::shared_ptr<Image> img) {
+  for (auto it = waiting.begin(); it != waiting.end();) {
+    if (it->second != key) {
+      ++it;
+      continue;
+    }
+    ThumbnailView *view = it->first;
+    it = waiting.erase(it);
+    view->set(img);
+  }
+}
+
+void ThumbnailService::cancel(ThumbnailView *view) {
+  waiting.erase(view);
+}
+
+ThumbnailView::ThumbnailView(lv_obj_t *img)
+  : img(img)
+{
+}
+
+ThumbnailView::~ThumbnailView() {
+  ThumbnailService::get_instance()->cancel(this);
+}
+
+void ThumbnailView::show(const std::string &path, uint32_t size) {
+  ThumbnailService *s = ThumbnailService::get_instance();
+  s->cancel(this);
+  lv_img_set_zoom(img, LV_IMG_ZOOM_NONE);
+
+  auto cached = s->fetch(path, size, this);
+  if (cached) {
+    set(cached);
+    return;
+  }
+
+  lv_img_set_src(img, LV_SYMBOL_IMAGE);
+  shown.reset();
+}
+
+void ThumbnailView::clear() {
+  ThumbnailService::get_instance()->cancel(this);
+  set(NULL);
+}
+
+void ThumbnailView::set(std::shared_ptr<ThumbnailService::Image> next) {
+  if (next) {
+    lv_img_set_src(img, &next->dsc);
+  } else {
+    // free src
+    lv_img_set_src(img, NULL);
+    // hack to color in empty space.
+    ((lv_img_t*)img)->src_type = LV_IMG_SRC_SYMBOL;
+  }
+  // the widget has let go of the old image
+  shown = std::move(next);
+}
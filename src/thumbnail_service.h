@@ -0,0 +1,112 @@
+#ifndef __THUMBNAIL_SERVICE_H__
+#define __THUMBNAIL_SERVICE_H__
+
+#include "lv_lock.h"
+#include "metrics.h"
+#include "lvgl/lvgl.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class ThumbnailDiskCache;
+class ThumbnailView;
+
+// Decodes PNG and QOI thumbnails on a worker thread, scaled to fit the box
+// they are shown in and converted to LVGL's native colour format, so
+// drawing them is a plain blit. Decoded images are kept up to [ui]
+// thumbnail_cache_kb, least recently used first out, and on disk with
+// ThumbnailDiskCache when thumbnail_disk_cache_path is set.
+//
+// Everything but the worker runs with lv_lock held.
+class ThumbnailService {
+ public:
+  struct Image {
+    Image(uint32_t w, uint32_t h, std::unique_ptr<uint8_t[]> pixels, size_t size);
+    ~Image();
+
+    lv_img_dsc_t dsc;
+    std::unique_ptr<uint8_t[]> pixels;
+  };
+
+  static ThumbnailService *get_instance();
+
+  void init(LvLock &l);
+
+  // cached image of path fit into a size x size box. NULL if it still has
+  // to be decoded, view is then handed it when it is
+  std::shared_ptr<Image> fetch(const std::string &path, uint32_t size, ThumbnailView *view = NULL);
+
+ private:
+  friend class ThumbnailView;
+
+  ThumbnailService();
+  ~ThumbnailService();
+  ThumbnailService(const ThumbnailService &) = delete;
+  ThumbnailService &operator=(const ThumbnailService &) = delete;
+
+  struct Job {
+    std::string key;
+    std::string path;
+    uint32_t size;
+  };
+
+  struct Entry {
+    std::string key;
+    std::shared_ptr<Image> img;
+  };
+
+  void run();
+  // with lv_lock held, img is NULL when the decode failed
+  void deliver(const std::string &key, std::shared_ptr<Image> img);
+  void notify(const std::string &key, std::shared_ptr<Image> img);
+  void cancel(ThumbnailView *view);
+
+  LvLock *lv_lock;
+  std::string disk_path;
+  size_t disk_budget;
+  std::unique_ptr<ThumbnailDiskCache> disk;
+  size_t budget;
+  size_t used;
+  // front is the most recently used
+  std::list<Entry> entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  std::unordered_map<ThumbnailView *, std::string> waiting;
+
+  // newest at the back, decoded first
+  std::mutex queue_lock;
+  std::condition_variable queue_cv;
+  std::deque<Job> queue;
+
+  Histogram *decode_us;
+  Metrics::Counter *hits;
+  Metrics::Counter *misses;
+  Metrics::Counter *disk_hits;
+};
+
+// An lv_img showing a thumbnail through ThumbnailService, a placeholder
+// symbol until it is decoded. Holds the image it shows, so eviction never
+// pulls pixels from under a widget.
+class ThumbnailView {
+ public:
+  ThumbnailView(lv_obj_t *img);
+  ~ThumbnailView();
+
+  void show(const std::string &path, uint32_t size);
+  void clear();
+
+ private:
+  friend class ThumbnailService;
+
+  void set(std::shared_ptr<ThumbnailService::Image> img);
+
+  lv_obj_t *img;
+  std::shared_ptr<ThumbnailService::Image> shown;
+};
+
+#endif // __THUMBNAIL_SERVICE_H__
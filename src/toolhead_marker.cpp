@@ -0,0 +1,122 @@
+#include "toolhead_marker.h"
+#include "state.h"
+
+#include <algorithm>
+
+ToolheadMarker::ToolheadMarker(lv_obj_t *m, lv_coord_t d, lv_coord_t mg, lv_obj_t *c)
+  : map(m)
+  , dot(lv_obj_create(m))
+  , caption(c)
+  , timer(lv_timer_create(&ToolheadMarker::refresh_cb, LV_DISP_DEF_REFR_PERIOD, this))
+  , dim(d)
+  , margin(mg)
+  , x(0)
+  , y(0)
+  , known(false)
+  , moved(false)
+  , object_changed(false)
+{
+  lv_coord_t size = std::min<lv_coord_t>(std::max<lv_coord_t>(dim / 24, 6), 12);
+  lv_obj_remove_style_all(dot);
+  lv_obj_set_size(dot, size, size);
+  lv_obj_set_style_radius(dot, LV_RADIUS_CIRCLE, 0);
+  lv_obj_set_style_bg_color(dot, lv_palette_main(LV_PALETTE_AMBER), 0);
+  lv_obj_set_style_bg_opa(dot, LV_OPA_COVER, 0);
+  lv_obj_set_style_border_color(dot, lv_color_white(), 0);
+  lv_obj_set_style_border_width(dot, size > 8 ? 2 : 1, 0);
+  lv_obj_clear_flag(dot, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_add_flag(dot, LV_OBJ_FLAG_FLOATING | LV_OBJ_FLAG_HIDDEN);
+
+  if (caption != NULL) {
+    lv_label_set_text(caption, "");
+  }
+}
+
+ToolheadMarker::~ToolheadMarker() {
+  lv_timer_del(timer);
+}
+
+void ToolheadMarker::sync(const BedMap &b) {
+  bed = b;
+
+  auto s = State::get_instance();
+  auto pos = s->get_data("/printer_state/motion_report/live_position"_json_pointer);
+  if (pos.is_null()) {
+    pos = s->get_data("/printer_state/toolhead/position"_json_pointer);
+  }
+  set_position(pos);
+  set_object(s->get_data("/printer_state/exclude_object/current_object"_json_pointer));
+
+  // the bed may have changed under an unchanged position
+  moved = true;
+  refresh();
+}
+
+void ToolheadMarker::consume(json &j) {
+  const json *status = StatusUpdate::status(j);
+  const json *live = StatusUpdate::field(status, "motion_report", "live_position");
+  if (live != NULL) {
+    set_position(*live);
+  } else {
+    const json *pos = StatusUpdate::field(status, "toolhead", "position");
+    if (pos != NULL) {
+      set_position(*pos);
+    }
+  }
+
+  const json *cur = StatusUpdate::field(status, "exclude_object", "current_object");
+  if (cur != NULL) {
+    set_object(*cur);
+  }
+}
+
+void ToolheadMarker::set_position(const json &pos) {
+  if (!pos.is_array() || pos.size() < 2 || !pos[0].is_number() || !pos[1].is_number()) {
+    return;
+  }
+  double px = pos[0].template get<double>();
+  double py = pos[1].template get<double>();
+  if (!known || px != x || py != y) {
+    x = px;
+    y = py;
+    known = true;
+    moved = true;
+  }
+}
+
+void ToolheadMarker::set_object(const json &name) {
+  std::string n = name.is_string() ? name.template get<std::string>() : "";
+  if (n != object) {
+    object = n;
+    object_changed = true;
+  }
+}
+
+void ToolheadMarker::refresh_cb(lv_timer_t *timer) {
+  static_cast<ToolheadMarker *>(timer->user_data)->refresh();
+}
+
+void ToolheadMarker::refresh() {
+  if (object_changed && caption != NULL) {
+    lv_label_set_text(caption, object.c_str());
+  }
+  object_changed = false;
+
+  if (!moved) {
+    return;
+  }
+  moved = false;
+  if (!known) {
+    lv_obj_add_flag(dot, LV_OBJ_FLAG_HIDDEN);
+    return;
+  }
+
+  // children sit inside the map's border and padding. set_pos is a no-op
+  // for the same pixel, so moves under a pixel invalidate nothing
+  lv_point_t p = bed.to_px(x, y, dim, margin);
+  lv_coord_t r = lv_obj_get_width(dot) / 2;
+  lv_coord_t border = lv_obj_get_style_border_width(map, LV_PART_MAIN);
+  lv_obj_set_pos(dot, p.x - r - border - lv_obj_get_style_pad_left(map, LV_PART_MAIN),
+                 p.y - r - border - lv_obj_get_style_pad_top(map, LV_PART_MAIN));
+  lv_obj_clear_flag(dot, LV_OBJ_FLAG_HIDDEN);
+}
@@ -0,0 +1,52 @@
+#ifndef __TOOLHEAD_MARKER_H__
+#define __TOOLHEAD_MARKER_H__
+
+#include "bed_map.h"
+#include "hv/json.hpp"
+#include "lvgl/lvgl.h"
+
+#include <string>
+
+using json = nlohmann::json;
+
+// The toolhead as a dot over a bed map. The dot is an object of its own,
+// so a move invalidates its old and new area and never the map under it.
+// Positions are taken at whatever rate Klipper publishes them and the
+// latest is applied once per display refresh. An optional caption label
+// shows the current object.
+//
+// Everything here runs with lv_lock held.
+class ToolheadMarker {
+ public:
+  // map is dim x dim pixels, the bed drawn margin inside its edges
+  ToolheadMarker(lv_obj_t *map, lv_coord_t dim, lv_coord_t margin, lv_obj_t *caption = NULL);
+  ~ToolheadMarker();
+
+  // new bed bounds, and the position and object from State
+  void sync(const BedMap &bed);
+  // a status update, motion_report, toolhead or exclude_object
+  void consume(json &j);
+
+ private:
+  static void refresh_cb(lv_timer_t *timer);
+  void refresh();
+  void set_position(const json &pos);
+  void set_object(const json &name);
+
+  lv_obj_t *map;
+  lv_obj_t *dot;
+  lv_obj_t *caption;
+  lv_timer_t *timer;
+  lv_coord_t dim;
+  lv_coord_t margin;
+  BedMap bed;
+
+  double x;
+  double y;
+  bool known;
+  bool moved;
+  std::string object;
+  bool object_changed;
+};
+
+#endif // __TOOLHEAD_MARKER_H__
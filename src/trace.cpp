@@ -0,0 +1,260 @@
+#include "trace.h"
+#include "perf_monitor.h"
+#include "logger.h"
+#include "lvgl/lvgl.h"
+
+#include <fmt/format.h>
+
+#include <csignal>
+#include <cstdio>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic_bool Trace::active(false);
+std::atomic_bool Trace::dump_requested(false);
+
+namespace {
+  void (*orig_read_cb)(lv_indev_drv_t *, lv_indev_data_t *) = NULL;
+  lv_indev_state_t last_state = LV_INDEV_STATE_RELEASED;
+
+  void traced_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data) {
+    uint64_t start = PerfMonitor::now_us();
+    orig_read_cb(drv, data);
+
+    // polled every read period, only edges are interesting
+    if (data->state != last_state) {
+      last_state = data->state;
+      Trace *trace = Trace::get_instance();
+      const char *name = data->state == LV_INDEV_STATE_PRESSED ? "touch_down" : "touch_up";
+      uint64_t id = trace->new_flow();
+      trace->flow_begin(name, id);
+      trace->complete("input", name, start, PerfMonitor::now_us() - start);
+      trace->set_touch_flow(id);
+      trace->pend_frame_flow(id);
+    }
+  }
+
+  uint32_t current_tid() {
+    static thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+  }
+}
+
+Trace::Trace()
+  : head(0)
+  , wrapped(false)
+  , next_flow(1)
+  , touch_flow(0)
+  , last_trigger_check(0)
+{
+}
+
+Trace *Trace::get_instance() {
+  static Trace instance;
+  return &instance;
+}
+
+void Trace::enable(size_t capacity, const std::string &path, const std::string &trigger) {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    events.resize(capacity > 0 ? capacity : 1);
+    head = 0;
+    wrapped = false;
+    dump_path = path;
+    trigger_file = trigger;
+  }
+
+  std::signal(SIGUSR2, &Trace::request_dump);
+  active = true;
+  LOG_INFO("tracing enabled, {} events, kill -USR2 or touch {} to dump to {}",
+           capacity, trigger_file, dump_path);
+}
+
+void Trace::attach(lv_indev_t *indev) {
+  if (indev == NULL || orig_read_cb != NULL) {
+    return;
+  }
+
+  orig_read_cb = indev->driver->read_cb;
+  indev->driver->read_cb = traced_read_cb;
+}
+
+void Trace::record(const Event &e) {
+  std::lock_guard<std::mutex> l(lock);
+  events[head] = e;
+  head++;
+  if (head == events.size()) {
+    head = 0;
+    wrapped = true;
+  }
+}
+
+void Trace::complete(const char *cat, const char *name, uint64_t start_us, uint64_t dur_us) {
+  if (!enabled()) {
+    return;
+  }
+  record({cat, name, 'X', current_tid(), start_us, dur_us, 0});
+}
+
+void Trace::instant(const char *cat, const char *name) {
+  if (!enabled()) {
+    return;
+  }
+  record({cat, name, 'i', current_tid(), PerfMonitor::now_us(), 0, 0});
+}
+
+uint64_t Trace::new_flow() {
+  return next_flow.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Trace::flow_begin(const char *name, uint64_t id) {
+  if (!enabled()) {
+    return;
+  }
+  record({"flow", name, 's', current_tid(), PerfMonitor::now_us(), 0, id});
+}
+
+void Trace::flow_step(const char *name, uint64_t id) {
+  if (!enabled() || id == 0) {
+    return;
+  }
+  record({"flow", name, 't', current_tid(), PerfMonitor::now_us(), 0, id});
+}
+
+void Trace::flow_end(const char *name, uint64_t id) {
+  if (!enabled() || id == 0) {
+    return;
+  }
+  record({"flow", name, 'f', current_tid(), PerfMonitor::now_us(), 0, id});
+}
+
+void Trace::pend_frame_flow(uint64_t id) {
+  if (!enabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(lock);
+  // nothing renders while the display sleeps, don't grow without bound
+  if (frame_flows.size() < 256) {
+    frame_flows.push_back(id);
+  }
+}
+
+void Trace::end_frame_flows() {
+  if (!enabled()) {
+    return;
+  }
+
+  std::vector<uint64_t> ids;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    ids.swap(frame_flows);
+  }
+
+  for (uint64_t id : ids) {
+    flow_end("frame", id);
+  }
+}
+
+void Trace::set_touch_flow(uint64_t id) {
+  touch_flow.store(id, std::memory_order_relaxed);
+}
+
+uint64_t Trace::get_touch_flow() const {
+  return touch_flow.load(std::memory_order_relaxed);
+}
+
+void Trace::request_dump(int sig) {
+  dump_requested = true;
+}
+
+void Trace::poll() {
+  if (!enabled()) {
+    return;
+  }
+
+  // input handlers run inside the timer handler, a touch only causes what
+  // happens in the same iteration
+  touch_flow.store(0, std::memory_order_relaxed);
+
+  uint64_t now = PerfMonitor::now_us();
+  if (!trigger_file.empty() && now - last_trigger_check > 1000000) {
+    last_trigger_check = now;
+    struct stat st;
+    if (stat(trigger_file.c_str(), &st) == 0) {
+      unlink(trigger_file.c_str());
+      dump_requested = true;
+    }
+  }
+
+  if (dump_requested.exchange(false)) {
+    dump();
+  }
+}
+
+bool Trace::dump() {
+  std::vector<Event> snapshot;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    if (wrapped) {
+      snapshot.insert(snapshot.end(), events.begin() + head, events.end());
+    }
+    snapshot.insert(snapshot.end(), events.begin(), events.begin() + head);
+  }
+
+  std::string tmp = dump_path + ".tmp";
+  FILE *f = fopen(tmp.c_str(), "w");
+  if (f == NULL) {
+    LOG_ERROR("failed to open trace file {}", tmp);
+    return false;
+  }
+
+  pid_t pid = getpid();
+  fmt::memory_buffer out;
+  auto it = std::back_inserter(out);
+  fmt::format_to(it, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    const Event &e = snapshot[i];
+    fmt::format_to(it, "{{\"cat\":\"{}\",\"name\":\"{}\",\"ph\":\"{}\",\"pid\":{},\"tid\":{},\"ts\":{}",
+                   e.cat, e.name, e.ph, pid, e.tid, e.ts);
+    if (e.ph == 'X') {
+      fmt::format_to(it, ",\"dur\":{}", e.dur);
+    } else if (e.ph == 'i') {
+      fmt::format_to(it, ",\"s\":\"t\"");
+    } else {
+      // flow ends bind to the enclosing slice rather than the next one
+      fmt::format_to(it, ",\"id\":{}{}", e.id, e.ph == 'f' ? ",\"bp\":\"e\"" : "");
+    }
+    fmt::format_to(it, "}}{}\n", i + 1 < snapshot.size() ? "," : "");
+
+    if (out.size() > 64 * 1024) {
+      fwrite(out.data(), 1, out.size(), f);
+      out.clear();
+    }
+  }
+  fmt::format_to(it, "]}}\n");
+  fwrite(out.data(), 1, out.size(), f);
+  fclose(f);
+
+  if (rename(tmp.c_str(), dump_path.c_str()) != 0) {
+    LOG_ERROR("failed to write trace file {}", dump_path);
+    return false;
+  }
+
+  LOG_INFO("wrote {} trace events to {}", snapshot.size(), dump_path);
+  return true;
+}
+
+TraceScope::TraceScope(const char *cat, const char *name)
+  : cat(cat)
+  , name(name)
+  , start(Trace::enabled() ? PerfMonitor::now_us() : 0)
+{
+}
+
+TraceScope::~TraceScope() {
+  if (start != 0) {
+    Trace::get_instance()->complete(cat, name, start, PerfMonitor::now_us() - start);
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct _lv_indev_t;
+
+// Chrome/Perfetto trace_event recorder backed by a fixed size ring buffer.
+// Names and categories are stored by pointer and must outlive the process,
+// use string literals or strings owned by long lived objects.
+class Trace {
+ public:
+  static Trace *get_instance();
+
+  static bool enabled() {
+    return active.load(std::memory_order_relaxed);
+  }
+
+  void enable(size_t capacity, const std::string &dump_path, const std::string &trigger_file);
+
+  // wraps the input device's read callback to start a flow on touch down/up
+  void attach(struct _lv_indev_t *indev);
+
+  void complete(const char *cat, const char *name, uint64_t start_us, uint64_t dur_us);
+  void instant(const char *cat, const char *name);
+
+  // flows tie slices on different threads together, e.g. a websocket
+  // message to the frame that displays it
+  uint64_t new_flow();
+  void flow_begin(const char *name, uint64_t id);
+  void flow_step(const char *name, uint64_t id);
+  void flow_end(const char *name, uint64_t id);
+
+  // flows ended by the next rendered frame
+  void pend_frame_flow(uint64_t id);
+  void end_frame_flows();
+
+  // the touch flow, if any, that caused the current ui callback
+  void set_touch_flow(uint64_t id);
+  uint64_t get_touch_flow() const;
+
+  // async signal safe
+  static void request_dump(int sig = 0);
+
+  // ui thread, checks for a pending dump request or the trigger file
+  void poll();
+  bool dump();
+
+ private:
+  Trace();
+  Trace(const Trace &) = delete;
+  Trace &operator=(const Trace &) = delete;
+
+  struct Event {
+    const char *cat;
+    const char *name;
+    char ph;
+    uint32_t tid;
+    uint64_t ts;
+    uint64_t dur;
+    uint64_t id;
+  };
+
+  void record(const Event &e);
+
+  static std::atomic_bool active;
+  static std::atomic_bool dump_requested;
+
+  std::mutex lock;
+  std::vector<Event> events;
+  size_t head;
+  bool wrapped;
+
+  std::vector<uint64_t> frame_flows;
+  std::atomic<uint64_t> next_flow;
+  std::atomic<uint64_t> touch_flow;
+
+  std::string dump_path;
+  std::string trigger_file;
+  uint64_t last_trigger_check;
+};
+
+// records a complete ("X") event spanning the enclosing scope
+class TraceScope {
+ public:
+  TraceScope(const char *cat, const char *name);
+  ~TraceScope();
+
+ private:
+  const char *cat;
+  const char *name;
+  uint64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(cat, name) TraceScope TRACE_CONCAT(__trace_scope_, __LINE__)(cat, name)
+
+#endif // __TRACE_H__
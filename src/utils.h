@@ -43,10 +43,10 @@ namespace KUtils {
   std::string eta_string(int64_t s);
   size_t bytes_to_mb(size_t s);
 
-  template<typename T, typename U> void sort_map_values(std::map<T, U> v,
+  template<typename T, typename U> void sort_map_values(const std::map<T, U> &v,
 							std::vector<U> &out_vect,
 							std::function<bool(U&, U&)> sorter) {
-    for (auto &el : v) {
+    for (const auto &el : v) {
       out_vect.push_back(el.second);
     }
 
@@ -0,0 +1,180 @@
+#include "virtual_list.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+  const lv_coord_t ROW_PAD = 12;
+}
+
+VirtualList::VirtualList(lv_obj_t *parent, TextFn t, ClickFn c, TextFn d)
+  : cont(lv_obj_create(parent))
+  , spacer(lv_obj_create(cont))
+  , text(t)
+  , clicked(c)
+  , detail(d)
+  , count(0)
+  , selected(SIZE_MAX)
+  , row_height(lv_font_get_line_height(lv_obj_get_style_text_font(cont, LV_PART_MAIN)) + 2 * ROW_PAD)
+{
+  lv_obj_set_style_pad_all(cont, 0, 0);
+  lv_obj_set_scroll_dir(cont, LV_DIR_VER);
+
+  lv_obj_remove_style_all(spacer);
+  lv_obj_clear_flag(spacer, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_set_size(spacer, 1, 0);
+
+  lv_obj_add_event_cb(cont, &VirtualList::_handle_event, LV_EVENT_SIZE_CHANGED, this);
+  lv_obj_add_event_cb(cont, &VirtualList::_handle_event, LV_EVENT_SCROLL, this);
+}
+
+lv_obj_t *VirtualList::get_container() {
+  return cont;
+}
+
+void VirtualList::set_count(size_t n) {
+  count = n;
+  selected = SIZE_MAX;
+  lv_obj_set_height(spacer, count * row_height);
+  for (auto &s : slots) {
+    s.bound = SIZE_MAX;
+  }
+  layout();
+}
+
+void VirtualList::set_selected(size_t row) {
+  if (row == selected) {
+    return;
+  }
+  for (auto &s : slots) {
+    if (s.bound == selected) {
+      lv_obj_clear_state(s.row, LV_STATE_CHECKED);
+    } else if (s.bound == row) {
+      lv_obj_add_state(s.row, LV_STATE_CHECKED);
+    }
+  }
+  selected = row;
+}
+
+void VirtualList::scroll_to(size_t row) {
+  lv_obj_scroll_to_y(cont, std::min(row, count) * row_height, LV_ANIM_OFF);
+  layout();
+}
+
+void VirtualList::refresh(size_t row) {
+  if (slots.empty() || row >= count) {
+    return;
+  }
+  Slot &s = slots[row % slots.size()];
+  if (s.bound == row) {
+    bind(s, row);
+  }
+}
+
+void VirtualList::handle_event(lv_event_t *e) {
+  lv_event_code_t code = lv_event_get_code(e);
+  if (code == LV_EVENT_SIZE_CHANGED) {
+    resize();
+  } else if (code == LV_EVENT_SCROLL) {
+    layout();
+  } else if (code == LV_EVENT_CLICKED) {
+    lv_obj_t *row = lv_event_get_current_target(e);
+    for (auto &s : slots) {
+      if (s.row == row && s.bound < count) {
+        clicked(s.bound);
+        break;
+      }
+    }
+  }
+}
+
+void VirtualList::resize() {
+  // the rows in view, the one cut at the bottom and the overscan
+  size_t want = lv_obj_get_height(cont) / row_height + 1 + 2 * OVERSCAN;
+  if (want <= slots.size()) {
+    return;
+  }
+
+  lv_color_t primary = lv_theme_get_color_primary(cont);
+  while (slots.size() < want) {
+    lv_obj_t *row = lv_obj_create(cont);
+    lv_obj_set_size(row, LV_PCT(100), row_height);
+    lv_obj_set_style_radius(row, 0, 0);
+    lv_obj_set_style_pad_ver(row, 0, 0);
+    lv_obj_set_style_pad_hor(row, ROW_PAD, 0);
+    lv_obj_set_style_border_width(row, 1, 0);
+    lv_obj_set_style_border_side(row, LV_BORDER_SIDE_BOTTOM, 0);
+    lv_obj_set_style_bg_color(row, primary, LV_STATE_CHECKED);
+    lv_obj_set_style_bg_color(row, primary, LV_STATE_PRESSED);
+    lv_obj_clear_flag(row, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICK_FOCUSABLE);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(row, &VirtualList::_handle_event, LV_EVENT_CLICKED, this);
+
+    lv_obj_t *label = lv_label_create(row);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_DOT);
+    lv_obj_t *extra = NULL;
+    if (detail) {
+      // the name takes what the detail leaves
+      lv_obj_set_flex_flow(row, LV_FLEX_FLOW_ROW);
+      lv_obj_set_flex_align(row, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+      lv_obj_set_flex_grow(label, 1);
+
+      extra = lv_label_create(row);
+      lv_obj_set_style_text_font(extra, &lv_font_montserrat_12, 0);
+      lv_obj_set_style_text_color(extra, lv_palette_main(LV_PALETTE_GREY), 0);
+      lv_obj_set_style_pad_left(extra, ROW_PAD, 0);
+    } else {
+      lv_obj_set_width(label, LV_PCT(100));
+      lv_obj_align(label, LV_ALIGN_LEFT_MID, 0, 0);
+    }
+
+    slots.push_back({row, label, extra, SIZE_MAX});
+  }
+
+  // rows map to slots by index modulo the pool
+  for (auto &s : slots) {
+    s.bound = SIZE_MAX;
+  }
+  layout();
+}
+
+void VirtualList::layout() {
+  if (slots.empty()) {
+    return;
+  }
+
+  size_t first = std::max<lv_coord_t>(lv_obj_get_scroll_y(cont), 0) / row_height;
+  first = first > OVERSCAN ? first - OVERSCAN : 0;
+  size_t last = std::min(count, first + slots.size());
+
+  for (size_t r = first; r < last; r++) {
+    Slot &s = slots[r % slots.size()];
+    if (s.bound != r) {
+      bind(s, r);
+    }
+  }
+
+  for (auto &s : slots) {
+    bool in_view = s.bound >= first && s.bound < last;
+    bool hidden = lv_obj_has_flag(s.row, LV_OBJ_FLAG_HIDDEN);
+    if (in_view && hidden) {
+      lv_obj_clear_flag(s.row, LV_OBJ_FLAG_HIDDEN);
+    } else if (!in_view && !hidden) {
+      lv_obj_add_flag(s.row, LV_OBJ_FLAG_HIDDEN);
+    }
+  }
+}
+
+void VirtualList::bind(Slot &s, size_t row) {
+  lv_label_set_text(s.label, text(row));
+  if (s.detail != NULL) {
+    lv_label_set_text(s.detail, detail(row));
+  }
+  lv_obj_set_y(s.row, row * row_height);
+  if (row == selected) {
+    lv_obj_add_state(s.row, LV_STATE_CHECKED);
+  } else {
+    lv_obj_clear_state(s.row, LV_STATE_CHECKED);
+  }
+  s.bound = row;
+}
@@ -0,0 +1,70 @@
+#ifndef __VIRTUAL_LIST_H__
+#define __VIRTUAL_LIST_H__
+
+#include "lvgl/lvgl.h"
+
+#include <functional>
+#include <vector>
+
+// A scrolling list of single line rows of which only those in view, and
+// a few either side, are LVGL objects. Rows are a fixed height, so the
+// first row in view is the scroll offset over the row height, and a
+// spacer as tall as every row gives the scroll range. Row objects are
+// recycled as rows scroll in and out; a row keeps its object while it
+// stays in the pool, so a scroll step binds only the rows it brings in.
+// Text comes from the model through text(row) when a row is bound, with
+// an optional dimmer detail at the right end of the row.
+//
+// Everything here runs with lv_lock held.
+class VirtualList {
+ public:
+  // the row's text, valid until the model changes
+  typedef std::function<const char *(size_t row)> TextFn;
+  typedef std::function<void(size_t row)> ClickFn;
+
+  VirtualList(lv_obj_t *parent, TextFn text, ClickFn clicked, TextFn detail = TextFn());
+
+  lv_obj_t *get_container();
+
+  // the model now has n rows, all rebound from text()
+  void set_count(size_t n);
+  size_t get_count() const { return count; }
+
+  // highlighted, SIZE_MAX for none
+  void set_selected(size_t row);
+  void scroll_to(size_t row);
+  // the row's text changed, rebound if it has an object
+  void refresh(size_t row);
+
+  static void _handle_event(lv_event_t *e) {
+    static_cast<VirtualList *>(e->user_data)->handle_event(e);
+  }
+
+ private:
+  static const size_t OVERSCAN = 2;
+
+  struct Slot {
+    lv_obj_t *row;
+    lv_obj_t *label;
+    lv_obj_t *detail;
+    // SIZE_MAX when unbound
+    size_t bound;
+  };
+
+  void handle_event(lv_event_t *e);
+  void resize();
+  void layout();
+  void bind(Slot &s, size_t row);
+
+  lv_obj_t *cont;
+  lv_obj_t *spacer;
+  TextFn text;
+  ClickFn clicked;
+  TextFn detail;
+  std::vector<Slot> slots;
+  size_t count;
+  size_t selected;
+  lv_coord_t row_height;
+};
+
+#endif // __VIRTUAL_LIST_H__
@@ -12,8 +12,12 @@
 
 #include "websocket_client.h"
 #include "logger.h"
+#include "lv_lock.h"
+#include "perf_monitor.h"
+#include "trace.h"
 
 #include <algorithm>
+#include <cstring>
 
 using namespace hv;
 using json = nlohmann::json;
@@ -21,24 +25,132 @@ using json = nlohmann::json;
 KWebSocketClient::KWebSocketClient(EventLoopPtr loop)
   : WebSocketClient(loop)
   , id(0)
+  , frames_in(Metrics::get_instance()->counter("guppy_ws_frames_total", "Websocket frames", "direction=\"in\""))
+  , frames_out(Metrics::get_instance()->counter("guppy_ws_frames_total", "Websocket frames", "direction=\"out\""))
+  , bytes_in(Metrics::get_instance()->counter("guppy_ws_bytes_total", "Websocket payload bytes", "direction=\"in\""))
+  , bytes_out(Metrics::get_instance()->counter("guppy_ws_bytes_total", "Websocket payload bytes", "direction=\"out\""))
+  , pending_rpcs(0)
 {
+  Metrics::get_instance()->gauge("guppy_ws_pending_rpcs", "JSON-RPC requests awaiting a response",
+                                 [this]() { return static_cast<double>(pending_rpcs.load()); });
 }
 
 KWebSocketClient::~KWebSocketClient() {
 }
 
+namespace {
+  void reconnect_setting(reconn_setting_t *reconn) {
+    reconn_setting_init(reconn);
+    reconn->min_delay = 200;
+    reconn->max_delay = 2000;
+    reconn->delay_policy = 2;
+  }
+}
+
 int KWebSocketClient::connect(const char* url,
 			      std::function<void()> connected,
 			      std::function<void()> disconnected) {
   LOG_DEBUG("websocket connecting");
+  on_connected = connected;
+  on_disconnected = disconnected;
+
   // set callbacks
-  onopen = [this, connected]() {
+  onopen = [this]() {
     const HttpResponsePtr& resp = getHttpResponse();
     LOG_DEBUG("onopen {}", resp->body.c_str());
-    connected();
+    on_connected();
+  };
+  onmessage = [this](const std::string &msg) {
+    handle_message(msg.data(), msg.size());
+  };
+
+  onclose = [this]() {
+    LOG_DEBUG("onclose");
+    on_disconnected();
+  };
+
+  // ping
+  setPingInterval(10000);
+
+  reconn_setting_t reconn;
+  reconnect_setting(&reconn);
+  setReconnect(&reconn);
+
+  http_headers headers;
+  return open(url, headers);
+};
+
+int KWebSocketClient::connect_unix(const std::string &path,
+				   std::function<void()> connected,
+				   std::function<void()> disconnected) {
+  LOG_DEBUG("unix socket connecting to {}", path);
+  on_connected = connected;
+  on_disconnected = disconnected;
+
+  uds = std::make_unique<hv::TcpClient>();
+  // a negative port makes libhv treat the host as a socket path
+  if (uds->createsocket(-1, path.c_str()) < 0) {
+    LOG_ERROR("failed to create unix socket for {}", path);
+    uds.reset();
+    return -1;
+  }
+
+  unpack_setting_t unpack;
+  memset(&unpack, 0, sizeof(unpack));
+  unpack.mode = UNPACK_BY_DELIMITER;
+  // file lists and metadata responses can get large
+  unpack.package_max_length = 16 * 1024 * 1024;
+  unpack.delimiter[0] = 0x03;
+  unpack.delimiter_bytes = 1;
+  uds->setUnpack(&unpack);
+
+  reconn_setting_t reconn;
+  reconnect_setting(&reconn);
+  uds->setReconnect(&reconn);
+
+  uds->onConnection = [this](const SocketChannelPtr &channel) {
+    if (channel->isConnected()) {
+      LOG_DEBUG("unix socket connected");
+      on_connected();
+    } else {
+      LOG_DEBUG("unix socket closed");
+      on_disconnected();
+    }
   };
-  onmessage = [this, connected, disconnected](const std::string &msg) {
-    auto j = json::parse(msg);
+  uds->onMessage = [this](const SocketChannelPtr &, Buffer *buf) {
+    const char *data = static_cast<const char *>(buf->data());
+    size_t len = buf->size();
+    if (len > 0 && data[len - 1] == 0x03) {
+      len--;
+    }
+    handle_message(data, len);
+  };
+
+  uds->start();
+  return 0;
+}
+
+void KWebSocketClient::handle_message(const char *data, size_t len) {
+  TRACE_SCOPE("ws", "ws_receive");
+  Trace *trace = Trace::get_instance();
+  PerfMonitor::get_instance()->record_message();
+  frames_in->fetch_add(1, std::memory_order_relaxed);
+  bytes_in->fetch_add(len, std::memory_order_relaxed);
+
+  // a throwing consumer or a malformed frame costs that frame, not the
+  // connection
+  try {
+    uint64_t start = PerfMonitor::now_us();
+    json &j = parser.parse(data, len);
+    uint64_t parsed = PerfMonitor::now_us();
+
+    auto method_it = j.find("method");
+    MethodMetrics &mm = method_metrics(method_it != j.end() && method_it->is_string()
+                                       ? method_it->get_ref<const std::string &>()
+                                       : "response");
+    mm.parse->observe(parsed - start);
+    LvLockWatchdog::get_instance()->set_message(mm.name);
+    trace->complete("ws", "ws_parse", start, parsed - start);
 
     if (j.contains("id")) {
       // XXX: get rid of consumers and use function ptrs for callback
@@ -53,23 +165,22 @@ int KWebSocketClient::connect(const char* url,
         cb_entry->second(j);
         callbacks.erase(cb_entry);
       }
+      update_pending();
     }
 
     if (j.contains("method")) {
       std::string method = j["method"].template get<std::string>();
       if ("notify_status_update" == method) {
-        for (const auto &entry : notify_consumers) {
-          entry->consume(j);
-        }
+        dispatch_status(j);
       } else if ("notify_klippy_disconnected" == method) {
         LOG_DEBUG("klippy disconnected");
-        disconnected();
+        on_disconnected();
       } else if ("notify_klippy_shutdown" == method) {
         LOG_DEBUG("klippy shutdown");
-        disconnected();
+        on_disconnected();
       } else if ("notify_klippy_ready" == method) {
         LOG_DEBUG("klippy connected");
-        connected();
+        on_connected();
       }
 
       for (const auto &entry : method_resp_cbs) {
@@ -80,26 +191,98 @@ int KWebSocketClient::connect(const char* url,
         }
       }
     }
-  };
 
-  onclose = [disconnected]() {
-    LOG_DEBUG("onclose");
-    disconnected();
-  };
+    mm.dispatch->observe(PerfMonitor::now_us() - parsed);
+  } catch (const std::exception &e) {
+    LOG_ERROR("failed to handle message: {}", e.what());
+  }
+  LvLockWatchdog::get_instance()->set_message(NULL);
+}
 
-  // ping
-  setPingInterval(10000);
+void KWebSocketClient::dispatch_status(json &j) {
+  Trace *trace = Trace::get_instance();
+  uint64_t flow = trace->new_flow();
+  trace->flow_begin("status", flow);
 
-  reconn_setting_t reconn;
-  reconn_setting_init(&reconn);
-  reconn.min_delay = 200;
-  reconn.max_delay = 2000;
-  reconn.delay_policy = 2;
-  setReconnect(&reconn);
+  notify_dispatcher.dispatch(j, [trace](NotifyConsumer *, const NotifyDispatcher::ConsumerMetrics &cm,
+                                        uint64_t consume_start, uint64_t consume_us) {
+    trace->complete("consume", cm.name.c_str(), consume_start, consume_us);
+  });
 
-  http_headers headers;
-  return open(url, headers);
-};
+  // ended by the frame that shows the update
+  trace->pend_frame_flow(flow);
+}
+
+hv::EventLoopPtr KWebSocketClient::event_loop() {
+  return uds ? uds->loop() : loop();
+}
+
+int KWebSocketClient::connect_klippy(const std::string &path, const std::vector<std::string> &groups) {
+  klippy = std::make_unique<KlippyClient>(event_loop(), frames_in, bytes_in);
+  klippy->set_groups(groups);
+  return klippy->connect(path, [this](json &j) {
+    TRACE_SCOPE("ws", "klippy_receive");
+    PerfMonitor::get_instance()->record_message();
+    uint64_t start = PerfMonitor::now_us();
+    MethodMetrics &mm = method_metrics("notify_status_update");
+    LvLockWatchdog::get_instance()->set_message(mm.name);
+    try {
+      dispatch_status(j);
+    } catch (const std::exception &e) {
+      LOG_ERROR("failed to handle klippy status update: {}", e.what());
+    }
+    mm.dispatch->observe(PerfMonitor::now_us() - start);
+    LvLockWatchdog::get_instance()->set_message(NULL);
+  });
+}
+
+int KWebSocketClient::subscribe_objects(const json &objects, std::function<void(json&)> cb) {
+  json params = json::object();
+  if (!klippy || !klippy->is_connected()) {
+    params["objects"] = objects;
+    return send_jsonrpc("printer.objects.subscribe", params, cb);
+  }
+
+  json direct = json::object();
+  json relayed = json::object();
+  for (auto &el : objects.items()) {
+    (klippy->wants(el.key()) ? direct : relayed)[el.key()] = el.value();
+  }
+  LOG_DEBUG("subscribing to {} objects through klippy, {} through moonraker", direct.size(), relayed.size());
+
+  // both replies arrive on the same loop thread
+  auto merged = std::make_shared<json>();
+  auto pending = std::make_shared<int>((direct.empty() ? 0 : 1) + (relayed.empty() ? 0 : 1));
+  auto on_result = [merged, pending, cb](json &j) {
+    auto &result = j["result"];
+    if (result.is_object() && result["status"].is_object()) {
+      json &merged_result = (*merged)["result"];
+      merged_result["eventtime"] = result["eventtime"];
+      merged_result["status"].update(result["status"]);
+    }
+
+    if (--(*pending) == 0) {
+      cb(*merged);
+    }
+  };
+
+  if (!direct.empty()) {
+    klippy->subscribe(direct, [this, direct, on_result](json &j) {
+      if (j.contains("error")) {
+        // klippy went away before replying, moonraker takes them
+        json params = {{"objects", direct}};
+        send_jsonrpc("printer.objects.subscribe", params, on_result);
+        return;
+      }
+      on_result(j);
+    });
+  }
+  if (!relayed.empty()) {
+    params["objects"] = relayed;
+    send_jsonrpc("printer.objects.subscribe", params, on_result);
+  }
+  return 0;
+}
 
 int KWebSocketClient::send_jsonrpc(const std::string &method,
 				   const json &params,
@@ -108,6 +291,7 @@ int KWebSocketClient::send_jsonrpc(const std::string &method,
   if (entry == callbacks.end()) {
     // LOG_DEBUG("registering consume %d, %x\n", id, consumer);
     callbacks.insert({id, cb});
+    update_pending();
     // XXX: check success, remove consumer if send is unsuccessfull
     return send_jsonrpc(method, params);
   } else {
@@ -122,6 +306,7 @@ int KWebSocketClient::send_jsonrpc(const std::string &method, std::function<void
   if (entry == callbacks.end()) {
     // LOG_DEBUG("registering consume %d, %x\n", id, consumer);
     callbacks.insert({id, cb});
+    update_pending();
     // XXX: check success, remove consumer if send is unsuccessfull
     return send_jsonrpc(method);
   } else {
@@ -134,50 +319,69 @@ int KWebSocketClient::send_jsonrpc(const std::string &method, const json &params
   const auto &entry = consumers.find(id);
   if (entry == consumers.end()) {
     consumers.insert({id, consumer});
+    update_pending();
     return send_jsonrpc(method, params);
   }
   return 0;
 }
 
 void KWebSocketClient::register_notify_update(NotifyConsumer *consumer) {
-  if (std::find(notify_consumers.begin(), notify_consumers.end(), consumer) == std::end(notify_consumers)) {
-    notify_consumers.push_back(consumer);
-  }
+  notify_dispatcher.add(consumer);
 }
 
 void KWebSocketClient::unregister_notify_update(NotifyConsumer *consumer) {
-  notify_consumers.erase(std::remove_if(
-    notify_consumers.begin(), notify_consumers.end(),
-    [consumer](NotifyConsumer *c) {
-      return c == consumer;
-    }));
+  notify_dispatcher.remove(consumer);
 }
 
-int KWebSocketClient::send_jsonrpc(const std::string &method, const json &params) {
-  json rpc;
-  rpc["jsonrpc"] = "2.0";
-  rpc["method"] = method;
-  rpc["params"] = params;
-  rpc["id"] = id++;
+bool KWebSocketClient::is_registered(NotifyConsumer *consumer) {
+  return notify_dispatcher.contains(consumer);
+}
 
-  LOG_DEBUG("send_jsonrpc: {}", rpc.dump());
-  return send(rpc.dump());
+void KWebSocketClient::run_in_loop(std::function<void()> task) {
+  event_loop()->queueInLoop(task);
+}
+
+int KWebSocketClient::send_jsonrpc(const std::string &method, const json &params) {
+  RpcWriter rpc(method);
+  rpc.params(params);
+  return send_jsonrpc(rpc);
 }
 
 int KWebSocketClient::send_jsonrpc(const std::string &method) {
-  json rpc;
-  rpc["jsonrpc"] = "2.0";
-  rpc["method"] = method;
-  rpc["id"] = id++;
+  RpcWriter rpc(method);
+  return send_jsonrpc(rpc);
+}
 
-  LOG_DEBUG("send_jsonrpc: {}", rpc.dump());
-  return send(rpc.dump());
+int KWebSocketClient::send_jsonrpc(RpcWriter &rpc) {
+  const std::string &frame = rpc.finish(id++);
+  if (frame.empty()) {
+    LOG_ERROR("dropping malformed jsonrpc request");
+    return -1;
+  }
+  return send_frame(frame);
+}
+
+int KWebSocketClient::send_jsonrpc(RpcWriter &rpc, std::function<void(json&)> cb) {
+  if (!rpc.ok()) {
+    LOG_ERROR("dropping malformed jsonrpc request");
+    return -1;
+  }
+  const auto &entry = callbacks.find(id);
+  if (entry == callbacks.end()) {
+    callbacks.insert({id, cb});
+    update_pending();
+    return send_jsonrpc(rpc);
+  }
+  return 0;
 }
 
 int KWebSocketClient::gcode_script(const std::string &gcode) {
-  json cmd = {{ "script", gcode }};
+  TRACE_SCOPE("ws", "gcode_script");
+  Trace::get_instance()->flow_step("gcode_script", Trace::get_instance()->get_touch_flow());
   LOG_TRACE("{}", gcode);
-  return send_jsonrpc("printer.gcode.script", cmd);
+  RpcWriter rpc("printer.gcode.script");
+  rpc.param("script", gcode);
+  return send_jsonrpc(rpc);
 }
 
 void KWebSocketClient::register_method_callback(std::string resp_method,
@@ -195,3 +399,39 @@ void KWebSocketClient::register_method_callback(std::string resp_method,
     entry->second.insert({handler_name, cb});
   }
 }
+
+KWebSocketClient::MethodMetrics &KWebSocketClient::method_metrics(const std::string &method) {
+  auto entry = method_metrics_cache.find(method);
+  if (entry != method_metrics_cache.end()) {
+    return entry->second;
+  }
+
+  Metrics *m = Metrics::get_instance();
+  std::string labels = fmt::format("method=\"{}\"", method);
+  MethodMetrics mm = {
+    NULL,
+    m->histogram("guppy_ws_parse_seconds", "Time spent parsing incoming frames", labels, 1e-6),
+    m->histogram("guppy_ws_dispatch_seconds", "Time spent dispatching parsed frames", labels, 1e-6)
+  };
+  auto inserted = method_metrics_cache.insert({method, mm}).first;
+  // map keys don't move, the watchdog keeps this pointer
+  inserted->second.name = inserted->first.c_str();
+  return inserted->second;
+}
+
+int KWebSocketClient::send_frame(const std::string &frame) {
+  LOG_DEBUG("send_jsonrpc: {}", frame);
+  frames_out->fetch_add(1, std::memory_order_relaxed);
+  bytes_out->fetch_add(frame.size(), std::memory_order_relaxed);
+  if (uds) {
+    static const char delimiter = 0x03;
+    std::lock_guard<std::mutex> guard(uds_write);
+    int ret = uds->send(frame);
+    return ret < 0 ? ret : uds->send(&delimiter, 1);
+  }
+  return send(frame);
+}
+
+void KWebSocketClient::update_pending() {
+  pending_rpcs = callbacks.size() + consumers.size();
+}
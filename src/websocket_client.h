@@ -2,13 +2,21 @@
 #define __KWEBSOCKET_CLIENT_H__
 
 #include "hv/WebSocketClient.h"
+#include "hv/TcpClient.h"
 #include "notify_consumer.h"
+#include "notify_dispatcher.h"
+#include "json_parser.h"
+#include "klippy_client.h"
+#include "metrics.h"
+#include "rpc_writer.h"
 #include "hv/json.hpp"
 
 #include <map>
 #include <vector>
 #include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 using json = nlohmann::json;
 
@@ -21,8 +29,26 @@ class KWebSocketClient : public hv::WebSocketClient {
 	      std::function<void()> connected,
 	      std::function<void()> disconnected);
 
+  // moonraker's unix socket, same JSON-RPC without the websocket framing
+  int connect_unix(const std::string &path,
+		   std::function<void()> connected,
+		   std::function<void()> disconnected);
+
+  // optional second connection for status updates of the given groups,
+  // straight from klippy's api socket
+  int connect_klippy(const std::string &path, const std::vector<std::string> &groups);
+
+  // printer.objects.subscribe, split between moonraker and klippy when
+  // klippy is connected. cb gets the combined result
+  int subscribe_objects(const json &objects, std::function<void(json&)> cb);
+
   void register_notify_update(NotifyConsumer *consumer);
   void unregister_notify_update(NotifyConsumer *consumer);
+  bool is_registered(NotifyConsumer *consumer);
+
+  // queues task on the thread status updates are dispatched on, it runs
+  // after the update in progress, if any
+  void run_in_loop(std::function<void()> task);
 
   // void register_gcode_resp(std::function<void(json&)> cb);
 
@@ -31,6 +57,8 @@ class KWebSocketClient : public hv::WebSocketClient {
   int send_jsonrpc(const std::string &method, const json &params, NotifyConsumer *consumer);  
   int send_jsonrpc(const std::string &method, const json &params);
   int send_jsonrpc(const std::string &method);
+  int send_jsonrpc(RpcWriter &rpc);
+  int send_jsonrpc(RpcWriter &rpc, std::function<void(json&)> cb);
   int gcode_script(const std::string &gcode);
 
   void register_method_callback(std::string resp_method,
@@ -38,14 +66,45 @@ class KWebSocketClient : public hv::WebSocketClient {
 				std::function<void(json&)> cb);
   
  private:
+  struct MethodMetrics {
+    const char *name;
+    Histogram *parse;
+    Histogram *dispatch;
+  };
+
+  void handle_message(const char *data, size_t len);
+  void dispatch_status(json &j);
+  hv::EventLoopPtr event_loop();
+  MethodMetrics &method_metrics(const std::string &method);
+  int send_frame(const std::string &frame);
+  void update_pending();
+
   std::map<uint32_t, std::function<void(json&)>> callbacks;
   std::map<uint32_t, NotifyConsumer*> consumers;
-  std::vector<NotifyConsumer*> notify_consumers;
+  NotifyDispatcher notify_dispatcher;
+  // frames are parsed into the document the last one left behind
+  JsonParser parser;
   // std::vector<std::function<void(json&)>> gcode_resp_cbs;
 
   // method_name : { <unique-name-cb-handler> :handler-cb }
   std::map<std::string, std::map<std::string, std::function<void(json&)>>> method_resp_cbs;
   std::atomic_uint64_t id;
+
+  // cached so the receive path does not go through the registry
+  std::map<std::string, MethodMetrics> method_metrics_cache;
+  Metrics::Counter *frames_in;
+  Metrics::Counter *frames_out;
+  Metrics::Counter *bytes_in;
+  Metrics::Counter *bytes_out;
+  std::atomic_uint64_t pending_rpcs;
+
+  std::function<void()> on_connected;
+  std::function<void()> on_disconnected;
+  // set when connected over the unix socket, the websocket is then unused
+  std::unique_ptr<hv::TcpClient> uds;
+  // a frame and its delimiter go out as two writes
+  std::mutex uds_write;
+  std::unique_ptr<KlippyClient> klippy;
 };
 
 #endif //__KWEBSOCKET_CLIENT_H__
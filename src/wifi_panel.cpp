@@ -2,6 +2,7 @@
 #include "utils.h"
 #include "config.h"
 #include "logger.h"
+#include "panel_manager.h"
 
 #include <sstream>
 #include <iostream>
@@ -25,9 +26,9 @@ static void draw_part_event_cb(lv_event_t * e) {
   }
 }
 
-WifiPanel::WifiPanel(std::mutex &l)
+WifiPanel::WifiPanel(LvLock &l)
   : lv_lock(l)
-  , cont(lv_obj_create(lv_scr_act()))
+  , cont(lv_obj_create(PanelManager::get_instance()->parking()))
   , spinner(lv_spinner_create(cont, 1000, 60))
   , top_cont(lv_obj_create(cont))
   , wifi_table(lv_table_create(top_cont))
@@ -103,13 +104,10 @@ WifiPanel::WifiPanel(std::mutex &l)
   // allow clicks on non-clickables to hide the keyboard
   lv_obj_add_event_cb(prompt_cont, &WifiPanel::_handle_kb_input, LV_EVENT_CLICKED, this);
   lv_obj_add_event_cb(wifi_label, &WifiPanel::_handle_kb_input, LV_EVENT_CLICKED, this);
-  lv_obj_move_background(cont);
   lv_obj_move_foreground(spinner);
 
   wpa_event.register_callback("WifiPanel",
       [this](const std::string &event) { this->handle_wpa_event(event); });
-
-  wpa_event.start();
 }
 
 WifiPanel::~WifiPanel() {
@@ -121,8 +119,13 @@ WifiPanel::~WifiPanel() {
 
 void WifiPanel::foreground() {
   LOG_TRACE("wifi panel fg");
-  lv_obj_move_foreground(cont);
+  PanelManager::get_instance()->show(cont);
   lv_obj_clear_flag(spinner, LV_OBJ_FLAG_HIDDEN);
+  if (!wpa_started) {
+    // nothing else needs wpa_supplicant, keep it off the startup path
+    wpa_event.start();
+    wpa_started = true;
+  }
   wpa_event.send_command("SCAN");
 }
 
@@ -132,7 +135,7 @@ void WifiPanel::handle_back_btn(lv_event_t *e) {
     LOG_TRACE("wifi panel bg");
     lv_obj_add_flag(wifi_table, LV_OBJ_FLAG_HIDDEN);
     lv_obj_add_flag(prompt_cont, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_move_background(cont);
+    PanelManager::get_instance()->hide(cont);
   }
 }
 
@@ -223,7 +226,7 @@ void WifiPanel::handle_wpa_event(const std::string &event) {
       LOG_TRACE("handle wpa event scan results - current network {}", cur_network);
     }
 
-    std::lock_guard<std::mutex> lock(lv_lock);
+    LV_LOCK_GUARD(lock, lv_lock);
     if (!has_current) {
       lv_label_set_text(wifi_label, "");
     }
@@ -271,7 +274,7 @@ void WifiPanel::handle_wpa_event(const std::string &event) {
 	      return a.second > b.second;
       });
       
-      std::lock_guard<std::mutex> lock(lv_lock);
+      LV_LOCK_GUARD(lock, lv_lock);
 
       uint32_t index = 0;
       for (const auto &wifi : pairs) {
@@ -4,7 +4,7 @@
 #include "wpa_event.h"
 #include "button_container.h"
 #include "lvgl/lvgl.h"
-#include <mutex>
+#include "lv_lock.h"
 
 #include <map>
 #include <set>
@@ -12,7 +12,7 @@
 
 class WifiPanel {
  public:
-  WifiPanel(std::mutex &l);
+  WifiPanel(LvLock &l);
   
   ~WifiPanel();
 
@@ -52,7 +52,7 @@ class WifiPanel {
   };
 
  private:
-  std::mutex &lv_lock;
+  LvLock &lv_lock;
   WpaEvent wpa_event;
   lv_obj_t *cont;
   lv_obj_t *spinner;
@@ -70,6 +70,7 @@ class WifiPanel {
   std::map<std::string, std::string> list_networks;
   std::map<std::string, int> wifi_name_db;
   bool entering_password = false;
+  bool wpa_started = false;
 
 };
 
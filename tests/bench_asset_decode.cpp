@@ -0,0 +1,104 @@
+// bench_asset_decode.cpp
+// first show latency of the packed icons: the time AssetCache takes to
+// expand an image it has not seen, over every asset in a directory
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include "asset_codec.h"
+#include "asset_source.h"
+
+struct Packed {
+  AssetSource src;
+  std::vector<uint8_t> data;
+};
+
+static void check(const Packed &p) {
+  size_t n = static_cast<size_t>(p.src.w) * p.src.h;
+  std::vector<uint8_t> out(n * 4);
+  bool ok = asset_decode(p.data.data(), p.data.size(), p.src.w, p.src.h, AssetPixels::BGRA8888, out.data());
+  assert(ok);
+  for (size_t i = 0; i < n * 4; i++) {
+    if (p.src.bgra[i - i % 4 + 3] == 0) {
+      // colour under transparent pixels is dropped
+      assert(out[i - i % 4 + 3] == 0);
+      continue;
+    }
+    assert(abs(static_cast<int>(out[i]) - p.src.bgra[i]) <= 2);
+  }
+
+  // truncated input is refused, not read past
+  ok = asset_decode(p.data.data(), p.data.size() / 2, p.src.w, p.src.h, AssetPixels::BGRA8888, out.data());
+  assert(!ok);
+  (void)ok;
+}
+
+static void run(const std::vector<Packed> &assets, AssetPixels fmt, const char *label) {
+  std::vector<double> us;
+  for (const auto &p : assets) {
+    auto start = std::chrono::steady_clock::now();
+    size_t size = static_cast<size_t>(p.src.w) * p.src.h * asset_pixel_size(fmt);
+    std::unique_ptr<uint8_t[]> pixels(new uint8_t[size]);
+    bool ok = asset_decode(p.data.data(), p.data.size(), p.src.w, p.src.h, fmt, pixels.get());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(ok);
+    (void)ok;
+    us.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+  }
+
+  std::sort(us.begin(), us.end());
+  double total = 0;
+  for (double u : us) {
+    total += u;
+  }
+  printf("%-14s p50 %6.1f us  p99 %6.1f us  max %6.1f us  all %zu icons %7.1f us\n", label,
+         us[us.size() / 2], us[us.size() * 99 / 100], us.back(), us.size(), total);
+}
+
+int main(int argc, char **argv) {
+  std::string dir = argc > 1 ? argv[1] : "assets/material";
+  std::vector<Packed> assets;
+  size_t raw = 0;
+  size_t packed = 0;
+
+  DIR *d = opendir(dir.c_str());
+  if (d == NULL) {
+    fprintf(stderr, "%s: can't open\n", dir.c_str());
+    return 1;
+  }
+  while (struct dirent *e = readdir(d)) {
+    std::string name = e->d_name;
+    if (name.size() < 2 || name.compare(name.size() - 2, 2, ".c") != 0) {
+      continue;
+    }
+    Packed p;
+    // not in an assert, NDEBUG would skip the read
+    if (!read_asset_source(dir + "/" + name, p.src)) {
+      fprintf(stderr, "%s/%s: not an lvgl image source\n", dir.c_str(), name.c_str());
+      closedir(d);
+      return 1;
+    }
+    p.data = asset_encode(p.src.bgra.data(), p.src.w, p.src.h);
+    check(p);
+    raw += p.src.bgra.size();
+    packed += p.data.size();
+    assets.push_back(std::move(p));
+  }
+  closedir(d);
+  if (assets.empty()) {
+    fprintf(stderr, "%s: no icons\n", dir.c_str());
+    return 1;
+  }
+
+  printf("%s: %zu icons, %zu bytes raw, %zu bytes packed\n", dir.c_str(), assets.size(), raw, packed);
+  // cold caches first, the numbers that matter on a panel's first show
+  run(assets, AssetPixels::BGRA8888, "32 bit, cold");
+  run(assets, AssetPixels::BGRA8888, "32 bit");
+  run(assets, AssetPixels::RGB565A8, "16 bit");
+  return 0;
+}
@@ -0,0 +1,165 @@
+// bench_console_log.cpp
+// console appends the way the textarea took them, the whole text scanned
+// for newlines and cut back to the cap on every line, against ConsoleLog
+// plus the layout ConsoleView does after each: the lines in a 400 px
+// viewport found and walked. heights come from a monospace wrap model
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "console_log.h"
+
+namespace {
+  const int LINE_H = 17;
+  const int COLS = 64;
+  const int VIEW_H = 400;
+  const int APPENDS = 20000;
+
+  int32_t wrap_height(const std::string &text) {
+    int rows = 1;
+    int col = 0;
+    for (char c : text) {
+      if (c == '\n' || ++col > COLS) {
+        rows++;
+        col = c == '\n' ? 0 : 1;
+      }
+    }
+    return rows * LINE_H;
+  }
+
+  // as ta_add_text_limit_lines did it, minus the textarea's own re-wrap
+  void textarea_append(std::string &text, const std::string &line, int cap) {
+    text += line;
+    text += "\n";
+
+    int line_count = 0;
+    const char *full = text.c_str();
+    const char *p = full;
+    while (*p) {
+      if (*p == '\n') {
+        line_count++;
+      }
+      p++;
+    }
+
+    if (line_count > cap) {
+      int drop = line_count - cap;
+      const char *keep = full;
+      while (drop > 0 && *keep) {
+        if (*keep == '\n') drop--;
+        keep++;
+      }
+      std::string trimmed(keep, strlen(keep));
+      text = trimmed;
+    }
+  }
+
+  size_t visible(const ConsoleLog &log, int64_t top) {
+    size_t n = 0;
+    for (size_t i = log.find(top); i < log.size() && log.offset(i) < top + VIEW_H; i++) {
+      n++;
+    }
+    return n;
+  }
+
+  std::vector<std::string> responses() {
+    const char *samples[] = {
+      "// probe at 110.000,110.000 is z=1.987500",
+      "echo: START_PRINT BED_TEMP=60 EXTRUDER_TEMP=210 CHAMBER_TEMP=0 MATERIAL=PLA NOZZLE=0.4 SKEW_PROFILE=default",
+      "// Klipper state: Ready",
+      "ok",
+      "// bed_mesh: generated points\n// Index | Tool Adjusted | Probe\n// 0 | (11.0, 11.0) | (36.0, 11.0)",
+      "!! Move out of range: 235.000 10.000 0.600 [12.345]",
+    };
+    std::vector<std::string> out;
+    for (int i = 0; i < APPENDS; i++) {
+      out.push_back(samples[i % 6]);
+    }
+    return out;
+  }
+
+  double us_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main() {
+  auto lines = responses();
+
+  // offsets agree with a running sum, find lands on the covering line
+  {
+    ConsoleLog log(50);
+    for (int i = 0; i < 180; i++) {
+      log.push(lines[i], wrap_height(lines[i]));
+    }
+    assert(log.size() == 50);
+    int64_t y = 0;
+    for (size_t i = 0; i < log.size(); i++) {
+      assert(log.offset(i) == y);
+      assert(log.find(y) == i && log.find(y + log.at(i).height - 1) == i);
+      y += log.at(i).height;
+    }
+    assert(log.height() == y && log.find(y) == log.size());
+    log.measure([](const std::string &) { return LINE_H; });
+    assert(log.height() == 50 * LINE_H && log.find(LINE_H * 7 + 3) == 7);
+  }
+
+  printf("%d appends, a %d px viewport\n", APPENDS, VIEW_H);
+  printf("%-28s %12s %12s\n", "", "us/append", "last 1000");
+
+  const int caps[] = {100, 2000, 5000};
+  for (int cap : caps) {
+    std::string text;
+    auto start = std::chrono::steady_clock::now();
+    auto tail = start;
+    for (int i = 0; i < APPENDS; i++) {
+      if (i == APPENDS - 1000) {
+        tail = std::chrono::steady_clock::now();
+      }
+      textarea_append(text, lines[i], cap);
+    }
+    double all = us_since(start) / APPENDS;
+    double last = us_since(tail) / 1000;
+    char name[64];
+    snprintf(name, sizeof(name), "textarea, %d lines", cap);
+    printf("%-28s %12.3f %12.3f\n", name, all, last);
+  }
+
+  for (int cap : caps) {
+    ConsoleLog log(cap);
+    size_t shown = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto tail = start;
+    for (int i = 0; i < APPENDS; i++) {
+      if (i == APPENDS - 1000) {
+        tail = std::chrono::steady_clock::now();
+      }
+      log.push(lines[i], wrap_height(lines[i]));
+      shown += visible(log, std::max<int64_t>(log.height() - VIEW_H, 0));
+    }
+    double all = us_since(start) / APPENDS;
+    double last = us_since(tail) / 1000;
+    char name[64];
+    snprintf(name, sizeof(name), "ring and view, %d lines", cap);
+    printf("%-28s %12.3f %12.3f  (%.1f lines in view)\n", name, all, last,
+           static_cast<double>(shown) / APPENDS);
+  }
+
+  // scrolling back through a full log
+  ConsoleLog log(5000);
+  for (int i = 0; i < APPENDS; i++) {
+    log.push(lines[i], wrap_height(lines[i]));
+  }
+  size_t shown = 0;
+  int steps = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int64_t y = log.height() - VIEW_H; y >= 0; y -= 7, steps++) {
+    shown += visible(log, y);
+  }
+  printf("scroll over 5000 lines        %12.3f us/step, %.1f lines in view\n",
+         us_since(start) / steps, static_cast<double>(shown) / steps);
+  return 0;
+}
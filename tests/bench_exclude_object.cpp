@@ -0,0 +1,179 @@
+// bench_exclude_object.cpp
+// a synthetic 500 object plate on the exclude object canvas: touches
+// resolved by a linear point in polygon scan against ObjectMap's grid and
+// masks, and the objects a state change redraws, all of them before
+// against those ObjectMap finds under the changed one
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "object_map.h"
+
+namespace {
+  const int16_t CANVAS = 400;
+  const int16_t DRAW_PAD = 16;
+  const size_t OBJECTS = 500;
+  const int TOUCHES = 200000;
+
+  typedef ObjectMap::Point Point;
+
+  // as ExcludeObjectPanel did it
+  bool point_in_polygon(int16_t x, int16_t y, const std::vector<Point> &poly) {
+    if (poly.size() < 3) {
+      return false;
+    }
+
+    bool inside = false;
+    size_t j = poly.size() - 1;
+    for (size_t i = 0; i < poly.size(); j = i++) {
+      const Point &pi = poly[i];
+      const Point &pj = poly[j];
+      if ((pi.y > y) != (pj.y > y)) {
+        double x_intersect = static_cast<double>(pj.x - pi.x)
+          * static_cast<double>(y - pi.y)
+          / static_cast<double>(pj.y - pi.y)
+          + static_cast<double>(pi.x);
+        if (static_cast<double>(x) < x_intersect) {
+          inside = !inside;
+        }
+      }
+    }
+    return inside;
+  }
+
+  int linear_hit(const ObjectMap &map, int16_t x, int16_t y, const std::vector<bool> &excluded) {
+    int hit = -1;
+    long best_area = 0;
+    for (size_t i = 0; i < map.size(); i++) {
+      const ObjectMap::Object &o = map.get(i);
+      if (excluded[i] || !point_in_polygon(x, y, o.polygon)) {
+        continue;
+      }
+      long area = static_cast<long>(std::max<int16_t>(o.box.x1 - o.box.x0, 1))
+        * static_cast<long>(std::max<int16_t>(o.box.y1 - o.box.y0, 1));
+      if (hit < 0 || area < best_area) {
+        hit = i;
+        best_area = area;
+      }
+    }
+    return hit;
+  }
+
+  // a 25 x 20 plate of small parts, rounded or L shaped, slightly jittered
+  std::vector<std::vector<Point>> plate(std::mt19937 &rng) {
+    std::uniform_real_distribution<double> jitter(-2.0, 2.0);
+    std::vector<std::vector<Point>> polygons;
+    const int cols = 25;
+    const double pitch = (CANVAS - 24) / static_cast<double>(cols);
+    for (size_t n = 0; n < OBJECTS; n++) {
+      double cx = 12 + pitch * (n % cols + 0.5) + jitter(rng);
+      double cy = 12 + pitch * (n / cols + 0.5) + jitter(rng);
+      double r = pitch * 0.45;
+      std::vector<Point> poly;
+      if (n % 3 == 0) {
+        const double l[6][2] = {{-1, -1}, {1, -1}, {1, 0}, {0, 0}, {0, 1}, {-1, 1}};
+        for (auto &p : l) {
+          poly.push_back({static_cast<int16_t>(std::lround(cx + p[0] * r)),
+                          static_cast<int16_t>(std::lround(cy + p[1] * r))});
+        }
+      } else {
+        for (int k = 0; k < 24; k++) {
+          double a = k * 2 * M_PI / 24;
+          poly.push_back({static_cast<int16_t>(std::lround(cx + std::cos(a) * r)),
+                          static_cast<int16_t>(std::lround(cy + std::sin(a) * r))});
+        }
+      }
+      polygons.push_back(std::move(poly));
+    }
+    return polygons;
+  }
+
+  double us_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main() {
+  std::mt19937 rng(42);
+  auto polygons = plate(rng);
+
+  ObjectMap map;
+  auto start = std::chrono::steady_clock::now();
+  map.build(polygons, CANVAS, CANVAS);
+  double build_us = us_since(start);
+  assert(map.size() == OBJECTS);
+
+  std::vector<bool> excluded(OBJECTS);
+  for (size_t i = 0; i < OBJECTS; i += 7) {
+    excluded[i] = true;
+  }
+  auto accept = [&excluded](size_t i) { return !excluded[i]; };
+
+  std::uniform_int_distribution<int> coord(0, CANVAS - 1);
+  std::vector<Point> touches(TOUCHES);
+  for (auto &t : touches) {
+    t = {static_cast<int16_t>(coord(rng)), static_cast<int16_t>(coord(rng))};
+  }
+
+  // same object for every touch
+  size_t hits = 0;
+  for (auto &t : touches) {
+    int a = linear_hit(map, t.x, t.y, excluded);
+    assert(a == map.hit(t.x, t.y, accept));
+    hits += a >= 0;
+  }
+
+  // best of a few rounds, interleaved
+  double linear = 1e9;
+  double indexed = 1e9;
+  volatile int sink = 0;
+  for (int round = 0; round < 5; round++) {
+    start = std::chrono::steady_clock::now();
+    for (auto &t : touches) {
+      sink += linear_hit(map, t.x, t.y, excluded);
+    }
+    linear = std::min(linear, us_since(start) / TOUCHES);
+
+    start = std::chrono::steady_clock::now();
+    for (auto &t : touches) {
+      sink += map.hit(t.x, t.y, accept);
+    }
+    indexed = std::min(indexed, us_since(start) / TOUCHES);
+  }
+
+  // a status update moving current_object, or excluding one
+  size_t drawn = 0;
+  size_t most = 0;
+  std::vector<size_t> under;
+  for (size_t i = 0; i < OBJECTS; i++) {
+    const ObjectMap::Box &b = map.get(i).box;
+    map.query({static_cast<int16_t>(b.x0 - 2 * DRAW_PAD), static_cast<int16_t>(b.y0 - 2 * DRAW_PAD),
+               static_cast<int16_t>(b.x1 + 2 * DRAW_PAD), static_cast<int16_t>(b.y1 + 2 * DRAW_PAD)}, under);
+    assert(std::find(under.begin(), under.end(), i) != under.end());
+    drawn += under.size();
+    most = std::max(most, under.size());
+  }
+
+  // a part hanging off the canvas is masked only where it is on it, one
+  // wholly off it has nothing to mask
+  {
+    ObjectMap edge;
+    edge.build({{{-30000, -30000}, {50, -30000}, {50, 50}, {-30000, 50}},
+                {{500, 500}, {600, 500}, {600, 600}}}, CANVAS, CANVAS);
+    const ObjectMap::Object &on = edge.get(0);
+    assert(on.box.x0 == 0 && on.box.y0 == 0 && on.box.x1 == 50 && on.box.y1 == 50);
+    assert(on.mask.size() == (51 * 51 + 7) / 8);
+    assert(edge.hit(10, 10, [](size_t) { return true; }) == 0);
+    assert(edge.get(1).box.x1 < edge.get(1).box.x0 && edge.get(1).mask.empty());
+  }
+
+  printf("%zu objects on a %dx%d canvas, built in %.1f us\n", OBJECTS, CANVAS, CANVAS, build_us);
+  printf("touch, linear scan   %7.3f us\n", linear);
+  printf("touch, grid and mask %7.3f us  (%zu of %d touches hit)\n", indexed, hits, TOUCHES);
+  printf("objects drawn per state change: full redraw %zu, incremental %.1f avg %zu max\n",
+         OBJECTS, static_cast<double>(drawn) / OBJECTS, most);
+  return 0;
+}
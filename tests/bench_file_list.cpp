@@ -0,0 +1,227 @@
+// bench_file_list.cpp
+// a 10000 file folder in the print panel's list. the lv_table it replaced
+// is modelled on the host: it keeps a malloc'd cell per row and a height
+// per row, grows a row at a time as cells are set past its end,
+// re-measuring every row each time it does, and a frame walks the rows
+// from the top to find those in view. text is measured with a fixed glyph
+// width table. the list is the real VirtualList on the LVGL stub, fed
+// the rows' text back to back with an offset each, as PrintPanel does. a
+// scroll step is the work before drawing, finding and binding the rows in
+// view; neither draws
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "lvgl/lvgl.h"
+#include "virtual_list.h"
+
+namespace {
+  const size_t FILES = 10000;
+  const int ROW_H = 44;
+  const int VIEW_H = 420;
+  const int WIDTH = 380;
+  const int SCROLL_STEP = 24;
+  const char *SYMBOL = "\xEF\x85\x9B";
+
+  uint8_t glyph_w[256];
+
+  // rows the text wraps to
+  int measure(const char *s) {
+    int w = 0;
+    int rows = 1;
+    for (; *s; s++) {
+      w += glyph_w[static_cast<uint8_t>(*s)];
+      if (w > WIDTH) {
+        rows++;
+        w = 0;
+      }
+    }
+    return rows;
+  }
+
+  volatile size_t in_view;
+
+  // malloc's chunk for a request
+  size_t chunk(size_t n) {
+    return (n + 8 + 15) & ~static_cast<size_t>(15);
+  }
+
+  std::vector<std::string> names() {
+    const char *stems[] = {"Benchy", "Voron_Cube", "Calibration_Tower", "Bracket", "Gear", "Hinge",
+                           "Spool_Holder", "Clip", "Enclosure_Panel", "Fan_Duct"};
+    std::vector<std::string> out;
+    for (size_t i = 0; i < FILES; i++) {
+      char buf[96];
+      snprintf(buf, sizeof(buf), "%s_%zu_PLA_0.2mm_%dm.gcode", stems[i % 10], i, static_cast<int>(30 + i % 400));
+      out.push_back(buf);
+    }
+    return out;
+  }
+
+  struct Table {
+    std::vector<char *> cells;
+    std::vector<int32_t> row_h;
+    size_t bytes = 0;
+
+    ~Table() {
+      for (char *c : cells) {
+        free(c);
+      }
+    }
+
+    void set_row_cnt(size_t n) {
+      for (size_t i = n; i < cells.size(); i++) {
+        free(cells[i]);
+      }
+      cells.resize(n, NULL);
+      row_h.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        row_h[i] = cells[i] ? measure(cells[i]) * ROW_H : ROW_H;
+      }
+    }
+
+    void set_cell(size_t row, const std::string &name) {
+      if (row >= cells.size()) {
+        set_row_cnt(row + 1);
+      }
+      char buf[128];
+      int n = snprintf(buf, sizeof(buf), "%s  %s", SYMBOL, name.c_str());
+      // a leading format byte
+      cells[row] = static_cast<char *>(realloc(cells[row], n + 2));
+      memcpy(cells[row], buf, n + 1);
+      row_h[row] = measure(cells[row]) * ROW_H;
+    }
+
+    void frame(int scroll_y) {
+      int y = 0;
+      for (size_t r = 0; r < cells.size(); r++) {
+        int h = row_h[r];
+        if (y + h <= scroll_y) {
+          y += h;
+          continue;
+        }
+        if (y >= scroll_y + VIEW_H) {
+          break;
+        }
+        in_view += r;
+        y += h;
+      }
+    }
+
+    size_t memory() const {
+      size_t m = cells.capacity() * sizeof(char *) + row_h.capacity() * sizeof(int32_t);
+      for (char *c : cells) {
+        m += chunk(strlen(c) + 2);
+      }
+      return m;
+    }
+  };
+
+  struct List {
+    std::string text;
+    std::vector<uint32_t> offsets;
+    VirtualList list;
+    lv_obj_t *cont;
+
+    List()
+      : list(lv_stub_screen(),
+             [this](size_t row) { return text.c_str() + offsets[row]; },
+             [](size_t) {},
+             [](size_t) { return "42m"; })
+      , cont(list.get_container())
+    {
+      lv_obj_set_size(cont, WIDTH, VIEW_H);
+    }
+
+    void set_rows(const std::vector<std::string> &names) {
+      text.clear();
+      offsets.clear();
+      for (auto &n : names) {
+        offsets.push_back(text.size());
+        text.append(SYMBOL);
+        text.append("  ");
+        text.append(n);
+        text.push_back('\0');
+      }
+      list.set_count(names.size());
+    }
+
+    void frame(int scroll_y) {
+      lv_obj_scroll_to_y(cont, scroll_y, LV_ANIM_OFF);
+    }
+
+    // the spacer, then the row objects
+    lv_coord_t height() const {
+      return lv_obj_get_height(lv_obj_get_child(cont, 0));
+    }
+
+    size_t rows() const {
+      return lv_obj_get_child_cnt(cont) - 1;
+    }
+
+    size_t memory() const {
+      return text.capacity() + offsets.capacity() * sizeof(uint32_t);
+    }
+  };
+
+  double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // steps over the whole list, us per step
+  template<typename T> double scroll(T &view, int height) {
+    int steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int y = 0; y + VIEW_H <= height; y += SCROLL_STEP, steps++) {
+      view.frame(y);
+    }
+    return ms_since(start) * 1000 / steps;
+  }
+}
+
+int main() {
+  for (int c = 0; c < 256; c++) {
+    glyph_w[c] = c < 0x80 ? 7 + c % 5 : 4;
+  }
+  auto files = names();
+
+  auto start = std::chrono::steady_clock::now();
+  Table table;
+  for (size_t i = 0; i < files.size(); i++) {
+    table.set_cell(i, files[i]);
+  }
+  table.set_row_cnt(files.size());
+  table.frame(0);
+  double table_open = ms_since(start);
+
+  start = std::chrono::steady_clock::now();
+  List list;
+  list.set_rows(files);
+  list.frame(0);
+  double list_open = ms_since(start);
+
+  int height = 0;
+  for (auto h : table.row_h) {
+    height += h;
+  }
+  double table_us = scroll(table, height);
+  double list_us = scroll(list, list.height());
+
+  // picking the selected row again leaves it selected
+  lv_obj_scroll_to_y(list.cont, 0, LV_ANIM_OFF);
+  list.list.set_selected(3);
+  list.list.set_selected(3);
+  assert(lv_obj_has_state(lv_obj_get_child(list.cont, 1 + 3), LV_STATE_CHECKED));
+
+  printf("%zu files in a %d px view\n", FILES, VIEW_H);
+  printf("%-14s %12s %16s %12s\n", "", "open ms", "scroll us/step", "model KiB");
+  printf("%-14s %12.1f %16.2f %12.1f\n", "lv_table", table_open, table_us, table.memory() / 1024.0);
+  printf("%-14s %12.3f %16.2f %12.1f\n", "virtual list", list_open, list_us, list.memory() / 1024.0);
+  printf("live rows: table %zu cells, list %zu objects\n", table.cells.size(), list.rows());
+  return 0;
+}
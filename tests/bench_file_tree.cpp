@@ -0,0 +1,240 @@
+// bench_file_tree.cpp
+// one upload into a 20000 file library, 200 folders of 100 files. the
+// old panel answered every notify_filelist_changed with server.files.list,
+// parsed the whole listing, rebuilt a tree of std::map nodes from the
+// paths and sorted a copy of the folder shown. the file tree applies the
+// notify item to the one folder it names and lists that folder from its
+// modified index. both must list the folder the same way
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include "file_tree.h"
+
+namespace {
+  const size_t FOLDERS = 200;
+  const size_t PER_FOLDER = 100;
+  const int UPLOADS = 20;
+
+  // the tree the panel used to keep
+  struct Tree {
+    Tree(const std::string &filename, const std::string &path, uint32_t modified)
+      : name(filename)
+      , full_path(path)
+      , date_modified(modified)
+      , parent(this) {
+    }
+
+    bool is_leaf() const { return children.empty(); }
+
+    Tree &find_or_create(const std::string &value, const std::string &path, uint32_t modified) {
+      if (modified > date_modified) {
+        date_modified = modified;
+      }
+      const auto &entry = children.find(value);
+      if (entry != children.cend()) {
+        return entry->second;
+      }
+      children.insert({value, Tree(value, path, modified)});
+      Tree &child = children.find(value)->second;
+      child.parent = this;
+      return child;
+    }
+
+    void add_path(const std::vector<std::string> &paths, uint32_t modified) {
+      Tree *cur_node = this;
+      std::string cur_path;
+      for (const auto &p : paths) {
+        cur_path = cur_path.empty() ? p : cur_path + "/" + p;
+        cur_node = &cur_node->find_or_create(p, cur_path, modified);
+      }
+    }
+
+    Tree *find_path(const std::vector<std::string> &paths) {
+      Tree *cur_node = this;
+      for (const auto &p : paths) {
+        auto entry = cur_node->children.find(p);
+        if (entry == cur_node->children.end()) {
+          return this;
+        }
+        cur_node = &entry->second;
+      }
+      return cur_node;
+    }
+
+    std::string name;
+    std::string full_path;
+    uint32_t date_modified;
+    json metadata;
+    Tree *parent;
+    std::map<std::string, Tree> children;
+  };
+
+  std::vector<std::string> split(const std::string &s, char delim) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    for (size_t i = 0; i <= s.size(); i++) {
+      if (i == s.size() || s[i] == delim) {
+        out.push_back(s.substr(start, i - start));
+        start = i + 1;
+      }
+    }
+    return out;
+  }
+
+  std::string folder(size_t f) {
+    return "project_" + std::to_string(f);
+  }
+
+  std::string file(size_t f, size_t i) {
+    return "part_" + std::to_string(f) + "_" + std::to_string(i) + "_PLA_0.2mm.gcode";
+  }
+
+  // what server.files.list sends, serialized as it arrives
+  std::string list_response(const std::vector<std::string> &uploaded) {
+    json files = json::array();
+    for (size_t f = 0; f < FOLDERS; f++) {
+      for (size_t i = 0; i < PER_FOLDER; i++) {
+        files.push_back({{"path", folder(f) + "/" + file(f, i)}, {"modified", 1700000000.0 + f * PER_FOLDER + i},
+                         {"size", 1048576}, {"permissions", "rw"}});
+      }
+    }
+    for (size_t u = 0; u < uploaded.size(); u++) {
+      files.push_back({{"path", uploaded[u]}, {"modified", 1800000000.0 + u}, {"size", 1048576}, {"permissions", "rw"}});
+    }
+    return json({{"result", files}}).dump();
+  }
+
+  std::string directory_response(const std::string &dir) {
+    json result = {{"dirs", json::array()}, {"files", json::array()}};
+    if (dir.empty()) {
+      for (size_t f = 0; f < FOLDERS; f++) {
+        result["dirs"].push_back({{"dirname", folder(f)}, {"modified", 1700000000.0 + f}, {"size", 4096}});
+      }
+    } else {
+      size_t f = std::stoul(dir.substr(dir.find('_') + 1));
+      for (size_t i = 0; i < PER_FOLDER; i++) {
+        result["files"].push_back({{"filename", file(f, i)}, {"modified", 1700000000.0 + f * PER_FOLDER + i},
+                                   {"size", 1048576}, {"permissions", "rw"}});
+      }
+    }
+    return json({{"result", result}}).dump();
+  }
+
+  std::vector<std::string> old_listing(Tree &root, const std::string &dir) {
+    Tree *d = root.find_path(split(dir, '/'));
+    std::vector<Tree *> sorted;
+    for (auto &c : d->children) {
+      sorted.push_back(&c.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](Tree *x, Tree *y) {
+      if (x->is_leaf() != y->is_leaf()) {
+        return y->is_leaf();
+      }
+      return x->date_modified > y->date_modified;
+    });
+    std::vector<std::string> out;
+    for (Tree *t : sorted) {
+      out.push_back(t->name);
+    }
+    return out;
+  }
+
+  std::vector<std::string> new_listing(const FileTree &tree, const std::string &dir) {
+    std::vector<std::string> out;
+    const FileTree::Node &d = tree.get(tree.find(dir));
+    for (FileTree::Id c : d.by_modified) {
+      if (tree.get(c).dir) {
+        out.push_back(tree.name(c));
+      }
+    }
+    for (FileTree::Id c : d.by_modified) {
+      if (!tree.get(c).dir) {
+        out.push_back(tree.name(c));
+      }
+    }
+    return out;
+  }
+
+  double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main() {
+  const std::string shown = folder(42);
+
+  // opening the panel
+  std::string listed = list_response({});
+  auto start = std::chrono::steady_clock::now();
+  Tree root("", "", 0);
+  json all = json::parse(listed);
+  for (auto &f : all["result"]) {
+    root.add_path(split(f["path"], '/'), f["modified"].get<uint32_t>());
+  }
+  old_listing(root, shown);
+  double old_open = ms_since(start);
+
+  std::string top = directory_response("");
+  std::string inside = directory_response(shown);
+  start = std::chrono::steady_clock::now();
+  FileTree tree;
+  tree.fill(FileTree::ROOT, json::parse(top)["result"]);
+  tree.fill(tree.find(shown), json::parse(inside)["result"]);
+  new_listing(tree, shown);
+  double new_open = ms_since(start);
+
+  std::vector<std::string> uploaded;
+  double old_upload = 0;
+  double new_upload = 0;
+  for (int u = 0; u < UPLOADS; u++) {
+    uploaded.push_back(shown + "/upload_" + std::to_string(u) + ".gcode");
+    json item = {{"root", "gcodes"}, {"path", uploaded.back()}, {"modified", 1800000000.0 + u}, {"size", 1048576}};
+    std::string notify = json({{"method", "notify_filelist_changed"},
+                               {"params", {{{"action", "create_file"}, {"item", item}}}}}).dump();
+
+    listed = list_response(uploaded);
+
+    start = std::chrono::steady_clock::now();
+    json n = json::parse(notify);
+    root = Tree("", "", 0);
+    all = json::parse(listed);
+    for (auto &f : all["result"]) {
+      root.add_path(split(f["path"], '/'), f["modified"].get<uint32_t>());
+    }
+    std::vector<std::string> old_rows = old_listing(root, shown);
+    old_upload += ms_since(start);
+
+    start = std::chrono::steady_clock::now();
+    json m = json::parse(notify);
+    FileTree::Change change = tree.apply(m["/params/0/action"_json_pointer].get<std::string>(),
+                                         m["/params/0/item"_json_pointer], json::object());
+    std::vector<std::string> new_rows = new_listing(tree, shown);
+    new_upload += ms_since(start);
+
+    assert(change.dir == tree.find(shown));
+    assert(old_rows == new_rows);
+    assert(new_rows.front() == "upload_" + std::to_string(u) + ".gcode");
+  }
+
+  // a move out and a delete touch only their folders
+  json moved = {{"root", "gcodes"}, {"path", folder(7) + "/upload_0.gcode"}, {"modified", 1900000000.0}};
+  json from = {{"root", "gcodes"}, {"path", uploaded[0]}};
+  FileTree::Change change = tree.apply("move_file", moved, from);
+  assert(change.from == tree.find(shown) && change.dir == FileTree::NONE);
+  assert(tree.find(uploaded[0]) == FileTree::NONE);
+  change = tree.apply("delete_file", {{"root", "gcodes"}, {"path", uploaded[1]}}, json::object());
+  assert(change.dir == tree.find(shown));
+  assert(new_listing(tree, shown).size() == PER_FOLDER + UPLOADS - 2);
+  (void)change;
+
+  printf("%zu files in %zu folders, %d uploads into one\n", FOLDERS * PER_FOLDER, FOLDERS, UPLOADS);
+  printf("%-12s %14s %16s\n", "", "open ms", "per upload ms");
+  printf("%-12s %14.2f %16.2f\n", "full list", old_open, old_upload / UPLOADS);
+  printf("%-12s %14.2f %16.4f\n", "file tree", new_open, new_upload / UPLOADS);
+  printf("file tree nodes: %zu\n", tree.size());
+  return 0;
+}
@@ -0,0 +1,192 @@
+// bench_gcode_trie.cpp
+// 2000 macro style commands, each typed a keystroke at a time with a
+// backspace now and then. GcodeCompleter keeps the trie cursor as the
+// text changes, against a scan of every name for the prefix and a sort
+// of the matches. both rank the same way and must agree; the completer
+// must not allocate once warm
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "gcode_trie.h"
+
+namespace {
+  size_t allocations = 0;
+}
+
+void *operator new(size_t n) {
+  allocations++;
+  void *p = malloc(n);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+namespace {
+  const size_t COMMANDS = 2000;
+
+  std::vector<std::string> commands(std::mt19937 &rng) {
+    const char *heads[] = {"_CLIENT_", "SET_", "BED_MESH_", "PROBE_", "M", "G", "_KAMP_", "TEST_",
+                           "START_", "END_", "LOAD_", "UNLOAD_", "SAVE_", "QUERY_", "_GUPPY_", "CALIBRATE_"};
+    const char *words[] = {"FILAMENT", "NOZZLE", "HEATER", "FAN", "SPEED", "TEMPERATURE", "PRINT",
+                           "LINE", "PURGE", "PARK", "HOME", "CONFIG", "OFFSET", "ACCEL", "LED", "CHAMBER",
+                           "Z", "XY", "MESH", "WIPE", "PRESSURE_ADVANCE", "INPUT_SHAPER", "CAMERA"};
+    std::uniform_int_distribution<int> head(0, 15);
+    std::uniform_int_distribution<int> word(0, 22);
+    std::uniform_int_distribution<int> parts(1, 3);
+    std::uniform_int_distribution<int> code(0, 999);
+
+    std::vector<std::string> out;
+    while (out.size() < COMMANDS) {
+      std::string h = heads[head(rng)];
+      std::string name = h;
+      if (h == "M" || h == "G") {
+        name += std::to_string(code(rng));
+      } else {
+        int n = parts(rng);
+        for (int i = 0; i < n; i++) {
+          name += (i ? "_" : "") + std::string(words[word(rng)]);
+        }
+      }
+      if (std::find(out.begin(), out.end(), name) == out.end()) {
+        out.push_back(name);
+      }
+    }
+    return out;
+  }
+
+  // every name checked for the prefix, the matches sorted
+  size_t scan(const GcodeTrie &trie, const std::vector<uint32_t> &weights, const std::string &prefix,
+              std::vector<uint32_t> &out) {
+    out.clear();
+    for (uint32_t i = 0; i < trie.size(); i++) {
+      if (trie.name(i).compare(0, prefix.size(), prefix) == 0) {
+        out.push_back(i);
+      }
+    }
+    size_t keep = std::min(out.size(), GcodeTrie::MAX_COMPLETIONS);
+    std::partial_sort(out.begin(), out.begin() + keep, out.end(), [&](uint32_t a, uint32_t b) {
+      if (weights[a] != weights[b]) return weights[a] > weights[b];
+      if (trie.name(a).size() != trie.name(b).size()) return trie.name(a).size() < trie.name(b).size();
+      return a < b;
+    });
+    out.resize(keep);
+    return keep;
+  }
+
+  // the text after each keystroke, one in six a backspace
+  std::vector<std::string> typing(const std::vector<std::string> &names, std::mt19937 &rng) {
+    std::uniform_int_distribution<int> dice(0, 5);
+    std::vector<std::string> steps;
+    for (auto &name : names) {
+      std::string text;
+      for (size_t i = 0; i < name.size(); i++) {
+        if (i > 1 && dice(rng) == 0) {
+          text.push_back('x');
+          steps.push_back(text);
+          text.pop_back();
+          steps.push_back(text);
+        }
+        text.push_back(std::tolower(name[i]));
+        steps.push_back(text);
+      }
+      steps.push_back(text + " ");
+      steps.push_back("");
+    }
+    return steps;
+  }
+
+  std::string upper(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+    return s;
+  }
+
+  double us_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main() {
+  std::mt19937 rng(7);
+  auto names = commands(rng);
+
+  GcodeTrie trie;
+  auto start = std::chrono::steady_clock::now();
+  trie.build(names);
+  double build_us = us_since(start);
+  assert(trie.size() == COMMANDS);
+
+  // a few used lately
+  std::vector<uint32_t> weights(trie.size());
+  std::uniform_int_distribution<uint32_t> pick(0, trie.size() - 1);
+  for (int i = 0; i < 50; i++) {
+    weights[pick(rng)] += 50 - i;
+  }
+  start = std::chrono::steady_clock::now();
+  trie.rank(weights);
+  double rank_us = us_since(start);
+
+  for (size_t i = 0; i < trie.size(); i++) {
+    assert(trie.find(trie.name(i)) == static_cast<int>(i));
+  }
+
+  std::shuffle(names.begin(), names.end(), rng);
+  auto steps = typing(names, rng);
+
+  // same completions, word by word
+  GcodeCompleter completer(trie);
+  std::vector<uint32_t> expect;
+  for (auto &text : steps) {
+    completer.update(text.c_str());
+    std::string word = upper(text.substr(0, text.find(' ')));
+    size_t n = 0;
+    const uint32_t *got = completer.completions(n);
+    size_t m = scan(trie, weights, word, expect);
+    assert(n == m && std::equal(expect.begin(), expect.end(), got));
+  }
+
+  volatile size_t sink = 0;
+  double trie_us = 1e9;
+  double scan_us = 1e9;
+  size_t trie_allocs = 0;
+  for (int round = 0; round < 5; round++) {
+    completer.reset();
+    size_t before = allocations;
+    start = std::chrono::steady_clock::now();
+    for (auto &text : steps) {
+      completer.update(text.c_str());
+      size_t n = 0;
+      const uint32_t *got = completer.completions(n);
+      sink += n ? got[0] : 0;
+    }
+    trie_us = std::min(trie_us, us_since(start) / steps.size());
+    trie_allocs = allocations - before;
+
+    start = std::chrono::steady_clock::now();
+    for (auto &text : steps) {
+      std::string word = upper(text.substr(0, text.find(' ')));
+      sink += scan(trie, weights, word, expect);
+    }
+    scan_us = std::min(scan_us, us_since(start) / steps.size());
+  }
+
+  printf("%zu commands, built in %.0f us, ranked in %.0f us\n", trie.size(), build_us, rank_us);
+  printf("%zu keystrokes\n", steps.size());
+  printf("keystroke, scan and sort     %8.3f us\n", scan_us);
+  printf("keystroke, trie completer    %8.3f us  (%zu allocations)\n", trie_us, trie_allocs);
+  return 0;
+}
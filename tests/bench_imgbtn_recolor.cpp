@@ -0,0 +1,161 @@
+// bench_imgbtn_recolor.cpp
+// redraw of a panel of twelve disabled 64x64 image buttons, recolored at
+// draw time by an img_recolor style against the baked variants from
+// AssetCache. The draw loop follows LVGL 8.3's software renderer for a
+// TRUE_COLOR_ALPHA image at LV_COLOR_DEPTH 32: split each row into colour
+// and mask, recolor, then blend.
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include "asset_codec.h"
+#include "asset_source.h"
+
+namespace {
+  const uint32_t SCREEN_W = 800;
+  const uint32_t SCREEN_H = 480;
+  const size_t BUTTONS = 12;
+  const int FRAMES = 2000;
+
+  struct Color {
+    uint8_t b, g, r, a;
+  };
+
+  inline uint8_t udiv255(uint32_t x) {
+    return (x * 0x8081U) >> 0x17;
+  }
+
+  inline Color mix(Color c1, Color c2, uint8_t m) {
+    return {udiv255(c1.b * m + c2.b * (255 - m)),
+            udiv255(c1.g * m + c2.g * (255 - m)),
+            udiv255(c1.r * m + c2.r * (255 - m)), 0xff};
+  }
+
+  inline Color mix_premult(const uint16_t *premult, Color c, uint8_t m) {
+    return {udiv255(premult[2] + c.b * m), udiv255(premult[1] + c.g * m),
+            udiv255(premult[0] + c.r * m), 0xff};
+  }
+
+  void draw(std::vector<Color> &fb, const uint8_t *img, uint32_t w, uint32_t h,
+            uint32_t x0, uint32_t y0, const Color *recolor) {
+    std::vector<Color> rgb(w);
+    std::vector<uint8_t> mask(w);
+    // a style value, not a constant the compiler can fold
+    static volatile uint8_t recolor_opa = 255;
+    uint8_t opa = recolor_opa;
+    uint16_t premult[3] = {0, 0, 0};
+    if (recolor != NULL) {
+      premult[0] = recolor->r * opa;
+      premult[1] = recolor->g * opa;
+      premult[2] = recolor->b * opa;
+    }
+
+    for (uint32_t y = 0; y < h; y++) {
+      const uint8_t *row = img + y * w * 4;
+      for (uint32_t x = 0; x < w; x++) {
+        rgb[x] = {row[x * 4], row[x * 4 + 1], row[x * 4 + 2], 0xff};
+        mask[x] = row[x * 4 + 3];
+      }
+      if (recolor != NULL) {
+        for (uint32_t x = 0; x < w; x++) {
+          rgb[x] = mix_premult(premult, rgb[x], 255 - opa);
+        }
+      }
+      Color *dst = fb.data() + (y0 + y) * SCREEN_W + x0;
+      for (uint32_t x = 0; x < w; x++) {
+        if (mask[x] == 0xff) {
+          dst[x] = rgb[x];
+        } else if (mask[x] != 0) {
+          dst[x] = mix(rgb[x], dst[x], mask[x]);
+        }
+      }
+    }
+  }
+
+  double run(std::vector<Color> &fb, const std::vector<std::vector<uint8_t>> &icons,
+             uint32_t w, uint32_t h, const Color *recolor) {
+    std::fill(fb.begin(), fb.end(), Color{0x20, 0x20, 0x20, 0xff});
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < FRAMES; f++) {
+      for (size_t i = 0; i < icons.size(); i++) {
+        draw(fb, icons[i].data(), w, h, 40 + (i % 4) * 180, 40 + (i / 4) * 140, recolor);
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / FRAMES;
+  }
+}
+
+int main(int argc, char **argv) {
+  std::string dir = argc > 1 ? argv[1] : "assets/material";
+  std::vector<std::string> names;
+  DIR *d = opendir(dir.c_str());
+  if (d == NULL) {
+    fprintf(stderr, "%s: can't open\n", dir.c_str());
+    return 1;
+  }
+  while (struct dirent *e = readdir(d)) {
+    std::string name = e->d_name;
+    if (name.size() > 2 && name.compare(name.size() - 2, 2, ".c") == 0) {
+      names.push_back(name);
+    }
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+  if (names.size() < BUTTONS) {
+    fprintf(stderr, "%s: fewer than %zu icons\n", dir.c_str(), BUTTONS);
+    return 1;
+  }
+
+  // the disabled colour, lv_palette_darken(LV_PALETTE_GREY, 1)
+  Color grey = {0x61, 0x61, 0x61, 0xff};
+  const uint8_t grey_rgb[3] = {grey.r, grey.g, grey.b};
+
+  std::vector<std::vector<uint8_t>> plain;
+  std::vector<std::vector<uint8_t>> baked;
+  uint32_t w = 0;
+  uint32_t h = 0;
+  for (size_t i = 0; i < BUTTONS; i++) {
+    AssetSource src;
+    // not in asserts, NDEBUG would skip the reads and decodes
+    if (!read_asset_source(dir + "/" + names[i], src)) {
+      fprintf(stderr, "%s/%s: not an lvgl image source\n", dir.c_str(), names[i].c_str());
+      return 1;
+    }
+    w = src.w;
+    h = src.h;
+    std::vector<uint8_t> packed = asset_encode(src.bgra.data(), w, h);
+    plain.emplace_back(w * h * 4);
+    baked.emplace_back(w * h * 4);
+    if (!asset_decode(packed.data(), packed.size(), w, h, AssetPixels::BGRA8888, plain.back().data())
+        || !asset_decode(packed.data(), packed.size(), w, h, AssetPixels::BGRA8888, baked.back().data(), grey_rgb)) {
+      fprintf(stderr, "%s/%s: doesn't decode\n", dir.c_str(), names[i].c_str());
+      return 1;
+    }
+  }
+
+  std::vector<Color> fb(SCREEN_W * SCREEN_H);
+  std::vector<Color> fb_baked(SCREEN_W * SCREEN_H);
+  // same pixels either way
+  run(fb, plain, w, h, &grey);
+  run(fb_baked, baked, w, h, NULL);
+  for (size_t i = 0; i < fb.size(); i++) {
+    assert(fb[i].r == fb_baked[i].r && fb[i].g == fb_baked[i].g && fb[i].b == fb_baked[i].b);
+  }
+
+  // best of a few rounds, interleaved
+  double recolored = 1e9;
+  double prebaked = 1e9;
+  for (int round = 0; round < 5; round++) {
+    recolored = std::min(recolored, run(fb, plain, w, h, &grey));
+    prebaked = std::min(prebaked, run(fb_baked, baked, w, h, NULL));
+  }
+
+  printf("%zu disabled %ux%u buttons, %d frames\n", BUTTONS, w, h, FRAMES);
+  printf("img_recolor style  %7.1f us per frame\n", recolored);
+  printf("baked variant      %7.1f us per frame\n", prebaked);
+  return 0;
+}
@@ -0,0 +1,96 @@
+// bench_json_parser.cpp
+// heap allocations per notify_status_update frame with json::parse and
+// with JsonParser, which parses into the document the previous frame left,
+// over frames recorded during a print
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+#include "json_parser.h"
+
+static uint64_t allocs = 0;
+static uint64_t alloc_bytes = 0;
+
+void *operator new(size_t n) {
+  allocs++;
+  alloc_bytes += n;
+  void *p = malloc(n == 0 ? 1 : n);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+struct Result {
+  uint64_t allocs;
+  uint64_t bytes;
+  double us;
+};
+
+static Result run(const std::vector<std::string> &frames, JsonParser *parser, json &state) {
+  uint64_t a = allocs;
+  uint64_t b = alloc_bytes;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &f : frames) {
+    if (parser != NULL) {
+      json &j = parser->parse(f.data(), f.size());
+      // what State::consume keeps, copied out on the long lived heap
+      state.merge_patch(j["/params/0"_json_pointer]);
+    } else {
+      json j = json::parse(f);
+      state.merge_patch(j["/params/0"_json_pointer]);
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return {allocs - a, alloc_bytes - b, std::chrono::duration<double, std::micro>(elapsed).count()};
+}
+
+int main(int argc, char **argv) {
+  std::ifstream in(argc > 1 ? argv[1] : "tests/data/status_frames.jsonl");
+  std::vector<std::string> frames;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty()) {
+      frames.push_back(line);
+    }
+  }
+  assert(!frames.empty());
+
+  // same documents as json::parse
+  JsonParser check;
+  for (const auto &f : frames) {
+    assert(check.parse(f.data(), f.size()) == json::parse(f));
+  }
+
+  // warm up so the long lived state has all its keys
+  JsonParser parser;
+  json heap_state;
+  json parser_state;
+  run(frames, NULL, heap_state);
+  run(frames, &parser, parser_state);
+
+  Result heap = run(frames, NULL, heap_state);
+  Result reused = run(frames, &parser, parser_state);
+  assert(heap_state == parser_state);
+
+  double n = frames.size();
+  printf("%zu frames, %lu fell back to json::parse\n", frames.size(),
+         static_cast<unsigned long>(parser.stats().fallbacks));
+  printf("json::parse: %.1f allocs/frame, %.0f bytes/frame, %.1f us/frame\n",
+         heap.allocs / n, heap.bytes / n, heap.us / n);
+  printf("JsonParser:  %.1f allocs/frame, %.0f bytes/frame, %.1f us/frame\n",
+         reused.allocs / n, reused.bytes / n, reused.us / n);
+  return 0;
+}
@@ -0,0 +1,94 @@
+// bench_metadata_cache.cpp
+// 1000 gcode files' server.files.metadata responses, shaped like
+// moonraker's with three thumbnails each. a cached pick replaces a
+// round trip to moonraker with a lookup; this measures the lookup, the
+// summary a list row shows, loading the cache file at startup and what
+// trimming the responses saves on disk
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <experimental/filesystem>
+#include "metadata_cache.h"
+
+namespace fs = std::experimental::filesystem;
+
+namespace {
+  const size_t FILES = 1000;
+  const int ROUNDS = 200;
+
+  std::string name(size_t i) {
+    return "project_" + std::to_string(i % 20) + "/part_" + std::to_string(i) + "_PLA_0.2mm.gcode";
+  }
+
+  json response(size_t i) {
+    json thumbs = json::array();
+    for (int w : {32, 300, 400}) {
+      thumbs.push_back({{"width", w}, {"height", w}, {"size", w * 40},
+                        {"relative_path", ".thumbs/part_" + std::to_string(i) + "-" + std::to_string(w) + "x"
+                                          + std::to_string(w) + ".png"}});
+    }
+    return {{"result", {
+      {"size", 1048576 + i}, {"modified", 1700000000.0 + i}, {"uuid", "2b3c2a86-7a4e-4c5e-9d3f-0c6c2d1a0f3e"},
+      {"slicer", "OrcaSlicer"}, {"slicer_version", "2.1.1"}, {"gcode_start_byte", 18231},
+      {"gcode_end_byte", 1040000}, {"layer_count", 250}, {"object_height", 50.0}, {"estimated_time", 3600 + i},
+      {"nozzle_diameter", 0.4}, {"layer_height", 0.2}, {"first_layer_height", 0.2},
+      {"first_layer_extr_temp", 220.0}, {"first_layer_bed_temp", 60.0}, {"chamber_temp", 0.0},
+      {"filament_name", "Generic PLA"}, {"filament_type", "PLA"}, {"filament_total", 4200.5},
+      {"filament_weight_total", 12.6}, {"print_start_time", nullptr}, {"job_id", nullptr},
+      {"thumbnails", thumbs}, {"filename", name(i)}}}};
+  }
+
+  double us_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main() {
+  std::string path = (fs::temp_directory_path() / "bench_metadata_cache").string();
+  fs::remove(path);
+
+  std::vector<std::string> names;
+  size_t raw = 0;
+  {
+    MetadataCache cache(FILES);
+    cache.load(path);
+    for (size_t i = 0; i < FILES; i++) {
+      names.push_back(name(i));
+      json r = response(i);
+      raw += r.dump().size() + 1;
+      cache.put(names[i], 1700000000.0 + i, 1048576 + i, r);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  MetadataCache cache(FILES);
+  cache.load(path);
+  double load_us = us_since(start);
+
+  size_t found = 0;
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < FILES; i++) {
+      found += cache.get(names[i], 1700000000.0 + i, 1048576 + i) != NULL;
+    }
+  }
+  double get_us = us_since(start) / (ROUNDS * FILES);
+
+  size_t chars = 0;
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < FILES; i++) {
+      chars += strlen(cache.summary(names[i], 1700000000.0 + i, 1048576 + i));
+    }
+  }
+  double summary_us = us_since(start) / (ROUNDS * FILES);
+
+  printf("%zu files, %zu of %zu loaded, %zu hits\n", FILES, cache.size(), FILES, found);
+  printf("load %.1f ms, get %.3f us, row summary %.3f us (\"%s\")\n", load_us / 1000, get_us, summary_us,
+         cache.summary(names[0], 1700000000.0, 1048576));
+  printf("on disk %.1f KiB, untrimmed responses %.1f KiB\n", fs::file_size(path) / 1024.0, raw / 1024.0);
+  fs::remove(path);
+  return chars == 0;
+}
@@ -0,0 +1,109 @@
+// bench_toolhead_marker.cpp
+// the real ToolheadMarker on a 400x400 exclude object map, on the LVGL
+// stub, fed motion_report updates of a toolhead moving over the bed at
+// several speeds. positions arrive faster than frames, lv_timer_handler
+// runs once per frame and the marker applies the latest. the area it
+// invalidates per frame, as the stub counts it, is compared with
+// redrawing the whole map per position
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include "hv/json.hpp"
+#include "lvgl/lvgl.h"
+#include "toolhead_marker.h"
+
+using json = nlohmann::json;
+
+namespace {
+  const int CANVAS = 400;
+  const int MARGIN = 12;
+  const double FRAME_S = 0.030;
+  const double UPDATE_S = 0.004;
+  const double SECONDS = 20.0;
+
+  // the toolhead on a zig zag infill path at speed mm/s
+  void position(double t, double speed, double &x, double &y) {
+    const double line = 180.0;
+    const double pitch = 0.4;
+    double d = t * speed;
+    int row = static_cast<int>(d / line);
+    double along = d - row * line;
+    x = 20 + (row % 2 ? line - along : along);
+    y = 20 + std::fmod(row * pitch, 180.0);
+  }
+
+  struct Result {
+    double us_per_frame;
+    double px_per_frame;
+    int frames;
+    int redraws;
+    int updates;
+  };
+
+  Result run(double speed) {
+    lv_obj_t *map = lv_obj_create(NULL);
+    lv_obj_set_size(map, CANVAS, CANVAS);
+    Result r = {0, 0, 0, 0, 0};
+    {
+      ToolheadMarker marker(map, CANVAS, MARGIN);
+      json update = {
+        {"method", "notify_status_update"},
+        {"params", {{{"motion_report", {{"live_position", {0.0, 0.0, 0.2, 0.0}}}}}, 0.0}}
+      };
+      json &live = update["params"][0]["motion_report"]["live_position"];
+
+      uint64_t pixels = 0;
+      double next_update = 0;
+      double us = 0;
+      for (double t = 0; t < SECONDS; t += FRAME_S) {
+        auto start = std::chrono::steady_clock::now();
+        // everything published since the last frame, the latest wins
+        for (; next_update <= t; next_update += UPDATE_S) {
+          double x, y;
+          position(next_update, speed, x, y);
+          live[0] = x;
+          live[1] = y;
+          marker.consume(update);
+          r.updates++;
+        }
+
+        lv_stub_reset_invalidated();
+        lv_timer_handler();
+        us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t px = lv_stub_invalidated_px();
+        if (px > 0) {
+          // the dot's old area and its new one, never the map
+          assert(px < static_cast<uint64_t>(CANVAS) * CANVAS / 100);
+          pixels += px;
+          r.redraws++;
+        }
+        r.frames++;
+      }
+      r.us_per_frame = us / r.frames;
+      r.px_per_frame = r.redraws ? static_cast<double>(pixels) / r.redraws : 0.0;
+    }
+    lv_obj_del(map);
+    return r;
+  }
+}
+
+int main() {
+  printf("%.0f s of printing, a position every %.0f ms, a frame every %.0f ms\n",
+         SECONDS, UPDATE_S * 1000, FRAME_S * 1000);
+  printf("%9s %8s %8s %8s %14s %12s %12s\n",
+         "speed", "updates", "frames", "redraws", "marker us/frame", "full px", "marker px");
+  const double speeds[] = {1, 10, 50, 150, 300, 600};
+  for (double speed : speeds) {
+    Result best = run(speed);
+    for (int round = 0; round < 4; round++) {
+      best.us_per_frame = std::min(best.us_per_frame, run(speed).us_per_frame);
+    }
+    printf("%5.0f mm/s %8d %8d %8d %14.2f %12d %12.0f\n", speed, best.updates, best.frames,
+           best.redraws, best.us_per_frame, CANVAS * CANVAS, best.px_per_frame);
+  }
+  return 0;
+}
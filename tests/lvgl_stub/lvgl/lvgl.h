@@ -0,0 +1,232 @@
+#ifndef __LVGL_STUB_H__
+#define __LVGL_STUB_H__
+
+// Just enough of LVGL 8.3 for the tests and benches to link the real
+// widgets that sit on top of it, see lvgl_stub.cpp. Objects keep their
+// geometry, flags, states and label text, timers run from
+// lv_timer_handler(), nothing is drawn. Every change that would make LVGL
+// redraw part of the screen adds that area to lv_stub_invalidated_px().
+
+#include <cstdint>
+
+typedef int32_t lv_coord_t;
+typedef uint8_t lv_opa_t;
+typedef uint32_t lv_part_t;
+typedef uint32_t lv_style_selector_t;
+typedef uint16_t lv_state_t;
+typedef uint32_t lv_obj_flag_t;
+
+typedef struct {
+  lv_coord_t x;
+  lv_coord_t y;
+} lv_point_t;
+
+typedef struct {
+  lv_coord_t x1;
+  lv_coord_t y1;
+  lv_coord_t x2;
+  lv_coord_t y2;
+} lv_area_t;
+
+typedef struct {
+  uint16_t full;
+} lv_color_t;
+
+typedef struct {
+  lv_coord_t line_height;
+} lv_font_t;
+
+struct _lv_obj_t;
+typedef struct _lv_obj_t lv_obj_t;
+
+typedef enum {
+  LV_EVENT_ALL = 0,
+  LV_EVENT_PRESSED,
+  LV_EVENT_CLICKED,
+  LV_EVENT_SCROLL,
+  LV_EVENT_SIZE_CHANGED,
+} lv_event_code_t;
+
+typedef struct {
+  lv_obj_t *target;
+  lv_obj_t *current_target;
+  lv_event_code_t code;
+  void *user_data;
+  void *param;
+} lv_event_t;
+
+typedef void (*lv_event_cb_t)(lv_event_t *e);
+
+struct _lv_timer_t;
+typedef struct _lv_timer_t lv_timer_t;
+typedef void (*lv_timer_cb_t)(lv_timer_t *);
+
+struct _lv_timer_t {
+  uint32_t period;
+  lv_timer_cb_t timer_cb;
+  void *user_data;
+};
+
+typedef enum { LV_INDEV_STATE_RELEASED = 0, LV_INDEV_STATE_PRESSED } lv_indev_state_t;
+
+typedef struct {
+  lv_point_t point;
+  lv_indev_state_t state;
+} lv_indev_data_t;
+
+struct _lv_indev_drv_t;
+typedef struct _lv_indev_drv_t lv_indev_drv_t;
+
+struct _lv_indev_drv_t {
+  void (*read_cb)(lv_indev_drv_t *drv, lv_indev_data_t *data);
+};
+
+typedef struct _lv_indev_t {
+  lv_indev_drv_t *driver;
+} lv_indev_t;
+
+typedef enum {
+  LV_PALETTE_RED, LV_PALETTE_PINK, LV_PALETTE_PURPLE, LV_PALETTE_DEEP_PURPLE, LV_PALETTE_INDIGO,
+  LV_PALETTE_BLUE, LV_PALETTE_LIGHT_BLUE, LV_PALETTE_CYAN, LV_PALETTE_TEAL, LV_PALETTE_GREEN,
+  LV_PALETTE_LIGHT_GREEN, LV_PALETTE_LIME, LV_PALETTE_YELLOW, LV_PALETTE_AMBER, LV_PALETTE_ORANGE,
+  LV_PALETTE_DEEP_ORANGE, LV_PALETTE_BROWN, LV_PALETTE_BLUE_GREY, LV_PALETTE_GREY,
+  LV_PALETTE_LAST
+} lv_palette_t;
+
+enum {
+  LV_OBJ_FLAG_HIDDEN = 1 << 0,
+  LV_OBJ_FLAG_CLICKABLE = 1 << 1,
+  LV_OBJ_FLAG_CLICK_FOCUSABLE = 1 << 2,
+  LV_OBJ_FLAG_SCROLLABLE = 1 << 4,
+  LV_OBJ_FLAG_FLOATING = 1 << 16,
+};
+
+enum {
+  LV_STATE_DEFAULT = 0,
+  LV_STATE_CHECKED = 1 << 0,
+  LV_STATE_PRESSED = 1 << 5,
+};
+
+enum {
+  LV_PART_MAIN = 0,
+};
+
+enum {
+  LV_OPA_TRANSP = 0,
+  LV_OPA_COVER = 255,
+};
+
+enum {
+  LV_ANIM_OFF = 0,
+  LV_ANIM_ON,
+};
+
+enum {
+  LV_DIR_NONE = 0,
+  LV_DIR_VER = 0x0c,
+};
+
+enum {
+  LV_ALIGN_DEFAULT = 0,
+  LV_ALIGN_LEFT_MID = 7,
+};
+
+enum {
+  LV_BORDER_SIDE_BOTTOM = 1,
+};
+
+enum {
+  LV_LABEL_LONG_WRAP = 0,
+  LV_LABEL_LONG_DOT = 1,
+};
+
+enum {
+  LV_FLEX_FLOW_ROW = 0,
+  LV_FLEX_FLOW_COLUMN = 1,
+};
+
+enum {
+  LV_FLEX_ALIGN_START = 0,
+  LV_FLEX_ALIGN_CENTER = 2,
+};
+
+#define LV_RADIUS_CIRCLE 0x7FFF
+#define LV_DISP_DEF_REFR_PERIOD 30
+#define LV_COORD_SET_SPEC(x) ((x) | (1 << 29))
+#define LV_PCT(x) LV_COORD_SET_SPEC(x)
+
+extern const lv_font_t lv_font_montserrat_12;
+
+lv_obj_t *lv_obj_create(lv_obj_t *parent);
+lv_obj_t *lv_label_create(lv_obj_t *parent);
+void lv_obj_del(lv_obj_t *obj);
+lv_obj_t *lv_obj_get_child(const lv_obj_t *obj, int32_t id);
+uint32_t lv_obj_get_child_cnt(const lv_obj_t *obj);
+
+void lv_obj_set_pos(lv_obj_t *obj, lv_coord_t x, lv_coord_t y);
+void lv_obj_set_y(lv_obj_t *obj, lv_coord_t y);
+void lv_obj_set_size(lv_obj_t *obj, lv_coord_t w, lv_coord_t h);
+void lv_obj_set_width(lv_obj_t *obj, lv_coord_t w);
+void lv_obj_set_height(lv_obj_t *obj, lv_coord_t h);
+void lv_obj_align(lv_obj_t *obj, int align, lv_coord_t x, lv_coord_t y);
+lv_coord_t lv_obj_get_width(const lv_obj_t *obj);
+lv_coord_t lv_obj_get_height(const lv_obj_t *obj);
+
+void lv_obj_add_flag(lv_obj_t *obj, lv_obj_flag_t f);
+void lv_obj_clear_flag(lv_obj_t *obj, lv_obj_flag_t f);
+bool lv_obj_has_flag(const lv_obj_t *obj, lv_obj_flag_t f);
+void lv_obj_add_state(lv_obj_t *obj, lv_state_t state);
+void lv_obj_clear_state(lv_obj_t *obj, lv_state_t state);
+bool lv_obj_has_state(const lv_obj_t *obj, lv_state_t state);
+
+void lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t cb, lv_event_code_t filter, void *user_data);
+lv_event_code_t lv_event_get_code(lv_event_t *e);
+lv_obj_t *lv_event_get_target(lv_event_t *e);
+lv_obj_t *lv_event_get_current_target(lv_event_t *e);
+void *lv_event_get_user_data(lv_event_t *e);
+
+void lv_obj_set_scroll_dir(lv_obj_t *obj, int dir);
+void lv_obj_scroll_to_y(lv_obj_t *obj, lv_coord_t y, int anim);
+lv_coord_t lv_obj_get_scroll_y(const lv_obj_t *obj);
+
+void lv_obj_remove_style_all(lv_obj_t *obj);
+void lv_obj_set_style_radius(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t selector);
+void lv_obj_set_style_bg_color(lv_obj_t *obj, lv_color_t v, lv_style_selector_t selector);
+void lv_obj_set_style_bg_opa(lv_obj_t *obj, lv_opa_t v, lv_style_selector_t selector);
+void lv_obj_set_style_border_color(lv_obj_t *obj, lv_color_t v, lv_style_selector_t selector);
+void lv_obj_set_style_border_width(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t selector);
+void lv_obj_set_style_border_side(lv_obj_t *obj, int v, lv_style_selector_t selector);
+void lv_obj_set_style_pad_all(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t selector);
+void lv_obj_set_style_pad_hor(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t selector);
+void lv_obj_set_style_pad_ver(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t selector);
+void lv_obj_set_style_pad_left(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t selector);
+void lv_obj_set_style_text_color(lv_obj_t *obj, lv_color_t v, lv_style_selector_t selector);
+void lv_obj_set_style_text_font(lv_obj_t *obj, const lv_font_t *v, lv_style_selector_t selector);
+lv_coord_t lv_obj_get_style_border_width(const lv_obj_t *obj, lv_part_t part);
+lv_coord_t lv_obj_get_style_pad_left(const lv_obj_t *obj, lv_part_t part);
+lv_coord_t lv_obj_get_style_pad_top(const lv_obj_t *obj, lv_part_t part);
+const lv_font_t *lv_obj_get_style_text_font(const lv_obj_t *obj, lv_part_t part);
+
+void lv_obj_set_flex_flow(lv_obj_t *obj, int flow);
+void lv_obj_set_flex_align(lv_obj_t *obj, int main_place, int cross_place, int track_place);
+void lv_obj_set_flex_grow(lv_obj_t *obj, uint8_t grow);
+
+void lv_label_set_text(lv_obj_t *obj, const char *text);
+void lv_label_set_long_mode(lv_obj_t *obj, int mode);
+const char *lv_label_get_text(const lv_obj_t *obj);
+
+lv_coord_t lv_font_get_line_height(const lv_font_t *font);
+lv_color_t lv_palette_main(lv_palette_t p);
+lv_color_t lv_color_white(void);
+lv_color_t lv_theme_get_color_primary(lv_obj_t *obj);
+
+lv_timer_t *lv_timer_create(lv_timer_cb_t cb, uint32_t period, void *user_data);
+void lv_timer_del(lv_timer_t *timer);
+uint32_t lv_timer_handler(void);
+
+// the stub's own
+lv_obj_t *lv_stub_screen(void);
+uint64_t lv_stub_invalidated_px(void);
+void lv_stub_reset_invalidated(void);
+
+#endif // __LVGL_STUB_H__
@@ -0,0 +1,408 @@
+// lvgl_stub.cpp
+// see lvgl/lvgl.h next to this
+#include "lvgl/lvgl.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+struct _lv_obj_t {
+  lv_obj_t *parent;
+  std::vector<lv_obj_t *> children;
+  lv_coord_t x;
+  lv_coord_t y;
+  lv_coord_t w;
+  lv_coord_t h;
+  lv_obj_flag_t flags;
+  lv_state_t state;
+  lv_coord_t scroll_y;
+  lv_coord_t border_width;
+  lv_coord_t pad_left;
+  lv_coord_t pad_top;
+  const lv_font_t *font;
+  std::string text;
+
+  struct Handler {
+    lv_event_cb_t cb;
+    lv_event_code_t filter;
+    void *user_data;
+  };
+  std::vector<Handler> handlers;
+};
+
+const lv_font_t lv_font_montserrat_12 = {15};
+
+namespace {
+  uint64_t invalidated = 0;
+  std::vector<lv_timer_t *> timers;
+
+  lv_obj_t *new_obj(lv_obj_t *parent) {
+    if (parent == NULL && lv_stub_screen() != NULL) {
+      parent = lv_stub_screen();
+    }
+    lv_obj_t *obj = new lv_obj_t{parent, {}, 0, 0, 0, 0, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE,
+                                 LV_STATE_DEFAULT, 0, 0, 0, 0, NULL, "", {}};
+    if (parent != NULL) {
+      parent->children.push_back(obj);
+    }
+    return obj;
+  }
+
+  bool visible(const lv_obj_t *obj) {
+    for (; obj != NULL; obj = obj->parent) {
+      if (obj->flags & LV_OBJ_FLAG_HIDDEN) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // what LVGL would redraw for obj, clipped to nothing, overlaps counted twice
+  void invalidate(const lv_obj_t *obj) {
+    if (visible(obj) && obj->w > 0 && obj->h > 0) {
+      invalidated += static_cast<uint64_t>(obj->w) * obj->h;
+    }
+  }
+
+  void send(lv_obj_t *obj, lv_event_code_t code) {
+    for (const auto &h : obj->handlers) {
+      if (h.filter == LV_EVENT_ALL || h.filter == code) {
+        lv_event_t e = {obj, obj, code, h.user_data, NULL};
+        h.cb(&e);
+      }
+    }
+  }
+
+  lv_coord_t resolve(const lv_obj_t *obj, lv_coord_t v, bool width) {
+    if (v & (1 << 29)) {
+      // LV_PCT of the parent's size
+      lv_coord_t pct = v & ~(1 << 29);
+      lv_coord_t of = obj->parent == NULL ? 0 : (width ? obj->parent->w : obj->parent->h);
+      return of * pct / 100;
+    }
+    return v;
+  }
+
+  void set_geometry(lv_obj_t *obj, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h) {
+    w = resolve(obj, w, true);
+    h = resolve(obj, h, false);
+    if (obj->x == x && obj->y == y && obj->w == w && obj->h == h) {
+      return;
+    }
+
+    bool resized = obj->w != w || obj->h != h;
+    invalidate(obj);
+    obj->x = x;
+    obj->y = y;
+    obj->w = w;
+    obj->h = h;
+    invalidate(obj);
+    if (resized) {
+      send(obj, LV_EVENT_SIZE_CHANGED);
+    }
+  }
+}
+
+lv_obj_t *lv_stub_screen(void) {
+  static lv_obj_t *screen = NULL;
+  if (screen == NULL) {
+    screen = new lv_obj_t{NULL, {}, 0, 0, 800, 480, 0, LV_STATE_DEFAULT, 0, 0, 0, 0, NULL, "", {}};
+  }
+  return screen;
+}
+
+uint64_t lv_stub_invalidated_px(void) {
+  return invalidated;
+}
+
+void lv_stub_reset_invalidated(void) {
+  invalidated = 0;
+}
+
+lv_obj_t *lv_obj_create(lv_obj_t *parent) {
+  return new_obj(parent);
+}
+
+lv_obj_t *lv_label_create(lv_obj_t *parent) {
+  lv_obj_t *obj = new_obj(parent);
+  obj->flags &= ~(LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+  return obj;
+}
+
+void lv_obj_del(lv_obj_t *obj) {
+  invalidate(obj);
+  while (!obj->children.empty()) {
+    lv_obj_del(obj->children.back());
+  }
+  if (obj->parent != NULL) {
+    auto &siblings = obj->parent->children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), obj));
+  }
+  delete obj;
+}
+
+lv_obj_t *lv_obj_get_child(const lv_obj_t *obj, int32_t id) {
+  // negative ids count from the end
+  int32_t n = obj->children.size();
+  if (id < 0) {
+    id += n;
+  }
+  return id >= 0 && id < n ? obj->children[id] : NULL;
+}
+
+uint32_t lv_obj_get_child_cnt(const lv_obj_t *obj) {
+  return obj->children.size();
+}
+
+void lv_obj_set_pos(lv_obj_t *obj, lv_coord_t x, lv_coord_t y) {
+  set_geometry(obj, x, y, obj->w, obj->h);
+}
+
+void lv_obj_set_y(lv_obj_t *obj, lv_coord_t y) {
+  set_geometry(obj, obj->x, y, obj->w, obj->h);
+}
+
+void lv_obj_set_size(lv_obj_t *obj, lv_coord_t w, lv_coord_t h) {
+  set_geometry(obj, obj->x, obj->y, w, h);
+}
+
+void lv_obj_set_width(lv_obj_t *obj, lv_coord_t w) {
+  set_geometry(obj, obj->x, obj->y, w, obj->h);
+}
+
+void lv_obj_set_height(lv_obj_t *obj, lv_coord_t h) {
+  set_geometry(obj, obj->x, obj->y, obj->w, h);
+}
+
+void lv_obj_align(lv_obj_t *obj, int, lv_coord_t x, lv_coord_t y) {
+  set_geometry(obj, x, y, obj->w, obj->h);
+}
+
+lv_coord_t lv_obj_get_width(const lv_obj_t *obj) {
+  return obj->w;
+}
+
+lv_coord_t lv_obj_get_height(const lv_obj_t *obj) {
+  return obj->h;
+}
+
+void lv_obj_add_flag(lv_obj_t *obj, lv_obj_flag_t f) {
+  if ((f & LV_OBJ_FLAG_HIDDEN) && !(obj->flags & LV_OBJ_FLAG_HIDDEN)) {
+    invalidate(obj);
+  }
+  obj->flags |= f;
+}
+
+void lv_obj_clear_flag(lv_obj_t *obj, lv_obj_flag_t f) {
+  bool shown = (f & LV_OBJ_FLAG_HIDDEN) && (obj->flags & LV_OBJ_FLAG_HIDDEN);
+  obj->flags &= ~f;
+  if (shown) {
+    invalidate(obj);
+  }
+}
+
+bool lv_obj_has_flag(const lv_obj_t *obj, lv_obj_flag_t f) {
+  return (obj->flags & f) == f;
+}
+
+void lv_obj_add_state(lv_obj_t *obj, lv_state_t state) {
+  if ((obj->state & state) != state) {
+    obj->state |= state;
+    invalidate(obj);
+  }
+}
+
+void lv_obj_clear_state(lv_obj_t *obj, lv_state_t state) {
+  if (obj->state & state) {
+    obj->state &= ~state;
+    invalidate(obj);
+  }
+}
+
+bool lv_obj_has_state(const lv_obj_t *obj, lv_state_t state) {
+  return (obj->state & state) != 0;
+}
+
+void lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t cb, lv_event_code_t filter, void *user_data) {
+  obj->handlers.push_back({cb, filter, user_data});
+}
+
+lv_event_code_t lv_event_get_code(lv_event_t *e) {
+  return e->code;
+}
+
+lv_obj_t *lv_event_get_target(lv_event_t *e) {
+  return e->target;
+}
+
+lv_obj_t *lv_event_get_current_target(lv_event_t *e) {
+  return e->current_target;
+}
+
+void *lv_event_get_user_data(lv_event_t *e) {
+  return e->user_data;
+}
+
+void lv_obj_set_scroll_dir(lv_obj_t *, int) {
+}
+
+void lv_obj_scroll_to_y(lv_obj_t *obj, lv_coord_t y, int) {
+  if (obj->scroll_y != y) {
+    obj->scroll_y = y;
+    // the whole viewport moves
+    invalidate(obj);
+    send(obj, LV_EVENT_SCROLL);
+  }
+}
+
+lv_coord_t lv_obj_get_scroll_y(const lv_obj_t *obj) {
+  return obj->scroll_y;
+}
+
+void lv_obj_remove_style_all(lv_obj_t *obj) {
+  obj->border_width = 0;
+  obj->pad_left = 0;
+  obj->pad_top = 0;
+  obj->font = NULL;
+  invalidate(obj);
+}
+
+void lv_obj_set_style_radius(lv_obj_t *obj, lv_coord_t, lv_style_selector_t) {
+  invalidate(obj);
+}
+
+void lv_obj_set_style_bg_color(lv_obj_t *obj, lv_color_t, lv_style_selector_t) {
+  invalidate(obj);
+}
+
+void lv_obj_set_style_bg_opa(lv_obj_t *obj, lv_opa_t, lv_style_selector_t) {
+  invalidate(obj);
+}
+
+void lv_obj_set_style_border_color(lv_obj_t *obj, lv_color_t, lv_style_selector_t) {
+  invalidate(obj);
+}
+
+void lv_obj_set_style_border_width(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t) {
+  obj->border_width = v;
+  invalidate(obj);
+}
+
+void lv_obj_set_style_border_side(lv_obj_t *obj, int, lv_style_selector_t) {
+  invalidate(obj);
+}
+
+void lv_obj_set_style_pad_all(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t) {
+  obj->pad_left = v;
+  obj->pad_top = v;
+  invalidate(obj);
+}
+
+void lv_obj_set_style_pad_hor(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t) {
+  obj->pad_left = v;
+  invalidate(obj);
+}
+
+void lv_obj_set_style_pad_ver(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t) {
+  obj->pad_top = v;
+  invalidate(obj);
+}
+
+void lv_obj_set_style_pad_left(lv_obj_t *obj, lv_coord_t v, lv_style_selector_t) {
+  obj->pad_left = v;
+  invalidate(obj);
+}
+
+void lv_obj_set_style_text_color(lv_obj_t *obj, lv_color_t, lv_style_selector_t) {
+  invalidate(obj);
+}
+
+void lv_obj_set_style_text_font(lv_obj_t *obj, const lv_font_t *v, lv_style_selector_t) {
+  obj->font = v;
+  invalidate(obj);
+}
+
+lv_coord_t lv_obj_get_style_border_width(const lv_obj_t *obj, lv_part_t) {
+  return obj->border_width;
+}
+
+lv_coord_t lv_obj_get_style_pad_left(const lv_obj_t *obj, lv_part_t) {
+  return obj->pad_left;
+}
+
+lv_coord_t lv_obj_get_style_pad_top(const lv_obj_t *obj, lv_part_t) {
+  return obj->pad_top;
+}
+
+const lv_font_t *lv_obj_get_style_text_font(const lv_obj_t *obj, lv_part_t) {
+  // inherited, like LVGL's text styles
+  for (; obj != NULL; obj = obj->parent) {
+    if (obj->font != NULL) {
+      return obj->font;
+    }
+  }
+  return &lv_font_montserrat_12;
+}
+
+void lv_obj_set_flex_flow(lv_obj_t *, int) {
+}
+
+void lv_obj_set_flex_align(lv_obj_t *, int, int, int) {
+}
+
+void lv_obj_set_flex_grow(lv_obj_t *, uint8_t) {
+}
+
+void lv_label_set_text(lv_obj_t *obj, const char *text) {
+  if (obj->text != text) {
+    obj->text = text;
+    invalidate(obj);
+  }
+}
+
+void lv_label_set_long_mode(lv_obj_t *, int) {
+}
+
+const char *lv_label_get_text(const lv_obj_t *obj) {
+  return obj->text.c_str();
+}
+
+lv_coord_t lv_font_get_line_height(const lv_font_t *font) {
+  return font->line_height;
+}
+
+lv_color_t lv_palette_main(lv_palette_t p) {
+  return {static_cast<uint16_t>(p)};
+}
+
+lv_color_t lv_color_white(void) {
+  return {0xffff};
+}
+
+lv_color_t lv_theme_get_color_primary(lv_obj_t *) {
+  return {0x2196};
+}
+
+lv_timer_t *lv_timer_create(lv_timer_cb_t cb, uint32_t period, void *user_data) {
+  lv_timer_t *t = new lv_timer_t{period, cb, user_data};
+  timers.push_back(t);
+  return t;
+}
+
+void lv_timer_del(lv_timer_t *timer) {
+  timers.erase(std::find(timers.begin(), timers.end(), timer));
+  delete timer;
+}
+
+// every timer once, whatever its period. a timer may not delete others
+uint32_t lv_timer_handler(void) {
+  for (size_t i = 0; i < timers.size(); i++) {
+    lv_timer_t *t = timers[i];
+    t->timer_cb(t);
+    if (i < timers.size() && timers[i] != t) {
+      // deleted itself
+      i--;
+    }
+  }
+  return LV_DISP_DEF_REFR_PERIOD;
+}
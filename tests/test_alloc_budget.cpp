@@ -0,0 +1,254 @@
+// test_alloc_budget.cpp
+// feeds recorded notify_status_update frames through the same parse and
+// NotifyDispatcher path as KWebSocketClient::onmessage and counts heap
+// allocations per frame for the parse, for each consumer and for the ui
+// timers the update wakes. the consumers are State, the real ToolheadMarker
+// on the LVGL stub, and the StatusFields MainPanel reads its sensors and
+// print state through, MainPanel itself needs a connection. fails when the steady state goes over the budget
+// below, lower it when the numbers drop.
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <malloc.h>
+#include <string>
+#include <vector>
+#include "hv/json.hpp"
+#include "json_parser.h"
+#include "notify_dispatcher.h"
+#include "state.h"
+#include "status_fields.h"
+#include "toolhead_marker.h"
+
+using json = nlohmann::json;
+
+// steady state heap allocations per frame, all consumers and the parse
+static const double ALLOCS_PER_FRAME_BUDGET = 2.0;
+
+extern "C" {
+  void *__libc_malloc(size_t n);
+  void *__libc_calloc(size_t n, size_t size);
+  void *__libc_realloc(void *p, size_t n);
+  void __libc_free(void *p);
+}
+
+namespace {
+  struct Counters {
+    uint64_t allocs;
+    uint64_t bytes;
+    int64_t live;
+    int64_t peak;
+  };
+
+  Counters counters = {0, 0, 0, 0};
+
+  void count_alloc(void *p) {
+    if (p != NULL) {
+      size_t n = malloc_usable_size(p);
+      counters.allocs++;
+      counters.bytes += n;
+      counters.live += n;
+      if (counters.live > counters.peak) {
+        counters.peak = counters.live;
+      }
+    }
+  }
+
+  void count_free(void *p) {
+    if (p != NULL) {
+      counters.live -= malloc_usable_size(p);
+    }
+  }
+}
+
+extern "C" {
+  void *malloc(size_t n) {
+    void *p = __libc_malloc(n);
+    count_alloc(p);
+    return p;
+  }
+
+  void *calloc(size_t n, size_t size) {
+    void *p = __libc_calloc(n, size);
+    count_alloc(p);
+    return p;
+  }
+
+  void *realloc(void *p, size_t n) {
+    count_free(p);
+    void *r = __libc_realloc(p, n);
+    count_alloc(r);
+    return r;
+  }
+
+  void free(void *p) {
+    count_free(p);
+    __libc_free(p);
+  }
+}
+
+// ExcludeObjectPanel hands every update to its marker
+class ToolheadMarkerConsumer : public NotifyConsumer {
+ public:
+  ToolheadMarkerConsumer(LvLock &l)
+    : NotifyConsumer(l)
+    , map(lv_obj_create(NULL))
+    , caption(lv_label_create(NULL))
+    , marker(map, 400, 12, caption)
+  {
+    lv_obj_set_size(map, 400, 400);
+  }
+
+  void consume(json &j) {
+    LV_LOCK_GUARD(lock, lv_lock);
+    marker.consume(j);
+  }
+
+ private:
+  lv_obj_t *map;
+  lv_obj_t *caption;
+  ToolheadMarker marker;
+};
+
+// MainPanel's StatusFields, set up as create_sensors does for these
+// sensors, MainPanel itself needs a websocket for its sensor rows
+class MainPanelFields : public NotifyConsumer {
+ public:
+  MainPanelFields(LvLock &l)
+    : NotifyConsumer(l)
+    , print_state(status_fields.add("print_stats", "state"))
+    , printing(false)
+  {
+    for (auto &key : {"extruder", "heater_bed", "temperature_sensor chamber_temp"}) {
+      sensors.push_back({status_fields.add(key, "target"), status_fields.add(key, "temperature"), 0, 0});
+    }
+  }
+
+  void consume(json &j) {
+    LV_LOCK_GUARD(lock, lv_lock);
+    status_fields.read(j);
+    for (auto &s : sensors) {
+      const json *target_value = status_fields.get(s.target);
+      if (target_value != NULL) {
+        s.target_value = target_value->template get<int>();
+      }
+
+      const json *temp_value = status_fields.get(s.temperature);
+      if (temp_value != NULL) {
+        s.temperature_value = temp_value->template get<int>();
+      }
+    }
+
+    const json *pstat_state = status_fields.get(print_state);
+    if (pstat_state != NULL) {
+      printing = pstat_state->template get_ref<const std::string &>() == "printing";
+    }
+  }
+
+ private:
+  struct Sensor {
+    StatusFields::Id target;
+    StatusFields::Id temperature;
+    int target_value;
+    int temperature_value;
+  };
+
+  StatusFields status_fields;
+  StatusFields::Id print_state;
+  std::vector<Sensor> sensors;
+  bool printing;
+};
+
+struct Usage {
+  std::string name;
+  uint64_t allocs;
+  uint64_t bytes;
+  int64_t peak;
+};
+
+static void start(Counters &at) {
+  counters.peak = counters.live;
+  at = counters;
+}
+
+static void stop(const Counters &at, Usage &u) {
+  u.allocs += counters.allocs - at.allocs;
+  u.bytes += counters.bytes - at.bytes;
+  if (counters.peak - at.live > u.peak) {
+    u.peak = counters.peak - at.live;
+  }
+}
+
+int main(int argc, char **argv) {
+  std::ifstream in(argc > 1 ? argv[1] : "tests/data/status_frames.jsonl");
+  std::vector<std::string> frames;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty()) {
+      frames.push_back(line);
+    }
+  }
+  assert(!frames.empty());
+
+  LvLock ui_lock("lv_lock");
+  ToolheadMarkerConsumer marker(ui_lock);
+  MainPanelFields sensors(ui_lock);
+
+  NotifyDispatcher dispatcher;
+  dispatcher.add(State::get_instance());
+  dispatcher.add(&marker);
+  dispatcher.add(&sensors);
+
+  std::vector<Usage> usage;
+  usage.push_back({"parse", 0, 0, 0});
+  for (NotifyConsumer *c : dispatcher.get_consumers()) {
+    usage.push_back({NotifyDispatcher::consumer_name(c), 0, 0, 0});
+  }
+  usage.push_back({"lv_timer_handler", 0, 0, 0});
+
+  JsonParser parser;
+
+  // the first pass fills the state, the second is the steady state
+  for (int pass = 0; pass < 2; pass++) {
+    for (auto &u : usage) {
+      u.allocs = u.bytes = u.peak = 0;
+    }
+
+    for (const auto &f : frames) {
+      Counters at;
+      start(at);
+      json &j = parser.parse(f.data(), f.size());
+      stop(at, usage[0]);
+
+      size_t i = 1;
+      start(at);
+      dispatcher.dispatch(j, [&](NotifyConsumer *, const NotifyDispatcher::ConsumerMetrics &, uint64_t, uint64_t) {
+        stop(at, usage[i++]);
+        start(at);
+      });
+
+      // the ui loop's next pass, the marker moves its dot
+      {
+        LV_LOCK_GUARD(lock, ui_lock);
+        lv_timer_handler();
+      }
+      stop(at, usage[i]);
+    }
+  }
+
+  double n = static_cast<double>(frames.size());
+  double total = 0;
+  printf("%zu frames, steady state per frame\n", frames.size());
+  printf("%-24s %10s %10s %10s\n", "", "allocs", "bytes", "peak");
+  for (const auto &u : usage) {
+    printf("%-24s %10.1f %10.0f %10ld\n", u.name.c_str(), u.allocs / n, u.bytes / n, static_cast<long>(u.peak));
+    total += u.allocs / n;
+  }
+  printf("%-24s %10.1f (budget %.1f)\n", "total", total, ALLOCS_PER_FRAME_BUDGET);
+
+  if (total > ALLOCS_PER_FRAME_BUDGET) {
+    printf("FAIL: allocations per frame over budget\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+// test_file_tree.cpp
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "file_tree.h"
+
+namespace {
+  json file(const std::string &name, double modified, uint64_t size = 100) {
+    return {{"filename", name}, {"modified", modified}, {"size", size}};
+  }
+
+  json dir(const std::string &name, double modified) {
+    return {{"dirname", name}, {"modified", modified}};
+  }
+
+  json item(const std::string &path, double modified = 0, const std::string &root = "gcodes") {
+    return {{"path", path}, {"root", root}, {"modified", modified}, {"size", 10}};
+  }
+
+  FileTree::Change apply(FileTree &t, const std::string &action, const json &i, const json &source = json::object()) {
+    return t.apply(action, i, source);
+  }
+
+  // names of dir newest first
+  std::vector<std::string> listing(const FileTree &t, FileTree::Id d) {
+    std::vector<std::string> out;
+    for (FileTree::Id c : t.get(d).by_modified) {
+      out.push_back(t.name(c));
+    }
+    return out;
+  }
+
+  typedef std::vector<std::string> Names;
+
+  // a.gcode, b.gcode and sub/ with c.gcode, both loaded
+  void load(FileTree &t) {
+    t.fill(FileTree::ROOT, {{"dirs", {dir("sub", 5), dir(".thumbs", 9)}},
+                            {"files", {file("a.gcode", 1), file("b.gcode", 2)}}});
+    t.fill(t.find("sub"), {{"files", {file("c.gcode", 3)}}});
+  }
+}
+
+int main() {
+  {
+    FileTree t;
+    load(t);
+    assert(listing(t, FileTree::ROOT) == Names({"sub", "b.gcode", "a.gcode"}));
+    assert(t.find("sub/c.gcode") != FileTree::NONE);
+    assert(t.find(".thumbs") == FileTree::NONE);
+    assert(t.path(t.find("sub/c.gcode")) == "sub/c.gcode");
+  }
+
+  {
+    // create and modify files
+    FileTree t;
+    load(t);
+    FileTree::Change c = apply(t, "create_file", item("new.gcode", 10));
+    assert(c.dir == FileTree::ROOT && c.from == FileTree::NONE && !c.reload);
+    assert(listing(t, FileTree::ROOT) == Names({"new.gcode", "sub", "b.gcode", "a.gcode"}));
+
+    c = apply(t, "modify_file", item("a.gcode", 20));
+    assert(c.dir == FileTree::ROOT);
+    assert(listing(t, FileTree::ROOT) == Names({"a.gcode", "new.gcode", "sub", "b.gcode"}));
+    assert(t.get(t.find("a.gcode")).size == 10);
+
+    // a directory not listed yet is left for when it is
+    c = apply(t, "create_file", item("nowhere/x.gcode", 30));
+    assert(c.dir == FileTree::NONE);
+    assert(t.find("nowhere/x.gcode") == FileTree::NONE);
+  }
+
+  {
+    // create and delete directories
+    FileTree t;
+    load(t);
+    FileTree::Change c = apply(t, "create_dir", item("empty", 11));
+    FileTree::Id empty = t.find("empty");
+    assert(c.dir == FileTree::ROOT && empty != FileTree::NONE);
+    assert(t.get(empty).dir && t.get(empty).loaded && t.get(empty).by_name.empty());
+
+    c = apply(t, "create_file", item("empty/d.gcode", 12));
+    assert(c.dir == empty && listing(t, empty) == Names({"d.gcode"}));
+
+    c = apply(t, "delete_dir", item("sub"));
+    assert(c.dir == FileTree::ROOT);
+    assert(t.find("sub") == FileTree::NONE && t.find("sub/c.gcode") == FileTree::NONE);
+
+    size_t before = t.size();
+    c = apply(t, "delete_file", item("a.gcode"));
+    assert(c.dir == FileTree::ROOT && t.find("a.gcode") == FileTree::NONE);
+    assert(t.size() == before - 1);
+
+    c = apply(t, "delete_file", item("missing.gcode"));
+    assert(c.dir == FileTree::NONE);
+  }
+
+  {
+    // moves and renames, within and between directories
+    FileTree t;
+    load(t);
+    FileTree::Id sub = t.find("sub");
+    FileTree::Change c = apply(t, "move_file", item("renamed.gcode", 2), item("b.gcode"));
+    assert(c.dir == FileTree::ROOT && c.from == FileTree::ROOT);
+    assert(t.find("b.gcode") == FileTree::NONE && t.find("renamed.gcode") != FileTree::NONE);
+
+    c = apply(t, "move_file", item("sub/a.gcode", 1), item("a.gcode"));
+    assert(c.dir == sub && c.from == FileTree::ROOT);
+    assert(listing(t, sub) == Names({"c.gcode", "a.gcode"}));
+
+    // over an existing file
+    c = apply(t, "move_file", item("sub/c.gcode", 4), item("renamed.gcode"));
+    assert(listing(t, sub) == Names({"c.gcode", "a.gcode"}));
+    assert(t.get(t.find("sub/c.gcode")).modified == 4);
+    assert(listing(t, FileTree::ROOT) == Names({"sub"}));
+
+    // a directory keeps what is loaded under it
+    apply(t, "create_dir", item("other", 6));
+    c = apply(t, "move_dir", item("other/moved", 5), item("sub"));
+    FileTree::Id moved = t.find("other/moved");
+    assert(moved == sub && c.dir == t.find("other") && c.from == FileTree::ROOT);
+    assert(t.get(moved).loaded && listing(t, moved) == Names({"c.gcode", "a.gcode"}));
+
+    // into a directory not listed yet, it goes away until that is
+    apply(t, "create_dir", item("cold", 7));
+    t.unload();
+    t.fill(FileTree::ROOT, {{"dirs", {dir("other", 6), dir("cold", 7)}}});
+    t.fill(t.find("other"), {{"dirs", {dir("moved", 5)}}});
+    c = apply(t, "move_dir", item("cold/moved", 5), item("other/moved"));
+    assert(c.dir == FileTree::NONE && c.from == t.find("other"));
+    assert(t.find("other/moved") == FileTree::NONE);
+  }
+
+  {
+    // other roots are outside the tree
+    FileTree t;
+    load(t);
+    FileTree::Change c = apply(t, "create_file", item("x.gcode", 1, "config"));
+    assert(c.dir == FileTree::NONE && t.find("x.gcode") == FileTree::NONE);
+
+    // moved out is deleted
+    c = apply(t, "move_file", item("a.gcode", 1, "config"), item("a.gcode"));
+    assert(c.dir == FileTree::ROOT && t.find("a.gcode") == FileTree::NONE);
+    c = apply(t, "move_dir", item("sub", 5, "config"), item("sub"));
+    assert(c.dir == FileTree::ROOT && t.find("sub") == FileTree::NONE);
+
+    // moved in is created, a directory not loaded as it may have files
+    c = apply(t, "move_file", item("in.gcode", 8), item("in.gcode", 8, "config"));
+    assert(c.dir == FileTree::ROOT && c.from == FileTree::NONE && t.find("in.gcode") != FileTree::NONE);
+    c = apply(t, "move_dir", item("indir", 9), item("indir", 9, "config"));
+    FileTree::Id indir = t.find("indir");
+    assert(c.dir == FileTree::ROOT && indir != FileTree::NONE);
+    assert(t.get(indir).dir && !t.get(indir).loaded);
+
+    // a same named file at the source in the tree is left alone
+    c = apply(t, "move_file", item("b2.gcode", 8), item("b.gcode", 2, "config"));
+    assert(t.find("b.gcode") != FileTree::NONE && t.find("b2.gcode") != FileTree::NONE);
+
+    c = apply(t, "root_update", item(""));
+    assert(c.reload);
+  }
+
+  printf("file tree ok\n");
+  return 0;
+}
@@ -0,0 +1,96 @@
+// test_json_parser.cpp
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "json_parser.h"
+
+namespace {
+  // dump tells integers, unsigned and floats apart, == doesn't
+  void check(JsonParser &parser, const std::string &text) {
+    json &j = parser.parse(text.data(), text.size());
+    assert(j.dump() == json::parse(text).dump());
+  }
+}
+
+int main() {
+  {
+    // one parser through documents that keep changing shape
+    std::vector<std::string> docs = {
+      R"({"a": {"x": 1, "y": [1, 2, 3]}, "b": "text", "c": null})",
+      R"({"a": {"x": 2}, "d": true})",
+      R"({"a": [1, {"x": 1}], "b": {"nested": {"deep": false}}})",
+      R"({"b": "a longer string than fits inline", "a": {"y": [4]}})",
+      R"({"a": {}, "b": [], "c": ""})",
+      R"([1, -1, 18446744073709551615, -9223372036854775808, 18446744073709551616, 0.5, -0, 1e3, 2E-2])",
+      R"("just a string")",
+      R"(  {"ws" :	[ 1 ,2 ] }
+)",
+      R"({"esc": "q\"b\\s\/n\nt\tr\rb\bf\f", "a": {"x": 1, "y": [1, 2, 3]}})",
+      R"({"dup": 1, "dup": 2, "other": 3})",
+      R"({"dup": {"k": 1}, "dup": [2]})",
+      R"({"jsonrpc":"2.0","method":"notify_status_update","params":[{"toolhead":{"position":[1,2,3,4]}},1.5]})",
+      R"({"jsonrpc":"2.0","method":"notify_status_update","params":[{"extruder":{"temperature":200.5}},2.0]})",
+      R"({"jsonrpc":"2.0","method":"notify_status_update","params":[{"toolhead":{"position":[5,6,7,8]}},2.5]})",
+      R"(true)",
+      R"({"a": {"x": 1, "y": [1, 2, 3]}, "b": "text", "c": null})",
+    };
+    JsonParser parser;
+    for (int round = 0; round < 2; round++) {
+      for (const auto &d : docs) {
+        check(parser, d);
+      }
+    }
+    assert(parser.stats().fallbacks == 0);
+  }
+
+  {
+    // left to json::parse
+    JsonParser parser;
+    check(parser, R"({"a": 1})");
+    check(parser, R"({"u": "é😀"})");
+    check(parser, "{\"utf8\": \"caf\xc3\xa9\"}");
+    check(parser, R"({"a": 1})");
+    assert(parser.stats().fallbacks == 2);
+  }
+
+  {
+    // a frame over the reuse limit, and the small ones after it
+    std::string big = "{\"list\": [";
+    for (int i = 0; i < 20000; i++) {
+      big += (i ? ", " : "") + std::to_string(i * 0.25);
+    }
+    big += "], \"tiny\": 1e-400, \"a\": {\"x\": 1}}";
+    JsonParser parser;
+    check(parser, R"({"a": {"x": 0}, "b": 2})");
+    check(parser, big);
+    check(parser, R"({"a": {"x": 2}, "b": 3})");
+    check(parser, R"({"list": [1.5], "a": {"x": 3}})");
+  }
+
+  {
+    // invalid input throws or is discarded like json::parse, and the next
+    // document still comes out right
+    std::vector<std::string> bad = {
+      "", "{", R"({"a": 1,})", R"({"a" 1})", "[1 2]", "01", "1.", "-", "1e", "tru", "nul",
+      R"({"a": 1} x)", "\"\x01\"", R"("\x")", "1e400", R"({"a": [1, 2)",
+    };
+    JsonParser parser;
+    for (const auto &b : bad) {
+      check(parser, R"({"a": {"b": [1, 2]}, "c": "d"})");
+      assert(parser.parse(b.data(), b.size(), false).is_discarded());
+      bool thrown = false;
+      try {
+        parser.parse(b.data(), b.size());
+      } catch (const json::exception &) {
+        thrown = true;
+      }
+      assert(thrown);
+    }
+    check(parser, R"({"a": {"b": [3]}, "c": "e"})");
+  }
+
+  printf("json parser ok\n");
+  return 0;
+}
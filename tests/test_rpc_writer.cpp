@@ -0,0 +1,127 @@
+// test_rpc_writer.cpp
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include "hv/json.hpp"
+#include "rpc_writer.h"
+
+using json = nlohmann::json;
+
+int main() {
+  {
+    RpcWriter rpc("printer.emergency_stop");
+    json j = json::parse(rpc.finish(7));
+    assert(j == json({{"jsonrpc", "2.0"}, {"method", "printer.emergency_stop"}, {"id", 7}}));
+  }
+
+  {
+    // everything json escapes, including control characters
+    std::string script = "M117 \"quoted\" back\\slash\nnext\tline\x01\x1f caf\xc3\xa9";
+    RpcWriter rpc("printer.gcode.script");
+    rpc.param("script", script);
+    const std::string &frame = rpc.finish(1);
+    json j = json::parse(frame);
+    assert(j["params"]["script"] == script);
+    assert(j["id"] == 1);
+    assert(frame.find('\n') == std::string::npos);
+  }
+
+  {
+    RpcWriter rpc("server.spoolman.proxy");
+    rpc.param("request_method", "PATCH")
+      .param("path", std::string("/v1/spool/3"))
+      .param("spool_id", -3)
+      .param("big", static_cast<uint64_t>(1) << 63)
+      .begin_object("body")
+      .param("archived", true)
+      .end_object()
+      .param("after", false);
+    json j = json::parse(rpc.finish(2));
+    json expected = {
+      {"jsonrpc", "2.0"},
+      {"method", "server.spoolman.proxy"},
+      {"params", {
+          {"request_method", "PATCH"},
+          {"path", "/v1/spool/3"},
+          {"spool_id", -3},
+          {"big", static_cast<uint64_t>(1) << 63},
+          {"body", {{"archived", true}}},
+          {"after", false}}},
+      {"id", 2}
+    };
+    assert(j == expected);
+  }
+
+  {
+    // unclosed objects are closed by finish
+    RpcWriter rpc("a");
+    rpc.begin_object("x").param("y", 1);
+    json j = json::parse(rpc.finish(3));
+    assert(j["params"]["x"]["y"] == 1);
+  }
+
+  {
+    json params = {{"objects", {{"toolhead", nullptr}, {"extruder", {"temperature", "target"}}}}};
+    RpcWriter rpc("printer.objects.subscribe");
+    rpc.params(params);
+    json j = json::parse(rpc.finish(4));
+    assert(j["params"] == params);
+    assert(j["method"] == "printer.objects.subscribe");
+  }
+
+  {
+    // a writer created while another is alive, as from a callback, doesn't
+    // write over the first one's frame
+    RpcWriter outer("outer");
+    outer.param("a", 1);
+    {
+      RpcWriter inner("inner");
+      inner.param("b", 2);
+      json j = json::parse(inner.finish(6));
+      assert(j["method"] == "inner" && j["params"] == json({{"b", 2}}));
+    }
+    outer.param("c", 3);
+    json j = json::parse(outer.finish(5));
+    assert(j["method"] == "outer" && j["params"] == json({{"a", 1}, {"c", 3}}));
+  }
+
+  {
+    // nesting past MAX_DEPTH fails the writer
+    RpcWriter rpc("deep");
+    rpc.begin_object("1").begin_object("2").begin_object("3");
+    assert(rpc.ok());
+    rpc.begin_object("4").param("x", 1);
+    assert(!rpc.ok());
+    assert(rpc.finish(8).empty());
+  }
+
+  {
+    // nothing but finish after params
+    RpcWriter rpc("order");
+    rpc.params(json::object()).param("x", 1);
+    assert(!rpc.ok());
+    assert(rpc.finish(9).empty());
+  }
+
+  {
+    // params after a param, and anything after finish
+    RpcWriter rpc("order");
+    rpc.param("x", 1).params(json::object());
+    assert(!rpc.ok());
+
+    RpcWriter done("done");
+    assert(!done.finish(10).empty());
+    done.begin_object("x");
+    assert(!done.ok());
+  }
+
+  {
+    // the shared buffer is free again once the writers are gone
+    RpcWriter rpc("again");
+    json j = json::parse(rpc.finish(11));
+    assert(j["method"] == "again");
+  }
+
+  printf("rpc writer ok\n");
+  return 0;
+}
@@ -0,0 +1,124 @@
+// Packs the LVGL image converter output under assets/material* into
+// run length encoded images decoded at runtime by AssetCache, see
+// src/asset_codec.h. Run by the Makefile for every asset.
+//
+//   ./build/asset_pack assets/material/home.c build/assets/material/home.c
+//   ./build/asset_pack --report [--binary build/bin/grumpyscreen] assets/material/*.c
+
+#include "asset_codec.h"
+#include "asset_source.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+static std::string upper(std::string s) {
+  for (auto &c : s) {
+    c = toupper(c);
+  }
+  return s;
+}
+
+static int pack(const char *in, const char *out) {
+  AssetSource src;
+  if (!read_asset_source(in, src)) {
+    fprintf(stderr, "%s: no 32 bit image data\n", in);
+    return 1;
+  }
+
+  std::vector<uint8_t> packed = asset_encode(src.bgra.data(), src.w, src.h);
+  std::string attr = "LV_ATTRIBUTE_IMG_" + upper(src.name);
+
+  std::ofstream f(out);
+  f << "// packed by tools/asset_pack from " << in << ", do not edit\n"
+    << "#ifdef __has_include\n"
+    << "    #if __has_include(\"lvgl.h\")\n"
+    << "        #ifndef LV_LVGL_H_INCLUDE_SIMPLE\n"
+    << "            #define LV_LVGL_H_INCLUDE_SIMPLE\n"
+    << "        #endif\n"
+    << "    #endif\n"
+    << "#endif\n\n"
+    << "#if defined(LV_LVGL_H_INCLUDE_SIMPLE)\n"
+    << "    #include \"lvgl.h\"\n"
+    << "#else\n"
+    << "    #include \"lvgl/lvgl.h\"\n"
+    << "#endif\n\n"
+    << "#ifndef " << attr << "\n"
+    << "#define " << attr << "\n"
+    << "#endif\n\n"
+    << "const LV_ATTRIBUTE_LARGE_CONST " << attr << " uint8_t " << src.name << "_map[] = {";
+
+  char hex[8];
+  for (size_t i = 0; i < packed.size(); i++) {
+    snprintf(hex, sizeof(hex), "0x%02x,", packed[i]);
+    f << (i % 16 == 0 ? "\n  " : " ") << hex;
+  }
+
+  f << "\n};\n\n"
+    << "const lv_img_dsc_t " << src.name << " = {\n"
+    << "  .header.cf = LV_IMG_CF_USER_ENCODED_0,\n"
+    << "  .header.always_zero = 0,\n"
+    << "  .header.reserved = 0,\n"
+    << "  .header.w = " << src.w << ",\n"
+    << "  .header.h = " << src.h << ",\n"
+    << "  .data_size = " << packed.size() << ",\n"
+    << "  .data = " << src.name << "_map,\n"
+    << "};\n";
+
+  if (!f) {
+    fprintf(stderr, "%s: write failed\n", out);
+    return 1;
+  }
+  return 0;
+}
+
+// sizes of the image data compiled into the binary, raw is the 32 bit array
+static int report(const std::vector<const char *> &files, const char *binary) {
+  size_t raw = 0;
+  size_t packed = 0;
+  size_t one_colour = 0;
+  for (const char *in : files) {
+    AssetSource src;
+    if (!read_asset_source(in, src)) {
+      fprintf(stderr, "%s: no 32 bit image data\n", in);
+      return 1;
+    }
+    std::vector<uint8_t> p = asset_encode(src.bgra.data(), src.w, src.h);
+    raw += src.bgra.size();
+    packed += p.size();
+    one_colour += p[0] == ASSET_A8;
+  }
+
+  printf("assets: %zu images, %zu single colour, %zu bytes raw, %zu bytes packed (%.1f%%)\n",
+         files.size(), one_colour, raw, packed, raw > 0 ? 100.0 * packed / raw : 0.0);
+
+  struct stat st;
+  if (binary != NULL && stat(binary, &st) == 0) {
+    size_t after = st.st_size;
+    printf("binary: %zu bytes, %zu with raw assets\n", after, after - packed + raw);
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && std::string(argv[1]) == "--report") {
+    const char *binary = NULL;
+    std::vector<const char *> files;
+    for (int i = 2; i < argc; i++) {
+      if (std::string(argv[i]) == "--binary" && i + 1 < argc) {
+        binary = argv[++i];
+      } else {
+        files.push_back(argv[i]);
+      }
+    }
+    return report(files, binary);
+  }
+
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s in.c out.c\n       %s --report [--binary path] in.c...\n", argv[0], argv[0]);
+    return 2;
+  }
+  return pack(argv[1], argv[2]);
+}
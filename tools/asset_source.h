@@ -0,0 +1,72 @@
+#ifndef __ASSET_SOURCE_H__
+#define __ASSET_SOURCE_H__
+
+// Reads the images written by the LVGL image converter, as found under
+// assets/material*, for tools/asset_pack and tests/bench_asset_decode.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <vector>
+
+struct AssetSource {
+  std::string name;
+  uint32_t w;
+  uint32_t h;
+  // the LV_COLOR_DEPTH == 32 section, b g r a per pixel
+  std::vector<uint8_t> bgra;
+};
+
+inline bool read_asset_source(const std::string &path, AssetSource &out) {
+  std::ifstream f(path);
+  std::string text((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+  std::smatch m;
+  if (!std::regex_search(text, m, std::regex("const lv_img_dsc_t (\\w+) = \\{"))) {
+    return false;
+  }
+  out.name = m[1];
+  if (!std::regex_search(text, m, std::regex("\\.header\\.w = (\\d+)"))) {
+    return false;
+  }
+  out.w = std::stoul(m[1]);
+  if (!std::regex_search(text, m, std::regex("\\.header\\.h = (\\d+)"))) {
+    return false;
+  }
+  out.h = std::stoul(m[1]);
+
+  size_t start = text.find("#if LV_COLOR_DEPTH == 32");
+  if (start == std::string::npos) {
+    return false;
+  }
+  start = text.find('\n', start);
+  size_t end = text.find("#endif", start);
+  if (start == std::string::npos || end == std::string::npos) {
+    return false;
+  }
+
+  out.bgra.clear();
+  out.bgra.reserve(static_cast<size_t>(out.w) * out.h * 4);
+  const char *p = text.c_str() + start;
+  const char *stop = text.c_str() + end;
+  while (p < stop) {
+    if (p[0] == '0' && p[1] == 'x') {
+      char *next;
+      out.bgra.push_back(static_cast<uint8_t>(strtoul(p, &next, 16)));
+      p = next;
+    } else if (p[0] == '/' && p[1] == '*') {
+      // the converter's "Pixel format: ..." comment
+      const char *close = strstr(p, "*/");
+      p = close != NULL ? close + 2 : stop;
+    } else {
+      p++;
+    }
+  }
+  return out.bgra.size() == static_cast<size_t>(out.w) * out.h * 4;
+}
+
+#endif // __ASSET_SOURCE_H__
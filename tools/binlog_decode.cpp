@@ -0,0 +1,170 @@
+// Decodes binary log segments written with [ui] log_binary_path back to text.
+//
+//   make binlog_decode
+//   ./build/binlog_decode grumpyscreen.41.bin grumpyscreen.42.bin
+
+#define FMT_HEADER_ONLY
+#include <fmt/args.h>
+#include <fmt/format.h>
+
+#include "binlog.h"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+static const char *level_name(uint8_t level) {
+  switch (level) {
+    case 0: return "TRACE";
+    case 1: return "DEBUG";
+    case 2: return "INFO ";
+    case 3: return "ERROR";
+    default: return "?    ";
+  }
+}
+
+static void print_line(uint8_t level, uint64_t ts_us, const std::string &msg) {
+  time_t ts = ts_us / 1000000;
+  std::tm tm{};
+  localtime_r(&ts, &tm);
+  char buf[32];
+  strftime(buf, sizeof(buf), "%F %T", &tm);
+  fmt::print("{}.{:03} [{}] {}\n", buf, (ts_us / 1000) % 1000, level_name(level), msg);
+}
+
+static bool decode_args(const uint8_t *p, const uint8_t *end,
+                        fmt::dynamic_format_arg_store<fmt::format_context> &store) {
+  if (p >= end) {
+    return false;
+  }
+
+  uint8_t count = *p++;
+  for (uint8_t i = 0; i < count; i++) {
+    if (p >= end) {
+      return false;
+    }
+
+    uint8_t type = *p++;
+    uint64_t v = 0;
+    switch (type) {
+      case binlog::ARG_BOOL:
+      case binlog::ARG_CHAR:
+        if (p >= end) {
+          return false;
+        }
+        if (type == binlog::ARG_BOOL) {
+          store.push_back(*p != 0);
+        } else {
+          store.push_back(static_cast<char>(*p));
+        }
+        p++;
+        break;
+      case binlog::ARG_INT:
+        if (!binlog::get_varint(p, end, v)) {
+          return false;
+        }
+        store.push_back(static_cast<long long>(binlog::unzigzag(v)));
+        break;
+      case binlog::ARG_UINT:
+        if (!binlog::get_varint(p, end, v)) {
+          return false;
+        }
+        store.push_back(static_cast<unsigned long long>(v));
+        break;
+      case binlog::ARG_DOUBLE: {
+        if (end - p < 8) {
+          return false;
+        }
+        uint64_t bits = binlog::get_le(p, 8);
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        store.push_back(d);
+        p += 8;
+        break;
+      }
+      case binlog::ARG_STRING:
+        if (!binlog::get_varint(p, end, v) || static_cast<uint64_t>(end - p) < v) {
+          return false;
+        }
+        store.push_back(std::string(reinterpret_cast<const char *>(p), v));
+        p += v;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+static int decode_segment(const char *path) {
+  std::ifstream f(path, std::ios::binary);
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  if (data.size() < binlog::SEGMENT_HEADER_SIZE || memcmp(data.data(), binlog::MAGIC, sizeof(binlog::MAGIC)) != 0) {
+    fprintf(stderr, "%s: not a binary log segment\n", path);
+    return 1;
+  }
+
+  if (data[4] != binlog::VERSION) {
+    fprintf(stderr, "%s: unsupported version %d\n", path, data[4]);
+    return 1;
+  }
+
+  std::map<uint64_t, std::string> formats;
+  size_t off = binlog::SEGMENT_HEADER_SIZE;
+  while (off + binlog::RECORD_HEADER_SIZE <= data.size()) {
+    const uint8_t *h = data.data() + off;
+    uint8_t type = h[0];
+    uint8_t level = h[1];
+    uint32_t len = binlog::get_le(h + 4, 4);
+    uint64_t ts_us = binlog::get_le(h + 8, 8);
+    off += binlog::RECORD_HEADER_SIZE;
+
+    if (off + len > data.size()) {
+      // the tail of a segment that was not synced before a crash
+      fprintf(stderr, "%s: truncated record at offset %zu\n", path, off - binlog::RECORD_HEADER_SIZE);
+      return 1;
+    }
+
+    const uint8_t *p = data.data() + off;
+    const uint8_t *end = p + len;
+    off += len;
+
+    uint64_t id = 0;
+    if (type == binlog::REC_FORMAT) {
+      if (binlog::get_varint(p, end, id)) {
+        formats[id] = std::string(reinterpret_cast<const char *>(p), end - p);
+      }
+    } else if (type == binlog::REC_LINE) {
+      fmt::dynamic_format_arg_store<fmt::format_context> store;
+      auto entry = binlog::get_varint(p, end, id) ? formats.find(id) : formats.end();
+      if (entry == formats.end() || !decode_args(p, end, store)) {
+        print_line(level, ts_us, fmt::format("<undecodable record, format {}>", id));
+        continue;
+      }
+
+      try {
+        print_line(level, ts_us, fmt::vformat(entry->second, store));
+      } catch (const fmt::format_error &e) {
+        print_line(level, ts_us, fmt::format("<{}: {}>", e.what(), entry->second));
+      }
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s segment.bin...\n", argv[0]);
+    return 2;
+  }
+
+  int ret = 0;
+  for (int i = 1; i < argc; i++) {
+    ret |= decode_segment(argv[i]);
+  }
+  return ret;
+}